@@ -13,7 +13,7 @@
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
-#define BOOT_FLASH_BUFFER_SIZE 260U
+#define BOOT_FLASH_BUFFER_SIZE 1032U
 #define BOOT_LED_NUMBER        12U
 
 /******************************************************************************************
@@ -9,7 +9,6 @@
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
-#define BOOT_CMD_NUMBERS    8U
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
@@ -29,7 +28,7 @@ enum Boot_ScpCommands
 /******************************************************************************************
  *                                    GLOBAL VARIABLES                                    *
  ******************************************************************************************/
-extern const SCP_Command_T bootScpCommands[BOOT_CMD_NUMBERS];
+extern const SCP_Command_T bootScpCommands[SCP_COMMAND_TABLE_SIZE];
 
 /******************************************************************************************
  *                                   FUNCTION PROTOTYPES                                  *
@@ -6,32 +6,74 @@
  ******************************************************************************************/
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
 #include <assert.h>
 #include "usart.h"
 #include "scp_dispatcher.h"
+#include "scp_cobs.h"
 
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
 #define SCP_MAX_HUART_INSTANCES 1U
 #define SCP_PACKET_START        0x7EU
+#define SCP_PACKET_START_V2     0x7FU
 #define SCP_PACKET_CRC_INIT     0x1D0FU
 #define SCP_PACKET_MAX_SIZE     2060U
 
+#define SCP_PROTOCOL_VERSION_1  1U
+#define SCP_PROTOCOL_VERSION_2  2U
+/* v2 packets in COBS frames delimited by zero bytes */
+#define SCP_PROTOCOL_VERSION_3  3U
+
+/* Requests awaiting a response, their sequence numbers are echoed by SCP_Transmit */
+#define SCP_MAX_PENDING_REQUESTS 4U
+
+/* Command tables are perfect hash tables indexed by SCP_COMMAND_HASH, see SCP_DEFINE_COMMAND_TABLE */
+#define SCP_COMMAND_TABLE_SIZE  64U
+#define SCP_COMMAND_HASH(id)    ((((id) ^ ((id) >> 8)) & (SCP_COMMAND_TABLE_SIZE - 1U)))
+
+/* Built-in commands, handled by the dispatcher before the command table */
+#define SCP_CMD_ECHO                    0x0F00U
+#define SCP_CMD_GET_PROTOCOL_VERSION    0x0F01U
+
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
  ******************************************************************************************/
 typedef uint16_t SCP_CommandId_T;
 
+typedef enum
+{
+    SCP_STATUS_OK                   = 0x00U,
+    SCP_STATUS_NACK_UNKNOWN_COMMAND = 0x01U,
+    SCP_STATUS_NACK_INVALID_SIZE    = 0x02U,
+    SCP_STATUS_NACK_CRC             = 0x03U,
+    SCP_STATUS_NACK_BUSY            = 0x04U,
+} SCP_Status_T;
+
+/* Protocol v1 header, as sent on the wire */
 typedef struct __attribute__((packed))
 {
     uint8_t start;
     uint16_t crc;
     SCP_CommandId_T id;
     uint8_t size;
+} SCP_PacketHeaderV1_T;
+
+static_assert(6 == sizeof(SCP_PacketHeaderV1_T), "6 != sizeof(SCP_PacketHeaderV1_T)");
+
+/* Protocol v2 header, as sent on the wire. Also used for received v1 packets, with seq and status zeroed */
+typedef struct __attribute__((packed))
+{
+    uint8_t start;
+    uint16_t crc;
+    SCP_CommandId_T id;
+    uint16_t size;
+    uint8_t seq;
+    uint8_t status;
 } SCP_PacketHeader;
 
-static_assert(6 == sizeof(SCP_PacketHeader), "6 != sizeof(SCP_PacketHeader)");
+static_assert(9 == sizeof(SCP_PacketHeader), "9 != sizeof(SCP_PacketHeader)");
 
 typedef struct __attribute__((packed))
 {
@@ -39,15 +81,67 @@ typedef struct __attribute__((packed))
     uint8_t data[SCP_PACKET_MAX_SIZE];
 } SCP_Packet;
 
+/* Device side timestamps of an echo request, in core clock cycles */
+typedef struct __attribute__((packed))
+{
+    uint32_t coreClockHz;
+    uint32_t rxTimestamp;
+    uint32_t dispatchTimestamp;
+    uint32_t txTimestamp;
+} SCP_EchoHeader_T;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t maxVersion;
+    uint8_t maxPendingRequests;
+    uint16_t maxPayloadSize;
+} SCP_ProtocolInfo_T;
+
+/* Largest COBS encoded v3 packet, the frame buffer is also used to decode the packet in place */
+#define SCP_COBS_FRAME_SIZE SCP_COBS_ENCODED_MAX_SIZE(sizeof(SCP_Packet))
+
 typedef void (*SCP_CommandHandler)(const SCP_Packet *const packet, void *context);
 
+typedef enum
+{
+    SCP_SIZE_EXACT,
+    SCP_SIZE_MAX,
+    SCP_SIZE_VARIABLE,
+} SCP_SizeKind_T;
+
 typedef struct
 {
     uint16_t id;
-    uint8_t size;
+    SCP_SizeKind_T sizeKind;
+    uint16_t size;
     SCP_CommandHandler handler;
 } SCP_Command_T;
 
+/**
+ * @brief Defines a command table from a list of commands, declared once as an X-macro:
+ *        #define LIST(X) X(id, sizeKind, size, handler) ...
+ *
+ * Every command is placed at the slot given by its hash, so the dispatcher finds it with a single
+ * lookup. Two commands sharing a slot produce duplicate case labels, failing the build.
+ */
+#define SCP_COMMAND_TABLE_ENTRY(id, sizeKind, size, handler) \
+    [SCP_COMMAND_HASH(id)] = {(id), (sizeKind), (size), (handler)},
+
+#define SCP_COMMAND_TABLE_CASE(id, sizeKind, size, handler) \
+    case SCP_COMMAND_HASH(id):
+
+#define SCP_DEFINE_COMMAND_TABLE(name, list)                                 \
+    static inline void name##_CheckHashCollisions(SCP_CommandId_T id)         \
+    {                                                                         \
+        switch (SCP_COMMAND_HASH(id))                                         \
+        {                                                                     \
+            list(SCP_COMMAND_TABLE_CASE) break;                               \
+        default:                                                              \
+            break;                                                            \
+        }                                                                     \
+    }                                                                         \
+    const SCP_Command_T name[SCP_COMMAND_TABLE_SIZE] = {list(SCP_COMMAND_TABLE_ENTRY)}
+
 typedef enum 
 {
     SCP_PACKET_STATE_IDLE,
@@ -55,23 +149,46 @@ typedef enum
     SCP_PACKET_STATE_GOT_CRC_LOW,
     SCP_PACKET_STATE_GOT_CRC_HIGH,
     SCP_PACKET_STATE_GOT_ID_LOW,
-    SCP_PACKET_STATE_GOT_SIZE,
+    SCP_PACKET_STATE_GOT_ID_HIGH,
+    SCP_PACKET_STATE_GOT_SIZE_LOW,
+    SCP_PACKET_STATE_GOT_SIZE_HIGH,
+    SCP_PACKET_STATE_GOT_SEQ,
     SCP_PACKET_STATE_GETTING_DATA,
     SCP_PACKET_STATE_PACKET_COMPLETE
 } SCP_PacketState_T;
 
+typedef struct
+{
+    SCP_CommandId_T id;
+    uint8_t seq;
+    uint8_t version;
+    bool isPending;
+} SCP_PendingRequest_T;
+
 typedef struct
 {
     uint8_t *buffer;
     uint16_t size;
     UART_HandleTypeDef *huart;
     const SCP_Command_T *commands;
-    size_t numCommands;
     void (*errorHandler)(const char *command);
 
     SCP_Packet receivedPacket;
-    uint8_t dataBytesReceived;
+    uint8_t rawVersion;
+    uint8_t receivedVersion;
+    uint8_t hostVersion;
+    uint32_t packetTimestamp;
+    volatile uint32_t rxTimestamp;
+    uint16_t dataBytesReceived;
     SCP_PacketState_T state;
+    SCP_PendingRequest_T pendingRequests[SCP_MAX_PENDING_REQUESTS];
+    uint8_t nextPendingSlot;
+    bool isCobsFraming;
+    bool isCobsFrameOverflow;
+    uint16_t cobsFrameSize;
+    uint32_t cobsFrameTimestamp;
+    uint8_t cobsFrame[SCP_COBS_FRAME_SIZE];
+    uint8_t txFrame[SCP_COBS_FRAME_SIZE + 2U];
     SCP_DispatcherQueue_T queue;
 } SCP_Instance_T;
 
@@ -82,8 +199,18 @@ typedef struct
 /******************************************************************************************
  *                                   FUNCTION PROTOTYPES                                  *
  ******************************************************************************************/
+/**
+ * @brief Returns the current timestamp used by SCP, in core clock cycles.
+ */
+static inline uint32_t SCP_GetTimestamp(void)
+{
+    return DWT->CYCCNT;
+}
+
 int SCP_Init(SCP_Instance_T *const scp);
 void SCP_Process(void *context);
 int SCP_Transmit(SCP_Instance_T *const scp, SCP_CommandId_T id, const void *data, uint16_t size);
+int SCP_TransmitStatus(SCP_Instance_T *const scp, SCP_CommandId_T id, uint8_t seq, SCP_Status_T status);
+uint16_t SCP_GetMaxPayloadSize(uint8_t version);
 
 #endif /* __SCP__H__ */
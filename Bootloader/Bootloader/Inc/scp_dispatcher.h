@@ -9,7 +9,7 @@
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
-#define SCP_GLOBAL_BUFFER_SIZE 256U
+#define SCP_GLOBAL_BUFFER_SIZE 4096U
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
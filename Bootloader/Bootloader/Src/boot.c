@@ -46,12 +46,11 @@ static Bootloader_T bootloader = {
         .size = sizeof(scpBuffer),
         .huart = &huart4,
         .commands = bootScpCommands,
-        .numCommands = sizeof(bootScpCommands) / sizeof(bootScpCommands[0]),
         .errorHandler = NULL},
     .flashManager = {
         .appSectorRange = {
             .startSector = FLASH_SECTOR_3,
-            .sectorCount = 5U},
+            .sectorCount = 4U},
         .appStartAddress = 0x0800C000U,
         .appEndAddress = 0x0805FFFFU
         },
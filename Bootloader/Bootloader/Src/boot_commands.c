@@ -29,16 +29,18 @@ static void Boot_JumpToAppCmd(const SCP_Packet *const packet, void *context);
 /******************************************************************************************
  *                                        VARIABLES                                       *
  ******************************************************************************************/
-const SCP_Command_T bootScpCommands[BOOT_CMD_NUMBERS] = {
-     {BOOT_CMD_GET_SESSION,     0,  Boot_GetSession},
-     {BOOT_CMD_GET_VERSION,     0,  Boot_GetVersionCmd},
-     {BOOT_CMD_START_DOWNLOAD,  0,  Boot_StartDownloadCmd},
-     {BOOT_CMD_ERASE_APP,       0,  Boot_EraseAppCmd},
-     {BOOT_CMD_FLASH_DATA,      0,  Boot_FlashDataCmd},
-     {BOOT_CMD_FLASH_CRC,       0,  Boot_FlashMacCmd},
-     {BOOT_CMD_VALIDATE_APP,    0,  Boot_ValidateAppCmd},
-     {BOOT_CMD_JUMP_TO_APP,     0,  Boot_JumpToAppCmd},
-};
+/* X(id, sizeKind, size, handler) */
+#define BOOT_COMMAND_LIST(X)                                                                \
+    X(BOOT_CMD_GET_SESSION,     SCP_SIZE_EXACT, 0U,                     Boot_GetSession)        \
+    X(BOOT_CMD_GET_VERSION,     SCP_SIZE_EXACT, 0U,                     Boot_GetVersionCmd)     \
+    X(BOOT_CMD_START_DOWNLOAD,  SCP_SIZE_EXACT, 0U,                     Boot_StartDownloadCmd)  \
+    X(BOOT_CMD_ERASE_APP,       SCP_SIZE_EXACT, 0U,                     Boot_EraseAppCmd)       \
+    X(BOOT_CMD_FLASH_DATA,      SCP_SIZE_MAX,   BOOT_FLASH_BUFFER_SIZE, Boot_FlashDataCmd)      \
+    X(BOOT_CMD_FLASH_CRC,       SCP_SIZE_MAX,   BOOT_FLASH_BUFFER_SIZE, Boot_FlashMacCmd)       \
+    X(BOOT_CMD_VALIDATE_APP,    SCP_SIZE_EXACT, 0U,                     Boot_ValidateAppCmd)    \
+    X(BOOT_CMD_JUMP_TO_APP,     SCP_SIZE_EXACT, 0U,                     Boot_JumpToAppCmd)
+
+SCP_DEFINE_COMMAND_TABLE(bootScpCommands, BOOT_COMMAND_LIST);
 
 /******************************************************************************************
  *                                        FUNCTIONS                                       *
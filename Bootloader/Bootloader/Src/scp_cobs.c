@@ -0,0 +1,147 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "scp_cobs.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define SCP_COBS_MAX_CODE 0xFFU
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Encodes data with Consistent Overhead Byte Stuffing, without a second buffer.
+ *        The input has to be placed at buffer + SCP_COBS_OVERHEAD(size), the encoded data is
+ *        written from the start of the buffer. The output never overtakes the input, because
+ *        it grows by at most one byte per 254 input bytes plus the leading code byte.
+ *
+ * @param[in,out] buffer Buffer of at least SCP_COBS_ENCODED_MAX_SIZE(size) bytes.
+ * @param[in] size Size of the input data.
+ * 
+ * @return Size of the encoded data, without the delimiter.
+ */
+size_t SCP_Cobs_EncodeInPlace(uint8_t *buffer, size_t size)
+{
+    size_t read = SCP_COBS_OVERHEAD(size);
+    size_t end = read + size;
+    size_t write = 1U;
+    size_t codeIndex = 0U;
+    uint8_t code = 1U;
+
+    while (read < end)
+    {
+        uint8_t byte = buffer[read++];
+
+        if (byte == SCP_COBS_DELIMITER)
+        {
+            buffer[codeIndex] = code;
+            codeIndex = write++;
+            code = 1U;
+        }
+        else
+        {
+            buffer[write++] = byte;
+            code++;
+
+            if (code == SCP_COBS_MAX_CODE)
+            {
+                buffer[codeIndex] = code;
+                codeIndex = write++;
+                code = 1U;
+            }
+        }
+    }
+    buffer[codeIndex] = code;
+
+    return write;
+}
+
+/**
+ * @brief Checks whether the data is a well-formed COBS frame, without modifying it.
+ *
+ * @param[in] buffer Encoded data, without the delimiter.
+ * @param[in] size Size of the encoded data.
+ * 
+ * @return
+ * - true if every code byte points inside the frame and the frame contains no delimiter.
+ * - false otherwise.
+ */
+bool SCP_Cobs_IsValid(const uint8_t *buffer, size_t size)
+{
+    size_t read = 0U;
+
+    if (size == 0U)
+    {
+        return false;
+    }
+
+    while (read < size)
+    {
+        uint8_t code = buffer[read++];
+
+        if ((code == SCP_COBS_DELIMITER) || ((read + code - 1U) > size))
+        {
+            return false;
+        }
+
+        for (uint8_t i = 1U; i < code; i++)
+        {
+            if (buffer[read++] == SCP_COBS_DELIMITER)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Decodes a COBS frame in place. The decoded data starts at the beginning of the buffer.
+ *
+ * @param[in,out] buffer Encoded data, without the delimiter.
+ * @param[in] size Size of the encoded data.
+ * 
+ * @return Size of the decoded data, 0 if the frame is malformed.
+ */
+size_t SCP_Cobs_DecodeInPlace(uint8_t *buffer, size_t size)
+{
+    size_t read = 0U;
+    size_t write = 0U;
+
+    while (read < size)
+    {
+        uint8_t code = buffer[read++];
+
+        if ((code == SCP_COBS_DELIMITER) || ((read + code - 1U) > size))
+        {
+            return 0U;
+        }
+
+        for (uint8_t i = 1U; i < code; i++)
+        {
+            buffer[write++] = buffer[read++];
+        }
+
+        if ((code != SCP_COBS_MAX_CODE) && (read < size))
+        {
+            buffer[write++] = SCP_COBS_DELIMITER;
+        }
+    }
+
+    return write;
+}
@@ -41,6 +41,7 @@ extern CRC_HandleTypeDef hcrc;
 void MX_CRC_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+void CRC_InitCRC16(void);
 uint16_t CRC_CalculateCRC16(const uint8_t *data, uint32_t size, uint16_t init);
 /* USER CODE END Prototypes */
 
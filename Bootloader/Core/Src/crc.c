@@ -21,6 +21,33 @@
 #include "crc.h"
 
 /* USER CODE BEGIN 0 */
+#include <string.h>
+#include <stdbool.h>
+
+#define CRC16_CCITT_POLYNOMIAL 0x1021U
+
+typedef struct
+{
+  const char *data;
+  uint16_t init;
+  uint16_t crc;
+} CRC16_TestVector_T;
+
+/* Expected values computed on the host with a bitwise CRC-16/CCITT (poly 0x1021, no reflection) */
+static const CRC16_TestVector_T crc16TestVectors[] =
+{
+  {"",                    0x1D0FU, 0x1D0FU},
+  {"123456789",           0x1D0FU, 0xE5CCU},
+  {"123456789",           0xFFFFU, 0x29B1U},
+  {"12345",               0x1D0FU, 0xA5A2U},
+  {"6789",                0xA5A2U, 0xE5CCU},
+  {"A",                   0x0000U, 0x58E5U},
+  {"The quick brown fox", 0x1D0FU, 0x9A04U},
+};
+
+/* Set once the hardware unit passed the test vectors, cleared while it is in use */
+static bool crc16HardwareReady = false;
+
 static const uint16_t crc16CcittLookup[256] =
 {
   0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
@@ -82,7 +109,7 @@ void MX_CRC_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN CRC_Init 2 */
-
+  CRC_InitCRC16();
   /* USER CODE END CRC_Init 2 */
 
 }
@@ -120,7 +147,10 @@ void HAL_CRC_MspDeInit(CRC_HandleTypeDef* crcHandle)
 }
 
 /* USER CODE BEGIN 1 */
-uint16_t CRC_CalculateCRC16(const uint8_t *data, uint32_t size, uint16_t init)
+/**
+ * @brief Calculates CRC16-CCITT in software, one table lookup per byte.
+ */
+static uint16_t CRC_CalculateCRC16Software(const uint8_t *data, uint32_t size, uint16_t init)
 {
   uint16_t crc = init;
 
@@ -131,4 +161,88 @@ uint16_t CRC_CalculateCRC16(const uint8_t *data, uint32_t size, uint16_t init)
 
   return crc;
 }
+
+/**
+ * @brief Calculates CRC16-CCITT on the CRC unit, reprogrammed to the 16-bit polynomial for the call.
+ *        Whole words are written byte-swapped, so the unit sees the data in memory order.
+ *        The CRC32 configuration used through the HAL is restored afterwards.
+ */
+static uint16_t CRC_CalculateCRC16Hardware(const uint8_t *data, uint32_t size, uint16_t init)
+{
+  uint32_t word;
+  uint16_t crc;
+
+  CRC->POL = CRC16_CCITT_POLYNOMIAL;
+  CRC->INIT = init;
+  CRC->CR = CRC_POLYLENGTH_16B | CRC_CR_RESET;
+
+  for (; size >= sizeof(word); size -= sizeof(word), data += sizeof(word))
+  {
+    memcpy(&word, data, sizeof(word));
+    CRC->DR = __REV(word);
+  }
+  for (; size > 0U; size--)
+  {
+    *(__IO uint8_t *)&CRC->DR = *data++;
+  }
+  crc = (uint16_t)CRC->DR;
+
+  CRC->POL = DEFAULT_CRC32_POLY;
+  CRC->INIT = DEFAULT_CRC_INITVALUE;
+  CRC->CR = CRC_POLYLENGTH_32B;
+
+  return crc;
+}
+
+/**
+ * @brief Enables the hardware CRC16 path if the CRC unit reproduces all test vectors,
+ *        otherwise CRC_CalculateCRC16 keeps using the software implementation.
+ */
+void CRC_InitCRC16(void)
+{
+  crc16HardwareReady = false;
+
+  for (size_t i = 0U; i < sizeof(crc16TestVectors) / sizeof(crc16TestVectors[0]); i++)
+  {
+    const CRC16_TestVector_T *vector = &crc16TestVectors[i];
+    const uint8_t *data = (const uint8_t *)vector->data;
+    uint32_t size = strlen(vector->data);
+
+    if ((CRC_CalculateCRC16Software(data, size, vector->init) != vector->crc) ||
+        (CRC_CalculateCRC16Hardware(data, size, vector->init) != vector->crc))
+    {
+      return;
+    }
+  }
+
+  crc16HardwareReady = true;
+}
+
+/**
+ * @brief Calculates CRC16-CCITT, on the CRC unit when it passed the self-test.
+ *        A call arriving while the unit is in use, by another CRC16 or by a HAL CRC32 calculation
+ *        interrupted by this call, falls back to software.
+ */
+uint16_t CRC_CalculateCRC16(const uint8_t *data, uint32_t size, uint16_t init)
+{
+  uint16_t crc;
+
+  __disable_irq();
+  bool useHardware = crc16HardwareReady && (hcrc.State == HAL_CRC_STATE_READY);
+  if (useHardware)
+  {
+    crc16HardwareReady = false;
+  }
+  __enable_irq();
+
+  if (!useHardware)
+  {
+    return CRC_CalculateCRC16Software(data, size, init);
+  }
+
+  crc = CRC_CalculateCRC16Hardware(data, size, init);
+  crc16HardwareReady = true;
+
+  return crc;
+}
 /* USER CODE END 1 */
@@ -1,6 +1,8 @@
 #include "bluetoothhandler.h"
 #include <QBluetoothUuid>
 #include <QDataStream>
+#include <QtEndian>
+#include <algorithm>
 
 BluetoothHandler::BluetoothHandler(QObject *parent)
     : QObject{parent},
@@ -8,7 +10,10 @@ BluetoothHandler::BluetoothHandler(QObject *parent)
     bluetoothSocket(new QBluetoothSocket(QBluetoothServiceInfo::RfcommProtocol, this)),
     connectionTimer(new QTimer(this)),
     responseTimer(new QTimer(this)),
-    currentCommand(Command::InvalidCommand),
+    nextSequence(1),
+    maxInFlight(1),
+    maxPayload(SCP::MAX_PAYLOAD_SIZE_V1),
+    negotiationInProgress(false),
     scpHandler(new SCP(this))
 {
     connect(discoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered, this, &BluetoothHandler::handleDeviceDiscovered);
@@ -22,7 +27,7 @@ BluetoothHandler::BluetoothHandler(QObject *parent)
     connect(responseTimer, &QTimer::timeout, this, &BluetoothHandler::handleResponseTimeout);
 
     connectionTimer->setSingleShot(true);
-    responseTimer->setSingleShot(true);
+    responseTimer->setInterval(RESPONSE_CHECK_INTERVAL);
 
     connect(scpHandler, &SCP::packetReadyToSend, this, &BluetoothHandler::handlePacketReadyToSend);
     connect(scpHandler, &SCP::commandReceived, this, &BluetoothHandler::handleCommandReceived);
@@ -91,15 +96,87 @@ void BluetoothHandler::sendCommand(Command command, const QByteArray &data)
         return;
     }
 
-    if (currentCommand != Command::InvalidCommand)
+    queuedRequests.enqueue({command, data});
+    sendQueuedRequests();
+}
+
+void BluetoothHandler::negotiateProtocol()
+{
+    /* Probe in v1 framing, a device without v2 support ignores the command and the probe times out */
+    scpHandler->setProtocolVersion(SCP::PROTOCOL_VERSION_1);
+    maxInFlight = 1;
+    maxPayload = SCP::MAX_PAYLOAD_SIZE_V1;
+    negotiationInProgress = true;
+
+    sendRequest(Command::GetProtocolVersion, QByteArray(), NEGOTIATION_TIMEOUT);
+}
+
+int BluetoothHandler::protocolVersion() const
+{
+    return scpHandler->protocolVersion();
+}
+
+int BluetoothHandler::maxPayloadSize() const
+{
+    return maxPayload;
+}
+
+void BluetoothHandler::resetRequests()
+{
+    pendingRequests.clear();
+    queuedRequests.clear();
+    responseTimer->stop();
+    negotiationInProgress = false;
+}
+
+void BluetoothHandler::sendRequest(Command command, const QByteArray &data, int timeout)
+{
+    const uint8_t sequence = allocateSequence();
+
+    pendingRequests.insert(sequence, {command, QDeadlineTimer(timeout)});
+    if (!responseTimer->isActive())
     {
-        emit errorOccurred("Previous command is still pending.");
-        return;
+        responseTimer->start();
+    }
+
+    scpHandler->sendCommand(command, data, sequence);
+}
+
+void BluetoothHandler::sendQueuedRequests()
+{
+    while (!queuedRequests.isEmpty() && !negotiationInProgress && (pendingRequests.size() < maxInFlight))
+    {
+        const QueuedRequest request = queuedRequests.dequeue();
+        sendRequest(request.command, request.data, RESPONSE_TIMEOUT);
     }
+}
+
+uint8_t BluetoothHandler::allocateSequence()
+{
+    uint8_t sequence;
+
+    /* Sequence 0 is reserved for packets sent by the device on its own */
+    do
+    {
+        sequence = nextSequence++;
+        if (nextSequence == 0)
+        {
+            nextSequence = 1;
+        }
+    } while (pendingRequests.contains(sequence));
+
+    return sequence;
+}
 
-    currentCommand = command;
-    responseTimer->start(RESPONSE_TIMEOUT);
-    scpHandler->sendCommand(command, data);
+void BluetoothHandler::finishNegotiation(int version, int inFlight, int payloadSize)
+{
+    negotiationInProgress = false;
+    scpHandler->setProtocolVersion(version);
+    maxInFlight = qBound(1, inFlight, MAX_IN_FLIGHT);
+    maxPayload = payloadSize;
+
+    emit protocolNegotiated(version);
+    sendQueuedRequests();
 }
 
 QList<QBluetoothDeviceInfo> BluetoothHandler::discoveredDevices() const
@@ -120,11 +197,14 @@ void BluetoothHandler::handleDiscoveryFinished()
 void BluetoothHandler::handleConnectionEstablished()
 {
     connectionTimer->stop();
+    resetRequests();
+    negotiateProtocol();
     emit connectionEstablished();
 }
 
 void BluetoothHandler::handleConnectionLost()
 {
+    resetRequests();
     emit connectionLost();
 }
 
@@ -145,8 +225,40 @@ void BluetoothHandler::handleConnectionTimeout()
 
 void BluetoothHandler::handleResponseTimeout()
 {
-    emit errorOccurred("Response timeout occurred.");
-    currentCommand = Command::InvalidCommand;
+    QList<Command> expiredCommands;
+
+    for (auto it = pendingRequests.begin(); it != pendingRequests.end();)
+    {
+        if (it->deadline.hasExpired())
+        {
+            expiredCommands.append(it->command);
+            it = pendingRequests.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    if (pendingRequests.isEmpty())
+    {
+        responseTimer->stop();
+    }
+
+    for (const Command command : expiredCommands)
+    {
+        if (negotiationInProgress && (command == Command::GetProtocolVersion))
+        {
+            finishNegotiation(SCP::PROTOCOL_VERSION_1, 1, SCP::MAX_PAYLOAD_SIZE_V1);
+        }
+        else
+        {
+            emit errorOccurred("Response timeout occurred.");
+            emit responseTimeout(command);
+        }
+    }
+
+    sendQueuedRequests();
 }
 
 void BluetoothHandler::handlePacketReadyToSend(const QByteArray &packet)
@@ -154,14 +266,59 @@ void BluetoothHandler::handlePacketReadyToSend(const QByteArray &packet)
     bluetoothSocket->write(packet);
 }
 
-void BluetoothHandler::handleCommandReceived(Command command, const QByteArray &data)
+void BluetoothHandler::handleCommandReceived(Command command, uint8_t sequence, SCP::Status status, const QByteArray &data)
 {
-    if (command == currentCommand)
+    auto request = pendingRequests.find(sequence);
+
+    /* v1 responses and responses sent after a device reset carry no sequence, match them by command */
+    if ((request == pendingRequests.end()) || (request->command != command))
+    {
+        request = std::find_if(pendingRequests.begin(), pendingRequests.end(),
+                               [command](const PendingRequest &pending) { return pending.command == command; });
+    }
+    if (request != pendingRequests.end())
+    {
+        pendingRequests.erase(request);
+    }
+    if (pendingRequests.isEmpty())
     {
         responseTimer->stop();
-        currentCommand = Command::InvalidCommand;
     }
-    emit dataReceived(command, data);
+
+    if (negotiationInProgress && (command == Command::GetProtocolVersion))
+    {
+        if ((status == SCP::Status::Ok) && (data.size() >= 4))
+        {
+            const uchar *info = reinterpret_cast<const uchar *>(data.constData());
+            finishNegotiation(qMin<int>(info[0], SCP::PROTOCOL_VERSION_3), info[1], qFromLittleEndian<quint16>(info + 2));
+        }
+        else
+        {
+            finishNegotiation(SCP::PROTOCOL_VERSION_1, 1, SCP::MAX_PAYLOAD_SIZE_V1);
+        }
+        return;
+    }
+
+    if (!negotiationInProgress && (scpHandler->protocolVersion() != SCP::PROTOCOL_VERSION_1) &&
+        (scpHandler->lastReceivedVersion() == SCP::PROTOCOL_VERSION_1))
+    {
+        emit errorOccurred("Device answered with protocol v1, renegotiating.");
+        negotiateProtocol();
+    }
+
+    if (status != SCP::Status::Ok)
+    {
+        emit errorOccurred(QString("Command 0x%1 rejected: %2.")
+                               .arg(static_cast<uint16_t>(command), 4, 16, QChar('0'))
+                               .arg(SCP::statusToString(status)));
+        emit commandRejected(command, status);
+    }
+    else
+    {
+        emit dataReceived(command, data);
+    }
+
+    sendQueuedRequests();
 }
 
 void BluetoothHandler::handleProtocolError(const QString &error)
@@ -5,6 +5,9 @@
 #include <QBluetoothSocket>
 #include <QBluetoothDeviceDiscoveryAgent>
 #include <QTimer>
+#include <QDeadlineTimer>
+#include <QMap>
+#include <QQueue>
 #include "command.h"
 #include "scp.h"
 
@@ -21,6 +24,9 @@ public:
     void disconnectFromDevice();
     bool isConnected() const;
     void sendCommand(Command command, const QByteArray &data);
+    void negotiateProtocol();
+    int protocolVersion() const;
+    int maxPayloadSize() const;
     QList<QBluetoothDeviceInfo> discoveredDevices() const;
 
 private slots:
@@ -32,7 +38,7 @@ private slots:
     void handleConnectionTimeout();
     void handleResponseTimeout();
     void handlePacketReadyToSend(const QByteArray &packet);
-    void handleCommandReceived(Command command, const QByteArray &data);
+    void handleCommandReceived(Command command, uint8_t sequence, SCP::Status status, const QByteArray &data);
     void handleProtocolError(const QString &error);
 
 signals:
@@ -41,22 +47,50 @@ signals:
     void connectionEstablished();
     void connectionLost();
     void dataReceived(Command command, const QByteArray &data);
+    void responseTimeout(Command command);
+    void commandRejected(Command command, SCP::Status status);
+    void protocolNegotiated(int version);
     void errorOccurred(const QString &error);
 
 private:
+    struct PendingRequest
+    {
+        Command command;
+        QDeadlineTimer deadline;
+    };
+
+    struct QueuedRequest
+    {
+        Command command;
+        QByteArray data;
+    };
+
     static constexpr int CONNECTION_TIMEOUT = 5000;
     static constexpr int RESPONSE_TIMEOUT = 5000;
+    static constexpr int NEGOTIATION_TIMEOUT = 1000;
+    static constexpr int RESPONSE_CHECK_INTERVAL = 20;
+    static constexpr int MAX_IN_FLIGHT = 4;
 
     QBluetoothDeviceDiscoveryAgent *discoveryAgent;
     QBluetoothSocket *bluetoothSocket;
     QTimer *connectionTimer;
     QTimer *responseTimer;
 
-    Command currentCommand;
+    QMap<uint8_t, PendingRequest> pendingRequests;
+    QQueue<QueuedRequest> queuedRequests;
+    uint8_t nextSequence;
+    int maxInFlight;
+    int maxPayload;
+    bool negotiationInProgress;
 
     SCP *scpHandler;
 
     void resetSocket();
+    void resetRequests();
+    void sendRequest(Command command, const QByteArray &data, int timeout);
+    void sendQueuedRequests();
+    uint8_t allocateSequence();
+    void finishNegotiation(int version, int inFlight, int payloadSize);
 };
 
 #endif // BLUETOOTHHANDLER_H
@@ -221,8 +221,14 @@ void Bootloader::sendNextFirmwareChunk()
 
     int bytesInChunk = 0;
     quint32 currentAddress = startAddress;
+    int blockSize = FLASH_BLOCK_SIZE;
 
-    while (firmwareIterator != firmwareMap.constEnd() && bytesInChunk < FLASH_BLOCK_SIZE)
+    if (bluetoothHandler->protocolVersion() >= SCP::PROTOCOL_VERSION_2)
+    {
+        blockSize = qMin(FLASH_BLOCK_SIZE_V2, bluetoothHandler->maxPayloadSize() - FLASH_CHUNK_HEADER_SIZE);
+    }
+
+    while (firmwareIterator != firmwareMap.constEnd() && bytesInChunk < blockSize)
     {
         if (firmwareIterator.key() != currentAddress)
         {
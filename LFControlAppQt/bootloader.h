@@ -47,6 +47,8 @@ private:
     };
 
     static const int FLASH_BLOCK_SIZE = 120;
+    static const int FLASH_BLOCK_SIZE_V2 = 1024;
+    static const int FLASH_CHUNK_HEADER_SIZE = 7;
     static const quint32 APP_START_ADDRESS = 0x0800C000U;
     static const quint32 APP_END_ADDRESS = 0x0805FFFFU;
     static const quint32 CRC_SIZE = 4U;
@@ -13,6 +13,23 @@ enum class Command : uint16_t
     SetDebugMode     = 0x0005,
     DebugData        = 0x0006,
     GetActiveSession = 0x0007,
+    GetNvmStatus     = 0x0008,
+    GetParams        = 0x0009,
+    SetParams        = 0x000A,
+    CommitParams     = 0x000B,
+    SelectProfile    = 0x000C,
+    GetProfiles      = 0x000D,
+    CloneProfile     = 0x000E,
+    DiffProfiles     = 0x000F,
+    CalibrationProgress = 0x0012,
+    StoreThresholds  = 0x0013,
+    GetTrackMap      = 0x0014,
+    IdentifyMotors   = 0x0015,
+    Autotune         = 0x0016,
+    GetEventLog      = 0x0017,
+
+    Echo               = 0x0F00,
+    GetProtocolVersion = 0x0F01,
 
     BootGetVersion      = 0xF001,
     BootStartDownload   = 0xF002,
@@ -28,7 +45,43 @@ enum class Command : uint16_t
 enum class CommandSetMode : uint8_t
 {
     Start = 0x00,
-    Stop  = 0x01
+    Stop  = 0x01,
+    Map   = 0x02
+};
+
+enum class CommandAutotune : uint8_t
+{
+    Wheels = 0x00,
+    Line   = 0x01
+};
+
+enum class ParamResult : uint8_t
+{
+    Ok          = 0x00,
+    UnknownId   = 0x01,
+    OutOfRange  = 0x02,
+    Malformed   = 0x03
+};
+
+enum class ProfileResult : uint8_t
+{
+    Ok          = 0x00,
+    Invalid     = 0x01,
+    Uncommitted = 0x02
+};
+
+enum class NvmWriteResult : uint8_t
+{
+    Ok      = 0x00,
+    Invalid = 0x01
+};
+
+enum class NvmStatus : uint8_t
+{
+    Complete = 0x00,
+    Pending  = 0x01,
+    Busy     = 0x02,
+    Failed   = 0x03
 };
 
 #endif // COMMAND_H
@@ -15,6 +15,13 @@ public:
     float motorLeftVelocity;
     float motorRightVelocity;
     bool isSpeedReduced;
+    /* Thresholds used by the robot, adapted to the lighting during a run */
+    std::array<uint16_t, SENSORS_NUMBER> thresholds;
+    /* Speed setpoint of the trajectory generator [m/s] and its acceleration [m/s^2] */
+    float setpointSpeed;
+    float setpointAccel;
+    /* Wheels whose PWM is capped by the traction control, bit 0 left, bit 1 right */
+    uint8_t slipMask;
 
     DebugData() = default;
 
@@ -35,12 +42,25 @@ public:
         offset += sizeof(sensorError);
         isSpeedReduced = *reinterpret_cast<const bool *>(data + offset);
         offset += sizeof(isSpeedReduced);
+        for (size_t i = 0U; i < thresholds.size(); ++i)
+        {
+            std::memcpy(&thresholds[i], data + offset, sizeof(thresholds[i]));
+            offset += sizeof(thresholds[i]);
+        }
+        std::memcpy(&setpointSpeed, data + offset, sizeof(setpointSpeed));
+        offset += sizeof(setpointSpeed);
+        std::memcpy(&setpointAccel, data + offset, sizeof(setpointAccel));
+        offset += sizeof(setpointAccel);
+        slipMask = data[offset];
+        offset += sizeof(slipMask);
     }
 
     constexpr size_t size() const
     {
         return sizeof(sensorError) + (sensorValues.size() * sizeof(uint16_t)) +
-               sizeof(motorLeftVelocity) + sizeof(motorRightVelocity) + sizeof(isSpeedReduced);
+               sizeof(motorLeftVelocity) + sizeof(motorRightVelocity) + sizeof(isSpeedReduced) +
+               (thresholds.size() * sizeof(uint16_t)) + sizeof(setpointSpeed) + sizeof(setpointAccel) +
+               sizeof(slipMask);
     }
 
     QString toString() const
@@ -50,14 +70,17 @@ public:
 
         for (size_t i = 0U; i < sensorValues.size(); ++i)
         {
-            output.append(QString("Sensor %1 Value: %2\n")
+            output.append(QString("Sensor %1 Value: %2, Threshold: %3\n")
                               .arg(i + 1)
-                              .arg(sensorValues[i]));
+                              .arg(sensorValues[i])
+                              .arg(thresholds[i]));
         }
         output.append(QString("Sensor Error: %1\n").arg(sensorError));
         output.append(QString("Motor Left Velocity: %1\n").arg(motorLeftVelocity));
         output.append(QString("Motor Right Velocity: %1\n").arg(motorRightVelocity));
         output.append(QString("Right angle detected: %1\n").arg(isSpeedReduced));
+        output.append(QString("Setpoint Speed: %1, Acceleration: %2\n").arg(setpointSpeed).arg(setpointAccel));
+        output.append(QString("Slipping wheels: %1\n").arg(slipMask));
 
         return output;
     }
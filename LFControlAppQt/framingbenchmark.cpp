@@ -0,0 +1,212 @@
+#include "framingbenchmark.h"
+#include <QElapsedTimer>
+#include <QtEndian>
+#include <algorithm>
+
+FramingBenchmark::FramingBenchmark(QObject *parent)
+    : QObject(parent)
+{
+}
+
+FramingBenchmark::Result FramingBenchmark::run(int version, const Settings &settings)
+{
+    SCP sender;
+    SCP receiver;
+    QByteArray packet;
+    QByteArray stream;
+    QList<Frame> frames;
+    QList<bool> delivered(settings.frames, false);
+    Result result;
+
+    random.seed(settings.seed);
+    sender.setProtocolVersion(version);
+    receiver.setProtocolVersion(version);
+    connect(&sender, &SCP::packetReadyToSend, this, [&packet](const QByteArray &data)
+            { packet = data; });
+
+    result.version = version;
+    result.framesSent = settings.frames;
+
+    /* v1 payload size is limited to 8 bits */
+    const int maxPayloadSize = (version == SCP::PROTOCOL_VERSION_1) ? qMin<int>(settings.maxPayloadSize, SCP::MAX_PAYLOAD_SIZE_V1)
+                                                                    : settings.maxPayloadSize;
+
+    for (int i = 0; i < settings.frames; ++i)
+    {
+        Frame frame;
+
+        packet.clear();
+        sender.sendCommand(Command::Echo, buildPayload(static_cast<quint32>(i), maxPayloadSize));
+
+        frame.corrupted = (random.generateDouble() < settings.errorRate);
+        if (frame.corrupted)
+        {
+            corrupt(packet);
+            result.framesCorrupted++;
+        }
+
+        frame.start = stream.size();
+        stream.append(packet);
+        frame.end = stream.size();
+        frames.append(frame);
+    }
+
+    connect(&receiver, &SCP::commandReceived, this, [&](Command command, uint8_t, SCP::Status, const QByteArray &data)
+            {
+                if ((command != Command::Echo) || (data.size() < FRAME_INDEX_SIZE))
+                {
+                    return;
+                }
+
+                const quint32 index = qFromLittleEndian<quint32>(data.constData());
+                if (index >= static_cast<quint32>(frames.size()))
+                {
+                    result.corruptedAccepted++;
+                    return;
+                }
+                if (frames.at(index).corrupted)
+                {
+                    result.corruptedAccepted++;
+                }
+                else if (!delivered.at(index))
+                {
+                    result.framesReceived++;
+                }
+                delivered[index] = true;
+            });
+
+    /* Random chunks, as delivered by the Bluetooth socket */
+    QElapsedTimer parseTimer;
+    parseTimer.start();
+    for (qsizetype offset = 0; offset < stream.size();)
+    {
+        const qsizetype chunkSize = qMin<qsizetype>(random.bounded(1, MAX_CHUNK_SIZE + 1), stream.size() - offset);
+        receiver.receiveData(stream.mid(offset, chunkSize));
+        offset += chunkSize;
+    }
+    const qint64 parseNs = parseTimer.nsecsElapsed();
+
+    result.bytesSent = stream.size();
+    result.framesLost = (result.framesSent - result.framesCorrupted) - result.framesReceived;
+    if (!stream.isEmpty())
+    {
+        result.parseNsPerByte = static_cast<double>(parseNs) / stream.size();
+    }
+
+    /* Recovery is the good data skipped between a corrupted frame and the next frame the parser delivers */
+    QList<qint64> recoveryBytes;
+    for (int i = 0; i < frames.size(); ++i)
+    {
+        if (!frames.at(i).corrupted)
+        {
+            continue;
+        }
+
+        int next = i + 1;
+        while ((next < frames.size()) && !delivered.at(next) && !frames.at(next).corrupted)
+        {
+            next++;
+        }
+
+        if (next >= frames.size())
+        {
+            recoveryBytes.append(stream.size() - frames.at(i).end);
+        }
+        else if (!frames.at(next).corrupted)
+        {
+            recoveryBytes.append(frames.at(next).start - frames.at(i).end);
+        }
+    }
+
+    if (!recoveryBytes.isEmpty())
+    {
+        qint64 total = 0;
+        for (const qint64 bytes : recoveryBytes)
+        {
+            total += bytes;
+        }
+        result.recoveryAvgBytes = static_cast<double>(total) / recoveryBytes.size();
+        result.recoveryMaxBytes = static_cast<int>(*std::max_element(recoveryBytes.begin(), recoveryBytes.end()));
+        result.recoveryAvgMs = result.recoveryAvgBytes * BITS_PER_UART_BYTE * 1000.0 / settings.baudRate;
+    }
+
+    return result;
+}
+
+QString FramingBenchmark::formatResult(const Result &result)
+{
+    return QString("v%1: received %2/%3 good frames (lost %4), corrupted %5, false accepts %6, "
+                   "recovery avg/max %7/%8 B (%9 ms on the link), parser %10 ns/B")
+        .arg(result.version)
+        .arg(result.framesReceived)
+        .arg(result.framesSent - result.framesCorrupted)
+        .arg(result.framesLost)
+        .arg(result.framesCorrupted)
+        .arg(result.corruptedAccepted)
+        .arg(result.recoveryAvgBytes, 0, 'f', 1)
+        .arg(result.recoveryMaxBytes)
+        .arg(result.recoveryAvgMs, 0, 'f', 2)
+        .arg(result.parseNsPerByte, 0, 'f', 1);
+}
+
+QByteArray FramingBenchmark::buildPayload(quint32 index, int maxPayloadSize)
+{
+    const int size = random.bounded(FRAME_INDEX_SIZE, qMax(FRAME_INDEX_SIZE, maxPayloadSize) + 1);
+    QByteArray payload(size, Qt::Uninitialized);
+
+    qToLittleEndian(index, payload.data());
+    for (int i = FRAME_INDEX_SIZE; i < size; ++i)
+    {
+        payload[i] = randomByte();
+    }
+
+    return payload;
+}
+
+void FramingBenchmark::corrupt(QByteArray &frame)
+{
+    if (frame.isEmpty())
+    {
+        return;
+    }
+
+    const qsizetype position = random.bounded(static_cast<int>(frame.size()));
+
+    switch (static_cast<Corruption>(random.bounded(4)))
+    {
+    case Corruption::BitFlip:
+        frame[position] = static_cast<char>(frame.at(position) ^ (1 << random.bounded(8)));
+        break;
+    case Corruption::Truncation:
+        frame.truncate(position);
+        break;
+    case Corruption::ByteDrop:
+        frame.remove(position, 1);
+        break;
+    case Corruption::Garbage:
+    default:
+    {
+        QByteArray garbage;
+        const int garbageSize = random.bounded(1, MAX_GARBAGE_SIZE + 1);
+        for (int i = 0; i < garbageSize; ++i)
+        {
+            garbage.append(randomByte());
+        }
+        frame.insert(position, garbage);
+        break;
+    }
+    }
+}
+
+char FramingBenchmark::randomByte()
+{
+    /* Start bytes and delimiters are overrepresented, they are the ones misleading the parsers */
+    static constexpr char SPECIAL_BYTES[] = { 0x00, 0x7E, 0x7F };
+
+    if (random.bounded(4) == 0)
+    {
+        return SPECIAL_BYTES[random.bounded(static_cast<int>(sizeof(SPECIAL_BYTES)))];
+    }
+
+    return static_cast<char>(random.bounded(256));
+}
@@ -0,0 +1,76 @@
+#ifndef FRAMINGBENCHMARK_H
+#define FRAMINGBENCHMARK_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QRandomGenerator>
+#include "command.h"
+#include "scp.h"
+
+/* Offline fuzzer comparing how fast the SCP receive path resynchronises after corrupted frames.
+   Echo packets with random payloads are encoded by SCP, corrupted and fed to a receiving SCP instance */
+class FramingBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    struct Settings
+    {
+        int frames = 10000;
+        double errorRate = 0.05;
+        quint32 seed = 1;
+        int maxPayloadSize = 255;
+        int baudRate = 115200;
+    };
+
+    struct Result
+    {
+        int version = 0;
+        int framesSent = 0;
+        int framesCorrupted = 0;
+        int framesReceived = 0;
+        int framesLost = 0;
+        int corruptedAccepted = 0;
+        qint64 bytesSent = 0;
+        double recoveryAvgBytes = 0.0;
+        int recoveryMaxBytes = 0;
+        double recoveryAvgMs = 0.0;
+        double parseNsPerByte = 0.0;
+    };
+
+    explicit FramingBenchmark(QObject *parent = nullptr);
+
+    Result run(int version, const Settings &settings);
+
+    static QString formatResult(const Result &result);
+
+private:
+    enum class Corruption
+    {
+        BitFlip,
+        Truncation,
+        ByteDrop,
+        Garbage
+    };
+
+    /* Frame index placed at the start of every payload, to identify the delivered frames */
+    static constexpr int FRAME_INDEX_SIZE = 4;
+    static constexpr int BITS_PER_UART_BYTE = 10;
+    static constexpr int MAX_CHUNK_SIZE = 64;
+    static constexpr int MAX_GARBAGE_SIZE = 16;
+
+    struct Frame
+    {
+        qint64 start = 0;
+        qint64 end = 0;
+        bool corrupted = false;
+    };
+
+    QRandomGenerator random;
+
+    QByteArray buildPayload(quint32 index, int maxPayloadSize);
+    void corrupt(QByteArray &frame);
+    char randomByte();
+};
+
+#endif // FRAMINGBENCHMARK_H
@@ -0,0 +1,234 @@
+#include "linkbenchmark.h"
+#include <QtEndian>
+#include <QtMath>
+#include <algorithm>
+#include <numeric>
+
+LinkBenchmark::LinkBenchmark(BluetoothHandler *bluetoothHandler, QObject *parent)
+    : QObject(parent),
+    bluetoothHandler(bluetoothHandler),
+    running(false),
+    currentPayloadSize(0),
+    currentIteration(0),
+    sequence(0),
+    lost(0)
+{
+    connect(bluetoothHandler, &BluetoothHandler::dataReceived, this, &LinkBenchmark::handleDataReceived);
+    connect(bluetoothHandler, &BluetoothHandler::responseTimeout, this, &LinkBenchmark::handleResponseTimeout);
+}
+
+void LinkBenchmark::start(const Settings &settings)
+{
+    if (running)
+    {
+        emit errorOccurred("Link benchmark is already running.");
+        return;
+    }
+    if (!bluetoothHandler->isConnected())
+    {
+        emit errorOccurred("Link benchmark requires an active connection.");
+        return;
+    }
+    if ((settings.minPayloadSize > settings.maxPayloadSize) || (settings.payloadStep <= 0) || (settings.iterations <= 0))
+    {
+        emit errorOccurred("Invalid link benchmark settings.");
+        return;
+    }
+
+    this->settings = settings;
+    results.clear();
+    currentPayloadSize = settings.minPayloadSize;
+    currentIteration = 0;
+    lost = 0;
+    rttSamples.clear();
+    deviceSamples.clear();
+    running = true;
+
+    sendNextEcho();
+}
+
+void LinkBenchmark::stop()
+{
+    if (running)
+    {
+        running = false;
+        emit finished(results);
+    }
+}
+
+bool LinkBenchmark::isRunning() const
+{
+    return running;
+}
+
+QString LinkBenchmark::formatResult(const Result &result)
+{
+    return QString("%1 B: RTT min/avg/p50/p95/max %2/%3/%4/%5/%6 ms, device %7 us, %8 B/s, lost %9/%10")
+        .arg(result.payloadSize)
+        .arg(result.rttMinMs, 0, 'f', 2)
+        .arg(result.rttAvgMs, 0, 'f', 2)
+        .arg(result.rttP50Ms, 0, 'f', 2)
+        .arg(result.rttP95Ms, 0, 'f', 2)
+        .arg(result.rttMaxMs, 0, 'f', 2)
+        .arg(result.deviceAvgUs, 0, 'f', 1)
+        .arg(result.throughputBps, 0, 'f', 0)
+        .arg(result.lost)
+        .arg(result.samples + result.lost);
+}
+
+void LinkBenchmark::handleDataReceived(Command command, const QByteArray &data)
+{
+    if (!running || (command != Command::Echo))
+    {
+        return;
+    }
+
+    const double rttMs = rttTimer.nsecsElapsed() / 1e6;
+
+    if ((data.size() < ECHO_HEADER_SIZE) || (data.mid(ECHO_HEADER_SIZE) != currentPayload))
+    {
+        lost++;
+    }
+    else
+    {
+        const uchar *header = reinterpret_cast<const uchar *>(data.constData());
+        const quint32 coreClockHz = qFromLittleEndian<quint32>(header);
+        const quint32 rxTimestamp = qFromLittleEndian<quint32>(header + 4);
+        const quint32 txTimestamp = qFromLittleEndian<quint32>(header + 12);
+
+        if (coreClockHz > 0U)
+        {
+            /* Unsigned difference handles a cycle counter wrap between the two timestamps */
+            deviceSamples.append(static_cast<quint32>(txTimestamp - rxTimestamp) * 1e6 / coreClockHz);
+        }
+        rttSamples.append(rttMs);
+        emit sampleMeasured(currentPayloadSize, rttMs);
+    }
+
+    currentIteration++;
+    if (currentIteration >= settings.iterations)
+    {
+        finishPayloadSize();
+    }
+    else
+    {
+        sendNextEcho();
+    }
+}
+
+void LinkBenchmark::handleResponseTimeout(Command command)
+{
+    if (!running || (command != Command::Echo))
+    {
+        return;
+    }
+
+    lost++;
+    currentIteration++;
+    if (currentIteration >= settings.iterations)
+    {
+        finishPayloadSize();
+    }
+    else
+    {
+        sendNextEcho();
+    }
+}
+
+void LinkBenchmark::sendNextEcho()
+{
+    sequence++;
+    currentPayload = buildPayload(currentPayloadSize);
+    rttTimer.start();
+    bluetoothHandler->sendCommand(Command::Echo, currentPayload);
+}
+
+void LinkBenchmark::finishPayloadSize()
+{
+    Result result;
+
+    result.payloadSize = currentPayloadSize;
+    result.samples = rttSamples.size();
+    result.lost = lost;
+
+    if (!rttSamples.isEmpty())
+    {
+        QList<double> sorted = rttSamples;
+        std::sort(sorted.begin(), sorted.end());
+
+        auto percentile = [&sorted](double p)
+        {
+            const qsizetype index = qBound<qsizetype>(0, qCeil(p * sorted.size()) - 1, sorted.size() - 1);
+            return sorted.at(index);
+        };
+
+        result.rttMinMs = sorted.first();
+        result.rttMaxMs = sorted.last();
+        result.rttAvgMs = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+        result.rttP50Ms = percentile(0.50);
+        result.rttP95Ms = percentile(0.95);
+
+        /* Bytes on the wire in both directions for a single echo exchange */
+        const int exchangeBytes = packetSizeOnWire(currentPayloadSize) +
+                                  packetSizeOnWire(ECHO_HEADER_SIZE + currentPayloadSize);
+        if (result.rttAvgMs > 0.0)
+        {
+            result.throughputBps = exchangeBytes / (result.rttAvgMs / 1000.0);
+        }
+    }
+    if (!deviceSamples.isEmpty())
+    {
+        result.deviceAvgUs = std::accumulate(deviceSamples.begin(), deviceSamples.end(), 0.0) / deviceSamples.size();
+    }
+
+    results.append(result);
+    emit resultReady(result);
+
+    currentPayloadSize += settings.payloadStep;
+    currentIteration = 0;
+    lost = 0;
+    rttSamples.clear();
+    deviceSamples.clear();
+
+    if (currentPayloadSize > settings.maxPayloadSize)
+    {
+        running = false;
+        emit finished(results);
+    }
+    else
+    {
+        sendNextEcho();
+    }
+}
+
+int LinkBenchmark::packetSizeOnWire(int payloadSize) const
+{
+    const int version = bluetoothHandler->protocolVersion();
+
+    if (version == SCP::PROTOCOL_VERSION_1)
+    {
+        return PACKET_HEADER_SIZE + payloadSize;
+    }
+
+    const int packetSize = PACKET_HEADER_SIZE_V2 + payloadSize;
+    if (version == SCP::PROTOCOL_VERSION_2)
+    {
+        return packetSize;
+    }
+
+    /* COBS adds a code byte per started block of 254 bytes */
+    return packetSize + (packetSize / 254 + 1) + COBS_DELIMITERS_SIZE;
+}
+
+QByteArray LinkBenchmark::buildPayload(int size) const
+{
+    QByteArray payload(size, Qt::Uninitialized);
+
+    /* Sequence number first, so that a stale echo of a previous request is never accepted */
+    for (int i = 0; i < size; ++i)
+    {
+        payload[i] = static_cast<char>((i < 2) ? (sequence >> (8 * i)) : (i & 0xFF));
+    }
+
+    return payload;
+}
@@ -0,0 +1,81 @@
+#ifndef LINKBENCHMARK_H
+#define LINKBENCHMARK_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include "command.h"
+#include "bluetoothhandler.h"
+
+class LinkBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    struct Settings
+    {
+        int minPayloadSize = 0;
+        int maxPayloadSize = 184;
+        int payloadStep = 16;
+        int iterations = 50;
+    };
+
+    struct Result
+    {
+        int payloadSize = 0;
+        int samples = 0;
+        int lost = 0;
+        double rttMinMs = 0.0;
+        double rttAvgMs = 0.0;
+        double rttP50Ms = 0.0;
+        double rttP95Ms = 0.0;
+        double rttMaxMs = 0.0;
+        double deviceAvgUs = 0.0;
+        double throughputBps = 0.0;
+    };
+
+    /* Layout of the device timestamps prepended to every echo response */
+    static constexpr int ECHO_HEADER_SIZE = 16;
+    static constexpr int PACKET_HEADER_SIZE = 6;
+    static constexpr int PACKET_HEADER_SIZE_V2 = 9;
+    static constexpr int COBS_DELIMITERS_SIZE = 2;
+
+    explicit LinkBenchmark(BluetoothHandler *bluetoothHandler, QObject *parent = nullptr);
+
+    void start(const Settings &settings);
+    void stop();
+    bool isRunning() const;
+
+    static QString formatResult(const Result &result);
+
+signals:
+    void sampleMeasured(int payloadSize, double rttMs);
+    void resultReady(const LinkBenchmark::Result &result);
+    void finished(const QList<LinkBenchmark::Result> &results);
+    void errorOccurred(const QString &error);
+
+private slots:
+    void handleDataReceived(Command command, const QByteArray &data);
+    void handleResponseTimeout(Command command);
+
+private:
+    BluetoothHandler *bluetoothHandler;
+    Settings settings;
+    bool running;
+    int currentPayloadSize;
+    int currentIteration;
+    quint16 sequence;
+    int lost;
+    QByteArray currentPayload;
+    QElapsedTimer rttTimer;
+    QList<double> rttSamples;
+    QList<double> deviceSamples;
+    QList<Result> results;
+
+    void sendNextEcho();
+    void finishPayloadSize();
+    int packetSizeOnWire(int payloadSize) const;
+    QByteArray buildPayload(int size) const;
+};
+
+#endif // LINKBENCHMARK_H
@@ -1,9 +1,163 @@
 #include "mainwindow.h"
+#include "bluetoothhandler.h"
+#include "linkbenchmark.h"
+#include "framingbenchmark.h"
 
 #include <QApplication>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+
+static bool hasArgument(int argc, char *argv[], const char *argument)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        if (qstrcmp(argv[i], argument) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Headless link benchmark: discovers the device, runs the echo sweep and prints one line per payload size */
+static int runLinkBenchmark(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Linefollower SCP link benchmark");
+    parser.addHelpOption();
+
+    QCommandLineOption benchmarkOption("benchmark", "Run the link benchmark without GUI.");
+    QCommandLineOption deviceOption("device", "Bluetooth device name.", "name", "=Linefollower");
+    QCommandLineOption minSizeOption("min-size", "Minimal echo payload size [B].", "bytes", "0");
+    QCommandLineOption maxSizeOption("max-size", "Maximal echo payload size [B].", "bytes", "184");
+    QCommandLineOption stepOption("step", "Payload size step [B].", "bytes", "16");
+    QCommandLineOption iterationsOption("iterations", "Echo requests per payload size.", "count", "50");
+    parser.addOptions({benchmarkOption, deviceOption, minSizeOption, maxSizeOption, stepOption, iterationsOption});
+    parser.process(app);
+
+    LinkBenchmark::Settings settings;
+    settings.minPayloadSize = parser.value(minSizeOption).toInt();
+    settings.maxPayloadSize = parser.value(maxSizeOption).toInt();
+    settings.payloadStep = parser.value(stepOption).toInt();
+    settings.iterations = parser.value(iterationsOption).toInt();
+    const QString deviceName = parser.value(deviceOption);
+
+    BluetoothHandler bluetoothHandler;
+    LinkBenchmark linkBenchmark(&bluetoothHandler);
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    bool deviceFound = false;
+
+    QObject::connect(&bluetoothHandler, &BluetoothHandler::deviceFound, &app, [&](const QBluetoothDeviceInfo &device)
+                     {
+                         if (!deviceFound && (device.name() == deviceName))
+                         {
+                             deviceFound = true;
+                             out << "Connecting to " << device.name() << Qt::endl;
+                             bluetoothHandler.connectToDevice(device.address());
+                         }
+                     });
+    QObject::connect(&bluetoothHandler, &BluetoothHandler::discoveryFinished, &app, [&]()
+                     {
+                         if (!deviceFound)
+                         {
+                             err << "Device " << deviceName << " not found." << Qt::endl;
+                             app.exit(1);
+                         }
+                     });
+    QObject::connect(&bluetoothHandler, &BluetoothHandler::connectionEstablished, &app, [&]()
+                     { bluetoothHandler.stopDeviceDiscovery(); });
+    QObject::connect(&bluetoothHandler, &BluetoothHandler::protocolNegotiated, &app, [&](int version)
+                     {
+                         if (linkBenchmark.isRunning())
+                         {
+                             return;
+                         }
+                         out << "Protocol v" << version << ", max payload " << bluetoothHandler.maxPayloadSize() << " B" << Qt::endl;
+                         linkBenchmark.start(settings);
+                         if (!linkBenchmark.isRunning())
+                         {
+                             app.exit(1);
+                         }
+                     });
+    QObject::connect(&bluetoothHandler, &BluetoothHandler::connectionLost, &app, [&]()
+                     {
+                         err << "Connection lost." << Qt::endl;
+                         app.exit(1);
+                     });
+    QObject::connect(&bluetoothHandler, &BluetoothHandler::errorOccurred, &app, [&](const QString &error)
+                     { err << error << Qt::endl; });
+    QObject::connect(&linkBenchmark, &LinkBenchmark::errorOccurred, &app, [&](const QString &error)
+                     { err << error << Qt::endl; });
+    QObject::connect(&linkBenchmark, &LinkBenchmark::resultReady, &app, [&](const LinkBenchmark::Result &result)
+                     { out << LinkBenchmark::formatResult(result) << Qt::endl; });
+    QObject::connect(&linkBenchmark, &LinkBenchmark::finished, &app, [&](const QList<LinkBenchmark::Result> &results)
+                     {
+                         bool anyReceived = false;
+                         for (const LinkBenchmark::Result &result : results)
+                         {
+                             anyReceived = anyReceived || (result.samples > 0);
+                         }
+                         app.exit(anyReceived ? 0 : 1);
+                     });
+
+    bluetoothHandler.startDeviceDiscovery();
+
+    return app.exec();
+}
+
+/* Offline framing fuzzer: compares the resynchronisation of the unframed and COBS framed protocol versions */
+static int runFramingBenchmark(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Linefollower SCP framing fuzzer");
+    parser.addHelpOption();
+
+    QCommandLineOption fuzzOption("fuzz-framing", "Run the framing fuzzer without GUI.");
+    QCommandLineOption framesOption("frames", "Number of frames per protocol version.", "count", "10000");
+    QCommandLineOption errorRateOption("error-rate", "Probability of a frame being corrupted.", "rate", "0.05");
+    QCommandLineOption seedOption("seed", "Random generator seed.", "seed", "1");
+    QCommandLineOption maxSizeOption("max-size", "Maximal payload size [B].", "bytes", "255");
+    parser.addOptions({fuzzOption, framesOption, errorRateOption, seedOption, maxSizeOption});
+    parser.process(app);
+
+    FramingBenchmark::Settings settings;
+    settings.frames = parser.value(framesOption).toInt();
+    settings.errorRate = parser.value(errorRateOption).toDouble();
+    settings.seed = parser.value(seedOption).toUInt();
+    settings.maxPayloadSize = parser.value(maxSizeOption).toInt();
+
+    if ((settings.frames <= 0) || (settings.errorRate < 0.0) || (settings.errorRate > 1.0) || (settings.maxPayloadSize <= 0))
+    {
+        QTextStream(stderr) << "Invalid framing fuzzer settings." << Qt::endl;
+        return 1;
+    }
+
+    FramingBenchmark framingBenchmark;
+    QTextStream out(stdout);
+
+    for (const int version : {SCP::PROTOCOL_VERSION_1, SCP::PROTOCOL_VERSION_2, SCP::PROTOCOL_VERSION_3})
+    {
+        out << FramingBenchmark::formatResult(framingBenchmark.run(version, settings)) << Qt::endl;
+    }
+
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
+    if (hasArgument(argc, argv, "--fuzz-framing"))
+    {
+        QCoreApplication a(argc, argv);
+        return runFramingBenchmark(a);
+    }
+    if (hasArgument(argc, argv, "--benchmark"))
+    {
+        QCoreApplication a(argc, argv);
+        return runLinkBenchmark(a);
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -2,16 +2,21 @@
 #include "./ui_mainwindow.h"
 #include "debugdata.h"
 #include <QDateTime.h>
+#include <QtEndian>
 #include <QFileDialog>
 #include <QFile>
 #include <QTextStream>
 #include <QMessageBox>
+#include <algorithm>
+#include <bit>
+#include <cstring>
 
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent), ui(new Ui::MainWindow),
     bluetoothHandler(new BluetoothHandler(this)),
     bootloader(new Bootloader(bluetoothHandler, this)),
+    linkBenchmark(new LinkBenchmark(bluetoothHandler, this)),
     autoConnectInProgress(false),
     wasSpeedReduced(false),
     speedReducedStartTime(0),
@@ -26,6 +31,8 @@ MainWindow::MainWindow(QWidget *parent)
     motorPlot->setSeriesName("Motor Left");
     motorPlot->addSeries("Motor Right");
     motorPlot->addSeries("isSpeedReduced");
+    motorPlot->addSeries("Setpoint");
+    motorPlot->addSeries("Slip");
     QPen dashedPen(Qt::DashLine);
     dashedPen.setColor(Qt::red);
     QVBoxLayout *tab1Layout = new QVBoxLayout(ui->tabChart1);
@@ -41,6 +48,37 @@ MainWindow::MainWindow(QWidget *parent)
 
     motorPlot->setAxisRange(0, 0, -1, 3);
 
+    benchHistogramChart = new QChart();
+    benchHistogramChart->setTitle("RTT histogram");
+    benchHistogramChart->legend()->hide();
+    QChartView *benchHistogramView = new QChartView(benchHistogramChart, ui->widgetBenchHistogram);
+    benchHistogramView->setRenderHint(QPainter::Antialiasing);
+    QVBoxLayout *benchHistogramLayout = new QVBoxLayout(ui->widgetBenchHistogram);
+    benchHistogramLayout->setContentsMargins(0, 0, 0, 0);
+    benchHistogramLayout->addWidget(benchHistogramView);
+
+    trackMapChart = new QChart();
+    trackMapChart->setTitle("Track map");
+    trackMapChart->legend()->hide();
+    QChartView *trackMapView = new QChartView(trackMapChart, ui->widgetTrackMap);
+    trackMapView->setRenderHint(QPainter::Antialiasing);
+    QVBoxLayout *trackMapLayout = new QVBoxLayout(ui->widgetTrackMap);
+    trackMapLayout->setContentsMargins(0, 0, 0, 0);
+    trackMapLayout->addWidget(trackMapView);
+
+    speedProfileChart = new QChart();
+    speedProfileChart->setTitle("Speed profile");
+    QChartView *speedProfileView = new QChartView(speedProfileChart, ui->widgetSpeedProfile);
+    speedProfileView->setRenderHint(QPainter::Antialiasing);
+    QVBoxLayout *speedProfileLayout = new QVBoxLayout(ui->widgetSpeedProfile);
+    speedProfileLayout->setContentsMargins(0, 0, 0, 0);
+    speedProfileLayout->addWidget(speedProfileView);
+
+    ui->tableWidgetBenchResults->setColumnCount(8);
+    ui->tableWidgetBenchResults->setHorizontalHeaderLabels({"Payload [B]", "Lost", "RTT min [ms]", "RTT avg [ms]",
+                                                            "RTT p95 [ms]", "RTT max [ms]", "Device [us]", "Throughput [B/s]"});
+    ui->tableWidgetBenchResults->setEditTriggers(QAbstractItemView::NoEditTriggers);
+
     connect(bluetoothHandler, &BluetoothHandler::deviceFound, this, &MainWindow::captureDeviceProperties);
     connect(bluetoothHandler, &BluetoothHandler::discoveryFinished, this, &MainWindow::searchingFinished);
     connect(bluetoothHandler, &BluetoothHandler::connectionEstablished, this, &MainWindow::connectionEstablished);
@@ -48,12 +86,29 @@ MainWindow::MainWindow(QWidget *parent)
     connect(bluetoothHandler, &BluetoothHandler::dataReceived, this, &MainWindow::handleDataReceived);
     connect(bluetoothHandler, &BluetoothHandler::errorOccurred, this, [this](const QString &error)
             { addToLogs(error, false); });
+    connect(bluetoothHandler, &BluetoothHandler::protocolNegotiated, this, [this](int version)
+            { addToLogs(QString("SCP protocol v%1 negotiated, max payload %2 B").arg(version).arg(bluetoothHandler->maxPayloadSize()), false); });
 
     connect(bootloader, &Bootloader::errorOccurred, this, [this](const QString &error)
             {
                 addToLogs(error, false);
                 QMessageBox::warning(this, tr("Bootloader Error"), error);
             });
+    connect(linkBenchmark, &LinkBenchmark::errorOccurred, this, [this](const QString &error)
+            { addToLogs(error, false); });
+    connect(linkBenchmark, &LinkBenchmark::sampleMeasured, this, [this](int payloadSize, double rttMs)
+            {
+                Q_UNUSED(payloadSize);
+                benchRttSamples.append(rttMs);
+            });
+    connect(linkBenchmark, &LinkBenchmark::resultReady, this, &MainWindow::addBenchmarkResult);
+    connect(linkBenchmark, &LinkBenchmark::finished, this, [this](const QList<LinkBenchmark::Result> &results)
+            {
+                Q_UNUSED(results);
+                updateBenchmarkHistogram();
+                ui->pushButtonBenchStart->setEnabled(true);
+                addToLogs("Link benchmark finished", false);
+            });
     connect(bootloader, &Bootloader::progressUpdated, ui->progressBarBootloader, &QProgressBar::setValue);
     connect(bootloader, &Bootloader::errorOccurred, [this](const QString &error)
             {
@@ -155,7 +210,26 @@ void MainWindow::handleDataReceived(Command command, const QByteArray &data)
     {
     case Command::ReadNvmData:
     {
-        updateNvmLayout(data);
+        receiveNvmChunk(data);
+        break;
+    }
+    case Command::WriteNvmData:
+    {
+        /* The device answers each chunk, the next one is sent after the answer */
+        if (static_cast<NvmWriteResult>(data.at(0)) != NvmWriteResult::Ok)
+        {
+            addToLogs("NvM data chunk rejected, the layout of the device does not match.", false);
+            nvmWriteData.clear();
+            break;
+        }
+
+        const qsizetype written = qMin<qsizetype>(nvmWriteData.size(), NVMLayout::CHUNK_DATA_SIZE);
+
+        nvmWriteData.remove(0, written);
+        if (!nvmWriteData.isEmpty())
+        {
+            sendNvmWriteChunk(static_cast<uint16_t>(NVMLayout().size() - nvmWriteData.size()));
+        }
         break;
     }
     case Command::DebugData:
@@ -190,6 +264,138 @@ void MainWindow::handleDataReceived(Command command, const QByteArray &data)
         addToLogs("Active session: " + session, false);
         break;
     }
+    case Command::SetParams:
+    {
+        const auto result = static_cast<ParamResult>(data.at(0));
+
+        if (result != ParamResult::Ok)
+        {
+            const uint16_t id = qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(data.constData()) + 1);
+            addToLogs(QString("Parameter 0x%1 rejected (%2), read the NvM before the next write.")
+                          .arg(id, 4, 16, QChar('0'))
+                          .arg(static_cast<int>(result)), true);
+            deviceNvmLayout.reset();
+        }
+        break;
+    }
+    case Command::Calibrate:
+    {
+        const uint16_t failedChannels = qFromLittleEndian<quint16>(reinterpret_cast<const uchar *>(data.constData()));
+
+        if (failedChannels == 0)
+        {
+            addToLogs("Calibration complete.", true);
+        }
+        else
+        {
+            QString channels;
+            for (size_t i = 0; i < NVMLayout::SENSORS_NUMBER; ++i)
+            {
+                if (failedChannels & (1U << i))
+                {
+                    channels.append(QString(" %1").arg(i + 1));
+                }
+            }
+            addToLogs("Calibration failed for sensors:" + channels + ", previous values kept.", false);
+        }
+        /* Show the new thresholds */
+        sendNvmReadRequest(0);
+        break;
+    }
+    case Command::IdentifyMotors:
+        if (data.at(0) == 0)
+        {
+            addToLogs("Motor identification complete.", true);
+            /* Show the new motor curves */
+            sendNvmReadRequest(0);
+        }
+        else
+        {
+            addToLogs("Motor identification failed or stopped, previous motor curves kept.", false);
+        }
+        break;
+    case Command::CalibrationProgress:
+    {
+        /* {sweeps, stable channels mask, failed channels mask, elapsed ms} */
+        const auto *bytes = reinterpret_cast<const uchar *>(data.constData());
+        const uint16_t stableChannels = qFromLittleEndian<quint16>(bytes + 1);
+        const uint16_t failedChannels = qFromLittleEndian<quint16>(bytes + 3);
+        const uint16_t elapsed = qFromLittleEndian<quint16>(bytes + 5);
+
+        addToLogs(QString("Calibration sweep %1 (%2 ms): %3/%4 sensors stable, %5 without contrast")
+                      .arg(bytes[0])
+                      .arg(elapsed)
+                      .arg(std::popcount(stableChannels))
+                      .arg(NVMLayout::SENSORS_NUMBER)
+                      .arg(std::popcount(failedChannels)), true);
+        break;
+    }
+    case Command::GetProfiles:
+    {
+        updateProfiles(data);
+        break;
+    }
+    case Command::SelectProfile:
+    case Command::CloneProfile:
+    {
+        const auto result = static_cast<ProfileResult>(data.at(0));
+        if (result == ProfileResult::Ok)
+        {
+            /* The active layout may have changed, refresh the profiles and the parameters */
+            bluetoothHandler->sendCommand(Command::GetProfiles, nullptr);
+            sendNvmReadRequest(0);
+        }
+        else if (result == ProfileResult::Uncommitted)
+        {
+            addToLogs("Commit the parameter changes before switching or cloning profiles", true);
+        }
+        else
+        {
+            addToLogs("Invalid profile", true);
+        }
+        break;
+    }
+    case Command::DiffProfiles:
+    {
+        logProfileDiff(data);
+        break;
+    }
+    case Command::GetTrackMap:
+    {
+        updateTrackMap(data);
+        break;
+    }
+    case Command::Autotune:
+    {
+        confirmAutotuneResult(data);
+        break;
+    }
+    case Command::GetEventLog:
+    {
+        updateEventLog(data);
+        break;
+    }
+    case Command::GetNvmStatus:
+    case Command::CommitParams:
+    case Command::StoreThresholds:
+    {
+        switch (static_cast<NvmStatus>(data.at(0)))
+        {
+        case NvmStatus::Complete:
+            addToLogs("NVM data stored.", true);
+            break;
+        case NvmStatus::Pending:
+            addToLogs("NVM write postponed until the robot stops.", false);
+            break;
+        case NvmStatus::Busy:
+            addToLogs("NVM write in progress.", false);
+            break;
+        case NvmStatus::Failed:
+            addToLogs("NVM write failed.", true);
+            break;
+        }
+        break;
+    }
     default:
         break;
     }
@@ -245,6 +451,14 @@ void MainWindow::on_pushButtonStop_clicked()
     }
 }
 
+void MainWindow::on_pushButtonMapLap_clicked()
+{
+    QByteArray data;
+    data.append(static_cast<char>(CommandSetMode::Map));
+    bluetoothHandler->sendCommand(Command::SetMode, data);
+    addToLogs("Mapping lap started, stop the robot at the end of the lap and read the map", true);
+}
+
 void MainWindow::on_pushButtonReset_clicked()
 {
     bluetoothHandler->sendCommand(Command::Reset, nullptr);
@@ -257,6 +471,39 @@ void MainWindow::on_pushButtonCalibrate_clicked()
     addToLogs("Calibrate command sent", true);
 }
 
+void MainWindow::on_pushButtonStoreThresholds_clicked()
+{
+    bluetoothHandler->sendCommand(Command::StoreThresholds, nullptr);
+    addToLogs("Store adapted thresholds command sent", true);
+}
+
+void MainWindow::on_pushButtonIdentifyMotors_clicked()
+{
+    bluetoothHandler->sendCommand(Command::IdentifyMotors, nullptr);
+    addToLogs("Motor identification started, the robot spins in place", true);
+}
+
+void MainWindow::on_pushButtonAutotuneWheels_clicked()
+{
+    QByteArray data;
+    data.append(static_cast<char>(CommandAutotune::Wheels));
+    bluetoothHandler->sendCommand(Command::Autotune, data);
+    addToLogs("Wheel PID autotune started, the robot spins in place", true);
+}
+
+void MainWindow::on_pushButtonAutotuneLine_clicked()
+{
+    QByteArray data;
+    data.append(static_cast<char>(CommandAutotune::Line));
+    bluetoothHandler->sendCommand(Command::Autotune, data);
+    addToLogs("Line PID autotune started, the robot follows the line slowly", true);
+}
+
+void MainWindow::on_pushButtonReadEventLog_clicked()
+{
+    sendEventLogRequest(0);
+}
+
 void MainWindow::on_radioButtonDebugMode_clicked(bool checked)
 {
     QByteArray data;
@@ -280,13 +527,162 @@ void MainWindow::on_radioButtonDebugMode_clicked(bool checked)
 
 void MainWindow::on_pushButtonReadNvm_clicked()
 {
-    bluetoothHandler->sendCommand(Command::ReadNvmData, nullptr);
+    sendNvmReadRequest(0);
+    bluetoothHandler->sendCommand(Command::GetProfiles, nullptr);
     addToLogs("Read NvM command sent", true);
 }
 
 void MainWindow::on_pushButtonWriteNvm_clicked()
 {
-    NVMLayout nvmLayout;
+    const NVMLayout nvmLayout = nvmLayoutFromUi();
+
+    if (deviceNvmLayout)
+    {
+        sendChangedParameters(nvmLayout);
+    }
+    else
+    {
+        nvmWriteData.resize(nvmLayout.size());
+        nvmLayout.serializeToArray(reinterpret_cast<uint8_t *>(nvmWriteData.data()));
+
+        sendNvmWriteChunk(0);
+
+        addToLogs("Write NvM command sent", true);
+    }
+
+    deviceNvmLayout = nvmLayout;
+}
+
+void MainWindow::sendChangedParameters(const NVMLayout &nvmLayout)
+{
+    const std::vector<NVMLayout::Parameter> changed = nvmLayout.changedParameters(*deviceNvmLayout);
+
+    if (changed.empty())
+    {
+        addToLogs("No parameter changed", true);
+        return;
+    }
+
+    for (size_t first = 0; first < changed.size(); first += NVMLayout::MAX_PARAMS_PER_PACKET)
+    {
+        const size_t last = std::min(changed.size(), first + NVMLayout::MAX_PARAMS_PER_PACKET);
+        QByteArray data;
+
+        for (size_t i = first; i < last; ++i)
+        {
+            data.append(static_cast<char>(changed[i].id & 0xFF));
+            data.append(static_cast<char>(changed[i].id >> 8));
+            data.append(reinterpret_cast<const char *>(changed[i].value.data()), changed[i].value.size());
+        }
+        bluetoothHandler->sendCommand(Command::SetParams, data);
+    }
+    bluetoothHandler->sendCommand(Command::CommitParams, QByteArray());
+
+    addToLogs(QString("%1 changed parameters sent").arg(changed.size()), true);
+}
+
+void MainWindow::on_pushButtonProfileSelect_clicked()
+{
+    QByteArray data;
+    data.append(static_cast<char>(ui->comboBoxProfile->currentIndex()));
+    bluetoothHandler->sendCommand(Command::SelectProfile, data);
+    addToLogs("Select profile command sent", true);
+}
+
+void MainWindow::on_pushButtonProfileClone_clicked()
+{
+    QString name = ui->lineEditProfileName->text();
+
+    if (name.isEmpty())
+    {
+        name = ui->comboBoxProfileTarget->currentText();
+    }
+
+    QByteArray data;
+    data.append(static_cast<char>(ui->comboBoxProfile->currentIndex()));
+    data.append(static_cast<char>(ui->comboBoxProfileTarget->currentIndex()));
+    data.append(name.toLatin1().left(NVMLayout::PROFILE_NAME_SIZE).leftJustified(NVMLayout::PROFILE_NAME_SIZE, '\0'));
+
+    bluetoothHandler->sendCommand(Command::CloneProfile, data);
+    addToLogs("Clone profile command sent", true);
+}
+
+void MainWindow::on_pushButtonProfileDiff_clicked()
+{
+    const auto profileA = static_cast<uint8_t>(ui->comboBoxProfile->currentIndex());
+    const auto profileB = static_cast<uint8_t>(ui->comboBoxProfileTarget->currentIndex());
+
+    addToLogs(QString("Differences between %1 and %2:")
+                  .arg(ui->comboBoxProfile->currentText(), ui->comboBoxProfileTarget->currentText()), false);
+    sendDiffProfilesRequest(profileA, profileB, 0);
+}
+
+void MainWindow::sendDiffProfilesRequest(uint8_t profileA, uint8_t profileB, uint16_t firstId)
+{
+    QByteArray data;
+    data.append(static_cast<char>(profileA));
+    data.append(static_cast<char>(profileB));
+    data.append(static_cast<char>(firstId & 0xFF));
+    data.append(static_cast<char>(firstId >> 8));
+    bluetoothHandler->sendCommand(Command::DiffProfiles, data);
+}
+
+void MainWindow::updateProfiles(const QByteArray &data)
+{
+    const int activeProfile = static_cast<uint8_t>(data.at(0));
+    const int sourceIndex = ui->comboBoxProfile->currentIndex();
+    const int targetIndex = ui->comboBoxProfileTarget->currentIndex();
+
+    ui->comboBoxProfile->clear();
+    ui->comboBoxProfileTarget->clear();
+
+    for (size_t i = 0; i < NVMLayout::PROFILES_NUMBER; ++i)
+    {
+        const char *name = data.constData() + 1 + i * NVMLayout::PROFILE_NAME_SIZE;
+        const QString profileName = QString::fromLatin1(name, qstrnlen(name, NVMLayout::PROFILE_NAME_SIZE));
+
+        ui->comboBoxProfile->addItem(profileName);
+        ui->comboBoxProfileTarget->addItem(profileName);
+    }
+
+    ui->comboBoxProfile->setCurrentIndex(sourceIndex < 0 ? activeProfile : sourceIndex);
+    ui->comboBoxProfileTarget->setCurrentIndex(targetIndex < 0 ? 0 : targetIndex);
+
+    addToLogs("Active profile: " + ui->comboBoxProfile->itemText(activeProfile), false);
+}
+
+void MainWindow::logProfileDiff(const QByteArray &data)
+{
+    const auto *bytes = reinterpret_cast<const uint8_t *>(data.constData());
+    const size_t count = (data.size() - 2) / NVMLayout::PROFILE_DIFF_ENTRY_SIZE;
+    uint16_t id = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const uint8_t *entry = bytes + 2 + i * NVMLayout::PROFILE_DIFF_ENTRY_SIZE;
+        id = qFromLittleEndian<quint16>(entry);
+
+        addToLogs(QString("0x%1: %2 / %3")
+                      .arg(id, 4, 16, QChar('0'))
+                      .arg(NVMLayout::parameterValueToString(id, entry + 2),
+                           NVMLayout::parameterValueToString(id, entry + 6)), false);
+    }
+
+    /* A full response may be followed by more differences */
+    if (count == NVMLayout::MAX_DIFFS_PER_PACKET)
+    {
+        sendDiffProfilesRequest(bytes[0], bytes[1], id + 1);
+    }
+    else
+    {
+        addToLogs("Diff complete", false);
+    }
+}
+
+NVMLayout MainWindow::nvmLayoutFromUi() const
+{
+    /* Fields without a control, like the sensors normalization, keep the values read from the device */
+    NVMLayout nvmLayout = deviceNvmLayout.value_or(NVMLayout());
 
     QLineEdit *const sensorWeights[NVMLayout::SENSORS_NUMBER] = {
         ui->lineEditSensorWeight1, ui->lineEditSensorWeight2, ui->lineEditSensorWeight3,
@@ -308,7 +704,58 @@ void MainWindow::on_pushButtonWriteNvm_clicked()
     nvmLayout.sensors.errorThreshold = ui->lineEditErrorThreshold->text().toFloat();
     nvmLayout.sensors.fallbackErrorPositive = ui->lineEditfallbackPositive->text().toFloat();
     nvmLayout.sensors.fallbackErrorNegative = ui->lineEditfallbackNegative->text().toFloat();
+    nvmLayout.lineLossDecay = ui->lineEditLineLossDecay->text().toFloat();
     nvmLayout.targetSpeed = ui->lineEditTargetSpeed->text().toFloat();
+    nvmLayout.speedProfile.maxSpeed = ui->lineEditProfileMaxSpeed->text().toFloat();
+    nvmLayout.speedProfile.maxLateralAccel = ui->lineEditProfileLateralAccel->text().toFloat();
+    nvmLayout.speedProfile.maxDecel = ui->lineEditProfileDecel->text().toFloat();
+    nvmLayout.speedProfile.fallbackError = ui->lineEditProfileFallbackError->text().toFloat();
+    nvmLayout.straightBoost.speed = ui->lineEditBoostSpeed->text().toFloat();
+    nvmLayout.straightBoost.accel = ui->lineEditBoostAccel->text().toFloat();
+    nvmLayout.straightBoost.exitError = ui->lineEditBoostExitError->text().toFloat();
+    nvmLayout.straightBoost.holdDistance = ui->lineEditBoostHoldDistance->text().toFloat();
+    nvmLayout.straightBoost.holdTime = ui->lineEditBoostHoldTime->text().toUInt();
+    nvmLayout.motorModel.gain = ui->lineEditFeedforwardGain->text().toFloat();
+    nvmLayout.drive.reversePolicy = static_cast<uint16_t>(ui->comboBoxReversePolicy->currentIndex());
+    nvmLayout.drive.maxReversePwm = static_cast<uint16_t>(ui->lineEditMaxReversePwm->text().toUInt());
+    nvmLayout.trajectory.launchAccel = ui->lineEditLaunchAccel->text().toFloat();
+    nvmLayout.trajectory.cruiseAccel = ui->lineEditCruiseAccel->text().toFloat();
+    nvmLayout.trajectory.brakeDecel = ui->lineEditBrakeDecel->text().toFloat();
+    nvmLayout.trajectory.jerk = ui->lineEditJerk->text().toFloat();
+    nvmLayout.traction.maxAccelError = ui->lineEditSlipAccelError->text().toFloat();
+    nvmLayout.traction.maxSlipSpeed = ui->lineEditSlipSpeed->text().toFloat();
+    nvmLayout.traction.pwmFactor = ui->lineEditSlipPwmFactor->text().toFloat();
+    nvmLayout.traction.holdTime = ui->lineEditSlipHoldTime->text().toUInt();
+
+    /* Breakpoints missing in the comma separated list keep their values */
+    auto curveFromUi = [](const QLineEdit *lineEdit, std::array<float, NVMLayout::SPEED_CURVE_POINTS> &values)
+    {
+        const QStringList items = lineEdit->text().split(',', Qt::SkipEmptyParts);
+
+        for (size_t i = 0; (i < values.size()) && (i < static_cast<size_t>(items.size())); ++i)
+        {
+            values[i] = items[i].trimmed().toFloat();
+        }
+    };
+    curveFromUi(ui->lineEditCurveErrors, nvmLayout.speedSchedule.error.inputs);
+    curveFromUi(ui->lineEditCurveErrorFactors, nvmLayout.speedSchedule.error.factors);
+    curveFromUi(ui->lineEditCurveRates, nvmLayout.speedSchedule.errorRate.inputs);
+    curveFromUi(ui->lineEditCurveRateFactors, nvmLayout.speedSchedule.errorRate.factors);
+
+    auto gainsFromUi = [](const QLineEdit *lineEdit, std::array<float, NVMLayout::GAIN_SCHEDULE_POINTS> &values)
+    {
+        const QStringList items = lineEdit->text().split(',', Qt::SkipEmptyParts);
+
+        for (size_t i = 0; (i < values.size()) && (i < static_cast<size_t>(items.size())); ++i)
+        {
+            values[i] = items[i].trimmed().toFloat();
+        }
+    };
+    gainsFromUi(ui->lineEditGainSpeeds, nvmLayout.sensorGainSchedule.speeds);
+    gainsFromUi(ui->lineEditGainKp, nvmLayout.sensorGainSchedule.kp);
+    gainsFromUi(ui->lineEditGainKi, nvmLayout.sensorGainSchedule.ki);
+    gainsFromUi(ui->lineEditGainKd, nvmLayout.sensorGainSchedule.kd);
+
     nvmLayout.timerTimeout[static_cast<size_t>(NVMLayout::LF_Timers::LF_TIMER_NO_LINE_DETECTED)] = ui->lineEditNoLineDetectedTimeout->text().toFloat();
     nvmLayout.timerTimeout[static_cast<size_t>(NVMLayout::LF_Timers::LF_TIMER_REDUCED_SPEED)] = ui->lineEditAngleReducedSpeed->text().toFloat();
     nvmLayout.timerTimeout[static_cast<size_t>(NVMLayout::LF_Timers::LF_TIMER_SENSORS_STABILIZE)] = ui->lineEditSensorsStabilizeTime->text().toFloat();
@@ -345,12 +792,75 @@ void MainWindow::on_pushButtonWriteNvm_clicked()
         settings.pid.outputMin = settings.lineEditOutputMin->text().toFloat();
     }
 
-    QByteArray data(nvmLayout.size(), Qt::Uninitialized);
-    nvmLayout.serializeToArray(reinterpret_cast<uint8_t *>(data.data()));
+    return nvmLayout;
+}
 
-    bluetoothHandler->sendCommand(Command::WriteNvmData, data);
+void MainWindow::sendNvmReadRequest(uint16_t offset)
+{
+    QByteArray data;
+    data.append(static_cast<char>(offset & 0xFF));
+    data.append(static_cast<char>(offset >> 8));
+    bluetoothHandler->sendCommand(Command::ReadNvmData, data);
+}
+
+void MainWindow::receiveNvmChunk(const QByteArray &data)
+{
+    if (static_cast<size_t>(data.size()) < NVMLayout::CHUNK_HEADER_SIZE)
+    {
+        return;
+    }
+
+    const auto *bytes = reinterpret_cast<const uchar *>(data.constData());
+    const uint16_t total = qFromLittleEndian<quint16>(bytes);
+    const uint16_t offset = qFromLittleEndian<quint16>(bytes + 2);
+    const uint8_t count = bytes[4];
+
+    if (total != NVMLayout().size())
+    {
+        addToLogs(QString("NvM layout of the device (%1 bytes) does not match the application (%2 bytes).")
+                      .arg(total)
+                      .arg(NVMLayout().size()), false);
+        return;
+    }
+    if ((static_cast<size_t>(data.size()) != (NVMLayout::CHUNK_HEADER_SIZE + count)) || ((offset + count) > total))
+    {
+        return;
+    }
+
+    if (offset == 0)
+    {
+        nvmReadData.clear();
+    }
+    /* Chunks of an overlapping read of the layout are dropped, only one read continues */
+    if (offset != nvmReadData.size())
+    {
+        return;
+    }
+    nvmReadData.append(data.mid(NVMLayout::CHUNK_HEADER_SIZE));
 
-    addToLogs("Write NvM command sent", true);
+    if (nvmReadData.size() < total)
+    {
+        sendNvmReadRequest(static_cast<uint16_t>(nvmReadData.size()));
+    }
+    else
+    {
+        updateNvmLayout(nvmReadData);
+    }
+}
+
+void MainWindow::sendNvmWriteChunk(uint16_t offset)
+{
+    const uint16_t total = static_cast<uint16_t>(NVMLayout().size());
+    const QByteArray chunk = nvmWriteData.left(NVMLayout::CHUNK_DATA_SIZE);
+
+    QByteArray data;
+    data.append(static_cast<char>(total & 0xFF));
+    data.append(static_cast<char>(total >> 8));
+    data.append(static_cast<char>(offset & 0xFF));
+    data.append(static_cast<char>(offset >> 8));
+    data.append(static_cast<char>(chunk.size()));
+    data.append(chunk);
+    bluetoothHandler->sendCommand(Command::WriteNvmData, data);
 }
 
 void MainWindow::updateNvmLayout(const QByteArray &data)
@@ -358,6 +868,7 @@ void MainWindow::updateNvmLayout(const QByteArray &data)
     NVMLayout nvmLayout;
 
     nvmLayout.parseFromArray(reinterpret_cast<const uint8_t *>(data.data()));
+    deviceNvmLayout = nvmLayout;
 
     QLineEdit *const sensorWeights[NVMLayout::SENSORS_NUMBER] = {
         ui->lineEditSensorWeight1, ui->lineEditSensorWeight2, ui->lineEditSensorWeight3,
@@ -379,7 +890,59 @@ void MainWindow::updateNvmLayout(const QByteArray &data)
     ui->lineEditErrorThreshold->setText(QString::number(nvmLayout.sensors.errorThreshold));
     ui->lineEditfallbackPositive->setText(QString::number(nvmLayout.sensors.fallbackErrorPositive));
     ui->lineEditfallbackNegative->setText(QString::number(nvmLayout.sensors.fallbackErrorNegative));
+    ui->lineEditLineLossDecay->setText(QString::number(nvmLayout.lineLossDecay));
     ui->lineEditTargetSpeed->setText(QString::number(nvmLayout.targetSpeed));
+    ui->lineEditProfileMaxSpeed->setText(QString::number(nvmLayout.speedProfile.maxSpeed));
+    ui->lineEditProfileLateralAccel->setText(QString::number(nvmLayout.speedProfile.maxLateralAccel));
+    ui->lineEditProfileDecel->setText(QString::number(nvmLayout.speedProfile.maxDecel));
+    ui->lineEditProfileFallbackError->setText(QString::number(nvmLayout.speedProfile.fallbackError));
+    ui->lineEditBoostSpeed->setText(QString::number(nvmLayout.straightBoost.speed));
+    ui->lineEditBoostAccel->setText(QString::number(nvmLayout.straightBoost.accel));
+    ui->lineEditBoostExitError->setText(QString::number(nvmLayout.straightBoost.exitError));
+    ui->lineEditBoostHoldDistance->setText(QString::number(nvmLayout.straightBoost.holdDistance));
+    ui->lineEditBoostHoldTime->setText(QString::number(nvmLayout.straightBoost.holdTime));
+    ui->lineEditFeedforwardGain->setText(QString::number(nvmLayout.motorModel.gain));
+    ui->comboBoxReversePolicy->setCurrentIndex(nvmLayout.drive.reversePolicy);
+    ui->lineEditMaxReversePwm->setText(QString::number(nvmLayout.drive.maxReversePwm));
+    ui->lineEditLaunchAccel->setText(QString::number(nvmLayout.trajectory.launchAccel));
+    ui->lineEditCruiseAccel->setText(QString::number(nvmLayout.trajectory.cruiseAccel));
+    ui->lineEditBrakeDecel->setText(QString::number(nvmLayout.trajectory.brakeDecel));
+    ui->lineEditJerk->setText(QString::number(nvmLayout.trajectory.jerk));
+    ui->lineEditSlipAccelError->setText(QString::number(nvmLayout.traction.maxAccelError));
+    ui->lineEditSlipSpeed->setText(QString::number(nvmLayout.traction.maxSlipSpeed));
+    ui->lineEditSlipPwmFactor->setText(QString::number(nvmLayout.traction.pwmFactor));
+    ui->lineEditSlipHoldTime->setText(QString::number(nvmLayout.traction.holdTime));
+
+    auto curveToUi = [](QLineEdit *lineEdit, const std::array<float, NVMLayout::SPEED_CURVE_POINTS> &values)
+    {
+        QStringList items;
+
+        for (float value : values)
+        {
+            items.append(QString::number(value));
+        }
+        lineEdit->setText(items.join(", "));
+    };
+    curveToUi(ui->lineEditCurveErrors, nvmLayout.speedSchedule.error.inputs);
+    curveToUi(ui->lineEditCurveErrorFactors, nvmLayout.speedSchedule.error.factors);
+    curveToUi(ui->lineEditCurveRates, nvmLayout.speedSchedule.errorRate.inputs);
+    curveToUi(ui->lineEditCurveRateFactors, nvmLayout.speedSchedule.errorRate.factors);
+
+    auto gainsToUi = [](QLineEdit *lineEdit, const std::array<float, NVMLayout::GAIN_SCHEDULE_POINTS> &values)
+    {
+        QStringList items;
+
+        for (float value : values)
+        {
+            items.append(QString::number(value));
+        }
+        lineEdit->setText(items.join(", "));
+    };
+    gainsToUi(ui->lineEditGainSpeeds, nvmLayout.sensorGainSchedule.speeds);
+    gainsToUi(ui->lineEditGainKp, nvmLayout.sensorGainSchedule.kp);
+    gainsToUi(ui->lineEditGainKi, nvmLayout.sensorGainSchedule.ki);
+    gainsToUi(ui->lineEditGainKd, nvmLayout.sensorGainSchedule.kd);
+
     ui->lineEditNoLineDetectedTimeout->setText(QString::number( nvmLayout.timerTimeout[static_cast<size_t>(NVMLayout::LF_Timers::LF_TIMER_NO_LINE_DETECTED)]));
     ui->lineEditAngleReducedSpeed->setText(QString::number( nvmLayout.timerTimeout[static_cast<size_t>(NVMLayout::LF_Timers::LF_TIMER_REDUCED_SPEED)]));
     ui->lineEditSensorsStabilizeTime->setText(QString::number( nvmLayout.timerTimeout[static_cast<size_t>(NVMLayout::LF_Timers::LF_TIMER_SENSORS_STABILIZE)]));
@@ -444,7 +1007,8 @@ void MainWindow::updateDebugData(const QByteArray &data)
     for (int i = 0; i < DebugData::SENSORS_NUMBER; ++i)
     {
         sensorValues[i]->setText(QString::number(debugData.sensorValues[i]));
-        sensorLeds[i]->setOn(debugData.sensorValues[i] > 3000);
+        sensorValues[i]->setToolTip(QString("Threshold: %1").arg(debugData.thresholds[i]));
+        sensorLeds[i]->setOn(debugData.sensorValues[i] > debugData.thresholds[i]);
     }
 
     qint64 currentTime = QDateTime::currentMSecsSinceEpoch() - plotStartTime;
@@ -452,6 +1016,8 @@ void MainWindow::updateDebugData(const QByteArray &data)
     motorPlot->addDataPoint(0, currentTime, debugData.motorLeftVelocity);
     motorPlot->addDataPoint(1, currentTime, debugData.motorRightVelocity);
     motorPlot->addDataPoint(2, currentTime, debugData.isSpeedReduced ? 1.0 : 0.0);
+    motorPlot->addDataPoint(3, currentTime, debugData.setpointSpeed);
+    motorPlot->addDataPoint(4, currentTime, (debugData.slipMask != 0) ? 1.0 : 0.0);
 
     if (debugData.isSpeedReduced)
     {
@@ -580,3 +1146,364 @@ void MainWindow::on_pushButtonBootGetSession_clicked()
     bluetoothHandler->sendCommand(Command::GetActiveSession, nullptr);
     addToLogs("Get session command sent", true);
 }
+
+void MainWindow::on_pushButtonBenchStart_clicked()
+{
+    LinkBenchmark::Settings settings;
+
+    settings.minPayloadSize = ui->spinBoxBenchMinSize->value();
+    settings.maxPayloadSize = ui->spinBoxBenchMaxSize->value();
+    settings.payloadStep = ui->spinBoxBenchStep->value();
+    settings.iterations = ui->spinBoxBenchIterations->value();
+
+    benchRttSamples.clear();
+    ui->tableWidgetBenchResults->setRowCount(0);
+
+    linkBenchmark->start(settings);
+
+    if (linkBenchmark->isRunning())
+    {
+        ui->pushButtonBenchStart->setEnabled(false);
+        addToLogs("Link benchmark started", true);
+    }
+}
+
+void MainWindow::on_pushButtonBenchStop_clicked()
+{
+    linkBenchmark->stop();
+}
+
+void MainWindow::addBenchmarkResult(const LinkBenchmark::Result &result)
+{
+    const int row = ui->tableWidgetBenchResults->rowCount();
+    const QStringList values = {
+        QString::number(result.payloadSize),
+        QString("%1/%2").arg(result.lost).arg(result.samples + result.lost),
+        QString::number(result.rttMinMs, 'f', 2),
+        QString::number(result.rttAvgMs, 'f', 2),
+        QString::number(result.rttP95Ms, 'f', 2),
+        QString::number(result.rttMaxMs, 'f', 2),
+        QString::number(result.deviceAvgUs, 'f', 1),
+        QString::number(result.throughputBps, 'f', 0)};
+
+    ui->tableWidgetBenchResults->insertRow(row);
+    for (int column = 0; column < values.size(); ++column)
+    {
+        ui->tableWidgetBenchResults->setItem(row, column, new QTableWidgetItem(values[column]));
+    }
+
+    addToLogs(LinkBenchmark::formatResult(result), true);
+}
+
+void MainWindow::updateBenchmarkHistogram()
+{
+    benchHistogramChart->removeAllSeries();
+    for (QAbstractAxis *axis : benchHistogramChart->axes())
+    {
+        benchHistogramChart->removeAxis(axis);
+        delete axis;
+    }
+
+    if (benchRttSamples.isEmpty())
+    {
+        return;
+    }
+
+    const auto [minIt, maxIt] = std::minmax_element(benchRttSamples.cbegin(), benchRttSamples.cend());
+    const double minRtt = *minIt;
+    const double binWidth = qMax((*maxIt - minRtt) / BENCH_HISTOGRAM_BINS, 0.01);
+
+    QList<qreal> counts(BENCH_HISTOGRAM_BINS, 0.0);
+    for (double rtt : benchRttSamples)
+    {
+        const int bin = qMin(static_cast<int>((rtt - minRtt) / binWidth), BENCH_HISTOGRAM_BINS - 1);
+        counts[bin] += 1.0;
+    }
+
+    QBarSet *barSet = new QBarSet("RTT");
+    QStringList categories;
+    for (int i = 0; i < BENCH_HISTOGRAM_BINS; ++i)
+    {
+        barSet->append(counts[i]);
+        categories.append(QString::number(minRtt + i * binWidth, 'f', 1));
+    }
+
+    QBarSeries *barSeries = new QBarSeries();
+    barSeries->setBarWidth(1.0);
+    barSeries->append(barSet);
+    benchHistogramChart->addSeries(barSeries);
+
+    QBarCategoryAxis *axisX = new QBarCategoryAxis();
+    axisX->append(categories);
+    axisX->setTitleText("RTT [ms]");
+    benchHistogramChart->addAxis(axisX, Qt::AlignBottom);
+    barSeries->attachAxis(axisX);
+
+    QValueAxis *axisY = new QValueAxis();
+    axisY->setRange(0, *std::max_element(counts.cbegin(), counts.cend()));
+    axisY->setTitleText("Count");
+    benchHistogramChart->addAxis(axisY, Qt::AlignLeft);
+    barSeries->attachAxis(axisY);
+}
+
+void MainWindow::on_pushButtonReadMap_clicked()
+{
+    sendTrackMapRequest(0);
+}
+
+void MainWindow::sendTrackMapRequest(uint16_t firstSegment)
+{
+    QByteArray data;
+    data.append(static_cast<char>(firstSegment & 0xFF));
+    data.append(static_cast<char>(firstSegment >> 8));
+    bluetoothHandler->sendCommand(Command::GetTrackMap, data);
+}
+
+void MainWindow::updateTrackMap(const QByteArray &data)
+{
+    if (static_cast<size_t>(data.size()) < TrackMap::HEADER_SIZE)
+    {
+        return;
+    }
+
+    const uint16_t next = trackMap.parsePacket(reinterpret_cast<const uint8_t *>(data.constData()), data.size());
+
+    /* A map longer than one packet is read with several requests */
+    if (next < trackMap.total)
+    {
+        sendTrackMapRequest(next);
+        return;
+    }
+
+    switch (trackMap.state)
+    {
+    case TrackMap::State::Empty:
+        addToLogs("No track map recorded, run a mapping lap first.", false);
+        break;
+    case TrackMap::State::Recording:
+        addToLogs("Track map is being recorded, stop the robot first.", false);
+        break;
+    case TrackMap::State::Ready:
+        addToLogs(QString("Track map read: %1 segments, %2 m")
+                      .arg(trackMap.segments.size())
+                      .arg(trackMap.length(), 0, 'f', 2), false);
+        break;
+    }
+
+    updateTrackMapCharts();
+}
+
+void MainWindow::updateTrackMapCharts()
+{
+    for (QChart *chart : {trackMapChart, speedProfileChart})
+    {
+        chart->removeAllSeries();
+        for (QAbstractAxis *axis : chart->axes())
+        {
+            chart->removeAxis(axis);
+            delete axis;
+        }
+    }
+
+    if (trackMap.segments.empty())
+    {
+        return;
+    }
+
+    /* Same scale on both axes, so that the curves keep their shape */
+    const QList<QPointF> path = trackMap.path();
+    double minX = 0.0, maxX = 0.0, minY = 0.0, maxY = 0.0;
+    QLineSeries *pathSeries = new QLineSeries();
+
+    for (const QPointF &point : path)
+    {
+        minX = qMin(minX, point.x());
+        maxX = qMax(maxX, point.x());
+        minY = qMin(minY, point.y());
+        maxY = qMax(maxY, point.y());
+    }
+    pathSeries->append(path);
+    trackMapChart->addSeries(pathSeries);
+
+    const double span = qMax(qMax(maxX - minX, maxY - minY), 0.1);
+    const double centerX = (minX + maxX) / 2.0;
+    const double centerY = (minY + maxY) / 2.0;
+
+    QValueAxis *axisX = new QValueAxis();
+    axisX->setRange(centerX - span / 2.0, centerX + span / 2.0);
+    axisX->setTitleText("x [m]");
+    trackMapChart->addAxis(axisX, Qt::AlignBottom);
+    pathSeries->attachAxis(axisX);
+
+    QValueAxis *axisY = new QValueAxis();
+    axisY->setRange(centerY - span / 2.0, centerY + span / 2.0);
+    axisY->setTitleText("y [m]");
+    trackMapChart->addAxis(axisY, Qt::AlignLeft);
+    pathSeries->attachAxis(axisY);
+
+    /* Speed limit of every segment and the entry speeds which place the braking points */
+    QLineSeries *limitSeries = new QLineSeries();
+    QLineSeries *entrySeries = new QLineSeries();
+    double distance = 0.0;
+    double maxSpeed = 0.0;
+
+    limitSeries->setName("Segment limit");
+    entrySeries->setName("Entry speed");
+
+    for (const TrackMap::Segment &segment : trackMap.segments)
+    {
+        limitSeries->append(distance, segment.speed);
+        entrySeries->append(distance, segment.entrySpeed);
+        distance += segment.length;
+        limitSeries->append(distance, segment.speed);
+        maxSpeed = qMax(maxSpeed, static_cast<double>(segment.speed));
+    }
+    speedProfileChart->addSeries(limitSeries);
+    speedProfileChart->addSeries(entrySeries);
+
+    QValueAxis *axisDistance = new QValueAxis();
+    axisDistance->setRange(0.0, distance);
+    axisDistance->setTitleText("Distance [m]");
+    speedProfileChart->addAxis(axisDistance, Qt::AlignBottom);
+    limitSeries->attachAxis(axisDistance);
+    entrySeries->attachAxis(axisDistance);
+
+    QValueAxis *axisSpeed = new QValueAxis();
+    axisSpeed->setRange(0.0, maxSpeed * 1.1);
+    axisSpeed->setTitleText("Speed [m/s]");
+    speedProfileChart->addAxis(axisSpeed, Qt::AlignLeft);
+    limitSeries->attachAxis(axisSpeed);
+    entrySeries->attachAxis(axisSpeed);
+}
+
+void MainWindow::confirmAutotuneResult(const QByteArray &data)
+{
+    /* {loop, status, ultimate gain, ultimate period [ms], {kp, ki, kd} Ziegler-Nichols, {kp, ki, kd} Tyreus-Luyben} */
+    static const QString loopNames[] = {"PID EncoderLeft", "PID EncoderRight", "PID Sensors"};
+    const auto *bytes = reinterpret_cast<const uchar *>(data.constData());
+    const uint8_t loop = bytes[0];
+    float values[8];
+
+    if (loop > 2)
+    {
+        return;
+    }
+    if (bytes[1] != 0)
+    {
+        addToLogs(QString("Autotune of %1 failed, the loop did not oscillate.").arg(loopNames[loop]), false);
+        return;
+    }
+
+    std::memcpy(values, bytes + 2, sizeof(values));
+    addToLogs(QString("Autotune of %1: Ku %2, Pu %3 ms, Ziegler-Nichols kp %4 ki %5 kd %6, "
+                      "Tyreus-Luyben kp %7 ki %8 kd %9")
+                  .arg(loopNames[loop])
+                  .arg(values[0]).arg(values[1])
+                  .arg(values[2]).arg(values[3]).arg(values[4])
+                  .arg(values[5]).arg(values[6]).arg(values[7]), true);
+
+    QMessageBox box(this);
+    box.setWindowTitle(tr("Autotune"));
+    box.setText(tr("Apply the gains found for %1? They are written to the robot with Write NVM.").arg(loopNames[loop]));
+    QPushButton *zieglerNichols = box.addButton(tr("Ziegler-Nichols"), QMessageBox::AcceptRole);
+    QPushButton *tyreusLuyben = box.addButton(tr("Tyreus-Luyben"), QMessageBox::AcceptRole);
+    box.addButton(QMessageBox::Cancel);
+    box.exec();
+
+    const float *gains = nullptr;
+    if (box.clickedButton() == zieglerNichols)
+    {
+        gains = values + 2;
+    }
+    else if (box.clickedButton() == tyreusLuyben)
+    {
+        gains = values + 5;
+    }
+    else
+    {
+        return;
+    }
+
+    QLineEdit *const lineEdits[][3] = {
+        {ui->lineEditPid2Kp, ui->lineEditPid2Ki, ui->lineEditPid2Kd},
+        {ui->lineEditPid3Kp, ui->lineEditPid3Ki, ui->lineEditPid3Kd},
+        {ui->lineEditPid1Kp, ui->lineEditPid1Ki, ui->lineEditPid1Kd}};
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        lineEdits[loop][i]->setText(QString::number(gains[i]));
+    }
+}
+
+void MainWindow::sendEventLogRequest(uint16_t firstEvent)
+{
+    QByteArray data;
+    data.append(static_cast<char>(firstEvent & 0xFF));
+    data.append(static_cast<char>(firstEvent >> 8));
+    bluetoothHandler->sendCommand(Command::GetEventLog, data);
+}
+
+void MainWindow::updateEventLog(const QByteArray &data)
+{
+    /* {total, first, count, {time [ms], type, wheel, value} * count} */
+    static constexpr qsizetype HEADER_SIZE = 5;
+    static constexpr qsizetype EVENT_SIZE = 8;
+    static const QString wheelNames[] = {"left", "right"};
+    const auto *bytes = reinterpret_cast<const uchar *>(data.constData());
+
+    if (data.size() < HEADER_SIZE)
+    {
+        return;
+    }
+
+    const uint16_t total = qFromLittleEndian<uint16_t>(bytes);
+    const uint16_t first = qFromLittleEndian<uint16_t>(bytes + 2);
+    const uint8_t count = bytes[4];
+
+    if (total == 0)
+    {
+        addToLogs("Event log is empty, no run since the reset.", false);
+        return;
+    }
+
+    for (qsizetype i = 0; (i < count) && (HEADER_SIZE + (i + 1) * EVENT_SIZE <= data.size()); ++i)
+    {
+        const uchar *event = bytes + HEADER_SIZE + i * EVENT_SIZE;
+        const uint32_t time = qFromLittleEndian<uint32_t>(event);
+        const uint8_t wheel = event[5];
+        const int16_t value = qFromLittleEndian<int16_t>(event + 6);
+        QString text;
+
+        switch (event[4])
+        {
+        case 0:
+            text = (value != 0) ? "mapping lap started" : "run started";
+            break;
+        case 1:
+            text = "run stopped";
+            break;
+        case 2:
+            text = QString("%1 wheel slipped, acceleration %2 m/s²")
+                       .arg(wheelNames[wheel & 1U])
+                       .arg(value / 10.0);
+            break;
+        case 3:
+            text = QString("%1 wheel turned backward while driven forward, velocity %2 m/s, "
+                           "encoder reversed, run aborted")
+                       .arg(wheelNames[wheel & 1U])
+                       .arg(value / 100.0);
+            break;
+        default:
+            text = QString("unknown event %1").arg(event[4]);
+            break;
+        }
+
+        addToLogs(QString("Event %1/%2 at %3 ms: %4").arg(first + i + 1).arg(total).arg(time).arg(text), false);
+    }
+
+    /* A log longer than one packet is read with several requests */
+    if ((count > 0) && (first + count < total))
+    {
+        sendEventLogRequest(static_cast<uint16_t>(first + count));
+    }
+}
@@ -8,10 +8,13 @@
 #include <QtCharts>
 #include <QLineSeries>
 #include <QValueAxis>
+#include <optional>
 #include "nvmlayout.h"
 #include "bluetoothhandler.h"
 #include "plot.h"
 #include "bootloader.h"
+#include "linkbenchmark.h"
+#include "trackmap.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui
@@ -40,11 +43,20 @@ private slots:
     void on_pushButtonAutoConnect_clicked();
     void on_pushButtonStart_clicked();
     void on_pushButtonStop_clicked();
+    void on_pushButtonMapLap_clicked();
     void on_pushButtonReset_clicked();
     void on_pushButtonCalibrate_clicked();
+    void on_pushButtonStoreThresholds_clicked();
+    void on_pushButtonIdentifyMotors_clicked();
+    void on_pushButtonAutotuneWheels_clicked();
+    void on_pushButtonAutotuneLine_clicked();
+    void on_pushButtonReadEventLog_clicked();
     void on_radioButtonDebugMode_clicked(bool checked);
     void on_pushButtonReadNvm_clicked();
     void on_pushButtonWriteNvm_clicked();
+    void on_pushButtonProfileSelect_clicked();
+    void on_pushButtonProfileClone_clicked();
+    void on_pushButtonProfileDiff_clicked();
     void on_pushButtonClearLogs_clicked();
     void on_pushButtonSaveLogs_clicked();
     void on_pushButtonBootEnter_clicked();
@@ -54,11 +66,15 @@ private slots:
     void on_pushButtonBootFlash_clicked();
     void on_pushButtonBootJumpApp_clicked();
     void on_pushButtonBootGetSession_clicked();
+    void on_pushButtonBenchStart_clicked();
+    void on_pushButtonBenchStop_clicked();
+    void on_pushButtonReadMap_clicked();
 
 private:
     Ui::MainWindow *ui;
     BluetoothHandler *bluetoothHandler;
     Bootloader *bootloader;
+    LinkBenchmark *linkBenchmark;
     bool autoConnectInProgress;
     QString autoConnectDeviceName;
 
@@ -69,12 +85,42 @@ private:
     qint64 runStartTime;
     qint64 totalRunTime;
 
+    /* Layout last read from or written to the robot, parameter writes send only the fields changed since */
+    std::optional<NVMLayout> deviceNvmLayout;
+    /* Layout being read or written chunk by chunk */
+    QByteArray nvmReadData;
+    QByteArray nvmWriteData;
+
     Plot *motorPlot;
     Plot *sensorPlot;
     size_t plotStartTime;
 
+    static constexpr int BENCH_HISTOGRAM_BINS = 20;
+    QChart *benchHistogramChart;
+    QList<double> benchRttSamples;
+
+    TrackMap trackMap;
+    QChart *trackMapChart;
+    QChart *speedProfileChart;
+
+    void sendNvmReadRequest(uint16_t offset);
+    void receiveNvmChunk(const QByteArray &data);
+    void sendNvmWriteChunk(uint16_t offset);
     void updateNvmLayout(const QByteArray &data);
+    NVMLayout nvmLayoutFromUi() const;
+    void sendChangedParameters(const NVMLayout &nvmLayout);
+    void updateProfiles(const QByteArray &data);
+    void sendDiffProfilesRequest(uint8_t profileA, uint8_t profileB, uint16_t firstId);
+    void logProfileDiff(const QByteArray &data);
     void updateDebugData(const QByteArray &data);
     void addToLogs(const QString &msg, bool isDebugMsg);
+    void addBenchmarkResult(const LinkBenchmark::Result &result);
+    void updateBenchmarkHistogram();
+    void sendTrackMapRequest(uint16_t firstSegment);
+    void updateTrackMap(const QByteArray &data);
+    void updateTrackMapCharts();
+    void confirmAutotuneResult(const QByteArray &data);
+    void sendEventLogRequest(uint16_t firstEvent);
+    void updateEventLog(const QByteArray &data);
 };
 #endif // MAINWINDOW_H
@@ -4,6 +4,7 @@
 #include "pidsettings.h"
 #include <array>
 #include <cstring>
+#include <vector>
 #include <QString>
 
 class NVMLayout
@@ -11,6 +12,12 @@ class NVMLayout
 public:
     static constexpr size_t SENSORS_NUMBER = 12;
     static constexpr size_t LF_TIMER_NB = 4;
+    static constexpr size_t SPEED_CURVE_POINTS = 6;
+    static constexpr size_t GAIN_SCHEDULE_POINTS = 4;
+    static constexpr size_t MOTOR_MODEL_POINTS = 8;
+    /* The layout is read and written in chunks {total, offset, count, data} that fit a v1 payload */
+    static constexpr size_t CHUNK_HEADER_SIZE = 5;
+    static constexpr size_t CHUNK_DATA_SIZE = 240;
 
     enum class LF_Timers
     {
@@ -33,9 +40,130 @@ public:
     } sensors;
     float targetSpeed;
     std::array<uint32_t, LF_TIMER_NB> timerTimeout;
+    /* Found by the calibration, normalized reading = (reading - offset) * gain, the defaults
+       normalize the whole ADC range */
+    struct
+    {
+        std::array<float, SENSORS_NUMBER> gains = filledArray<float>(1000.0f / 4095.0f);
+        std::array<uint16_t, SENSORS_NUMBER> offsets = filledArray<uint16_t>(0);
+    } normalization;
+    /* Online adaptation of the thresholds during a run, a rate of 0 disables it */
+    struct
+    {
+        float rate = 0.0f;
+        float margin = 0.25f;
+        uint16_t maxDeviation = 400;
+        uint16_t maxSlewRate = 500;
+    } adaptation;
+    /* Speed profile calculated from the track map recorded on a mapping lap */
+    struct
+    {
+        float maxSpeed = 2.5f;
+        float maxLateralAccel = 6.0f;
+        float maxDecel = 5.0f;
+        float fallbackError = 4.0f;
+    } speedProfile;
+    /* Speed-up on straights, a speed not above the target speed disables it */
+    struct
+    {
+        float speed = 0.0f;
+        float accel = 3.0f;
+        float exitError = 1.0f;
+        float holdDistance = 0.15f;
+        uint32_t holdTime = 0;
+    } straightBoost;
+    /* Factor of the target speed over |sensor error| and over |error rate| [1/s], breakpoints in
+       ascending order, the lower factor is used */
+    struct SpeedCurve
+    {
+        std::array<float, SPEED_CURVE_POINTS> inputs;
+        std::array<float, SPEED_CURVE_POINTS> factors;
+    };
+    struct
+    {
+        SpeedCurve error = {{0.0f, 1.0f, 2.0f, 4.0f, 8.0f, 10.0f}, {1.0f, 1.0f, 0.97f, 0.93f, 0.88f, 0.85f}};
+        SpeedCurve errorRate = {{0.0f, 100.0f, 200.0f, 400.0f, 800.0f, 1600.0f},
+                                {1.0f, 1.0f, 0.97f, 0.93f, 0.88f, 0.85f}};
+    } speedSchedule;
+    /* Gains of the line PID over the measured speed [m/s], used instead of the gains of pidStgSensor
+       when the speeds are ascending */
+    struct
+    {
+        std::array<float, GAIN_SCHEDULE_POINTS> speeds = {0.0f, 0.0f, 0.0f, 0.0f};
+        std::array<float, GAIN_SCHEDULE_POINTS> kp = {0.1f, 0.1f, 0.1f, 0.1f};
+        std::array<float, GAIN_SCHEDULE_POINTS> ki = {0.0f, 0.0f, 0.0f, 0.0f};
+        std::array<float, GAIN_SCHEDULE_POINTS> kd = {0.0f, 0.0f, 0.0f, 0.0f};
+    } sensorGainSchedule;
+    /* Feedforward of the wheel PIDs: steady-state velocity [m/s] at PWM steps, found by the motor
+       identification, the first point is the deadband. The gain scales the PWM, 0 disables it */
+    struct MotorCurve
+    {
+        std::array<float, MOTOR_MODEL_POINTS> velocities{};
+        std::array<uint16_t, MOTOR_MODEL_POINTS> pwm{};
+    };
+    struct
+    {
+        MotorCurve left;
+        MotorCurve right;
+        float gain = 1.0f;
+    } motorModel;
+    /* Negative wheel commands: 0 coast, 1 short brake, 2 backward PWM up to maxReversePwm */
+    struct
+    {
+        uint16_t reversePolicy = 2;
+        uint16_t maxReversePwm = 500;
+    } drive;
+    /* Limits of the speed setpoint of a run [m/s^2, jerk m/s^3], 0 removes a limit */
+    struct
+    {
+        float launchAccel = 4.0f;
+        float cruiseAccel = 8.0f;
+        float brakeDecel = 15.0f;
+        float jerk = 200.0f;
+    } trajectory;
+    /* Wheel slip detection: acceleration beyond the setpoint one [m/s^2], speed difference beyond the
+       commanded one [m/s], 0 disables a detection; PWM cap of a slipping wheel and its duration [ms] */
+    struct
+    {
+        float maxAccelError = 15.0f;
+        float maxSlipSpeed = 0.5f;
+        float pwmFactor = 0.7f;
+        uint32_t holdTime = 100;
+    } traction;
+    /* Time in which the error predicted after a line loss gives way to the fallback errors [ms], 0 uses
+       only the fallback errors */
+    float lineLossDecay = 150.0f;
+
+    /* Parameter of the firmware dictionary (lf_params.c), the value is encoded as sent over SCP:
+       4 bytes little endian, IEEE 754 floats or 32-bit signed integers */
+    struct Parameter
+    {
+        uint16_t id;
+        std::array<uint8_t, 4> value;
+    };
+
+    static constexpr size_t MAX_PARAMS_PER_PACKET = 32;
+
+    /* Profiles stored by the firmware, each one is a full layout */
+    static constexpr size_t PROFILES_NUMBER = 4;
+    static constexpr size_t PROFILE_NAME_SIZE = 16;
+    /* Diff response entry: {id, value of the first profile, value of the second profile} */
+    static constexpr size_t PROFILE_DIFF_ENTRY_SIZE = 10;
+    static constexpr size_t MAX_DIFFS_PER_PACKET = 25;
 
     NVMLayout() = default;
 
+    template <typename T>
+    static constexpr std::array<T, SENSORS_NUMBER> filledArray(T value)
+    {
+        std::array<T, SENSORS_NUMBER> array{};
+        for (auto &element : array)
+        {
+            element = value;
+        }
+        return array;
+    }
+
     void parseFromArray(const uint8_t *data)
     {
         size_t offset = 0;
@@ -75,6 +203,51 @@ public:
             std::memcpy(&timerTimeout[i], data + offset, sizeof(timerTimeout[i]));
             offset += sizeof(timerTimeout[i]);
         }
+
+        std::memcpy(normalization.gains.data(), data + offset, normalization.gains.size() * sizeof(float));
+        offset += normalization.gains.size() * sizeof(float);
+
+        std::memcpy(normalization.offsets.data(), data + offset, normalization.offsets.size() * sizeof(uint16_t));
+        offset += normalization.offsets.size() * sizeof(uint16_t);
+
+        std::memcpy(&adaptation.rate, data + offset, sizeof(adaptation.rate));
+        offset += sizeof(adaptation.rate);
+
+        std::memcpy(&adaptation.margin, data + offset, sizeof(adaptation.margin));
+        offset += sizeof(adaptation.margin);
+
+        std::memcpy(&adaptation.maxDeviation, data + offset, sizeof(adaptation.maxDeviation));
+        offset += sizeof(adaptation.maxDeviation);
+
+        std::memcpy(&adaptation.maxSlewRate, data + offset, sizeof(adaptation.maxSlewRate));
+        offset += sizeof(adaptation.maxSlewRate);
+
+        std::memcpy(&speedProfile, data + offset, sizeof(speedProfile));
+        offset += sizeof(speedProfile);
+
+        std::memcpy(&straightBoost, data + offset, sizeof(straightBoost));
+        offset += sizeof(straightBoost);
+
+        std::memcpy(&speedSchedule, data + offset, sizeof(speedSchedule));
+        offset += sizeof(speedSchedule);
+
+        std::memcpy(&sensorGainSchedule, data + offset, sizeof(sensorGainSchedule));
+        offset += sizeof(sensorGainSchedule);
+
+        std::memcpy(&motorModel, data + offset, sizeof(motorModel));
+        offset += sizeof(motorModel);
+
+        std::memcpy(&drive, data + offset, sizeof(drive));
+        offset += sizeof(drive);
+
+        std::memcpy(&trajectory, data + offset, sizeof(trajectory));
+        offset += sizeof(trajectory);
+
+        std::memcpy(&traction, data + offset, sizeof(traction));
+        offset += sizeof(traction);
+
+        std::memcpy(&lineLossDecay, data + offset, sizeof(lineLossDecay));
+        offset += sizeof(lineLossDecay);
     }
 
     void serializeToArray(uint8_t *data) const
@@ -116,6 +289,221 @@ public:
             std::memcpy(data + offset, &timerTimeout[i], sizeof(timerTimeout[i]));
             offset += sizeof(timerTimeout[i]);
         }
+
+        std::memcpy(data + offset, normalization.gains.data(), normalization.gains.size() * sizeof(float));
+        offset += normalization.gains.size() * sizeof(float);
+
+        std::memcpy(data + offset, normalization.offsets.data(), normalization.offsets.size() * sizeof(uint16_t));
+        offset += normalization.offsets.size() * sizeof(uint16_t);
+
+        std::memcpy(data + offset, &adaptation.rate, sizeof(adaptation.rate));
+        offset += sizeof(adaptation.rate);
+
+        std::memcpy(data + offset, &adaptation.margin, sizeof(adaptation.margin));
+        offset += sizeof(adaptation.margin);
+
+        std::memcpy(data + offset, &adaptation.maxDeviation, sizeof(adaptation.maxDeviation));
+        offset += sizeof(adaptation.maxDeviation);
+
+        std::memcpy(data + offset, &adaptation.maxSlewRate, sizeof(adaptation.maxSlewRate));
+        offset += sizeof(adaptation.maxSlewRate);
+
+        std::memcpy(data + offset, &speedProfile, sizeof(speedProfile));
+        offset += sizeof(speedProfile);
+
+        std::memcpy(data + offset, &straightBoost, sizeof(straightBoost));
+        offset += sizeof(straightBoost);
+
+        std::memcpy(data + offset, &speedSchedule, sizeof(speedSchedule));
+        offset += sizeof(speedSchedule);
+
+        std::memcpy(data + offset, &sensorGainSchedule, sizeof(sensorGainSchedule));
+        offset += sizeof(sensorGainSchedule);
+
+        std::memcpy(data + offset, &motorModel, sizeof(motorModel));
+        offset += sizeof(motorModel);
+
+        std::memcpy(data + offset, &drive, sizeof(drive));
+        offset += sizeof(drive);
+
+        std::memcpy(data + offset, &trajectory, sizeof(trajectory));
+        offset += sizeof(trajectory);
+
+        std::memcpy(data + offset, &traction, sizeof(traction));
+        offset += sizeof(traction);
+
+        std::memcpy(data + offset, &lineLossDecay, sizeof(lineLossDecay));
+        offset += sizeof(lineLossDecay);
+    }
+
+    std::vector<Parameter> parameters() const
+    {
+        std::vector<Parameter> params;
+
+        auto addFloat = [&params](uint16_t id, float value)
+        {
+            Parameter param{id, {}};
+            std::memcpy(param.value.data(), &value, sizeof(value));
+            params.push_back(param);
+        };
+        auto addInteger = [&params](uint16_t id, int32_t value)
+        {
+            Parameter param{id, {}};
+            std::memcpy(param.value.data(), &value, sizeof(value));
+            params.push_back(param);
+        };
+        auto addPid = [&addFloat](uint16_t base, const PIDSettings &pid)
+        {
+            addFloat(base + 0x00, pid.kp);
+            addFloat(base + 0x01, pid.ki);
+            addFloat(base + 0x02, pid.kd);
+            addFloat(base + 0x03, pid.integralMax);
+            addFloat(base + 0x04, pid.integralMin);
+            addFloat(base + 0x05, pid.outputMax);
+            addFloat(base + 0x06, pid.outputMin);
+        };
+
+        addPid(0x0100, pidStgSensor);
+        for (size_t i = 0; i < GAIN_SCHEDULE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0110 + i), sensorGainSchedule.speeds[i]);
+        }
+        for (size_t i = 0; i < GAIN_SCHEDULE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0114 + i), sensorGainSchedule.kp[i]);
+        }
+        for (size_t i = 0; i < GAIN_SCHEDULE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0118 + i), sensorGainSchedule.ki[i]);
+        }
+        for (size_t i = 0; i < GAIN_SCHEDULE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x011C + i), sensorGainSchedule.kd[i]);
+        }
+        addPid(0x0200, pidStgEncoderLeft);
+        addPid(0x0300, pidStgEncoderRight);
+        for (size_t i = 0; i < SENSORS_NUMBER; ++i)
+        {
+            addInteger(static_cast<uint16_t>(0x0400 + i), sensors.weights[i]);
+        }
+        for (size_t i = 0; i < SENSORS_NUMBER; ++i)
+        {
+            addInteger(static_cast<uint16_t>(0x0410 + i), sensors.thresholds[i]);
+        }
+        addFloat(0x0420, sensors.errorThreshold);
+        addFloat(0x0421, sensors.fallbackErrorPositive);
+        addFloat(0x0422, sensors.fallbackErrorNegative);
+        addFloat(0x0423, lineLossDecay);
+        for (size_t i = 0; i < SENSORS_NUMBER; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0430 + i), normalization.gains[i]);
+        }
+        for (size_t i = 0; i < SENSORS_NUMBER; ++i)
+        {
+            addInteger(static_cast<uint16_t>(0x0440 + i), normalization.offsets[i]);
+        }
+        addFloat(0x0450, adaptation.rate);
+        addFloat(0x0451, adaptation.margin);
+        addInteger(0x0452, adaptation.maxDeviation);
+        addInteger(0x0453, adaptation.maxSlewRate);
+        addFloat(0x0500, targetSpeed);
+        addFloat(0x0510, speedProfile.maxSpeed);
+        addFloat(0x0511, speedProfile.maxLateralAccel);
+        addFloat(0x0512, speedProfile.maxDecel);
+        addFloat(0x0513, speedProfile.fallbackError);
+        addFloat(0x0520, straightBoost.speed);
+        addFloat(0x0521, straightBoost.accel);
+        addFloat(0x0522, straightBoost.exitError);
+        addFloat(0x0523, straightBoost.holdDistance);
+        addInteger(0x0524, static_cast<int32_t>(straightBoost.holdTime));
+        for (size_t i = 0; i < SPEED_CURVE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0530 + i), speedSchedule.error.inputs[i]);
+        }
+        for (size_t i = 0; i < SPEED_CURVE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0536 + i), speedSchedule.error.factors[i]);
+        }
+        for (size_t i = 0; i < SPEED_CURVE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0540 + i), speedSchedule.errorRate.inputs[i]);
+        }
+        for (size_t i = 0; i < SPEED_CURVE_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0546 + i), speedSchedule.errorRate.factors[i]);
+        }
+        addFloat(0x0550, trajectory.launchAccel);
+        addFloat(0x0551, trajectory.cruiseAccel);
+        addFloat(0x0552, trajectory.brakeDecel);
+        addFloat(0x0553, trajectory.jerk);
+        for (size_t i = 0; i < LF_TIMER_NB; ++i)
+        {
+            addInteger(static_cast<uint16_t>(0x0600 + i), static_cast<int32_t>(timerTimeout[i]));
+        }
+        for (size_t i = 0; i < MOTOR_MODEL_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0700 + i), motorModel.left.velocities[i]);
+        }
+        for (size_t i = 0; i < MOTOR_MODEL_POINTS; ++i)
+        {
+            addInteger(static_cast<uint16_t>(0x0708 + i), motorModel.left.pwm[i]);
+        }
+        for (size_t i = 0; i < MOTOR_MODEL_POINTS; ++i)
+        {
+            addFloat(static_cast<uint16_t>(0x0710 + i), motorModel.right.velocities[i]);
+        }
+        for (size_t i = 0; i < MOTOR_MODEL_POINTS; ++i)
+        {
+            addInteger(static_cast<uint16_t>(0x0718 + i), motorModel.right.pwm[i]);
+        }
+        addFloat(0x0720, motorModel.gain);
+        addInteger(0x0730, drive.reversePolicy);
+        addInteger(0x0731, drive.maxReversePwm);
+        addFloat(0x0740, traction.maxAccelError);
+        addFloat(0x0741, traction.maxSlipSpeed);
+        addFloat(0x0742, traction.pwmFactor);
+        addInteger(0x0743, static_cast<int32_t>(traction.holdTime));
+
+        return params;
+    }
+
+    std::vector<Parameter> changedParameters(const NVMLayout &reference) const
+    {
+        const std::vector<Parameter> current = parameters();
+        const std::vector<Parameter> previous = reference.parameters();
+        std::vector<Parameter> changed;
+
+        for (size_t i = 0; i < current.size(); ++i)
+        {
+            if (current[i].value != previous[i].value)
+            {
+                changed.push_back(current[i]);
+            }
+        }
+
+        return changed;
+    }
+
+    /* The sensor arrays, the normalization offsets, the adaptation limits, the boost hold time, the
+       timers, the PWM of the motor curves, the drive settings and the slip hold time are integers, all
+       other parameters are floats */
+    static QString parameterValueToString(uint16_t id, const uint8_t *value)
+    {
+        const bool isInteger = ((id >= 0x0400) && (id < 0x0420)) || ((id >= 0x0440) && (id < 0x0450)) ||
+                               (id == 0x0452) || (id == 0x0453) || (id == 0x0524) || ((id >= 0x0600) && (id < 0x0700)) ||
+                               ((id >= 0x0708) && (id < 0x0710)) || ((id >= 0x0718) && (id < 0x0720)) ||
+                               (id == 0x0730) || (id == 0x0731) || (id == 0x0743);
+
+        if (isInteger)
+        {
+            int32_t integer;
+            std::memcpy(&integer, value, sizeof(integer));
+            return QString::number(integer);
+        }
+
+        float number;
+        std::memcpy(&number, value, sizeof(number));
+        return QString::number(number);
     }
 
     constexpr size_t size() const
@@ -125,7 +513,14 @@ public:
                (sensors.thresholds.size() * sizeof(uint16_t)) +
                sizeof(sensors.errorThreshold) + sizeof(sensors.fallbackErrorPositive) +
                sizeof(sensors.fallbackErrorNegative) + sizeof(targetSpeed) +
-               (timerTimeout.size() * sizeof(uint32_t));
+               (timerTimeout.size() * sizeof(uint32_t)) +
+               (normalization.gains.size() * sizeof(float)) +
+               (normalization.offsets.size() * sizeof(uint16_t)) +
+               sizeof(adaptation.rate) + sizeof(adaptation.margin) +
+               sizeof(adaptation.maxDeviation) + sizeof(adaptation.maxSlewRate) +
+               sizeof(speedProfile) + sizeof(straightBoost) + sizeof(speedSchedule) +
+               sizeof(sensorGainSchedule) + sizeof(motorModel) + sizeof(drive) + sizeof(trajectory) +
+               sizeof(traction) + sizeof(lineLossDecay);
     }
 
     QString toString() const
@@ -143,6 +538,16 @@ public:
                           .arg(pidStgSensor.outputMax)
                           .arg(pidStgSensor.outputMin));
 
+        output.append("Gain Schedule:\n");
+        for (size_t i = 0; i < GAIN_SCHEDULE_POINTS; ++i)
+        {
+            output.append(QString("Speed %1: Kp: %2, Ki: %3, Kd: %4\n")
+                              .arg(sensorGainSchedule.speeds[i])
+                              .arg(sensorGainSchedule.kp[i])
+                              .arg(sensorGainSchedule.ki[i])
+                              .arg(sensorGainSchedule.kd[i]));
+        }
+
         output.append("\nPID Encoder Left Settings:\n");
         output.append(QString("Kp: %1, Ki: %2, Kd: %3, IntMax: %4, IntMin: %5, "
                               "OutputMax: %6, OutputMin: %7\n")
@@ -168,16 +573,68 @@ public:
         output.append("\nSensor Weights:\n");
         for (int i = 0; i < SENSORS_NUMBER; ++i)
         {
-            output.append(QString("Sensor %1 Weight: %2, Threshold: %3\n")
+            output.append(QString("Sensor %1 Weight: %2, Threshold: %3, Gain: %4, Offset: %5\n")
                               .arg(i + 1)
                               .arg(sensors.weights[i])
-                              .arg(sensors.thresholds[i]));
+                              .arg(sensors.thresholds[i])
+                              .arg(normalization.gains[i])
+                              .arg(normalization.offsets[i]));
         }
 
         output.append(QString("\nError Threshold: %1\n").arg(sensors.errorThreshold));
         output.append(QString("Fallback Error Positive: %1\n").arg(sensors.fallbackErrorPositive));
         output.append(QString("Fallback Error Negative: %1\n").arg(sensors.fallbackErrorNegative));
+        output.append(QString("Line Loss Decay: %1\n").arg(lineLossDecay));
+        output.append(QString("\nThreshold Adaptation Rate: %1, Margin: %2, Max Deviation: %3, Max Slew Rate: %4\n")
+                          .arg(adaptation.rate)
+                          .arg(adaptation.margin)
+                          .arg(adaptation.maxDeviation)
+                          .arg(adaptation.maxSlewRate));
         output.append(QString("\nTarget Speed: %1\n").arg(targetSpeed));
+        output.append(QString("Speed Profile Max Speed: %1, Max Lateral Accel: %2, Max Decel: %3, Fallback Error: %4\n")
+                          .arg(speedProfile.maxSpeed)
+                          .arg(speedProfile.maxLateralAccel)
+                          .arg(speedProfile.maxDecel)
+                          .arg(speedProfile.fallbackError));
+        output.append(QString("Straight Boost Speed: %1, Accel: %2, Exit Error: %3, Hold Distance: %4, Hold Time: %5\n")
+                          .arg(straightBoost.speed)
+                          .arg(straightBoost.accel)
+                          .arg(straightBoost.exitError)
+                          .arg(straightBoost.holdDistance)
+                          .arg(straightBoost.holdTime));
+        output.append("Speed Schedule:\n");
+        for (size_t i = 0; i < SPEED_CURVE_POINTS; ++i)
+        {
+            output.append(QString("Error %1: %2, Error Rate %3: %4\n")
+                              .arg(speedSchedule.error.inputs[i])
+                              .arg(speedSchedule.error.factors[i])
+                              .arg(speedSchedule.errorRate.inputs[i])
+                              .arg(speedSchedule.errorRate.factors[i]));
+        }
+
+        output.append(QString("\nMotor Model Gain: %1\n").arg(motorModel.gain));
+        for (size_t i = 0; i < MOTOR_MODEL_POINTS; ++i)
+        {
+            output.append(QString("Left %1 m/s: PWM %2, Right %3 m/s: PWM %4\n")
+                              .arg(motorModel.left.velocities[i])
+                              .arg(motorModel.left.pwm[i])
+                              .arg(motorModel.right.velocities[i])
+                              .arg(motorModel.right.pwm[i]));
+        }
+
+        output.append(QString("\nReverse Policy: %1, Max Reverse PWM: %2\n")
+                          .arg(drive.reversePolicy)
+                          .arg(drive.maxReversePwm));
+        output.append(QString("Launch Accel: %1, Cruise Accel: %2, Brake Decel: %3, Jerk: %4\n")
+                          .arg(trajectory.launchAccel)
+                          .arg(trajectory.cruiseAccel)
+                          .arg(trajectory.brakeDecel)
+                          .arg(trajectory.jerk));
+        output.append(QString("Slip Accel Error: %1, Slip Speed: %2, Slip PWM Factor: %3, Slip Hold Time: %4\n")
+                          .arg(traction.maxAccelError)
+                          .arg(traction.maxSlipSpeed)
+                          .arg(traction.pwmFactor)
+                          .arg(traction.holdTime));
 
         output.append("\nTimer Timeouts:\n");
         for (size_t i = 0; i < timerTimeout.size(); ++i)
@@ -6,32 +6,178 @@
 SCP::SCP(QObject *parent)
     : QObject(parent),
     packetState(PacketState::Idle),
+    version(PROTOCOL_VERSION_1),
+    receivedVersion(PROTOCOL_VERSION_1),
+    cobsFraming(false),
+    cobsFrameOverflow(false),
     dataBytesReceived(0)
 {
 }
 
-void SCP::sendCommand(Command command, const QByteArray &data)
+void SCP::setProtocolVersion(int version)
 {
-    PacketHeader header = { START_BYTE, 0, static_cast<uint16_t>(command), static_cast<uint8_t>(data.size()) };
+    this->version = version;
 
-    QByteArray crcData;
-    QDataStream crcStream(&crcData, QIODevice::WriteOnly);
-    crcStream.setByteOrder(QDataStream::LittleEndian);
-    crcStream << header.id << header.size;
-    crcData.append(data);
+    /* COBS framing of the received data is enabled by the first valid frame, not by the negotiation */
+    if (version != PROTOCOL_VERSION_3)
+    {
+        cobsFraming = false;
+    }
+}
+
+int SCP::protocolVersion() const
+{
+    return version;
+}
+
+int SCP::lastReceivedVersion() const
+{
+    return receivedVersion;
+}
+
+QString SCP::statusToString(Status status)
+{
+    switch (status)
+    {
+    case Status::Ok:
+        return "OK";
+    case Status::NackUnknownCommand:
+        return "unknown command";
+    case Status::NackInvalidSize:
+        return "invalid size";
+    case Status::NackCrc:
+        return "CRC mismatch";
+    case Status::NackBusy:
+        return "busy";
+    case Status::NackTooLarge:
+        return "response too large for the protocol version";
+    default:
+        return QString("status 0x%1").arg(static_cast<uint8_t>(status), 2, 16, QChar('0'));
+    }
+}
+
+void SCP::sendCommand(Command command, const QByteArray &data, uint8_t sequence)
+{
+    if ((version == PROTOCOL_VERSION_1) && (data.size() > MAX_PAYLOAD_SIZE_V1))
+    {
+        emit errorOccurred("Packet data too large for protocol v1.");
+        return;
+    }
 
-    header.crc = calculateCRC(reinterpret_cast<const uint8_t*>(crcData.data()), crcData.size());
+    PacketHeader header = { (version == PROTOCOL_VERSION_1) ? START_BYTE : START_BYTE_V2, 0, static_cast<uint16_t>(command),
+                            static_cast<uint16_t>(data.size()), sequence, static_cast<uint8_t>(Status::Ok) };
+
+    header.crc = calculatePacketCRC(version, header, data);
 
     QByteArray packet;
     QDataStream packetStream(&packet, QIODevice::WriteOnly);
     packetStream.setByteOrder(QDataStream::LittleEndian);
-    packetStream << header.start << header.crc << header.id << header.size;
+    packetStream << header.start << header.crc << header.id;
+    if (version == PROTOCOL_VERSION_1)
+    {
+        packetStream << static_cast<uint8_t>(header.size);
+    }
+    else
+    {
+        packetStream << header.size << header.sequence << header.status;
+    }
     packet.append(data);
 
+    if (version == PROTOCOL_VERSION_3)
+    {
+        /* Leading delimiter terminates any partial frame left on the device by a previous error */
+        packet = COBS_DELIMITER + cobsEncode(packet) + COBS_DELIMITER;
+    }
+
     emit packetReadyToSend(packet);
 }
 
 void SCP::receiveData(const QByteArray &data)
+{
+    QByteArray rawData;
+
+    /* Every byte is collected into the COBS frame. Until the device answers with a valid COBS frame,
+       the bytes are also parsed as unframed v1 and v2 packets */
+    for (const char byte : data)
+    {
+        const bool wasCobsFraming = cobsFraming;
+
+        if (byte == COBS_DELIMITER)
+        {
+            processRawData(rawData);
+            rawData.clear();
+            processCobsFrame();
+        }
+        else if (cobsFrame.size() < MAX_COBS_FRAME_SIZE)
+        {
+            cobsFrame.append(byte);
+        }
+        else
+        {
+            cobsFrameOverflow = true;
+        }
+
+        if (!wasCobsFraming)
+        {
+            rawData.append(byte);
+        }
+    }
+
+    processRawData(rawData);
+}
+
+void SCP::processCobsFrame()
+{
+    const QByteArray frame = cobsFrame;
+    const bool overflow = cobsFrameOverflow;
+
+    cobsFrame.clear();
+    cobsFrameOverflow = false;
+
+    if (overflow || frame.isEmpty())
+    {
+        return;
+    }
+
+    const std::optional<QByteArray> packet = cobsDecode(frame);
+    if (!packet.has_value())
+    {
+        /* Not a COBS frame, e.g. an unframed packet sent by the device after a reset */
+        if (cobsFraming)
+        {
+            processRawData(frame + COBS_DELIMITER);
+        }
+        return;
+    }
+
+    const qsizetype headerSize = sizeof(PacketHeader);
+    if ((packet->size() < headerSize) || (static_cast<uint8_t>(packet->at(0)) != START_BYTE_V2))
+    {
+        return;
+    }
+
+    const PacketHeader *header = reinterpret_cast<const PacketHeader *>(packet->constData());
+    if (header->size != (packet->size() - headerSize))
+    {
+        return;
+    }
+
+    /* A frame interrupts any unframed packet in progress, the frame boundary is authoritative */
+    resetPacketReception();
+    dataBuffer.clear();
+
+    currentHeader = *header;
+    packetData = packet->mid(headerSize);
+    receivedVersion = PROTOCOL_VERSION_3;
+
+    if (validateAndProcessPacket())
+    {
+        cobsFraming = true;
+    }
+    resetPacketReception();
+}
+
+void SCP::processRawData(const QByteArray &data)
 {
     dataBuffer.append(data);
 
@@ -43,8 +189,10 @@ void SCP::receiveData(const QByteArray &data)
         {
             if (auto byte = extractUInt8FromBuffer(dataBuffer); byte.has_value())
             {
-                if (byte.value() == START_BYTE)
+                if (byte.value() == START_BYTE || byte.value() == START_BYTE_V2)
                 {
+                    currentHeader.start = byte.value();
+                    receivedVersion = (byte.value() == START_BYTE) ? PROTOCOL_VERSION_1 : PROTOCOL_VERSION_2;
                     packetState = PacketState::GotStart;
                 }
             }
@@ -85,27 +233,30 @@ void SCP::receiveData(const QByteArray &data)
         }
         case PacketState::GotId:
         {
-            if (auto sizeByte = extractUInt8FromBuffer(dataBuffer); sizeByte.has_value())
+            std::optional<uint16_t> size;
+
+            if (receivedVersion == PROTOCOL_VERSION_1)
             {
-                currentHeader.size = sizeByte.value();
-                dataBytesReceived = 0;
-                packetData.clear();
+                size = extractUInt8FromBuffer(dataBuffer);
+            }
+            else
+            {
+                size = extractUInt16FromBuffer(dataBuffer);
+            }
 
-                if (currentHeader.size > 0)
+            if (size.has_value())
+            {
+                currentHeader.size = size.value();
+                currentHeader.sequence = 0;
+                currentHeader.status = static_cast<uint8_t>(Status::Ok);
+
+                if (receivedVersion == PROTOCOL_VERSION_1)
                 {
-                    packetState = PacketState::GettingData;
+                    startDataReception();
                 }
                 else
                 {
-                    if (validateAndProcessPacket())
-                    {
-                        resetPacketReception();
-                    }
-                    else
-                    {
-                        emit errorOccurred("CRC mismatch in received packet.");
-                        resetPacketReception();
-                    }
+                    packetState = PacketState::GotSize;
                 }
             }
             else
@@ -115,6 +266,34 @@ void SCP::receiveData(const QByteArray &data)
             }
             break;
         }
+        case PacketState::GotSize:
+        {
+            if (auto sequence = extractUInt8FromBuffer(dataBuffer); sequence.has_value())
+            {
+                currentHeader.sequence = sequence.value();
+                packetState = PacketState::GotSequence;
+            }
+            else
+            {
+                /* Wait for more data */
+                return;
+            }
+            break;
+        }
+        case PacketState::GotSequence:
+        {
+            if (auto status = extractUInt8FromBuffer(dataBuffer); status.has_value())
+            {
+                currentHeader.status = status.value();
+                startDataReception();
+            }
+            else
+            {
+                /* Wait for more data */
+                return;
+            }
+            break;
+        }
         case PacketState::GettingData:
         {
             int bytesNeeded = currentHeader.size - dataBytesReceived;
@@ -124,15 +303,7 @@ void SCP::receiveData(const QByteArray &data)
                 dataBuffer.remove(0, bytesNeeded);
                 dataBytesReceived += bytesNeeded;
 
-                if (validateAndProcessPacket())
-                {
-                    resetPacketReception();
-                }
-                else
-                {
-                    emit errorOccurred("CRC mismatch in received packet.");
-                    resetPacketReception();
-                }
+                finishRawPacket();
             }
             else
             {
@@ -148,6 +319,31 @@ void SCP::receiveData(const QByteArray &data)
     }
 }
 
+void SCP::startDataReception()
+{
+    dataBytesReceived = 0;
+    packetData.clear();
+
+    if (currentHeader.size > 0)
+    {
+        packetState = PacketState::GettingData;
+    }
+    else
+    {
+        finishRawPacket();
+    }
+}
+
+void SCP::finishRawPacket()
+{
+    /* A valid unframed packet means the device is no longer sending COBS frames */
+    if (validateAndProcessPacket())
+    {
+        cobsFraming = false;
+    }
+    resetPacketReception();
+}
+
 uint16_t SCP::calculateCRC(const uint8_t *data, uint16_t size, uint16_t init)
 {
     uint16_t crc = init;
@@ -160,6 +356,25 @@ uint16_t SCP::calculateCRC(const uint8_t *data, uint16_t size, uint16_t init)
     return crc;
 }
 
+uint16_t SCP::calculatePacketCRC(int packetVersion, const PacketHeader &header, const QByteArray &data)
+{
+    QByteArray crcData;
+    QDataStream crcStream(&crcData, QIODevice::WriteOnly);
+    crcStream.setByteOrder(QDataStream::LittleEndian);
+    crcStream << header.id;
+    if (packetVersion == PROTOCOL_VERSION_1)
+    {
+        crcStream << static_cast<uint8_t>(header.size);
+    }
+    else
+    {
+        crcStream << header.size << header.sequence << header.status;
+    }
+    crcData.append(data);
+
+    return calculateCRC(reinterpret_cast<const uint8_t*>(crcData.data()), crcData.size());
+}
+
 void SCP::resetPacketReception()
 {
     packetState = PacketState::Idle;
@@ -171,37 +386,106 @@ void SCP::resetPacketReception()
 bool SCP::validateAndProcessPacket()
 {
     const Command currentCommand = static_cast<Command>(currentHeader.id);
+    Status status = static_cast<Status>(currentHeader.status);
 
+    if (calculatePacketCRC(receivedVersion, currentHeader, packetData) != currentHeader.crc)
+    {
+        emit errorOccurred("CRC mismatch in received packet.");
+        return false;
+    }
     if (!commandDataSize.contains(currentCommand))
     {
         emit errorOccurred("Received packet with unknown command.");
         return false;
     }
-    if (currentHeader.size != commandDataSize.at(currentCommand))
+
+    /* Rejected requests are answered without data. v1 has no status field, the device answers a response
+       that does not fit v1 without data */
+    const qsizetype expectedSize = commandDataSize.at(currentCommand);
+    if ((receivedVersion == PROTOCOL_VERSION_1) && (expectedSize > 0) && (currentHeader.size == 0))
+    {
+        status = Status::NackTooLarge;
+    }
+    if ((status == Status::Ok) && (expectedSize != VARIABLE_SIZE) && (currentHeader.size != expectedSize))
     {
         emit errorOccurred("Received packet with invalid size.");
         return false;
     }
 
-    QByteArray crcData;
-    QDataStream crcStream(&crcData, QIODevice::WriteOnly);
-    crcStream.setByteOrder(QDataStream::LittleEndian);
-    crcStream << currentHeader.id << currentHeader.size;
-    crcData.append(packetData);
+    emit commandReceived(currentCommand, currentHeader.sequence, status, packetData);
+    return true;
+}
+
+QByteArray SCP::cobsEncode(const QByteArray &data)
+{
+    QByteArray encoded;
+    qsizetype codeIndex = 0;
+    uint8_t code = 1;
 
-    uint16_t calculatedCRC = calculateCRC(reinterpret_cast<const uint8_t*>(crcData.data()), crcData.size());
+    encoded.reserve(data.size() + data.size() / 254 + 1);
+    encoded.append('\0');
 
-    if (calculatedCRC == currentHeader.crc)
+    for (const char byte : data)
     {
-        Command command = static_cast<Command>(currentHeader.id);
-        emit commandReceived(command, packetData);
-        return true;
+        if (byte == COBS_DELIMITER)
+        {
+            encoded[codeIndex] = static_cast<char>(code);
+            codeIndex = encoded.size();
+            encoded.append('\0');
+            code = 1;
+        }
+        else
+        {
+            encoded.append(byte);
+            code++;
+
+            if (code == COBS_MAX_CODE)
+            {
+                encoded[codeIndex] = static_cast<char>(code);
+                codeIndex = encoded.size();
+                encoded.append('\0');
+                code = 1;
+            }
+        }
     }
-    else
+    encoded[codeIndex] = static_cast<char>(code);
+
+    return encoded;
+}
+
+std::optional<QByteArray> SCP::cobsDecode(const QByteArray &frame)
+{
+    QByteArray decoded;
+    qsizetype read = 0;
+
+    decoded.reserve(frame.size());
+
+    while (read < frame.size())
     {
-        emit errorOccurred("CRC mismatch in received packet.");
-        return false;
+        const uint8_t code = static_cast<uint8_t>(frame.at(read++));
+
+        if ((code == 0) || ((read + code - 1) > frame.size()))
+        {
+            return std::nullopt;
+        }
+
+        for (uint8_t i = 1; i < code; ++i)
+        {
+            const char byte = frame.at(read++);
+            if (byte == COBS_DELIMITER)
+            {
+                return std::nullopt;
+            }
+            decoded.append(byte);
+        }
+
+        if ((code != COBS_MAX_CODE) && (read < frame.size()))
+        {
+            decoded.append(COBS_DELIMITER);
+        }
     }
+
+    return decoded;
 }
 
 std::optional<uint16_t> SCP::extractUInt16FromBuffer(QByteArray &buffer)
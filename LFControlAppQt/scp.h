@@ -12,14 +12,35 @@ class SCP : public QObject
 {
     Q_OBJECT
 public:
+    enum class Status : uint8_t
+    {
+        Ok                  = 0x00,
+        NackUnknownCommand  = 0x01,
+        NackInvalidSize     = 0x02,
+        NackCrc             = 0x03,
+        NackBusy            = 0x04,
+        NackTooLarge        = 0x05
+    };
+
+    constexpr static int PROTOCOL_VERSION_1 = 1;
+    constexpr static int PROTOCOL_VERSION_2 = 2;
+    /* v2 packets in COBS frames delimited by zero bytes */
+    constexpr static int PROTOCOL_VERSION_3 = 3;
+    constexpr static qsizetype MAX_PAYLOAD_SIZE_V1 = 255;
+
     explicit SCP(QObject *parent = nullptr);
 
-    void sendCommand(Command command, const QByteArray &data = QByteArray());
+    void sendCommand(Command command, const QByteArray &data = QByteArray(), uint8_t sequence = 0);
     void receiveData(const QByteArray &data);
+    void setProtocolVersion(int version);
+    int protocolVersion() const;
+    int lastReceivedVersion() const;
+
+    static QString statusToString(Status status);
 
 signals:
     void packetReadyToSend(const QByteArray &packet);
-    void commandReceived(Command command, const QByteArray &data);
+    void commandReceived(Command command, uint8_t sequence, SCP::Status status, const QByteArray &data);
     void errorOccurred(const QString &error);
 
 private:
@@ -30,13 +51,19 @@ private:
         GotCrc,
         GotId,
         GotSize,
+        GotSequence,
         GettingData
     };
 
     constexpr static uint8_t START_BYTE = 0x7E;
+    constexpr static uint8_t START_BYTE_V2 = 0x7F;
     constexpr static uint16_t CRC_POLYNOMIAL = 0x8408;
-    constexpr static qsizetype NVM_LAYOUT_SIZE = NVMLayout().size();
+    constexpr static char COBS_DELIMITER = 0x00;
+    constexpr static uint8_t COBS_MAX_CODE = 0xFF;
+    /* v2 header and the largest payload of any supported device, plus the worst case COBS overhead */
+    constexpr static qsizetype MAX_COBS_FRAME_SIZE = 9 + 0xFFFF + (9 + 0xFFFF) / 254 + 1;
     constexpr static qsizetype DEBUG_DATA_SIZE = DebugData().size();
+    constexpr static qsizetype VARIABLE_SIZE = -1;
     constexpr static uint16_t CRC16_CCIT_LOOKUP[256] =
     {
         0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
@@ -76,12 +103,28 @@ private:
     const std::unordered_map<Command, qsizetype> commandDataSize = {
         {Command::SetMode,              0},
         {Command::Reset,                0},
-        {Command::Calibrate,            0},
-        {Command::ReadNvmData,          NVM_LAYOUT_SIZE},
-        {Command::WriteNvmData,         0},
+        {Command::Calibrate,            2},
+        {Command::ReadNvmData,          VARIABLE_SIZE},
+        {Command::WriteNvmData,         1},
         {Command::SetDebugMode,         0},
         {Command::DebugData,            DEBUG_DATA_SIZE},
         {Command::GetActiveSession,     11},
+        {Command::GetNvmStatus,         1},
+        {Command::GetParams,            VARIABLE_SIZE},
+        {Command::SetParams,            3},
+        {Command::CommitParams,         1},
+        {Command::SelectProfile,        1},
+        {Command::GetProfiles,          1 + NVMLayout::PROFILES_NUMBER * NVMLayout::PROFILE_NAME_SIZE},
+        {Command::CloneProfile,         1},
+        {Command::DiffProfiles,         VARIABLE_SIZE},
+        {Command::CalibrationProgress,  7},
+        {Command::StoreThresholds,      1},
+        {Command::GetTrackMap,          VARIABLE_SIZE},
+        {Command::IdentifyMotors,       1},
+        {Command::Autotune,             34},
+        {Command::GetEventLog,          VARIABLE_SIZE},
+        {Command::Echo,                 VARIABLE_SIZE},
+        {Command::GetProtocolVersion,   4},
         {Command::BootGetVersion,       4},
         {Command::BootStartDownload,    0},
         {Command::BootEraseApp,         0},
@@ -92,14 +135,21 @@ private:
     };
 
     PacketState packetState;
-    
+    int version;
+    int receivedVersion;
+    bool cobsFraming;
+    bool cobsFrameOverflow;
+    QByteArray cobsFrame;
+
 #pragma pack(push, 1)
     struct PacketHeader
     {
         uint8_t start;
         uint16_t crc;
         uint16_t id;
-        uint8_t size;
+        uint16_t size;
+        uint8_t sequence;
+        uint8_t status;
     };
 #pragma pack(pop)
 
@@ -109,8 +159,16 @@ private:
     QByteArray dataBuffer;
 
     uint16_t calculateCRC(const uint8_t *data, uint16_t size, uint16_t init = 0x1D0F);
+    uint16_t calculatePacketCRC(int packetVersion, const PacketHeader &header, const QByteArray &data);
     void resetPacketReception();
+    void startDataReception();
+    void finishRawPacket();
     bool validateAndProcessPacket();
+    void processRawData(const QByteArray &data);
+    void processCobsFrame();
+
+    static QByteArray cobsEncode(const QByteArray &data);
+    static std::optional<QByteArray> cobsDecode(const QByteArray &frame);
 
     std::optional<uint16_t> extractUInt16FromBuffer(QByteArray &buffer);
     std::optional<uint8_t> extractUInt8FromBuffer(QByteArray &buffer);
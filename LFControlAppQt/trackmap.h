@@ -0,0 +1,116 @@
+#ifndef TRACKMAP_H
+#define TRACKMAP_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <QList>
+#include <QPointF>
+
+/* Track map recorded by the robot on a mapping lap, read with Command::GetTrackMap */
+class TrackMap
+{
+public:
+    /* {state, total, first, count} */
+    static constexpr size_t HEADER_SIZE = 6;
+    static constexpr size_t SEGMENT_SIZE = 5 * sizeof(float);
+    static constexpr size_t SEGMENTS_PER_PACKET = 12;
+    /* Length of a straight part of the drawn path [m] */
+    static constexpr double PATH_STEP = 0.01;
+
+    enum class State : uint8_t
+    {
+        Empty     = 0x00,
+        Recording = 0x01,
+        Ready     = 0x02
+    };
+
+    struct Segment
+    {
+        float length;       /* [m] */
+        float curvature;    /* [1/m], positive to the left */
+        float error;        /* Mean absolute sensor error on the mapping lap */
+        float speed;        /* Speed limit of the segment [m/s] */
+        float entrySpeed;   /* Speed limit at the start of the segment [m/s] */
+    };
+
+    State state = State::Empty;
+    uint16_t total = 0;
+    std::vector<Segment> segments;
+
+    TrackMap() = default;
+
+    /* Appends the segments of a response, returns the index of the next segment to request or
+       total when the map is complete */
+    uint16_t parsePacket(const uint8_t *data, size_t size)
+    {
+        uint16_t first;
+        uint8_t count = data[5];
+
+        state = static_cast<State>(data[0]);
+        std::memcpy(&total, data + 1, sizeof(total));
+        std::memcpy(&first, data + 3, sizeof(first));
+
+        if (first == 0)
+        {
+            segments.clear();
+        }
+
+        for (size_t i = 0; (i < count) && (HEADER_SIZE + (i + 1) * SEGMENT_SIZE <= size); ++i)
+        {
+            Segment segment;
+            const uint8_t *entry = data + HEADER_SIZE + i * SEGMENT_SIZE;
+
+            std::memcpy(&segment.length, entry, sizeof(float));
+            std::memcpy(&segment.curvature, entry + 4, sizeof(float));
+            std::memcpy(&segment.error, entry + 8, sizeof(float));
+            std::memcpy(&segment.speed, entry + 12, sizeof(float));
+            std::memcpy(&segment.entrySpeed, entry + 16, sizeof(float));
+            segments.push_back(segment);
+        }
+
+        return (count == 0) ? total : static_cast<uint16_t>(first + count);
+    }
+
+    double length() const
+    {
+        double length = 0.0;
+
+        for (const Segment &segment : segments)
+        {
+            length += segment.length;
+        }
+
+        return length;
+    }
+
+    /* Path of the robot integrated from the segment curvatures, starting at the origin heading along x */
+    QList<QPointF> path() const
+    {
+        QList<QPointF> points{QPointF(0.0, 0.0)};
+        double x = 0.0;
+        double y = 0.0;
+        double heading = 0.0;
+
+        for (const Segment &segment : segments)
+        {
+            const int steps = std::max(1, static_cast<int>(std::ceil(segment.length / PATH_STEP)));
+            const double step = segment.length / steps;
+
+            for (int i = 0; i < steps; ++i)
+            {
+                heading += segment.curvature * step;
+                x += std::cos(heading) * step;
+                y += std::sin(heading) * step;
+                points.append(QPointF(x, y));
+            }
+        }
+
+        return points;
+    }
+};
+
+#endif // TRACKMAP_H
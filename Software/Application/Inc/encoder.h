@@ -6,6 +6,7 @@
  ******************************************************************************************/
 #include "stm32f7xx_hal.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 /******************************************************************************************
  *                                         DEFINES                                        *
@@ -30,7 +31,9 @@ typedef struct
     int32_t countPrev;
     int32_t deltaCount;
     uint32_t timerMax;
-    float velocity; /* m/s */
+    bool isReversed; /* The counter counts down when the wheel turns forward */
+    float metersPerPulse; /* Derived from the settings by Encoder_Init */
+    float velocity; /* m/s, negative when the wheel turns backward */
 } Encoder_Instance_T;
 
 /******************************************************************************************
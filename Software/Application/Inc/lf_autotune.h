@@ -0,0 +1,53 @@
+#ifndef __LF_AUTOTUNE_H__
+#define __LF_AUTOTUNE_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_main.h"
+#include "lf_relay.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_AUTOTUNE_IN_PROGRESS,
+    LF_AUTOTUNE_ERROR,
+    LF_AUTOTUNE_COMPLETE,
+} LF_AutotuneStatus_T;
+
+typedef enum
+{
+    LF_AUTOTUNE_WHEEL_LEFT,
+    LF_AUTOTUNE_WHEEL_RIGHT,
+    LF_AUTOTUNE_LINE,
+    LF_AUTOTUNE_LOOP_NB
+} LF_AutotuneLoop_T;
+
+/* Sent with LF_CMD_AUTOTUNE for every tuned loop, the gains are only applied by the PC application */
+typedef struct __attribute__((packed))
+{
+    uint8_t loop;               /* LF_AutotuneLoop_T */
+    uint8_t status;             /* 0 if the loop oscillated and the gains are valid */
+    float ultimateGain;
+    float ultimatePeriod;       /* [ms] */
+    float gains[LF_RELAY_RULE_NB][3];   /* kp, ki, kd of every LF_RelayRule_T */
+} LF_AutotuneResult_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_StartAutotune(LineFollower_T *const me, bool isLineLoop);
+LF_AutotuneStatus_T LF_UpdateAutotune(LineFollower_T *const me);
+void LF_StopAutotune(LineFollower_T *const me);
+
+#endif /* __LF_AUTOTUNE_H__ */
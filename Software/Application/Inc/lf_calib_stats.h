@@ -0,0 +1,71 @@
+#ifndef __LF_CALIB_STATS_H__
+#define __LF_CALIB_STATS_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define LF_CALIB_STATS_ADC_MAX          4095U
+/* 128 bins of 32 ADC counts */
+#define LF_CALIB_STATS_BIN_SHIFT        5U
+#define LF_CALIB_STATS_BINS             ((LF_CALIB_STATS_ADC_MAX >> LF_CALIB_STATS_BIN_SHIFT) + 1U)
+/* Normalized reading of the line, the background reads 0 */
+#define LF_CALIB_STATS_NORMALIZED_MAX   1000U
+/* 1/100 of the lowest and of the highest samples are dropped as outliers */
+#define LF_CALIB_STATS_OUTLIER_DIVIDER  100U
+/* Both the line and the background have to cover 1/50 of the samples */
+#define LF_CALIB_STATS_CLASS_DIVIDER    50U
+#define LF_CALIB_STATS_MIN_SAMPLES      100U
+/* Minimal distance between the line and the background means, in ADC counts */
+#define LF_CALIB_STATS_MIN_CONTRAST     200U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+/* ADC values of one channel collected during the calibration */
+typedef struct
+{
+    uint16_t bins[LF_CALIB_STATS_BINS];
+} LF_CalibStats_Histogram_T;
+
+typedef struct
+{
+    uint16_t threshold;     /* Readings above the threshold are the line */
+    uint16_t background;    /* Mean reading of the background */
+    uint16_t line;          /* Mean reading of the line */
+    uint16_t offset;        /* Normalized reading: (reading - offset) * gain */
+    float gain;
+} LF_CalibStats_Result_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_CalibStats_Reset(LF_CalibStats_Histogram_T *const histogram);
+void LF_CalibStats_Add(LF_CalibStats_Histogram_T *const histogram, uint16_t value);
+int LF_CalibStats_Compute(const LF_CalibStats_Histogram_T *const histogram, LF_CalibStats_Result_T *const result);
+
+/**
+ * @brief Maps a reading to 0 (background) ... LF_CALIB_STATS_NORMALIZED_MAX (line).
+ */
+static inline uint16_t LF_CalibStats_Normalize(uint16_t value, uint16_t offset, float gain)
+{
+    if (value <= offset)
+    {
+        return 0U;
+    }
+
+    float normalized = (float)(value - offset) * gain;
+
+    return (normalized >= (float)LF_CALIB_STATS_NORMALIZED_MAX) ? LF_CALIB_STATS_NORMALIZED_MAX : (uint16_t)normalized;
+}
+
+#endif /* __LF_CALIB_STATS_H__ */
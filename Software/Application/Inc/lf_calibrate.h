@@ -20,6 +20,15 @@ typedef enum
     LF_CALIBRATION_COMPLETE,
 } LF_CalibrationStatus_T;
 
+/* Sent with LF_CMD_CALIBRATION_PROGRESS at the end of every sweep */
+typedef struct __attribute__((packed))
+{
+    uint8_t sweeps;
+    uint16_t stableChannels;    /* Bit mask of the channels with a converged threshold */
+    uint16_t failedChannels;    /* Bit mask of the channels without enough contrast yet */
+    uint16_t elapsed;           /* Time since the start of the calibration [ms] */
+} LF_CalibrationProgress_T;
+
 /******************************************************************************************
  *                                    GLOBAL VARIABLES                                    *
  ******************************************************************************************/
@@ -28,7 +37,7 @@ typedef enum
  *                                   FUNCTION PROTOTYPES                                  *
  ******************************************************************************************/
 void LF_StartCalibration(LineFollower_T *const me);
-void LF_UpdateCalibrationData(LineFollower_T *const me);
-void LF_StopCalibration(LineFollower_T *const me);
+LF_CalibrationStatus_T LF_UpdateCalibrationData(LineFollower_T *const me);
+uint16_t LF_StopCalibration(LineFollower_T *const me);
 
 #endif /* __LF_CALIBRATE_H__ */
@@ -0,0 +1,57 @@
+#ifndef __LF_EVENT_LOG_H__
+#define __LF_EVENT_LOG_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Events kept in RAM, the oldest one is overwritten when the log is full */
+#define LF_EVENT_LOG_SIZE               64U
+/* Events per log packet, fits the 255 byte payload of protocol v1 with the header */
+#define LF_EVENT_LOG_EVENTS_PER_PACKET  30U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_EVENT_RUN_START,         /* value: 1 for a mapping lap */
+    LF_EVENT_RUN_STOP,
+    LF_EVENT_SLIP,              /* wheel: LF_TractionWheel_T, value: wheel acceleration [0.1 m/s^2] */
+    LF_EVENT_WHEEL_REVERSED,    /* wheel: LF_TractionWheel_T, value: measured velocity [0.01 m/s] */
+} LF_EventType_T;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t time;              /* Since the start of the run [ms] */
+    uint8_t type;               /* LF_EventType_T */
+    uint8_t wheel;
+    int16_t value;
+} LF_Event_T;
+
+/* Black box of the last run, kept until the next start */
+typedef struct
+{
+    LF_Event_T events[LF_EVENT_LOG_SIZE];
+    uint32_t startTime;         /* [ms] */
+    uint16_t head;              /* Index of the oldest event */
+    uint16_t count;
+} LF_EventLog_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_EventLog_Clear(LF_EventLog_T *const log, uint32_t now);
+void LF_EventLog_Add(LF_EventLog_T *const log, uint32_t now, LF_EventType_T type, uint8_t wheel, float value);
+const LF_Event_T *LF_EventLog_Get(const LF_EventLog_T *const log, uint16_t index);
+
+#endif /* __LF_EVENT_LOG_H__ */
@@ -0,0 +1,34 @@
+#ifndef __LF_IDENTIFY_H__
+#define __LF_IDENTIFY_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_main.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_IDENTIFICATION_IN_PROGRESS,
+    LF_IDENTIFICATION_ERROR,
+    LF_IDENTIFICATION_COMPLETE,
+} LF_IdentificationStatus_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_StartIdentification(LineFollower_T *const me);
+LF_IdentificationStatus_T LF_UpdateIdentification(LineFollower_T *const me);
+int LF_StopIdentification(LineFollower_T *const me, LF_IdentificationStatus_T status);
+
+#endif /* __LF_IDENTIFY_H__ */
@@ -15,10 +15,17 @@
 #include "linefollower_config.h"
 #include "linefollower_commands.h"
 #include "encoder.h"
+#include "lf_track_map.h"
+#include "lf_speed_schedule.h"
+#include "lf_motor_model.h"
+#include "lf_trajectory.h"
+#include "lf_traction.h"
+#include "lf_event_log.h"
 
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
+#define LF_CACHE_LINE_SIZE  32U
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
@@ -27,6 +34,8 @@ typedef enum
 {
     LF_IDLE,
     LF_CALIBRATION,
+    LF_IDENTIFICATION,
+    LF_AUTOTUNE,
     LF_RUN,
     LF_ERROR
 } LFState_T;
@@ -38,6 +47,10 @@ typedef struct __attribute__((packed))
     float motorLeftVelocity;
     float motorRightVelocity;
     bool isSpeedReduced;
+    uint16_t thresholds[SENSORS_NUMBER];    /* Used thresholds, adapted during a run */
+    float setpointSpeed;                    /* Speed setpoint of the trajectory [m/s] */
+    float setpointAccel;                    /* [m/s^2] */
+    uint8_t slipMask;                       /* Wheels with a capped PWM, 1 << LF_TractionWheel_T */
 } Lf_DebugData_T;
 
 typedef struct
@@ -46,30 +59,107 @@ typedef struct
     LF_Signal_T associatedTimeoutSig;
 } LF_Timer_T;
 
+typedef struct
+{
+    float speed;            /* [m/s] */
+    float accelPerMs;       /* Ramp of the boost speed [m/s per ms] */
+    float exitError;
+    float holdDistance;     /* [m] */
+    float holdTime;         /* [ms] */
+    bool isEnabled;         /* The boost speed is above the target speed */
+} LF_StraightBoostConfig_T;
+
+/* Parameters used by the control loop, compiled from NVM_Layout_T into a flat struct
+   so that every read in the control step is a single load from the instance */
+typedef struct __attribute__((aligned(LF_CACHE_LINE_SIZE)))
+{
+    PID_Settings_T pidSensor;
+    PID_GainTable_T sensorGainTable;    /* Gains of the line PID over the measured speed */
+    PID_Settings_T pidEncoderLeft;
+    PID_Settings_T pidEncoderRight;
+    LF_MotorFeedforward_T feedforwardLeft;  /* PWM of the target wheel velocity, the PIDs correct the residual */
+    LF_MotorFeedforward_T feedforwardRight;
+    TB6612MotorDirection_T reverseDirection;    /* Direction of a negative wheel command */
+    uint16_t maxReversePwm;             /* 0 unless the negative commands drive backward */
+    Sensors_ErrorConfig_T sensors;
+    float targetSpeed;
+    LF_SpeedLut_T errorSpeedLut;        /* Speed factor over |sensor error| */
+    LF_SpeedLut_T errorRateSpeedLut;    /* Speed factor over |error rate| */
+    float reducedSpeedFactor;           /* Lowest factor of the curves, used while the speed is reduced */
+    uint32_t timerTimeout[LF_TIMER_NB];
+    uint16_t thresholds[SENSORS_NUMBER];
+    uint16_t backgroundLevels[SENSORS_NUMBER];
+    uint16_t lineLevels[SENSORS_NUMBER];
+    Sensors_AdaptConfig_T adaptation;
+    LF_TrackMap_Config_T speedProfile;
+    LF_StraightBoostConfig_T straightBoost;
+    LF_TrajectoryLimits_T trajectory;
+    LF_TractionLimits_T traction;
+} LF_ParamBank_T;
+
+typedef struct
+{
+    float speed;            /* Ramped target speed of the boost, 0 while it is off [m/s] */
+    float centredTime;      /* [ms] */
+    float centredDistance;  /* [m] */
+} LF_StraightBoost_T;
+
+/* Check of the encoder signs at the start of a run */
+typedef struct
+{
+    float runTime;                              /* [ms] */
+    float reversedTime[LF_TRACTION_WHEELS];     /* Time a wheel driven forward turned backward [ms] */
+} LF_DirectionCheck_T;
+
+/* Layout received with LF_CMD_WRITE_NVM_DATA, copied to the active profile once every chunk arrived in order */
+typedef struct
+{
+    NVM_Layout_T layout;
+    uint16_t nextOffset;                        /* Offset expected in the next chunk */
+} LF_NvmTransfer_T;
+
 typedef struct
 {
     LFState_T state;
     uint32_t *bootFlags;
     uint32_t prevCycleCount;
+    float msPerCycle;
     bool isDebugMode;
     volatile uint32_t *const cycleCountReg;
     TIM_HandleTypeDef *const debugModeTimer;
     LF_SignalQueue_T signals;
     Lf_DebugData_T debugData;
     LF_Timer_T timers[LF_TIMER_NB];
+    NVM_Status_T nvmStatus;
 
     Nvm_Instance_T nvmInstance;
-    NVM_Layout_T *const nvmBlock;
+    NVM_Profiles_T *const nvmProfiles;
+    NVM_Layout_T *nvmBlock;                 /* Layout of the active profile */
+    LF_NvmTransfer_T nvmTransfer;
+    bool isParamsModified;                  /* SET_PARAMS changed the active profile since it was last stored */
+    LF_ParamBank_T paramBanks[2];
+    const LF_ParamBank_T *params;           /* Active bank, read by the control loop */
+    const LF_ParamBank_T *pendingParams;    /* Staged bank, activated at the next control cycle */
     SCP_Instance_T scpInstance;
     PID_Instance_T pidSensorInstance;
+    PID_Settings_T pidSensorSettings;       /* Settings of the line PID with the scheduled gains */
     PID_Instance_T pidEncoderLeftInstance;
     PID_Instance_T pidEncoderRightInstance;
     Encoder_Instance_T encoderLeft;
     Encoder_Instance_T encoderRight;
     Sensors_Instance_T sensorsInstance;
+    LF_TrackMap_T trackMap;
+    bool isProfileActive;                   /* The run follows the speed profile of the track map */
+    LF_StraightBoost_T straightBoost;
+    LF_Trajectory_T trajectory;             /* Speed setpoint between the target speed and the wheel PIDs */
+    LF_Traction_T traction;
+    LF_DirectionCheck_T directionCheck;
+    LF_EventLog_T eventLog;                 /* Black box of the last run */
+    float previousError;
+    float errorRate;                        /* Filtered |sensor error| rate [1/s] */
 
-    const TB6612MotorDriver_T *const motorLeft;
-    const TB6612MotorDriver_T *const motorRight;
+    TB6612MotorDriver_T *const motorLeft;
+    TB6612MotorDriver_T *const motorRight;
 } LineFollower_T;
 
 /******************************************************************************************
@@ -82,6 +172,8 @@ typedef struct
 int LF_Init(LineFollower_T *const me);
 void LF_MainFunction(LineFollower_T *const me);
 void LF_SendSignal(LineFollower_T *const me, LF_Signal_T sig);
+void LF_StageParams(LineFollower_T *const me);
+int LF_StoreParams(LineFollower_T *const me);
 void LF_DebugModeTimerCallback(void *context);
 
 #endif /* __LF_MAIN_H__ */
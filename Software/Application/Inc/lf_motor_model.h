@@ -0,0 +1,46 @@
+#ifndef __LF_MOTOR_MODEL_H__
+#define __LF_MOTOR_MODEL_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Points of the velocity to PWM curve of a wheel, the first one is the deadband */
+#define LF_MOTOR_MODEL_POINTS   8U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+/* Steady-state velocity of a wheel at PWM steps, found by the motor identification */
+typedef struct
+{
+    float velocities[LF_MOTOR_MODEL_POINTS];    /* [m/s], ascending, the first one is 0 */
+    uint16_t pwm[LF_MOTOR_MODEL_POINTS];        /* Ascending, the first one is the deadband */
+} LF_MotorCurve_T;
+
+/* Curve compiled into segments, PWM = pwm + slopes * (velocity - velocities) within a segment */
+typedef struct
+{
+    float velocities[LF_MOTOR_MODEL_POINTS];
+    float pwm[LF_MOTOR_MODEL_POINTS];
+    float slopes[LF_MOTOR_MODEL_POINTS];
+    bool isEnabled;     /* The curve is valid and the gain is positive */
+} LF_MotorFeedforward_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+int LF_MotorModel_Compile(LF_MotorFeedforward_T *const feedforward, const LF_MotorCurve_T *const curve,
+                          float gain);
+float LF_MotorModel_GetPwm(const LF_MotorFeedforward_T *const feedforward, float velocity);
+
+#endif /* __LF_MOTOR_MODEL_H__ */
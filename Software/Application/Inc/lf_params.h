@@ -0,0 +1,65 @@
+#ifndef __LF_PARAMS_H__
+#define __LF_PARAMS_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "linefollower_config.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Every value is transferred as 4 bytes, little endian: IEEE 754 floats or 32-bit signed integers */
+#define LF_PARAM_VALUE_SIZE         4U
+#define LF_PARAM_ID_SIZE            2U
+#define LF_PARAM_ENTRY_SIZE         (LF_PARAM_ID_SIZE + LF_PARAM_VALUE_SIZE)
+/* Parameters per get/set packet, fits the 255 byte payload of protocol v1 */
+#define LF_PARAMS_MAX_PER_PACKET    32U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_PARAM_FLOAT,
+    LF_PARAM_UINT32,
+    LF_PARAM_UINT16,
+    LF_PARAM_INT8
+} LF_ParamType_T;
+
+typedef enum
+{
+    LF_PARAM_OK,
+    LF_PARAM_UNKNOWN_ID,
+    LF_PARAM_OUT_OF_RANGE,
+    LF_PARAM_MALFORMED
+} LF_ParamResult_T;
+
+/* Dictionary entry, an array field takes the ids id ... id + count - 1 */
+typedef struct
+{
+    uint16_t id;
+    uint16_t offset;        /* Offset of the field in NVM_Layout_T */
+    LF_ParamType_T type;
+    uint8_t count;          /* Number of elements */
+    float min;
+    float max;
+} LF_Param_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+const LF_Param_T *LF_Params_Find(uint16_t id, uint8_t *index);
+uint32_t LF_Params_GetCount(void);
+const LF_Param_T *LF_Params_GetByIndex(uint32_t index);
+int LF_Params_Get(const NVM_Layout_T *const layout, uint16_t id, uint8_t value[LF_PARAM_VALUE_SIZE]);
+LF_ParamResult_T LF_Params_Check(uint16_t id, const uint8_t value[LF_PARAM_VALUE_SIZE]);
+LF_ParamResult_T LF_Params_Set(NVM_Layout_T *const layout, uint16_t id, const uint8_t value[LF_PARAM_VALUE_SIZE]);
+
+#endif /* __LF_PARAMS_H__ */
@@ -0,0 +1,53 @@
+#ifndef __LF_PROFILES_H__
+#define __LF_PROFILES_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "linefollower_config.h"
+#include "lf_params.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Differences per diff packet, fits the 255 byte payload of protocol v1 with the profile indexes */
+#define LF_PROFILES_MAX_DIFFS_PER_PACKET    25U
+/* Layout stored by the firmware before the journal, raw with its CRC32 at the start of NVM_SECTOR_PRIMARY */
+#define LF_PROFILES_LEGACY_LAYOUT_SIZE      offsetof(NVM_Layout_T, normalization)
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+/* A parameter that differs between two profiles, values encoded as in lf_params */
+typedef struct __attribute__((packed))
+{
+    uint16_t id;
+    uint8_t valueA[LF_PARAM_VALUE_SIZE];
+    uint8_t valueB[LF_PARAM_VALUE_SIZE];
+} LF_ProfileDiff_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+int LF_Profiles_Validate(NVM_Profiles_T *const profiles);
+int LF_Profiles_Migrate(uint8_t *data, const uint8_t *record, uint16_t recordSize, uint16_t recordVersion);
+void LF_Profiles_UpdateCrc(NVM_Profiles_T *const profiles);
+int LF_Profiles_Select(NVM_Profiles_T *const profiles, uint8_t index);
+int LF_Profiles_Clone(NVM_Profiles_T *const profiles, uint8_t source, uint8_t destination,
+                      const char name[LF_PROFILE_NAME_SIZE]);
+uint16_t LF_Profiles_Diff(const NVM_Layout_T *const a, const NVM_Layout_T *const b, uint16_t firstId,
+                          LF_ProfileDiff_T *diffs, uint16_t maxDiffs);
+
+static inline NVM_Layout_T *LF_Profiles_GetActive(NVM_Profiles_T *const profiles)
+{
+    return &profiles->profiles[profiles->activeProfile].layout;
+}
+
+#endif /* __LF_PROFILES_H__ */
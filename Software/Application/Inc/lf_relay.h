@@ -0,0 +1,66 @@
+#ifndef __LF_RELAY_H__
+#define __LF_RELAY_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Oscillation cycles left out while the loop settles into the limit cycle */
+#define LF_RELAY_SKIPPED_CYCLES     2U
+/* Oscillation cycles averaged for the result */
+#define LF_RELAY_MEASURED_CYCLES    4U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_RELAY_RULE_ZIEGLER_NICHOLS,
+    LF_RELAY_RULE_TYREUS_LUYBEN,
+    LF_RELAY_RULE_NB
+} LF_RelayRule_T;
+
+/* Relay feedback experiment, the relay output drives the loop into a limit cycle */
+typedef struct
+{
+    float amplitude;    /* Relay output amplitude */
+    float hysteresis;   /* Error band without switching */
+    float output;
+    float elapsed;      /* Time since the last rising switch [ms] */
+    float errorMax;     /* Extremes of the error since the last rising switch */
+    float errorMin;
+    float periodSum;
+    float amplitudeSum;
+    uint8_t risingSwitches;
+    uint8_t cycles;     /* Measured cycles */
+} LF_Relay_T;
+
+/* Ultimate point of the loop and the gains derived from it, the time unit of the gains is ms
+   like the one of PID_Update */
+typedef struct
+{
+    float ultimateGain;
+    float ultimatePeriod;   /* [ms] */
+    float kp;
+    float ki;
+    float kd;
+} LF_RelayResult_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_Relay_Init(LF_Relay_T *const relay, float amplitude, float hysteresis);
+float LF_Relay_Update(LF_Relay_T *const relay, float error, float dt);
+bool LF_Relay_IsComplete(const LF_Relay_T *const relay);
+int LF_Relay_GetResult(const LF_Relay_T *const relay, LF_RelayRule_T rule, LF_RelayResult_T *const result);
+
+#endif /* __LF_RELAY_H__ */
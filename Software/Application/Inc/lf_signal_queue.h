@@ -18,9 +18,13 @@
 typedef enum 
 {
     LF_SIG_START,
+    LF_SIG_START_MAPPING,
     LF_SIG_STOP,
     LF_SIG_CALIBRATE,
     LF_SIG_CALIBRATION_COMPLETE,
+    LF_SIG_IDENTIFY,
+    LF_SIG_AUTOTUNE_WHEELS,
+    LF_SIG_AUTOTUNE_LINE,
     LF_SIG_ADC_DATA_UPDATED,
     LF_SIG_SEND_DEBUG_DATA,
     LF_SIG_TIMER_TICK,
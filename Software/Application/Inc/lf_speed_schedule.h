@@ -0,0 +1,62 @@
+#ifndef __LF_SPEED_SCHEDULE_H__
+#define __LF_SPEED_SCHEDULE_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Breakpoints of a speed curve stored in NVM */
+#define LF_SPEED_CURVE_POINTS   6U
+/* Uniformly sampled entries of a compiled curve, the last one holds past the last breakpoint */
+#define LF_SPEED_LUT_SIZE       32U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+/* Piecewise-linear curve, breakpoints in ascending order */
+typedef struct
+{
+    float inputs[LF_SPEED_CURVE_POINTS];
+    float factors[LF_SPEED_CURVE_POINTS];
+} LF_SpeedCurve_T;
+
+/* Curve resampled on a uniform grid, evaluated in constant time */
+typedef struct
+{
+    float factors[LF_SPEED_LUT_SIZE];
+    float scale;        /* LUT entries per input unit */
+} LF_SpeedLut_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_SpeedSchedule_Compile(LF_SpeedLut_T *const lut, const LF_SpeedCurve_T *const curve);
+
+/**
+ * @brief Returns the speed factor of the compiled curve for a non-negative input.
+ */
+static inline float LF_SpeedSchedule_Lookup(const LF_SpeedLut_T *const lut, float input)
+{
+    float position = input * lut->scale;
+
+    if (!(position < (float)(LF_SPEED_LUT_SIZE - 1U)))
+    {
+        return lut->factors[LF_SPEED_LUT_SIZE - 1U];
+    }
+
+    uint32_t index = (uint32_t)position;
+    float fraction = position - (float)index;
+
+    return lut->factors[index] + (lut->factors[index + 1U] - lut->factors[index]) * fraction;
+}
+
+#endif /* __LF_SPEED_SCHEDULE_H__ */
@@ -0,0 +1,82 @@
+#ifndef __LF_TRACK_MAP_H__
+#define __LF_TRACK_MAP_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define LF_TRACK_MAP_MAX_SEGMENTS           256U
+/* Travelled distance of one recorded step [m] */
+#define LF_TRACK_MAP_STEP                   0.02f
+/* A step whose curvature differs more from the current segment starts a new one [1/m] */
+#define LF_TRACK_MAP_CURVATURE_TOLERANCE    1.5f
+/* Segments per map packet, fits the 255 byte payload of protocol v1 with the header */
+#define LF_TRACK_MAP_SEGMENTS_PER_PACKET    12U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_TRACK_MAP_EMPTY,
+    LF_TRACK_MAP_RECORDING,
+    LF_TRACK_MAP_READY
+} LF_TrackMapState_T;
+
+/* Part of the track with a constant curvature */
+typedef struct __attribute__((packed))
+{
+    float length;       /* [m] */
+    float curvature;    /* [1/m], positive to the left */
+    float error;        /* Mean absolute sensor error recorded on the segment */
+    float speed;        /* Speed limit of the segment [m/s] */
+    float entrySpeed;   /* Speed limit at the start of the segment, includes the braking for the next ones [m/s] */
+} LF_TrackSegment_T;
+
+/* Limits of the speed profile, compiled from NVM_SpeedProfile_T */
+typedef struct
+{
+    float maxSpeed;         /* [m/s] */
+    float maxLateralAccel;  /* [m/s^2] */
+    float maxDecel;         /* [m/s^2] */
+    float fallbackError;    /* Sensor error above which the reactive speed is used */
+    float mappingSpeed;     /* Speed of the mapping lap, used on segments followed with a large error [m/s] */
+} LF_TrackMap_Config_T;
+
+typedef struct
+{
+    LF_TrackSegment_T segments[LF_TRACK_MAP_MAX_SEGMENTS];
+    uint16_t count;
+    LF_TrackMapState_T state;
+
+    /* Step being recorded */
+    float stepLeft;
+    float stepRight;
+    float stepError;
+    uint32_t stepSamples;
+
+    /* Position on the map while the profile is followed */
+    float distance;
+    float segmentEnd;
+    uint16_t segment;
+} LF_TrackMap_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_TrackMap_StartRecording(LF_TrackMap_T *const map);
+void LF_TrackMap_Record(LF_TrackMap_T *const map, float left, float right, float trackWidth, float error);
+int LF_TrackMap_FinishRecording(LF_TrackMap_T *const map);
+int LF_TrackMap_StartProfile(LF_TrackMap_T *const map, const LF_TrackMap_Config_T *const config);
+int LF_TrackMap_GetSpeed(LF_TrackMap_T *const map, float travelled, float maxDecel, float *speed);
+
+#endif /* __LF_TRACK_MAP_H__ */
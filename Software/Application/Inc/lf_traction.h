@@ -0,0 +1,58 @@
+#ifndef __LF_TRACTION_H__
+#define __LF_TRACTION_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Time constant of the filtered wheel accelerations [ms] */
+#define LF_TRACTION_FILTER_MS   5.0f
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_TRACTION_LEFT,
+    LF_TRACTION_RIGHT,
+    LF_TRACTION_WHEELS
+} LF_TractionWheel_T;
+
+/* Slip detection and the reaction to it, 0 disables a detection */
+typedef struct
+{
+    float maxAccelError;    /* Wheel acceleration beyond the one of its setpoint [m/s^2] */
+    float maxSlipSpeed;     /* Difference between the wheels beyond the commanded one [m/s] */
+    float pwmFactor;        /* Cap of the PWM of a slipping wheel, part of its PWM at the detection */
+    uint32_t holdTime;      /* Duration of the cap after the last detection [ms] */
+} LF_TractionLimits_T;
+
+typedef struct
+{
+    float prevVelocities[LF_TRACTION_WHEELS];
+    float prevSetpoints[LF_TRACTION_WHEELS];
+    float accels[LF_TRACTION_WHEELS];           /* Filtered measured acceleration [m/s^2] */
+    float setpointAccels[LF_TRACTION_WHEELS];   /* Filtered acceleration of the setpoint [m/s^2] */
+    float pwmCaps[LF_TRACTION_WHEELS];
+    float holdTimes[LF_TRACTION_WHEELS];        /* Remaining cap [ms], 0 while the wheel grips */
+} LF_Traction_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_Traction_Reset(LF_Traction_T *const traction);
+uint8_t LF_Traction_Update(LF_Traction_T *const traction, const LF_TractionLimits_T *const limits,
+                           const float velocities[LF_TRACTION_WHEELS], const float setpoints[LF_TRACTION_WHEELS],
+                           float pwm[LF_TRACTION_WHEELS], float dt);
+uint8_t LF_Traction_GetSlipMask(const LF_Traction_T *const traction);
+
+#endif /* __LF_TRACTION_H__ */
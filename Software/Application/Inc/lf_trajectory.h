@@ -0,0 +1,45 @@
+#ifndef __LF_TRAJECTORY_H__
+#define __LF_TRAJECTORY_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+/* Limits of the speed setpoint, 0 removes a limit */
+typedef struct
+{
+    float launchAccel;      /* From the start until the target speed is reached first [m/s^2] */
+    float cruiseAccel;      /* Later speed-ups [m/s^2] */
+    float brakeDecel;       /* [m/s^2] */
+    float jerk;             /* Change of the acceleration [m/s^3] */
+} LF_TrajectoryLimits_T;
+
+/* Setpoint of the robot speed, follows the target speed within the limits */
+typedef struct
+{
+    float speed;            /* [m/s] */
+    float accel;            /* [m/s^2] */
+    bool isLaunching;
+} LF_Trajectory_T;
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+void LF_Trajectory_Reset(LF_Trajectory_T *const trajectory);
+float LF_Trajectory_Update(LF_Trajectory_T *const trajectory, const LF_TrajectoryLimits_T *const limits,
+                           float target, float dt);
+
+#endif /* __LF_TRAJECTORY_H__ */
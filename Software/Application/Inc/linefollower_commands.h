@@ -9,7 +9,6 @@
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
-#define LINEFOLLOWER_COMMANDS_NUMBER 9U
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
@@ -24,13 +23,27 @@ enum LF_Commands
     LF_CMD_SET_DEBUG_MODE   = 0x0005,
     LF_CMD_SEND_DEBUG_DATA  = 0x0006,
     LF_CMD_GET_SESSION      = 0x0007,
+    LF_CMD_GET_NVM_STATUS   = 0x0008,
+    LF_CMD_GET_PARAMS       = 0x0009,
+    LF_CMD_SET_PARAMS       = 0x000A,
+    LF_CMD_COMMIT_PARAMS    = 0x000B,
+    LF_CMD_SELECT_PROFILE   = 0x000C,
+    LF_CMD_GET_PROFILES     = 0x000D,
+    LF_CMD_CLONE_PROFILE    = 0x000E,
+    LF_CMD_DIFF_PROFILES    = 0x000F,
+    LF_CMD_CALIBRATION_PROGRESS = 0x0012,
+    LF_CMD_STORE_THRESHOLDS = 0x0013,
+    LF_CMD_GET_TRACK_MAP    = 0x0014,
+    LF_CMD_IDENTIFY_MOTORS  = 0x0015,
+    LF_CMD_AUTOTUNE         = 0x0016,
+    LF_CMD_GET_EVENT_LOG    = 0x0017,
     LF_CMD_ENTER_BOOTLOADER = 0xF002,
 };
 
 /******************************************************************************************
  *                                    GLOBAL VARIABLES                                    *
  ******************************************************************************************/
-extern const SCP_Command_T lineFollowerCommands[LINEFOLLOWER_COMMANDS_NUMBER];
+extern const SCP_Command_T lineFollowerCommands[SCP_COMMAND_TABLE_SIZE];
 
 /******************************************************************************************
  *                                   FUNCTION PROTOTYPES                                  *
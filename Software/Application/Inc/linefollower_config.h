@@ -10,12 +10,23 @@
 #include "scp.h"
 #include "tb6612_motor.h"
 #include "encoder.h"
+#include "lf_speed_schedule.h"
+#include "lf_motor_model.h"
+#include "lf_trajectory.h"
+#include "lf_traction.h"
 
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
-#define NVM_SECTOR_USED  FLASH_SECTOR_2
+/* NVM journal sectors, sector 7 is outside of the application image checked by the bootloader */
+#define NVM_SECTOR_PRIMARY   FLASH_SECTOR_2
+#define NVM_SECTOR_SECONDARY FLASH_SECTOR_7
 #define SCP_BUFFER_SIZE  512U
+/* Version of the data stored in NVM, incremented on every change of NVM_Profiles_T.
+   NVM_LEGACY_VERSION (0) is the layout stored before the journal */
+#define NVM_LAYOUT_VERSION      1U
+#define LF_PROFILES_NUMBER      4U
+#define LF_PROFILE_NAME_SIZE    16U
 #define SENSORS_NUMBER   (12U)
 
 /******************************************************************************************
@@ -39,6 +50,72 @@ typedef struct
     float fallbackErrorNegative;
 } NVM_Sensors_T;
 
+/* Per-channel normalization found by the calibration: (reading - offset) * gain */
+typedef struct
+{
+    float gains[SENSORS_NUMBER];
+    uint16_t offsets[SENSORS_NUMBER];
+} NVM_SensorsNormalization_T;
+
+/* Online adaptation of the thresholds to the lighting during a run */
+typedef struct
+{
+    float rate;             /* Weight of a sample in the averaged line/background levels, 0 disables it */
+    float margin;           /* Part of the line - background span between the threshold and a used sample */
+    uint16_t maxDeviation;  /* Bound of a threshold around the calibrated one [ADC counts] */
+    uint16_t maxSlewRate;   /* Change limit of a threshold [ADC counts per second] */
+} NVM_SensorsAdaptation_T;
+
+/* Speed profile calculated from the track map, see lf_track_map */
+typedef struct
+{
+    float maxSpeed;         /* [m/s] */
+    float maxLateralAccel;  /* Limits the speed in the curves [m/s^2] */
+    float maxDecel;         /* Places the braking points before the curves [m/s^2] */
+    float fallbackError;    /* Sensor error above which the reactive speed is used */
+} NVM_SpeedProfile_T;
+
+/* Speed-up on straights, the line stays between the middle sensors long enough */
+typedef struct
+{
+    float speed;            /* Boost speed [m/s], a speed not above the target speed disables it */
+    float accel;            /* Ramp up to the boost speed [m/s^2] */
+    float exitError;        /* Sensor error which ends the boost at once */
+    float holdDistance;     /* Centred travel starting the boost [m], 0 uses only the time */
+    uint32_t holdTime;      /* Centred time starting the boost [ms], 0 uses only the distance */
+} NVM_StraightBoost_T;
+
+/* Factor of the target speed over |sensor error| and over |error rate| [1/s], the lower one is used */
+typedef struct
+{
+    LF_SpeedCurve_T error;
+    LF_SpeedCurve_T errorRate;
+} NVM_SpeedSchedule_T;
+
+/* Feedforward of the wheel PIDs, the curves are found by the motor identification */
+typedef struct
+{
+    LF_MotorCurve_T left;
+    LF_MotorCurve_T right;
+    float gain;             /* Scale of the feedforward PWM, 0 disables it */
+} NVM_MotorModel_T;
+
+/* Handling of a negative wheel command */
+typedef enum
+{
+    LF_REVERSE_COAST,       /* Driver outputs open */
+    LF_REVERSE_BRAKE,       /* Short brake */
+    LF_REVERSE_DRIVE,       /* Backward PWM up to maxReversePwm */
+    LF_REVERSE_POLICY_NB
+} LF_ReversePolicy_T;
+
+/* Negative wheel commands, they need a negative output_min of the wheel PIDs */
+typedef struct
+{
+    uint16_t reversePolicy;     /* LF_ReversePolicy_T */
+    uint16_t maxReversePwm;
+} NVM_Drive_T;
+
 typedef struct
 {
     PID_Settings_T pidStgSensor;
@@ -47,15 +124,80 @@ typedef struct
     NVM_Sensors_T sensors;
     float targetSpeed;
     uint32_t timerTimeout[LF_TIMER_NB];
+    /* New fields are appended, the layout of an older version is a prefix of the current one */
+    NVM_SensorsNormalization_T normalization;
+    NVM_SensorsAdaptation_T adaptation;
+    NVM_SpeedProfile_T speedProfile;
+    NVM_StraightBoost_T straightBoost;
+    NVM_SpeedSchedule_T speedSchedule;
+    PID_GainSchedule_T sensorGainSchedule;  /* Gains of the line PID over the measured speed [m/s] */
+    NVM_MotorModel_T motorModel;
+    NVM_Drive_T drive;
+    LF_TrajectoryLimits_T trajectory;       /* Limits of the speed setpoint of a run */
+    LF_TractionLimits_T traction;           /* Wheel slip detection */
+    float lineLossDecay;    /* Time in which the predicted error gives way to the fallback errors [ms] */
 } NVM_Layout_T;
 
+typedef struct
+{
+    char name[LF_PROFILE_NAME_SIZE];    /* Not null terminated if all characters are used */
+    uint32_t crc;                       /* CRC32 of the layout, updated before the profiles are stored */
+    NVM_Layout_T layout;
+} NVM_Profile_T;
+
+/* Data stored in NVM, the active profile is the one used by the robot */
+typedef struct
+{
+    uint32_t activeProfile;
+    NVM_Profile_T profiles[LF_PROFILES_NUMBER];
+} NVM_Profiles_T;
+
+typedef struct
+{
+    float trackWidth;       /* Distance between the wheels [m] */
+} LF_ChassisSettings_T;
+
+/* Sweep of the sensors over the line during the calibration, the robot rotates in place */
+typedef struct
+{
+    float sweepAngle;       /* Rotation to each side of the start heading [rad] */
+    uint16_t motorSpeed;
+} LF_CalibrationSettings_T;
+
+/* PWM steps of the motor identification, the robot spins in place */
+typedef struct
+{
+    uint16_t maxPwm;        /* PWM of the last step */
+    float rampRate;         /* Rise of the PWM while the deadband is searched [1/ms] */
+    float startVelocity;    /* Velocity at which a wheel counts as turning [m/s] */
+    uint32_t settleTime;    /* Time to the steady state after a step [ms] */
+    uint32_t measureTime;   /* Time over which the velocity of a step is averaged [ms] */
+} LF_IdentificationSettings_T;
+
+/* Relay feedback experiments of the PID autotune */
+typedef struct
+{
+    float wheelVelocity;    /* Setpoint of the wheel loops, the robot spins in place [m/s] */
+    uint16_t wheelBias;     /* PWM the wheel relays switch around without identified motor curves */
+    float wheelAmplitude;   /* [PWM] */
+    float wheelHysteresis;  /* [m/s] */
+    float lineSpeed;        /* Forward speed while the line loop is tuned [m/s] */
+    float lineAmplitude;    /* Differential wheel speed [m/s] */
+    float lineHysteresis;   /* Sensor error */
+    uint32_t timeout;       /* [ms] */
+} LF_AutotuneSettings_T;
+
 /******************************************************************************************
  *                                    GLOBAL VARIABLES                                    *
  ******************************************************************************************/
-extern const NVM_Layout_T NvmDefaultData;
-extern const TB6612MotorDriver_T LeftMotor;
-extern const TB6612MotorDriver_T RightMotor;
+extern const NVM_Profiles_T NvmDefaultProfiles;
+extern TB6612MotorDriver_T LeftMotor;
+extern TB6612MotorDriver_T RightMotor;
 extern const Encoder_Settings_T encoderSettings;
+extern const LF_ChassisSettings_T chassisSettings;
+extern const LF_CalibrationSettings_T calibrationSettings;
+extern const LF_IdentificationSettings_T identificationSettings;
+extern const LF_AutotuneSettings_T autotuneSettings;
 
 /******************************************************************************************
  *                                   FUNCTION PROTOTYPES                                  *
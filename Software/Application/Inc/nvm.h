@@ -10,18 +10,78 @@
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
+/* The journal alternates between two flash sectors, see nvm.c for the sector layout */
+#define NVM_JOURNAL_SECTORS 2U
+/* Bytes programmed per NVM_Process call, bounds the time a flush step holds the main loop */
+#define NVM_FLUSH_SLICE_SIZE 32U
+/* Returned by NVM_Port_GetEraseStatus while the erase is in progress */
+#define NVM_PORT_BUSY 1
+/* Version passed to the migrate function for the data stored before the journal */
+#define NVM_LEGACY_VERSION 0U
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
  ******************************************************************************************/
+typedef enum
+{
+    NVM_FLUSH_IDLE,     /* Nothing to flush */
+    NVM_FLUSH_PENDING,  /* Data staged, waiting until the flush is allowed */
+    NVM_FLUSH_ERASE,    /* Swapping to the other sector, waiting for the erase to complete */
+    NVM_FLUSH_HEADER,   /* Programming the journal header of the erased sector */
+    NVM_FLUSH_INDEX,    /* Programming the footer index entry of the record */
+    NVM_FLUSH_RECORD    /* Programming the record, one slice per call */
+} NVM_FlushState_T;
+
+typedef enum
+{
+    NVM_STATUS_COMPLETE,    /* The RAM buffer is stored, or the last flush completed */
+    NVM_STATUS_PENDING,     /* A flush is staged but postponed */
+    NVM_STATUS_BUSY,        /* A flush is in progress */
+    NVM_STATUS_FAILED       /* The last flush failed, the next write retries it */
+} NVM_Status_T;
+
+typedef enum
+{
+    NVM_LOADED_RECORD,      /* The newest record of the current layout */
+    NVM_LOADED_MIGRATED,    /* A record of another layout, converted by the migrate function */
+    NVM_LOADED_DEFAULTS     /* No usable record, the default data */
+} NVM_LoadSource_T;
+
+/* Converts the data of a record of another layout version or size, the buffer holds the default data.
+   Returns 0 if the record is converted, -1 if the layout is not known */
+typedef int (*NVM_MigrateFunc_T)(uint8_t *data, const uint8_t *record, uint16_t recordSize, uint16_t recordVersion);
+
 typedef struct
 {
-    uint8_t *data;              /* Pointer to the RAM buffer */
-    const uint8_t *defaultData; /* Pointer to the default data */
-    uint32_t size;              /* Size of the EEPROM data */
-    uint32_t crc;               /* CRC value of the EEPROM data */
-    uint32_t sector;            /* Sector number of the Flash memory, where NVM data is stored */
-    uint32_t lastCrc;           /* Last CRC value of the EEPROM data */
+    uint8_t *data;                          /* Pointer to the RAM buffer */
+    const uint8_t *defaultData;             /* Pointer to the default data */
+    uint32_t size;                          /* Size of the EEPROM data */
+    uint32_t crc;                           /* CRC value of the EEPROM data */
+    uint32_t sectors[NVM_JOURNAL_SECTORS];  /* Sector numbers of the Flash memory, where the journal is stored */
+    uint16_t version;                       /* Layout version stored with every record */
+    NVM_MigrateFunc_T migrate;              /* Converts records of older layouts, optional */
+    uint32_t legacySize;                    /* Size of the data stored before the journal, raw and followed by its
+                                               CRC32 at the start of the first sector, 0 if there is none */
+    NVM_LoadSource_T loadSource;            /* Origin of the data loaded by NVM_Read */
+    uint32_t lastCrc;                       /* Last CRC value of the EEPROM data */
+
+    /* Journal state, restored by NVM_Read */
+    int8_t activeSector;                    /* Index of the sector records are appended to, -1 if none */
+    uint32_t generation;                    /* Generation of the active sector, incremented on every swap */
+    uint32_t sequence;                      /* Sequence number of the newest record */
+    uint32_t writeOffset;                   /* Offset of the next record in the active sector */
+    uint32_t indexCount;                    /* Number of footer index entries in the active sector */
+
+    /* Background flush */
+    uint8_t *staged;                        /* Pointer to the RAM copy being flushed, of the EEPROM data size */
+    NVM_FlushState_T flushState;            /* Step of the flush in progress */
+    int8_t flushSector;                     /* Index of the sector being erased by a swap */
+    bool isFlushFailed;                     /* The last flush failed */
+    bool isWriteRequested;                  /* The data was written again while the staged copy was being flushed */
+    uint32_t stagedCrc;                     /* CRC value of the staged data */
+    uint32_t recordCrc;                     /* CRC value of the record being flushed */
+    uint32_t recordOffset;                  /* Offset of the record being flushed in the active sector */
+    uint32_t flushOffset;                   /* Bytes of the record programmed so far */
 } Nvm_Instance_T;
 
 /******************************************************************************************
@@ -34,6 +94,18 @@ typedef struct
 int NVM_Init(Nvm_Instance_T *const nvm);
 int NVM_Read(Nvm_Instance_T *const nvm);
 int NVM_Write(Nvm_Instance_T *const nvm);
+int NVM_RequestWrite(Nvm_Instance_T *const nvm);
+void NVM_Process(Nvm_Instance_T *const nvm, bool isFlushAllowed);
+NVM_Status_T NVM_GetStatus(const Nvm_Instance_T *const nvm);
 int NVM_Erase(Nvm_Instance_T *const nvm);
 
+/* Flash and CRC access, implemented in nvm_stm32f7xx.c for the target */
+bool NVM_Port_IsSectorValid(uint32_t sector);
+const uint8_t *NVM_Port_GetSectorAddress(uint32_t sector);
+uint32_t NVM_Port_GetSectorSize(uint32_t sector);
+int NVM_Port_StartErase(uint32_t sector);
+int NVM_Port_GetEraseStatus(void);
+int NVM_Port_Program(const uint8_t *address, const uint8_t *data, uint32_t size);
+uint32_t NVM_Port_CalculateCrc(const uint8_t *data, uint32_t size, bool accumulate);
+
 #endif /* __NVM__H__ */
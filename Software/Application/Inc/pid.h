@@ -9,6 +9,8 @@
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
+/* Breakpoints of a gain schedule */
+#define PID_GAIN_SCHEDULE_POINTS    4U
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
@@ -27,13 +29,31 @@ typedef struct
 
 typedef struct
 {
-    PID_Settings_T *settings;
+    const PID_Settings_T *settings;
 
     float integral;       /* Integral term */
     float setpoint;       /* Desired value */
     float error_previous; /* Error at previous step */
 } PID_Instance_T;
 
+/* Gains at breakpoints of the scheduling input, stored in NVM */
+typedef struct
+{
+    float inputs[PID_GAIN_SCHEDULE_POINTS]; /* Ascending, the schedule is disabled otherwise */
+    float kp[PID_GAIN_SCHEDULE_POINTS];
+    float ki[PID_GAIN_SCHEDULE_POINTS];
+    float kd[PID_GAIN_SCHEDULE_POINTS];
+} PID_GainSchedule_T;
+
+/* Gain schedule compiled into segments, gain = gains + slopes * (input - start) */
+typedef struct
+{
+    float starts[PID_GAIN_SCHEDULE_POINTS];
+    float gains[PID_GAIN_SCHEDULE_POINTS][3];
+    float slopes[PID_GAIN_SCHEDULE_POINTS][3];
+    uint32_t count; /* Breakpoints in use, 0 if the schedule is disabled */
+} PID_GainTable_T;
+
 /******************************************************************************************
  *                                    GLOBAL VARIABLES                                    *
  ******************************************************************************************/
@@ -43,5 +63,8 @@ typedef struct
  ******************************************************************************************/
 int PID_Init(PID_Instance_T *const pid);
 float PID_Update(PID_Instance_T *const pid, const float measured, const float dt);
+int PID_CompileGainTable(PID_GainTable_T *const table, const PID_GainSchedule_T *const schedule);
+void PID_ScheduleGains(PID_Instance_T *const pid, PID_Settings_T *const settings, const PID_GainTable_T *const table,
+                       const float input);
 
 #endif /* __PID__H__ */
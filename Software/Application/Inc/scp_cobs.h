@@ -0,0 +1,35 @@
+#ifndef __SCP_COBS_H__
+#define __SCP_COBS_H__
+
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define SCP_COBS_DELIMITER              0x00U
+
+/* Worst case number of bytes added by the encoding, also the headroom needed by SCP_Cobs_EncodeInPlace */
+#define SCP_COBS_OVERHEAD(size)         (((size) / 254U) + 1U)
+#define SCP_COBS_ENCODED_MAX_SIZE(size) ((size) + SCP_COBS_OVERHEAD(size))
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                    GLOBAL VARIABLES                                    *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTION PROTOTYPES                                  *
+ ******************************************************************************************/
+size_t SCP_Cobs_EncodeInPlace(uint8_t *buffer, size_t size);
+bool SCP_Cobs_IsValid(const uint8_t *buffer, size_t size);
+size_t SCP_Cobs_DecodeInPlace(uint8_t *buffer, size_t size);
+
+#endif /* __SCP_COBS_H__ */
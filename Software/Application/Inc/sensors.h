@@ -10,6 +10,12 @@
 #include "gpio.h"
 #include "linefollower_config.h"
 
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Errors kept by the line tracker for the prediction after a line loss */
+#define SENSORS_TRACKER_SAMPLES     8U
+
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
  ******************************************************************************************/
@@ -23,9 +29,44 @@ typedef struct
 typedef struct
 {
     bool isActive;
-    int8_t positionWeight;
+    float lineLevel;        /* Averaged reading of the line */
+    float backgroundLevel;  /* Averaged reading of the background */
+    float threshold;        /* Adapted threshold, rounded into Sensors_Instance_T thresholds */
 } Sensor_Instance_T;
 
+/* Error calculation settings, compiled from NVM_Sensors_T when the parameters change */
+typedef struct
+{
+    float weights[SENSORS_NUMBER];
+    float errorThreshold;
+    float fallbackErrorPositive;
+    float fallbackErrorNegative;
+    float lineLossDecay;    /* Time in which the prediction gives way to the fallback errors [ms] */
+} Sensors_ErrorConfig_T;
+
+/* Online threshold adaptation settings, compiled from NVM_SensorsAdaptation_T */
+typedef struct
+{
+    float rate;             /* 0 disables the adaptation */
+    float margin;
+    float maxDeviation;
+    float maxStepPerMs;
+} Sensors_AdaptConfig_T;
+
+/* Recent errors while the line is detected, a line fitted to them predicts the error after a loss */
+typedef struct
+{
+    float errors[SENSORS_TRACKER_SAMPLES];
+    float intervals[SENSORS_TRACKER_SAMPLES];   /* Time since the previous sample [ms] */
+    uint8_t head;                               /* Index of the next sample */
+    uint8_t count;
+    float elapsed;              /* Time since the last sample [ms] */
+    float predictedError;       /* Fitted error at the last sample */
+    float errorRate;            /* Fitted error rate [1/ms] */
+    float lastError;            /* Last returned error */
+    bool isLineLost;
+} Sensors_LineTracker_T;
+
 typedef void (*Sensor_DataUpdatedCb_T)(void *context);
 
 typedef struct
@@ -43,12 +84,14 @@ typedef struct
     const Sensors_Config_T *const config;
     Sensor_Instance_T sensors[SENSORS_NUMBER];
     uint16_t thresholds[SENSORS_NUMBER];
+    uint16_t calibratedThresholds[SENSORS_NUMBER];
     bool anySensorDetectedLine;
     bool rightAngleDetected;
     bool straightLineDetected;
     bool stabilizeDetected;
     Sensor_DataUpdatedCb_T callback;
     void *callbackContext;
+    Sensors_LineTracker_T tracker;
 } Sensors_Instance_T;
 
 /******************************************************************************************
@@ -58,10 +101,14 @@ typedef struct
 int Sensors_Init(Sensors_Instance_T *const instance,
                  Sensor_DataUpdatedCb_T callback,
                  void *callbackContext);
-void Sensors_SetThresholds(Sensors_Instance_T *const instance, uint16_t *const thresholds);
+void Sensors_SetCalibration(Sensors_Instance_T *const instance, const uint16_t *const thresholds,
+                            const uint16_t *const backgroundLevels, const uint16_t *const lineLevels);
+void Sensors_AdaptThresholds(Sensors_Instance_T *const instance, const Sensors_AdaptConfig_T *const config, float dt);
 void Sensors_GetRawData(Sensors_Instance_T *const instance, uint16_t *data);
 void Sensors_UpdateLeds(Sensors_Instance_T *const instance);
-float Sensors_CalculateError(Sensors_Instance_T *const instance, const NVM_Sensors_T *const nvmSensors);
+void Sensors_ResetTracker(Sensors_Instance_T *const instance);
+float Sensors_CalculateError(Sensors_Instance_T *const instance, const Sensors_ErrorConfig_T *const config,
+                             float dt);
 void Sensors_ADCConvCpltCallback(Sensors_Instance_T *const instance, ADC_HandleTypeDef *hadc);
 
 #endif /* __SENSORS_H__ */
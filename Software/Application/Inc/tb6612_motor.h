@@ -33,6 +33,7 @@ typedef struct
     TB6612MotorPin_T in2;
     TIM_HandleTypeDef *pwmTimer;
     uint32_t pwmChannel;
+    TB6612MotorDirection_T direction;   /* Last direction written to the pins */
 } TB6612MotorDriver_T;
 
 /******************************************************************************************
@@ -42,10 +43,10 @@ typedef struct
 /******************************************************************************************
  *                                   FUNCTION PROTOTYPES                                  *
  ******************************************************************************************/
-int TB6612Motor_Init(const TB6612MotorDriver_T *const driver);
-void TB6612Motor_ChangeDirection(const TB6612MotorDriver_T *const driver, TB6612MotorDirection_T direction);
+int TB6612Motor_Init(TB6612MotorDriver_T *const driver);
+void TB6612Motor_ChangeDirection(TB6612MotorDriver_T *const driver, TB6612MotorDirection_T direction);
 void TB6612Motor_SetSpeed(const TB6612MotorDriver_T *const driver, uint16_t speed);
-void TB6612Motor_Stop(const TB6612MotorDriver_T *const driver);
-void TB6612Motor_Brake(const TB6612MotorDriver_T *const driver);
+void TB6612Motor_Stop(TB6612MotorDriver_T *const driver);
+void TB6612Motor_Brake(TB6612MotorDriver_T *const driver);
 
 #endif /* __TB6612FNG_MOTOR_H__ */
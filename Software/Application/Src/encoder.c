@@ -2,7 +2,6 @@
  *                                        INCLUDES                                        *
  ******************************************************************************************/
 #include "encoder.h"
-#include <math.h>
 
 /******************************************************************************************
  *                                         DEFINES                                        *
@@ -46,6 +45,10 @@ int Encoder_Init(Encoder_Instance_T *const encoder)
 
     encoder->timerMax = __HAL_TIM_GET_AUTORELOAD(encoder->htim);
 
+    /* Wheel circumference per motor revolution, divided among the encoder pulses */
+    encoder->metersPerPulse = (PI * encoder->settings->wheelDiameter) /
+                              (encoder->settings->gearRatio * (float)encoder->settings->pulsesPerRevolution);
+
     encoder->countPrev = 0;
     encoder->deltaCount = 0;
     encoder->velocity = 0.0f;
@@ -118,19 +121,17 @@ void Encoder_Update(Encoder_Instance_T *const encoder, float dt)
         delta += maxCount;
     }
 
+    if (encoder->isReversed)
+    {
+        delta = -delta;
+    }
+
     encoder->deltaCount = delta;
     encoder->countPrev = rawCount;
 
-    /* Calculate motor rotations */
-    float motorRotations = (float)(encoder->deltaCount) / (float)(encoder->settings->pulsesPerRevolution);
-
-    /* Calculate wheel rotations considering gearbox ratio */
-    float wheelRotations = motorRotations / encoder->settings->gearRatio;
-
     /* Calculate linear distance traveled (in meters) */
-    float circumference = PI * encoder->settings->wheelDiameter;
-    float distance = wheelRotations * circumference;
+    float distance = (float)encoder->deltaCount * encoder->metersPerPulse;
 
-    /* Calculate velocity (multiplied by 1000 to get meters per second) */
-    encoder->velocity = fabs(distance * 1000.0 / dt);
+    /* Calculate signed velocity (multiplied by 1000 to get meters per second) */
+    encoder->velocity = distance * 1000.0f / dt;
 }
@@ -0,0 +1,232 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "linefollower_config.h"
+#include "linefollower_commands.h"
+#include "tb6612_motor.h"
+#include "lf_autotune.h"
+#include "lf_motor_model.h"
+#include <math.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define LF_AUTOTUNE_MAX_PWM     999.0f
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef struct
+{
+    LF_Relay_T relays[LF_AUTOTUNE_LOOP_NB];
+    float wheelBias[2];                     /* PWM around which the wheel relays switch */
+    float elapsed;                          /* [ms] */
+    bool isLineLoop;
+    uint32_t prevCycleCount;
+} LF_AutotuneData_T;
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static uint16_t LF_AutotuneClampPwm(float pwm);
+static LF_AutotuneStatus_T LF_UpdateWheelLoops(LineFollower_T *const me, float dt);
+static LF_AutotuneStatus_T LF_UpdateLineLoop(LineFollower_T *const me, float dt);
+static void LF_SendAutotuneResult(LineFollower_T *const me, LF_AutotuneLoop_T loop);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+static LF_AutotuneData_T LF_AutotuneData;
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+static uint16_t LF_AutotuneClampPwm(float pwm)
+{
+    if (pwm < 0.0f)
+    {
+        return 0U;
+    }
+    else if (pwm > LF_AUTOTUNE_MAX_PWM)
+    {
+        return (uint16_t)LF_AUTOTUNE_MAX_PWM;
+    }
+
+    return (uint16_t)pwm;
+}
+
+/**
+ * @brief Runs the relays of both wheel velocity loops, the robot spins in place. The relays switch
+ *        the PWM around the bias, the PID is not used.
+ */
+static LF_AutotuneStatus_T LF_UpdateWheelLoops(LineFollower_T *const me, float dt)
+{
+    /* The wheels turn in opposite directions */
+    float errorLeft = autotuneSettings.wheelVelocity - fabsf(me->encoderLeft.velocity);
+    float errorRight = autotuneSettings.wheelVelocity - fabsf(me->encoderRight.velocity);
+    float outputLeft = LF_Relay_Update(&LF_AutotuneData.relays[LF_AUTOTUNE_WHEEL_LEFT], errorLeft, dt);
+    float outputRight = LF_Relay_Update(&LF_AutotuneData.relays[LF_AUTOTUNE_WHEEL_RIGHT], errorRight, dt);
+
+    TB6612Motor_SetSpeed(me->motorLeft, LF_AutotuneClampPwm(LF_AutotuneData.wheelBias[0] + outputLeft));
+    TB6612Motor_SetSpeed(me->motorRight, LF_AutotuneClampPwm(LF_AutotuneData.wheelBias[1] + outputRight));
+
+    if (LF_Relay_IsComplete(&LF_AutotuneData.relays[LF_AUTOTUNE_WHEEL_LEFT]) &&
+        LF_Relay_IsComplete(&LF_AutotuneData.relays[LF_AUTOTUNE_WHEEL_RIGHT]))
+    {
+        return LF_AUTOTUNE_COMPLETE;
+    }
+
+    return LF_AUTOTUNE_IN_PROGRESS;
+}
+
+/**
+ * @brief Runs the relay of the line loop in place of the line PID, the robot follows the line at a
+ *        low speed with the wheel PIDs and the feedforward as in a run.
+ */
+static LF_AutotuneStatus_T LF_UpdateLineLoop(LineFollower_T *const me, float dt)
+{
+    me->debugData.sensorError = Sensors_CalculateError(&me->sensorsInstance, &me->params->sensors, dt);
+
+    if (!me->sensorsInstance.anySensorDetectedLine)
+    {
+        return LF_AUTOTUNE_ERROR;
+    }
+
+    /* Same sign as the output of the line PID, whose setpoint is 0 */
+    float output = LF_Relay_Update(&LF_AutotuneData.relays[LF_AUTOTUNE_LINE], -me->debugData.sensorError, dt);
+    float targetSpeedLeft = autotuneSettings.lineSpeed - output;
+    float targetSpeedRight = autotuneSettings.lineSpeed + output;
+
+    me->pidEncoderLeftInstance.setpoint = targetSpeedLeft;
+    me->pidEncoderRightInstance.setpoint = targetSpeedRight;
+
+    float pwmLeft = PID_Update(&me->pidEncoderLeftInstance, me->encoderLeft.velocity, dt) +
+                    LF_MotorModel_GetPwm(&me->params->feedforwardLeft, targetSpeedLeft);
+    float pwmRight = PID_Update(&me->pidEncoderRightInstance, me->encoderRight.velocity, dt) +
+                     LF_MotorModel_GetPwm(&me->params->feedforwardRight, targetSpeedRight);
+
+    TB6612Motor_SetSpeed(me->motorLeft, LF_AutotuneClampPwm(pwmLeft));
+    TB6612Motor_SetSpeed(me->motorRight, LF_AutotuneClampPwm(pwmRight));
+
+    return LF_Relay_IsComplete(&LF_AutotuneData.relays[LF_AUTOTUNE_LINE]) ? LF_AUTOTUNE_COMPLETE
+                                                                             : LF_AUTOTUNE_IN_PROGRESS;
+}
+
+/**
+ * @brief Sends the ultimate point of a loop and the gains of every tuning rule to the PC application.
+ */
+static void LF_SendAutotuneResult(LineFollower_T *const me, LF_AutotuneLoop_T loop)
+{
+    LF_AutotuneResult_T response = {.loop = (uint8_t)loop, .status = 0U};
+
+    for (uint32_t rule = 0U; rule < LF_RELAY_RULE_NB; rule++)
+    {
+        LF_RelayResult_T result;
+
+        if (LF_Relay_GetResult(&LF_AutotuneData.relays[loop], (LF_RelayRule_T)rule, &result) != 0)
+        {
+            response.status = 1U;
+            break;
+        }
+
+        response.ultimateGain = result.ultimateGain;
+        response.ultimatePeriod = result.ultimatePeriod;
+        response.gains[rule][0] = result.kp;
+        response.gains[rule][1] = result.ki;
+        response.gains[rule][2] = result.kd;
+    }
+
+    (void)SCP_Transmit(&me->scpInstance, LF_CMD_AUTOTUNE, &response, sizeof(response));
+}
+
+/**
+ * @brief Starts the relay feedback experiments. The wheel loops are tuned together while the robot
+ *        spins in place, the line loop while it follows a line at a low speed. The encoders and the
+ *        PIDs have to be reset before.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ * @param[in] isLineLoop Tune the line loop instead of the wheel loops.
+ */
+void LF_StartAutotune(LineFollower_T *const me, bool isLineLoop)
+{
+    LF_Relay_Init(&LF_AutotuneData.relays[LF_AUTOTUNE_WHEEL_LEFT], autotuneSettings.wheelAmplitude,
+                  autotuneSettings.wheelHysteresis);
+    LF_Relay_Init(&LF_AutotuneData.relays[LF_AUTOTUNE_WHEEL_RIGHT], autotuneSettings.wheelAmplitude,
+                  autotuneSettings.wheelHysteresis);
+    LF_Relay_Init(&LF_AutotuneData.relays[LF_AUTOTUNE_LINE], autotuneSettings.lineAmplitude,
+                  autotuneSettings.lineHysteresis);
+
+    /* The identified motor curves center the relays, the fixed bias is used without them */
+    LF_AutotuneData.wheelBias[0] = (float)autotuneSettings.wheelBias;
+    LF_AutotuneData.wheelBias[1] = (float)autotuneSettings.wheelBias;
+
+    if (me->params->feedforwardLeft.isEnabled)
+    {
+        LF_AutotuneData.wheelBias[0] = LF_MotorModel_GetPwm(&me->params->feedforwardLeft,
+                                                            autotuneSettings.wheelVelocity);
+    }
+    if (me->params->feedforwardRight.isEnabled)
+    {
+        LF_AutotuneData.wheelBias[1] = LF_MotorModel_GetPwm(&me->params->feedforwardRight,
+                                                            autotuneSettings.wheelVelocity);
+    }
+
+    LF_AutotuneData.elapsed = 0.0f;
+    LF_AutotuneData.isLineLoop = isLineLoop;
+    LF_AutotuneData.prevCycleCount = *(me->cycleCountReg);
+
+    TB6612Motor_ChangeDirection(me->motorLeft, MOTOR_FORWARD);
+    TB6612Motor_ChangeDirection(me->motorRight, isLineLoop ? MOTOR_FORWARD : MOTOR_BACKWARD);
+}
+
+/**
+ * @brief Advances the experiments, to be called every control cycle. Every call takes constant time,
+ *        the gains are only calculated when the results are sent.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ *
+ * @return LF_AUTOTUNE_COMPLETE when every relay measured its cycles, LF_AUTOTUNE_ERROR on a timeout
+ *         or a lost line, LF_AUTOTUNE_IN_PROGRESS otherwise.
+ */
+LF_AutotuneStatus_T LF_UpdateAutotune(LineFollower_T *const me)
+{
+    uint32_t currCycleCount = *(me->cycleCountReg);
+    float dt = (float)(currCycleCount - LF_AutotuneData.prevCycleCount) * me->msPerCycle;
+
+    LF_AutotuneData.prevCycleCount = currCycleCount;
+    LF_AutotuneData.elapsed += dt;
+
+    if (LF_AutotuneData.elapsed > (float)autotuneSettings.timeout)
+    {
+        return LF_AUTOTUNE_ERROR;
+    }
+
+    Encoder_Update(&me->encoderLeft, dt);
+    Encoder_Update(&me->encoderRight, dt);
+
+    return LF_AutotuneData.isLineLoop ? LF_UpdateLineLoop(me, dt) : LF_UpdateWheelLoops(me, dt);
+}
+
+/**
+ * @brief Stops the motors and sends the result of every tuned loop, a loop that did not complete
+ *        is reported as failed.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ */
+void LF_StopAutotune(LineFollower_T *const me)
+{
+    TB6612Motor_Brake(me->motorLeft);
+    TB6612Motor_Brake(me->motorRight);
+    TB6612Motor_SetSpeed(me->motorLeft, 0U);
+    TB6612Motor_SetSpeed(me->motorRight, 0U);
+
+    if (LF_AutotuneData.isLineLoop)
+    {
+        LF_SendAutotuneResult(me, LF_AUTOTUNE_LINE);
+    }
+    else
+    {
+        LF_SendAutotuneResult(me, LF_AUTOTUNE_WHEEL_LEFT);
+        LF_SendAutotuneResult(me, LF_AUTOTUNE_WHEEL_RIGHT);
+    }
+}
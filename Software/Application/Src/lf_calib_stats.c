@@ -0,0 +1,172 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_calib_stats.h"
+#include <string.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define LF_CALIB_STATS_BIN_CENTER(bin) \
+    ((float)((bin) << LF_CALIB_STATS_BIN_SHIFT) + (float)(1U << (LF_CALIB_STATS_BIN_SHIFT - 1U)))
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static void LF_CalibStats_Trim(uint16_t bins[LF_CALIB_STATS_BINS], uint32_t count, bool fromTop);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+static void LF_CalibStats_Trim(uint16_t bins[LF_CALIB_STATS_BINS], uint32_t count, bool fromTop)
+{
+    for (uint32_t i = 0U; (i < LF_CALIB_STATS_BINS) && (count > 0U); i++)
+    {
+        uint16_t *bin = &bins[fromTop ? (LF_CALIB_STATS_BINS - 1U - i) : i];
+        uint16_t removed = (*bin < count) ? *bin : (uint16_t)count;
+
+        *bin -= removed;
+        count -= removed;
+    }
+}
+
+void LF_CalibStats_Reset(LF_CalibStats_Histogram_T *const histogram)
+{
+    memset(histogram->bins, 0, sizeof(histogram->bins));
+}
+
+/**
+ * @brief Adds a reading to the histogram. A full bin halves the whole histogram, which keeps
+ *        its shape for an arbitrary long calibration.
+ */
+void LF_CalibStats_Add(LF_CalibStats_Histogram_T *const histogram, uint16_t value)
+{
+    if (value > LF_CALIB_STATS_ADC_MAX)
+    {
+        value = LF_CALIB_STATS_ADC_MAX;
+    }
+
+    uint16_t *bin = &histogram->bins[value >> LF_CALIB_STATS_BIN_SHIFT];
+
+    if (*bin == UINT16_MAX)
+    {
+        for (uint32_t i = 0U; i < LF_CALIB_STATS_BINS; i++)
+        {
+            histogram->bins[i] >>= 1U;
+        }
+    }
+
+    (*bin)++;
+}
+
+/**
+ * @brief Splits the readings of one channel into the background and the line with the Otsu
+ *        method, after the outliers on both ends of the histogram are dropped.
+ *
+ * @param[in] histogram Readings collected during the calibration.
+ * @param[out] result Threshold and normalization of the channel.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if there are too few readings or the line cannot be told from the background.
+ */
+int LF_CalibStats_Compute(const LF_CalibStats_Histogram_T *const histogram, LF_CalibStats_Result_T *const result)
+{
+    uint16_t bins[LF_CALIB_STATS_BINS];
+    uint32_t total = 0U;
+
+    memcpy(bins, histogram->bins, sizeof(bins));
+
+    for (uint32_t i = 0U; i < LF_CALIB_STATS_BINS; i++)
+    {
+        total += bins[i];
+    }
+
+    if (total < LF_CALIB_STATS_MIN_SAMPLES)
+    {
+        return -1;
+    }
+
+    uint32_t outliers = total / LF_CALIB_STATS_OUTLIER_DIVIDER;
+
+    LF_CalibStats_Trim(bins, outliers, false);
+    LF_CalibStats_Trim(bins, outliers, true);
+    total -= 2U * outliers;
+
+    float sum = 0.0f;
+
+    for (uint32_t i = 0U; i < LF_CALIB_STATS_BINS; i++)
+    {
+        sum += (float)bins[i] * LF_CALIB_STATS_BIN_CENTER(i);
+    }
+
+    /* The split maximizing the variance between the classes */
+    float bestVariance = 0.0f;
+    float backgroundMean = 0.0f;
+    float lineMean = 0.0f;
+    uint32_t backgroundWeight = 0U;
+    uint32_t split = LF_CALIB_STATS_BINS;
+    uint32_t splitEnd = LF_CALIB_STATS_BINS;
+    uint32_t weight = 0U;
+    float partialSum = 0.0f;
+
+    for (uint32_t i = 0U; i < (LF_CALIB_STATS_BINS - 1U); i++)
+    {
+        weight += bins[i];
+        partialSum += (float)bins[i] * LF_CALIB_STATS_BIN_CENTER(i);
+
+        if ((weight == 0U) || (weight == total))
+        {
+            continue;
+        }
+
+        float mean0 = partialSum / (float)weight;
+        float mean1 = (sum - partialSum) / (float)(total - weight);
+        float variance = (float)weight * (float)(total - weight) * (mean1 - mean0) * (mean1 - mean0);
+
+        if (variance > bestVariance)
+        {
+            bestVariance = variance;
+            backgroundMean = mean0;
+            lineMean = mean1;
+            backgroundWeight = weight;
+            split = i;
+            splitEnd = i;
+        }
+        else if (variance == bestVariance)
+        {
+            /* Empty bins between the classes give the same split, the threshold is centered in the gap */
+            splitEnd = i;
+        }
+    }
+
+    if (split == LF_CALIB_STATS_BINS)
+    {
+        return -1;
+    }
+
+    uint32_t lineWeight = total - backgroundWeight;
+
+    if (((backgroundWeight * LF_CALIB_STATS_CLASS_DIVIDER) < total) ||
+        ((lineWeight * LF_CALIB_STATS_CLASS_DIVIDER) < total) ||
+        ((lineMean - backgroundMean) < (float)LF_CALIB_STATS_MIN_CONTRAST))
+    {
+        return -1;
+    }
+
+    result->threshold = (uint16_t)(((split + splitEnd + 2U) << LF_CALIB_STATS_BIN_SHIFT) / 2U);
+    result->background = (uint16_t)(backgroundMean + 0.5f);
+    result->line = (uint16_t)(lineMean + 0.5f);
+    result->offset = result->background;
+    result->gain = (float)LF_CALIB_STATS_NORMALIZED_MAX / (lineMean - backgroundMean);
+
+    return 0;
+}
@@ -3,30 +3,44 @@
  ******************************************************************************************/
 #include "nvm.h"
 #include "linefollower_config.h"
+#include "linefollower_commands.h"
 #include "sensors.h"
 #include "tb6612_motor.h"
 #include "lf_calibrate.h"
+#include "lf_calib_stats.h"
+#include <math.h>
 
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
-#define CALIB_MIN_VALUE_IDX       0
-#define CALIB_MAX_VALUE_IDX       1
-#define DEFAULT_MOTOR_SPEED       150U
+#define LF_CALIB_ALL_CHANNELS       ((uint16_t)((1U << SENSORS_NUMBER) - 1U))
+/* Sweep ends before the calibration may complete, the first one covers only half of the range */
+#define LF_CALIB_MIN_SWEEPS         2U
+/* A channel is stable when its threshold moved by at most one histogram bin over a sweep */
+#define LF_CALIB_STABLE_TOLERANCE   (1U << LF_CALIB_STATS_BIN_SHIFT)
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
  ******************************************************************************************/
 typedef struct
 {
-    uint16_t sensorValues[SENSORS_NUMBER][2];
-    uint16_t motorSpeed;
+    LF_CalibStats_Histogram_T histograms[SENSORS_NUMBER];
+    uint16_t thresholds[SENSORS_NUMBER];    /* Found at the end of the previous sweep */
+    uint16_t stableChannels;
+    uint16_t failedChannels;
+    float heading;                          /* Rotation from the start heading [rad] */
+    float direction;                        /* 1.0 while rotating clockwise, -1.0 otherwise */
+    uint8_t sweeps;
+    uint32_t prevCycleCount;
 } LF_CalibrationData_T;
 
 /******************************************************************************************
  *                                   FUNCTIONS PROTOTYPES                                 *
  ******************************************************************************************/
-static int LF_ApplySensorThresholds(LineFollower_T *const me);
+static uint16_t LF_ApplySensorThresholds(LineFollower_T *const me);
+static void LF_SetSweepDirection(LineFollower_T *const me, float direction);
+static void LF_UpdateHeading(LineFollower_T *const me);
+static void LF_CheckConvergence(LineFollower_T *const me);
 
 /******************************************************************************************
  *                                        VARIABLES                                       *
@@ -36,62 +50,182 @@ static LF_CalibrationData_T LF_CalibrationData;
 /******************************************************************************************
  *                                        FUNCTIONS                                       *
  ******************************************************************************************/
-static int LF_ApplySensorThresholds(LineFollower_T *const me)
+/**
+ * @brief Stores the threshold and the normalization of every channel that separates the line from
+ *        the background, a failed channel keeps its previous calibration.
+ *
+ * @return Bit mask of the failed channels.
+ */
+static uint16_t LF_ApplySensorThresholds(LineFollower_T *const me)
 {
+    NVM_Layout_T *layout = me->nvmBlock;
+    uint16_t failedChannels = 0U;
+
     for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
     {
-        uint16_t minValue = LF_CalibrationData.sensorValues[i][CALIB_MIN_VALUE_IDX];
-        uint16_t maxValue = LF_CalibrationData.sensorValues[i][CALIB_MAX_VALUE_IDX];
-        uint16_t range = maxValue - minValue;
-        uint16_t threshold = minValue + (range / 2U);
+        LF_CalibStats_Result_T result;
+
+        if (LF_CalibStats_Compute(&LF_CalibrationData.histograms[i], &result) != 0)
+        {
+            failedChannels |= (uint16_t)(1U << i);
+            continue;
+        }
+
+        layout->sensors.thresholds[i] = result.threshold;
+        layout->normalization.offsets[i] = result.offset;
+        layout->normalization.gains[i] = result.gain;
+    }
 
-        me->nvmBlock->sensors.thresholds[i] = threshold;
+    if (failedChannels != LF_CALIB_ALL_CHANNELS)
+    {
+        LF_StageParams(me);
+        (void)LF_StoreParams(me);
     }
 
-    Sensors_SetThresholds(&me->sensorsInstance, me->nvmBlock->sensors.thresholds);
-    return NVM_Write(&me->nvmInstance);
+    return failedChannels;
+}
+
+static void LF_SetSweepDirection(LineFollower_T *const me, float direction)
+{
+    LF_CalibrationData.direction = direction;
+
+    TB6612Motor_ChangeDirection(me->motorLeft, (direction > 0.0f) ? MOTOR_FORWARD : MOTOR_BACKWARD);
+    TB6612Motor_ChangeDirection(me->motorRight, (direction > 0.0f) ? MOTOR_BACKWARD : MOTOR_FORWARD);
+    TB6612Motor_SetSpeed(me->motorLeft, calibrationSettings.motorSpeed);
+    TB6612Motor_SetSpeed(me->motorRight, calibrationSettings.motorSpeed);
+}
+
+/**
+ * @brief Integrates the rotation of the robot from the encoders. The wheels turn in opposite
+ *        directions, so the travelled arcs are taken as absolute values in the commanded direction.
+ */
+static void LF_UpdateHeading(LineFollower_T *const me)
+{
+    uint32_t currCycleCount = *(me->cycleCountReg);
+    float dt = (float)(currCycleCount - LF_CalibrationData.prevCycleCount) * me->msPerCycle;
+
+    LF_CalibrationData.prevCycleCount = currCycleCount;
+
+    Encoder_Update(&me->encoderLeft, dt);
+    Encoder_Update(&me->encoderRight, dt);
+
+    float arc = 0.5f * (fabsf((float)me->encoderLeft.deltaCount * me->encoderLeft.metersPerPulse) +
+                        fabsf((float)me->encoderRight.deltaCount * me->encoderRight.metersPerPulse));
+
+    LF_CalibrationData.heading += LF_CalibrationData.direction * 2.0f * arc / chassisSettings.trackWidth;
 }
 
-void LF_StopCalibration(LineFollower_T *const me)
+/**
+ * @brief Compares the thresholds found at the end of a sweep with the previous sweep and reports
+ *        the progress to the PC application.
+ */
+static void LF_CheckConvergence(LineFollower_T *const me)
+{
+    LF_CalibrationProgress_T progress;
+
+    LF_CalibrationData.stableChannels = 0U;
+    LF_CalibrationData.failedChannels = 0U;
+
+    for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
+    {
+        LF_CalibStats_Result_T result;
+
+        if (LF_CalibStats_Compute(&LF_CalibrationData.histograms[i], &result) != 0)
+        {
+            LF_CalibrationData.failedChannels |= (uint16_t)(1U << i);
+            LF_CalibrationData.thresholds[i] = 0U;
+            continue;
+        }
+
+        uint16_t change = (result.threshold > LF_CalibrationData.thresholds[i])
+                              ? (result.threshold - LF_CalibrationData.thresholds[i])
+                              : (LF_CalibrationData.thresholds[i] - result.threshold);
+
+        if ((LF_CalibrationData.thresholds[i] != 0U) && (change <= LF_CALIB_STABLE_TOLERANCE))
+        {
+            LF_CalibrationData.stableChannels |= (uint16_t)(1U << i);
+        }
+        LF_CalibrationData.thresholds[i] = result.threshold;
+    }
+
+    progress.sweeps = LF_CalibrationData.sweeps;
+    progress.stableChannels = LF_CalibrationData.stableChannels;
+    progress.failedChannels = LF_CalibrationData.failedChannels;
+    progress.elapsed = (uint16_t)me->timers[LF_TIMER_CALIBRATION].tick;
+    (void)SCP_Transmit(&me->scpInstance, LF_CMD_CALIBRATION_PROGRESS, &progress, sizeof(progress));
+}
+
+/**
+ * @brief Stops the motors and applies the calibration.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ *
+ * @return Bit mask of the channels that could not be calibrated, 0 on success.
+ */
+uint16_t LF_StopCalibration(LineFollower_T *const me)
 {
     TB6612Motor_Brake(me->motorLeft);
     TB6612Motor_Brake(me->motorRight);
     TB6612Motor_SetSpeed(me->motorLeft, 0U);
     TB6612Motor_SetSpeed(me->motorRight, 0U);
 
-    (void)LF_ApplySensorThresholds(me);
+    return LF_ApplySensorThresholds(me);
 }
 
+/**
+ * @brief Starts sweeping the sensors over the line, the encoders have to be reset before.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ */
 void LF_StartCalibration(LineFollower_T *const me)
 {
-    LF_CalibrationData.motorSpeed = DEFAULT_MOTOR_SPEED;
-
     for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
     {
-        LF_CalibrationData.sensorValues[i][CALIB_MIN_VALUE_IDX] = UINT16_MAX;
-        LF_CalibrationData.sensorValues[i][CALIB_MAX_VALUE_IDX] = 0U;
+        LF_CalibStats_Reset(&LF_CalibrationData.histograms[i]);
+        LF_CalibrationData.thresholds[i] = 0U;
     }
 
-    TB6612Motor_ChangeDirection(me->motorLeft, MOTOR_FORWARD);
-    TB6612Motor_ChangeDirection(me->motorRight, MOTOR_BACKWARD);
-    TB6612Motor_SetSpeed(me->motorLeft, LF_CalibrationData.motorSpeed);
-    TB6612Motor_SetSpeed(me->motorRight, LF_CalibrationData.motorSpeed);
+    LF_CalibrationData.stableChannels = 0U;
+    LF_CalibrationData.failedChannels = LF_CALIB_ALL_CHANNELS;
+    LF_CalibrationData.heading = 0.0f;
+    LF_CalibrationData.sweeps = 0U;
+    LF_CalibrationData.prevCycleCount = *(me->cycleCountReg);
+
+    LF_SetSweepDirection(me, 1.0f);
 }
 
-void LF_UpdateCalibrationData(LineFollower_T *const me)
+/**
+ * @brief Collects the readings and reverses the rotation at the end of every sweep. The calibration
+ *        completes once every channel kept its threshold over a whole sweep, the calibration timer
+ *        only limits its duration.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ *
+ * @return LF_CALIBRATION_COMPLETE when all channels converged, LF_CALIBRATION_IN_PROGRESS otherwise.
+ */
+LF_CalibrationStatus_T LF_UpdateCalibrationData(LineFollower_T *const me)
 {
     for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
     {
-        const uint16_t sensorVal = me->sensorsInstance.adcBuffer[i];
+        LF_CalibStats_Add(&LF_CalibrationData.histograms[i], me->sensorsInstance.adcBuffer[i]);
+    }
 
-        if (sensorVal < LF_CalibrationData.sensorValues[i][CALIB_MIN_VALUE_IDX])
-        {
-            LF_CalibrationData.sensorValues[i][CALIB_MIN_VALUE_IDX] = sensorVal;
-        }
+    LF_UpdateHeading(me);
 
-        if (sensorVal > LF_CalibrationData.sensorValues[i][CALIB_MAX_VALUE_IDX])
-        {
-            LF_CalibrationData.sensorValues[i][CALIB_MAX_VALUE_IDX] = sensorVal;
-        }
+    if ((LF_CalibrationData.direction * LF_CalibrationData.heading) < calibrationSettings.sweepAngle)
+    {
+        return LF_CALIBRATION_IN_PROGRESS;
     }
+
+    LF_SetSweepDirection(me, -LF_CalibrationData.direction);
+    LF_CalibrationData.sweeps++;
+    LF_CheckConvergence(me);
+
+    if ((LF_CalibrationData.sweeps >= LF_CALIB_MIN_SWEEPS) &&
+        (LF_CalibrationData.stableChannels == LF_CALIB_ALL_CHANNELS))
+    {
+        return LF_CALIBRATION_COMPLETE;
+    }
+
+    return LF_CALIBRATION_IN_PROGRESS;
 }
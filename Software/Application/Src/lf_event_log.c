@@ -0,0 +1,94 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_event_log.h"
+#include <stddef.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Empties the log, the event times are counted from now.
+ *
+ * @param[out] log Pointer to the event log.
+ * @param[in] now Current time [ms].
+ */
+void LF_EventLog_Clear(LF_EventLog_T *const log, uint32_t now)
+{
+    log->startTime = now;
+    log->head = 0U;
+    log->count = 0U;
+}
+
+/**
+ * @brief Appends an event, the oldest one is overwritten when the log is full.
+ *
+ * @param[in,out] log Pointer to the event log.
+ * @param[in] now Current time [ms].
+ * @param[in] type Event type.
+ * @param[in] wheel Wheel of the event, 0 if it does not concern a wheel.
+ * @param[in] value Value of the event, saturated to int16_t.
+ */
+void LF_EventLog_Add(LF_EventLog_T *const log, uint32_t now, LF_EventType_T type, uint8_t wheel, float value)
+{
+    LF_Event_T *event;
+
+    if (log->count < LF_EVENT_LOG_SIZE)
+    {
+        event = &log->events[(log->head + log->count) % LF_EVENT_LOG_SIZE];
+        log->count++;
+    }
+    else
+    {
+        event = &log->events[log->head];
+        log->head = (uint16_t)((log->head + 1U) % LF_EVENT_LOG_SIZE);
+    }
+
+    if (value > (float)INT16_MAX)
+    {
+        value = (float)INT16_MAX;
+    }
+    else if (value < (float)INT16_MIN)
+    {
+        value = (float)INT16_MIN;
+    }
+
+    event->time = now - log->startTime;
+    event->type = (uint8_t)type;
+    event->wheel = wheel;
+    event->value = (int16_t)value;
+}
+
+/**
+ * @brief Returns an event of the log.
+ *
+ * @param[in] log Pointer to the event log.
+ * @param[in] index Index of the event, 0 is the oldest one.
+ *
+ * @return Pointer to the event, NULL if the index is past the last event.
+ */
+const LF_Event_T *LF_EventLog_Get(const LF_EventLog_T *const log, uint16_t index)
+{
+    if (index >= log->count)
+    {
+        return NULL;
+    }
+
+    return &log->events[(log->head + index) % LF_EVENT_LOG_SIZE];
+}
@@ -0,0 +1,270 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "linefollower_config.h"
+#include "tb6612_motor.h"
+#include "lf_identify.h"
+#include "lf_motor_model.h"
+#include <math.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define LF_IDENT_WHEEL_LEFT     0U
+#define LF_IDENT_WHEEL_RIGHT    1U
+#define LF_IDENT_WHEELS         2U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef enum
+{
+    LF_IDENT_RAMP,      /* PWM rises until both wheels turn, gives the deadbands */
+    LF_IDENT_SETTLE,    /* Waits for the steady state of a PWM step */
+    LF_IDENT_MEASURE    /* Averages the velocity of a PWM step */
+} LF_IdentificationPhase_T;
+
+typedef struct
+{
+    LF_MotorCurve_T curves[LF_IDENT_WHEELS];
+    float velocitySums[LF_IDENT_WHEELS];
+    bool isTurning[LF_IDENT_WHEELS];
+    float pwm;
+    float elapsed;                          /* Time in the phase [ms] */
+    uint32_t samples;
+    uint8_t step;
+    LF_IdentificationPhase_T phase;
+    uint32_t prevCycleCount;
+} LF_IdentificationData_T;
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static void LF_SetIdentificationPwm(LineFollower_T *const me, float pwm);
+static float LF_GetStepPwm(uint8_t step);
+static LF_IdentificationStatus_T LF_UpdateRamp(LineFollower_T *const me, const float velocities[LF_IDENT_WHEELS],
+                                               float dt);
+static LF_IdentificationStatus_T LF_UpdateStep(LineFollower_T *const me, const float velocities[LF_IDENT_WHEELS],
+                                               float dt);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+static LF_IdentificationData_T LF_IdentificationData;
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+static void LF_SetIdentificationPwm(LineFollower_T *const me, float pwm)
+{
+    LF_IdentificationData.pwm = pwm;
+
+    TB6612Motor_SetSpeed(me->motorLeft, (uint16_t)pwm);
+    TB6612Motor_SetSpeed(me->motorRight, (uint16_t)pwm);
+}
+
+/**
+ * @brief Returns the PWM of a step, the steps divide the range from the higher deadband
+ *        to the maximum PWM of the identification evenly.
+ */
+static float LF_GetStepPwm(uint8_t step)
+{
+    uint16_t deadband = LF_IdentificationData.curves[LF_IDENT_WHEEL_LEFT].pwm[0];
+
+    if (LF_IdentificationData.curves[LF_IDENT_WHEEL_RIGHT].pwm[0] > deadband)
+    {
+        deadband = LF_IdentificationData.curves[LF_IDENT_WHEEL_RIGHT].pwm[0];
+    }
+
+    return (float)deadband + (float)step * (float)(identificationSettings.maxPwm - deadband) /
+                                 (float)(LF_MOTOR_MODEL_POINTS - 1U);
+}
+
+/**
+ * @brief Raises the PWM slowly and stores the PWM at which each wheel starts to turn.
+ *
+ * @return LF_IDENTIFICATION_ERROR if a wheel does not turn below the maximum PWM,
+ *         LF_IDENTIFICATION_IN_PROGRESS otherwise.
+ */
+static LF_IdentificationStatus_T LF_UpdateRamp(LineFollower_T *const me, const float velocities[LF_IDENT_WHEELS],
+                                               float dt)
+{
+    for (uint32_t wheel = 0U; wheel < LF_IDENT_WHEELS; wheel++)
+    {
+        if (!LF_IdentificationData.isTurning[wheel] && (velocities[wheel] > identificationSettings.startVelocity))
+        {
+            LF_IdentificationData.isTurning[wheel] = true;
+            LF_IdentificationData.curves[wheel].pwm[0] = (uint16_t)LF_IdentificationData.pwm;
+            LF_IdentificationData.curves[wheel].velocities[0] = 0.0f;
+        }
+    }
+
+    if (LF_IdentificationData.isTurning[LF_IDENT_WHEEL_LEFT] && LF_IdentificationData.isTurning[LF_IDENT_WHEEL_RIGHT])
+    {
+        if (LF_GetStepPwm(1U) >= (float)identificationSettings.maxPwm)
+        {
+            return LF_IDENTIFICATION_ERROR;
+        }
+
+        LF_IdentificationData.step = 1U;
+        LF_IdentificationData.phase = LF_IDENT_SETTLE;
+        LF_IdentificationData.elapsed = 0.0f;
+        LF_SetIdentificationPwm(me, LF_GetStepPwm(1U));
+
+        return LF_IDENTIFICATION_IN_PROGRESS;
+    }
+
+    float pwm = LF_IdentificationData.pwm + identificationSettings.rampRate * dt;
+
+    if (pwm >= (float)identificationSettings.maxPwm)
+    {
+        return LF_IDENTIFICATION_ERROR;
+    }
+
+    LF_SetIdentificationPwm(me, pwm);
+
+    return LF_IDENTIFICATION_IN_PROGRESS;
+}
+
+/**
+ * @brief Waits for the steady state of the current PWM step, then averages the velocity of
+ *        each wheel and moves to the next step.
+ *
+ * @return LF_IDENTIFICATION_COMPLETE after the last step, LF_IDENTIFICATION_IN_PROGRESS otherwise.
+ */
+static LF_IdentificationStatus_T LF_UpdateStep(LineFollower_T *const me, const float velocities[LF_IDENT_WHEELS],
+                                               float dt)
+{
+    LF_IdentificationData.elapsed += dt;
+
+    if (LF_IdentificationData.phase == LF_IDENT_SETTLE)
+    {
+        if (LF_IdentificationData.elapsed >= (float)identificationSettings.settleTime)
+        {
+            LF_IdentificationData.phase = LF_IDENT_MEASURE;
+            LF_IdentificationData.elapsed = 0.0f;
+            LF_IdentificationData.velocitySums[LF_IDENT_WHEEL_LEFT] = 0.0f;
+            LF_IdentificationData.velocitySums[LF_IDENT_WHEEL_RIGHT] = 0.0f;
+            LF_IdentificationData.samples = 0U;
+        }
+
+        return LF_IDENTIFICATION_IN_PROGRESS;
+    }
+
+    LF_IdentificationData.velocitySums[LF_IDENT_WHEEL_LEFT] += velocities[LF_IDENT_WHEEL_LEFT];
+    LF_IdentificationData.velocitySums[LF_IDENT_WHEEL_RIGHT] += velocities[LF_IDENT_WHEEL_RIGHT];
+    LF_IdentificationData.samples++;
+
+    if (LF_IdentificationData.elapsed < (float)identificationSettings.measureTime)
+    {
+        return LF_IDENTIFICATION_IN_PROGRESS;
+    }
+
+    uint8_t step = LF_IdentificationData.step;
+
+    for (uint32_t wheel = 0U; wheel < LF_IDENT_WHEELS; wheel++)
+    {
+        LF_IdentificationData.curves[wheel].velocities[step] =
+            LF_IdentificationData.velocitySums[wheel] / (float)LF_IdentificationData.samples;
+        LF_IdentificationData.curves[wheel].pwm[step] = (uint16_t)LF_IdentificationData.pwm;
+    }
+
+    if (++LF_IdentificationData.step >= LF_MOTOR_MODEL_POINTS)
+    {
+        return LF_IDENTIFICATION_COMPLETE;
+    }
+
+    LF_IdentificationData.phase = LF_IDENT_SETTLE;
+    LF_IdentificationData.elapsed = 0.0f;
+    LF_SetIdentificationPwm(me, LF_GetStepPwm(LF_IdentificationData.step));
+
+    return LF_IDENTIFICATION_IN_PROGRESS;
+}
+
+/**
+ * @brief Starts the identification of the motors. The robot spins in place so that it stays
+ *        on the spot, the encoders have to be reset before.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ */
+void LF_StartIdentification(LineFollower_T *const me)
+{
+    for (uint32_t wheel = 0U; wheel < LF_IDENT_WHEELS; wheel++)
+    {
+        LF_IdentificationData.isTurning[wheel] = false;
+        LF_IdentificationData.velocitySums[wheel] = 0.0f;
+    }
+
+    LF_IdentificationData.step = 0U;
+    LF_IdentificationData.samples = 0U;
+    LF_IdentificationData.elapsed = 0.0f;
+    LF_IdentificationData.phase = LF_IDENT_RAMP;
+    LF_IdentificationData.prevCycleCount = *(me->cycleCountReg);
+
+    TB6612Motor_ChangeDirection(me->motorLeft, MOTOR_FORWARD);
+    TB6612Motor_ChangeDirection(me->motorRight, MOTOR_BACKWARD);
+    LF_SetIdentificationPwm(me, 0.0f);
+}
+
+/**
+ * @brief Advances the identification with new encoder readings, to be called every control cycle.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ *
+ * @return LF_IDENTIFICATION_COMPLETE after the last PWM step, LF_IDENTIFICATION_ERROR if a wheel
+ *         did not turn, LF_IDENTIFICATION_IN_PROGRESS otherwise.
+ */
+LF_IdentificationStatus_T LF_UpdateIdentification(LineFollower_T *const me)
+{
+    uint32_t currCycleCount = *(me->cycleCountReg);
+    float dt = (float)(currCycleCount - LF_IdentificationData.prevCycleCount) * me->msPerCycle;
+
+    LF_IdentificationData.prevCycleCount = currCycleCount;
+
+    Encoder_Update(&me->encoderLeft, dt);
+    Encoder_Update(&me->encoderRight, dt);
+
+    /* The wheels turn in opposite directions */
+    const float velocities[LF_IDENT_WHEELS] = {fabsf(me->encoderLeft.velocity), fabsf(me->encoderRight.velocity)};
+
+    if (LF_IdentificationData.phase == LF_IDENT_RAMP)
+    {
+        return LF_UpdateRamp(me, velocities, dt);
+    }
+
+    return LF_UpdateStep(me, velocities, dt);
+}
+
+/**
+ * @brief Stops the motors and, after a complete identification, stores the curves in the active profile.
+ *
+ * @param[in,out] me Pointer to the LineFollower_T instance.
+ * @param[in] status Status of the identification.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the identification did not complete or gave curves which are not ascending,
+ *   the previous curves are kept.
+ */
+int LF_StopIdentification(LineFollower_T *const me, LF_IdentificationStatus_T status)
+{
+    LF_MotorFeedforward_T feedforward;
+
+    TB6612Motor_Brake(me->motorLeft);
+    TB6612Motor_Brake(me->motorRight);
+    TB6612Motor_SetSpeed(me->motorLeft, 0U);
+    TB6612Motor_SetSpeed(me->motorRight, 0U);
+
+    if ((status != LF_IDENTIFICATION_COMPLETE) ||
+        (LF_MotorModel_Compile(&feedforward, &LF_IdentificationData.curves[LF_IDENT_WHEEL_LEFT], 1.0f) != 0) ||
+        (LF_MotorModel_Compile(&feedforward, &LF_IdentificationData.curves[LF_IDENT_WHEEL_RIGHT], 1.0f) != 0))
+    {
+        return -1;
+    }
+
+    me->nvmBlock->motorModel.left = LF_IdentificationData.curves[LF_IDENT_WHEEL_LEFT];
+    me->nvmBlock->motorModel.right = LF_IdentificationData.curves[LF_IDENT_WHEEL_RIGHT];
+    LF_StageParams(me);
+
+    return LF_StoreParams(me);
+}
@@ -0,0 +1,101 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_motor_model.h"
+#include <math.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Compiles the velocity to PWM curve of a wheel into segments, to be called when the
+ *        parameters change. The gain scales the whole curve, e.g. for another battery charge.
+ *
+ * @param[out] feedforward Pointer to the compiled curve.
+ * @param[in] curve Pointer to the identified curve.
+ * @param[in] gain Scale of the PWM, 0 disables the feedforward.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the curve is not ascending or the gain is not positive, the feedforward is disabled.
+ */
+int LF_MotorModel_Compile(LF_MotorFeedforward_T *const feedforward, const LF_MotorCurve_T *const curve,
+                          float gain)
+{
+    feedforward->isEnabled = false;
+
+    if (!(gain > 0.0f) || (curve->velocities[0] != 0.0f))
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 1U; i < LF_MOTOR_MODEL_POINTS; i++)
+    {
+        if (!(curve->velocities[i] > curve->velocities[i - 1U]) || (curve->pwm[i] < curve->pwm[i - 1U]))
+        {
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0U; i < LF_MOTOR_MODEL_POINTS; i++)
+    {
+        /* The last segment extrapolates with the slope of the previous one */
+        uint32_t segment = (i + 1U < LF_MOTOR_MODEL_POINTS) ? i : (i - 1U);
+
+        feedforward->velocities[i] = curve->velocities[i];
+        feedforward->pwm[i] = gain * (float)curve->pwm[i];
+        feedforward->slopes[i] = gain * (float)(curve->pwm[segment + 1U] - curve->pwm[segment]) /
+                                 (curve->velocities[segment + 1U] - curve->velocities[segment]);
+    }
+
+    feedforward->isEnabled = true;
+
+    return 0;
+}
+
+/**
+ * @brief Returns the signed PWM which holds the wheel at the given velocity, the deadband is
+ *        included for any velocity other than 0.
+ *
+ * @param[in] feedforward Pointer to the compiled curve.
+ * @param[in] velocity Target velocity of the wheel [m/s], negative backward.
+ *
+ * @return PWM of the feedforward, 0 if it is disabled or the wheel is to stand still.
+ */
+float LF_MotorModel_GetPwm(const LF_MotorFeedforward_T *const feedforward, float velocity)
+{
+    float speed = fabsf(velocity);
+
+    if (!feedforward->isEnabled || !(speed > 0.0f))
+    {
+        return 0.0f;
+    }
+
+    uint32_t segment = 0U;
+
+    while ((segment + 1U < LF_MOTOR_MODEL_POINTS) && (speed >= feedforward->velocities[segment + 1U]))
+    {
+        segment++;
+    }
+
+    float pwm = feedforward->pwm[segment] + feedforward->slopes[segment] * (speed - feedforward->velocities[segment]);
+
+    /* The curve is identified with one wheel turning backward, it holds for both directions */
+    return (velocity < 0.0f) ? -pwm : pwm;
+}
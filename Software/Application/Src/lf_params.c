@@ -0,0 +1,340 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_params.h"
+#include <stddef.h>
+#include <string.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define LF_PARAM_FIELD_SIZE(field)  sizeof(((NVM_Layout_T *)0)->field)
+#define LF_PARAM_TYPE_OF(ctype)     _Generic((ctype)0,              \
+                                        float: LF_PARAM_FLOAT,      \
+                                        uint32_t: LF_PARAM_UINT32,  \
+                                        uint16_t: LF_PARAM_UINT16,  \
+                                        int8_t: LF_PARAM_INT8)
+
+#define LF_PARAM_PID_LIST(X, base, pid)                                                 \
+    X((base) + 0x00U, pid.kp,               float, 1U, 0.0f,        10000.0f)           \
+    X((base) + 0x01U, pid.ki,               float, 1U, 0.0f,        10000.0f)           \
+    X((base) + 0x02U, pid.kd,               float, 1U, 0.0f,        10000.0f)           \
+    X((base) + 0x03U, pid.integral_max,     float, 1U, -10000.0f,   10000.0f)           \
+    X((base) + 0x04U, pid.integral_min,     float, 1U, -10000.0f,   10000.0f)           \
+    X((base) + 0x05U, pid.output_max,       float, 1U, -10000.0f,   10000.0f)           \
+    X((base) + 0x06U, pid.output_min,       float, 1U, -10000.0f,   10000.0f)
+
+/* X(id, field, ctype, count, min, max), sorted by id */
+#define LF_PARAM_LIST(X)                                                                                \
+    LF_PARAM_PID_LIST(X, 0x0100U, pidStgSensor)                                                         \
+    X(0x0110U, sensorGainSchedule.inputs,       float,      PID_GAIN_SCHEDULE_POINTS, 0.0f, 10.0f)      \
+    X(0x0114U, sensorGainSchedule.kp,           float,      PID_GAIN_SCHEDULE_POINTS, 0.0f, 10000.0f)   \
+    X(0x0118U, sensorGainSchedule.ki,           float,      PID_GAIN_SCHEDULE_POINTS, 0.0f, 10000.0f)   \
+    X(0x011CU, sensorGainSchedule.kd,           float,      PID_GAIN_SCHEDULE_POINTS, 0.0f, 10000.0f)   \
+    LF_PARAM_PID_LIST(X, 0x0200U, pidStgEncoderLeft)                                                    \
+    LF_PARAM_PID_LIST(X, 0x0300U, pidStgEncoderRight)                                                   \
+    X(0x0400U, sensors.weights,                 int8_t,     SENSORS_NUMBER, -127.0f,    127.0f)         \
+    X(0x0410U, sensors.thresholds,              uint16_t,   SENSORS_NUMBER, 0.0f,       4095.0f)        \
+    X(0x0420U, sensors.errorThreshold,          float,      1U,             0.0f,       100.0f)         \
+    X(0x0421U, sensors.fallbackErrorPositive,   float,      1U,             -100.0f,    100.0f)         \
+    X(0x0422U, sensors.fallbackErrorNegative,   float,      1U,             -100.0f,    100.0f)         \
+    X(0x0423U, lineLossDecay,                   float,      1U,             0.0f,       10000.0f)       \
+    X(0x0430U, normalization.gains,             float,      SENSORS_NUMBER, 0.0f,       1000.0f)        \
+    X(0x0440U, normalization.offsets,           uint16_t,   SENSORS_NUMBER, 0.0f,       4095.0f)        \
+    X(0x0450U, adaptation.rate,                 float,      1U,             0.0f,       1.0f)           \
+    X(0x0451U, adaptation.margin,               float,      1U,             0.0f,       0.5f)           \
+    X(0x0452U, adaptation.maxDeviation,         uint16_t,   1U,             0.0f,       4095.0f)        \
+    X(0x0453U, adaptation.maxSlewRate,          uint16_t,   1U,             0.0f,       65535.0f)       \
+    X(0x0500U, targetSpeed,                     float,      1U,             0.0f,       10.0f)          \
+    X(0x0510U, speedProfile.maxSpeed,           float,      1U,             0.0f,       10.0f)          \
+    X(0x0511U, speedProfile.maxLateralAccel,    float,      1U,             0.1f,       100.0f)         \
+    X(0x0512U, speedProfile.maxDecel,           float,      1U,             0.1f,       100.0f)         \
+    X(0x0513U, speedProfile.fallbackError,      float,      1U,             0.0f,       100.0f)         \
+    X(0x0520U, straightBoost.speed,             float,      1U,             0.0f,       10.0f)          \
+    X(0x0521U, straightBoost.accel,             float,      1U,             0.1f,       100.0f)         \
+    X(0x0522U, straightBoost.exitError,         float,      1U,             0.0f,       100.0f)         \
+    X(0x0523U, straightBoost.holdDistance,      float,      1U,             0.0f,       10.0f)          \
+    X(0x0524U, straightBoost.holdTime,          uint32_t,   1U,             0.0f,       60000.0f)       \
+    X(0x0530U, speedSchedule.error.inputs,      float,      LF_SPEED_CURVE_POINTS, 0.0f, 100.0f)        \
+    X(0x0536U, speedSchedule.error.factors,     float,      LF_SPEED_CURVE_POINTS, 0.0f, 1.0f)          \
+    X(0x0540U, speedSchedule.errorRate.inputs,  float,      LF_SPEED_CURVE_POINTS, 0.0f, 100000.0f)     \
+    X(0x0546U, speedSchedule.errorRate.factors, float,      LF_SPEED_CURVE_POINTS, 0.0f, 1.0f)          \
+    X(0x0550U, trajectory.launchAccel,          float,      1U,             0.0f,       100.0f)         \
+    X(0x0551U, trajectory.cruiseAccel,          float,      1U,             0.0f,       100.0f)         \
+    X(0x0552U, trajectory.brakeDecel,           float,      1U,             0.0f,       100.0f)         \
+    X(0x0553U, trajectory.jerk,                 float,      1U,             0.0f,       10000.0f)       \
+    X(0x0600U, timerTimeout,                    uint32_t,   LF_TIMER_NB,    0.0f,       60000.0f)       \
+    X(0x0700U, motorModel.left.velocities,      float,      LF_MOTOR_MODEL_POINTS, 0.0f, 100.0f)        \
+    X(0x0708U, motorModel.left.pwm,             uint16_t,   LF_MOTOR_MODEL_POINTS, 0.0f, 1000.0f)       \
+    X(0x0710U, motorModel.right.velocities,     float,      LF_MOTOR_MODEL_POINTS, 0.0f, 100.0f)        \
+    X(0x0718U, motorModel.right.pwm,            uint16_t,   LF_MOTOR_MODEL_POINTS, 0.0f, 1000.0f)       \
+    X(0x0720U, motorModel.gain,                 float,      1U,             0.0f,       2.0f)           \
+    X(0x0730U, drive.reversePolicy,             uint16_t,   1U,             0.0f,       2.0f)           \
+    X(0x0731U, drive.maxReversePwm,             uint16_t,   1U,             0.0f,       999.0f)         \
+    X(0x0740U, traction.maxAccelError,          float,      1U,             0.0f,       1000.0f)        \
+    X(0x0741U, traction.maxSlipSpeed,           float,      1U,             0.0f,       10.0f)          \
+    X(0x0742U, traction.pwmFactor,              float,      1U,             0.0f,       1.0f)           \
+    X(0x0743U, traction.holdTime,               uint32_t,   1U,             1.0f,       10000.0f)
+
+#define LF_PARAM_ENTRY(id, field, ctype, count, min, max) \
+    {(id), (uint16_t)offsetof(NVM_Layout_T, field), LF_PARAM_TYPE_OF(ctype), (count), (min), (max)},
+
+/* The dictionary follows NVM_Layout_T, a changed field type or array length fails the build */
+#define LF_PARAM_CHECK(id, field, ctype, count, min, max) \
+    _Static_assert(LF_PARAM_FIELD_SIZE(field) == (count) * sizeof(ctype), "Parameter does not match NVM_Layout_T: " #field);
+
+/* LF_Params_Find needs the ids sorted and the ranges of the array fields apart. The list folds into
+   ((...((0 <= id0 ? end0 : BAD) <= id1 ? end1 : BAD)...) <= idN ? endN : BAD), the end of the last
+   range if every range starts at or after the end of the previous one, so a resized array that runs
+   into the next id fails the build */
+#define LF_PARAM_ORDER_BAD                                          0x10000U
+#define LF_PARAM_ORDER_OPEN(id, field, ctype, count, min, max)      (
+#define LF_PARAM_ORDER_CLOSE(id, field, ctype, count, min, max)     <= (id) ? (id) + (count) : LF_PARAM_ORDER_BAD)
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static uint8_t *LF_Params_GetAddress(const NVM_Layout_T *const layout, const LF_Param_T *param, uint8_t index);
+static uint32_t LF_Params_GetTypeSize(LF_ParamType_T type);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+LF_PARAM_LIST(LF_PARAM_CHECK)
+_Static_assert((LF_PARAM_LIST(LF_PARAM_ORDER_OPEN) 0U LF_PARAM_LIST(LF_PARAM_ORDER_CLOSE)) < LF_PARAM_ORDER_BAD,
+               "Parameter ids are not sorted or the id range of an array overlaps the next id");
+
+static const LF_Param_T paramDictionary[] = {
+    LF_PARAM_LIST(LF_PARAM_ENTRY)
+};
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+static uint32_t LF_Params_GetTypeSize(LF_ParamType_T type)
+{
+    switch (type)
+    {
+    case LF_PARAM_FLOAT:
+    case LF_PARAM_UINT32:
+        return 4U;
+    case LF_PARAM_UINT16:
+        return 2U;
+    default:
+        return 1U;
+    }
+}
+
+static uint8_t *LF_Params_GetAddress(const NVM_Layout_T *const layout, const LF_Param_T *param, uint8_t index)
+{
+    return (uint8_t *)layout + param->offset + index * LF_Params_GetTypeSize(param->type);
+}
+
+/**
+ * @brief Finds the dictionary entry of the parameter with a binary search.
+ *
+ * @param[in] id Parameter id.
+ * @param[out] index Element index within an array field, may be NULL.
+ *
+ * @return Pointer to the dictionary entry, NULL if the id is unknown.
+ */
+const LF_Param_T *LF_Params_Find(uint16_t id, uint8_t *index)
+{
+    uint32_t low = 0U;
+    uint32_t high = sizeof(paramDictionary) / sizeof(paramDictionary[0]);
+
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2U;
+        const LF_Param_T *param = &paramDictionary[middle];
+
+        if (id < param->id)
+        {
+            high = middle;
+        }
+        else if (id >= param->id + param->count)
+        {
+            low = middle + 1U;
+        }
+        else
+        {
+            if (index != NULL)
+            {
+                *index = (uint8_t)(id - param->id);
+            }
+            return param;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Returns the number of dictionary entries, an array field is a single entry.
+ */
+uint32_t LF_Params_GetCount(void)
+{
+    return sizeof(paramDictionary) / sizeof(paramDictionary[0]);
+}
+
+/**
+ * @brief Returns the dictionary entry at the given position, the entries are sorted by id.
+ *
+ * @param[in] index Position of the entry, 0 ... LF_Params_GetCount() - 1.
+ *
+ * @return Pointer to the dictionary entry, NULL if the index is out of range.
+ */
+const LF_Param_T *LF_Params_GetByIndex(uint32_t index)
+{
+    if (index >= LF_Params_GetCount())
+    {
+        return NULL;
+    }
+
+    return &paramDictionary[index];
+}
+
+/**
+ * @brief Reads a parameter from the layout.
+ *
+ * @param[in] layout Pointer to the NVM layout.
+ * @param[in] id Parameter id.
+ * @param[out] value Encoded value of the parameter.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the id is unknown.
+ */
+int LF_Params_Get(const NVM_Layout_T *const layout, uint16_t id, uint8_t value[LF_PARAM_VALUE_SIZE])
+{
+    uint8_t index;
+    const LF_Param_T *param = LF_Params_Find(id, &index);
+
+    if (param == NULL)
+    {
+        return -1;
+    }
+
+    const uint8_t *address = LF_Params_GetAddress(layout, param, index);
+    int32_t integer = 0;
+
+    switch (param->type)
+    {
+    case LF_PARAM_FLOAT:
+        memcpy(value, address, LF_PARAM_VALUE_SIZE);
+        return 0;
+    case LF_PARAM_UINT32:
+    {
+        uint32_t field;
+        memcpy(&field, address, sizeof(field));
+        integer = (int32_t)field;
+        break;
+    }
+    case LF_PARAM_UINT16:
+    {
+        uint16_t field;
+        memcpy(&field, address, sizeof(field));
+        integer = field;
+        break;
+    }
+    case LF_PARAM_INT8:
+        integer = *(const int8_t *)address;
+        break;
+    }
+
+    memcpy(value, &integer, LF_PARAM_VALUE_SIZE);
+
+    return 0;
+}
+
+/**
+ * @brief Validates a parameter value against the dictionary, without changing the layout.
+ *
+ * @param[in] id Parameter id.
+ * @param[in] value Encoded value of the parameter.
+ *
+ * @return LF_PARAM_OK if the value can be set, the reason otherwise.
+ */
+LF_ParamResult_T LF_Params_Check(uint16_t id, const uint8_t value[LF_PARAM_VALUE_SIZE])
+{
+    const LF_Param_T *param = LF_Params_Find(id, NULL);
+    float number;
+
+    if (param == NULL)
+    {
+        return LF_PARAM_UNKNOWN_ID;
+    }
+
+    if (param->type == LF_PARAM_FLOAT)
+    {
+        memcpy(&number, value, sizeof(number));
+    }
+    else
+    {
+        int32_t integer;
+        memcpy(&integer, value, sizeof(integer));
+        number = (float)integer;
+    }
+
+    /* NaN fails both comparisons */
+    if (!((number >= param->min) && (number <= param->max)))
+    {
+        return LF_PARAM_OUT_OF_RANGE;
+    }
+
+    return LF_PARAM_OK;
+}
+
+/**
+ * @brief Validates and writes a parameter to the layout in RAM, the flash is not written.
+ *
+ * @param[in,out] layout Pointer to the NVM layout.
+ * @param[in] id Parameter id.
+ * @param[in] value Encoded value of the parameter.
+ *
+ * @return LF_PARAM_OK if the value is set, the reason otherwise.
+ */
+LF_ParamResult_T LF_Params_Set(NVM_Layout_T *const layout, uint16_t id, const uint8_t value[LF_PARAM_VALUE_SIZE])
+{
+    LF_ParamResult_T result = LF_Params_Check(id, value);
+
+    if (result != LF_PARAM_OK)
+    {
+        return result;
+    }
+
+    uint8_t index;
+    const LF_Param_T *param = LF_Params_Find(id, &index);
+    uint8_t *address = LF_Params_GetAddress(layout, param, index);
+    int32_t integer;
+
+    memcpy(&integer, value, sizeof(integer));
+
+    switch (param->type)
+    {
+    case LF_PARAM_FLOAT:
+        memcpy(address, value, LF_PARAM_VALUE_SIZE);
+        break;
+    case LF_PARAM_UINT32:
+    {
+        uint32_t field = (uint32_t)integer;
+        memcpy(address, &field, sizeof(field));
+        break;
+    }
+    case LF_PARAM_UINT16:
+    {
+        uint16_t field = (uint16_t)integer;
+        memcpy(address, &field, sizeof(field));
+        break;
+    }
+    case LF_PARAM_INT8:
+        *(int8_t *)address = (int8_t)integer;
+        break;
+    }
+
+    return LF_PARAM_OK;
+}
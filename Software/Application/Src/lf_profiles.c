@@ -0,0 +1,231 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_profiles.h"
+#include "nvm.h"
+#include <stddef.h>
+#include <string.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static uint32_t LF_Profiles_CalculateCrc(const NVM_Profile_T *const profile);
+static uint32_t LF_Profiles_GetLayoutSize(uint16_t version);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+static uint32_t LF_Profiles_CalculateCrc(const NVM_Profile_T *const profile)
+{
+    NVM_Port_CalculateCrc((const uint8_t *)profile->name, sizeof(profile->name), false);
+
+    return NVM_Port_CalculateCrc((const uint8_t *)&profile->layout, sizeof(profile->layout), true);
+}
+
+/**
+ * @brief Returns the size of the layout stored by an older firmware. New fields are appended to
+ *        NVM_Layout_T, so an older layout is a prefix of the current one.
+ */
+static uint32_t LF_Profiles_GetLayoutSize(uint16_t version)
+{
+    switch (version)
+    {
+    case NVM_LEGACY_VERSION:
+        return LF_PROFILES_LEGACY_LAYOUT_SIZE;
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief Checks the CRC of every profile, a corrupted profile is restored to the default one.
+ *        An invalid active profile index selects the first profile.
+ *
+ * @param[in,out] profiles Pointer to the profiles read from NVM.
+ *
+ * @return
+ * - 0 if all profiles are valid.
+ * - -1 if any profile or the active index was restored.
+ */
+int LF_Profiles_Validate(NVM_Profiles_T *const profiles)
+{
+    int ret = 0;
+
+    for (uint32_t i = 0U; i < LF_PROFILES_NUMBER; i++)
+    {
+        NVM_Profile_T *profile = &profiles->profiles[i];
+
+        if (profile->crc != LF_Profiles_CalculateCrc(profile))
+        {
+            *profile = NvmDefaultProfiles.profiles[i];
+            profile->crc = LF_Profiles_CalculateCrc(profile);
+            ret = -1;
+        }
+    }
+
+    if (profiles->activeProfile >= LF_PROFILES_NUMBER)
+    {
+        profiles->activeProfile = 0U;
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Converts the NVM data stored by an older firmware, see NVM_MigrateFunc_T.
+ *        Fields that did not exist in the old layout keep their default values.
+ *
+ * @param[in,out] data NVM buffer holding NvmDefaultProfiles.
+ * @param[in] record Data of the stored record.
+ * @param[in] recordSize Size of the stored data.
+ * @param[in] recordVersion Layout version of the stored data.
+ *
+ * @return
+ * - 0 if the record is converted.
+ * - -1 if the layout is not known.
+ */
+int LF_Profiles_Migrate(uint8_t *data, const uint8_t *record, uint16_t recordSize, uint16_t recordVersion)
+{
+    NVM_Profiles_T *profiles = (NVM_Profiles_T *)data;
+    uint32_t layoutSize = LF_Profiles_GetLayoutSize(recordVersion);
+
+    if ((layoutSize == 0U) || (recordSize != layoutSize))
+    {
+        return -1;
+    }
+
+    /* The single layout stored before the journal and the profiles becomes the first profile */
+    memcpy(&profiles->profiles[0].layout, record, layoutSize);
+    profiles->activeProfile = 0U;
+
+    LF_Profiles_UpdateCrc(profiles);
+
+    return 0;
+}
+
+/**
+ * @brief Updates the CRC of every profile, to be called before the profiles are written to NVM.
+ *
+ * @param[in,out] profiles Pointer to the profiles.
+ */
+void LF_Profiles_UpdateCrc(NVM_Profiles_T *const profiles)
+{
+    for (uint32_t i = 0U; i < LF_PROFILES_NUMBER; i++)
+    {
+        profiles->profiles[i].crc = LF_Profiles_CalculateCrc(&profiles->profiles[i]);
+    }
+}
+
+/**
+ * @brief Selects the active profile.
+ *
+ * @param[in,out] profiles Pointer to the profiles.
+ * @param[in] index Index of the profile to select.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the index is out of range.
+ */
+int LF_Profiles_Select(NVM_Profiles_T *const profiles, uint8_t index)
+{
+    if (index >= LF_PROFILES_NUMBER)
+    {
+        return -1;
+    }
+
+    profiles->activeProfile = index;
+
+    return 0;
+}
+
+/**
+ * @brief Copies the parameters of one profile to another one and renames it.
+ *
+ * @param[in,out] profiles Pointer to the profiles.
+ * @param[in] source Index of the copied profile.
+ * @param[in] destination Index of the overwritten profile.
+ * @param[in] name New name of the destination profile, not necessarily null terminated.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if an index is out of range.
+ */
+int LF_Profiles_Clone(NVM_Profiles_T *const profiles, uint8_t source, uint8_t destination,
+                      const char name[LF_PROFILE_NAME_SIZE])
+{
+    if ((source >= LF_PROFILES_NUMBER) || (destination >= LF_PROFILES_NUMBER))
+    {
+        return -1;
+    }
+
+    NVM_Profile_T *profile = &profiles->profiles[destination];
+
+    if (source != destination)
+    {
+        profile->layout = profiles->profiles[source].layout;
+    }
+    memcpy(profile->name, name, sizeof(profile->name));
+
+    return 0;
+}
+
+/**
+ * @brief Lists the parameters that differ between two layouts, in ascending id order.
+ *
+ * @param[in] a Pointer to the first layout.
+ * @param[in] b Pointer to the second layout.
+ * @param[in] firstId Lowest compared id, continues a listing that did not fit one packet.
+ * @param[out] diffs Buffer for the differences.
+ * @param[in] maxDiffs Capacity of the buffer.
+ *
+ * @return Number of differences written to the buffer.
+ */
+uint16_t LF_Profiles_Diff(const NVM_Layout_T *const a, const NVM_Layout_T *const b, uint16_t firstId,
+                          LF_ProfileDiff_T *diffs, uint16_t maxDiffs)
+{
+    uint16_t count = 0U;
+
+    for (uint32_t i = 0U; i < LF_Params_GetCount(); i++)
+    {
+        const LF_Param_T *param = LF_Params_GetByIndex(i);
+
+        for (uint16_t id = param->id; id < param->id + param->count; id++)
+        {
+            if (id < firstId)
+            {
+                continue;
+            }
+
+            if (count >= maxDiffs)
+            {
+                return count;
+            }
+
+            LF_ProfileDiff_T *diff = &diffs[count];
+
+            (void)LF_Params_Get(a, id, diff->valueA);
+            (void)LF_Params_Get(b, id, diff->valueB);
+
+            if (memcmp(diff->valueA, diff->valueB, LF_PARAM_VALUE_SIZE) != 0)
+            {
+                diff->id = id;
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
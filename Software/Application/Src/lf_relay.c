@@ -0,0 +1,153 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_relay.h"
+#include <math.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define LF_RELAY_PI     3.14159265f
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Prepares a relay experiment, the relay starts with a positive output.
+ *
+ * @param[out] relay Pointer to the relay.
+ * @param[in] amplitude Relay output amplitude, in the unit of the loop output.
+ * @param[in] hysteresis Error band without switching, in the unit of the loop error.
+ */
+void LF_Relay_Init(LF_Relay_T *const relay, float amplitude, float hysteresis)
+{
+    relay->amplitude = amplitude;
+    relay->hysteresis = hysteresis;
+    relay->output = amplitude;
+    relay->elapsed = 0.0f;
+    relay->errorMax = 0.0f;
+    relay->errorMin = 0.0f;
+    relay->periodSum = 0.0f;
+    relay->amplitudeSum = 0.0f;
+    relay->risingSwitches = 0U;
+    relay->cycles = 0U;
+}
+
+/**
+ * @brief Switches the relay on the error of the loop and measures the period and the amplitude
+ *        of the oscillation between two rising switches, constant time per call.
+ *
+ * @param[in,out] relay Pointer to the relay.
+ * @param[in] error Setpoint minus the measured value.
+ * @param[in] dt Duration of the control cycle [ms].
+ *
+ * @return Relay output, +amplitude or -amplitude.
+ */
+float LF_Relay_Update(LF_Relay_T *const relay, float error, float dt)
+{
+    relay->elapsed += dt;
+
+    if (error > relay->errorMax)
+    {
+        relay->errorMax = error;
+    }
+    if (error < relay->errorMin)
+    {
+        relay->errorMin = error;
+    }
+
+    if ((relay->output < 0.0f) && (error > relay->hysteresis))
+    {
+        relay->output = relay->amplitude;
+
+        if ((relay->risingSwitches > LF_RELAY_SKIPPED_CYCLES) && (relay->cycles < LF_RELAY_MEASURED_CYCLES))
+        {
+            relay->periodSum += relay->elapsed;
+            relay->amplitudeSum += 0.5f * (relay->errorMax - relay->errorMin);
+            relay->cycles++;
+        }
+
+        if (relay->risingSwitches < UINT8_MAX)
+        {
+            relay->risingSwitches++;
+        }
+        relay->elapsed = 0.0f;
+        relay->errorMax = error;
+        relay->errorMin = error;
+    }
+    else if ((relay->output > 0.0f) && (error < -relay->hysteresis))
+    {
+        relay->output = -relay->amplitude;
+    }
+
+    return relay->output;
+}
+
+bool LF_Relay_IsComplete(const LF_Relay_T *const relay)
+{
+    return relay->cycles >= LF_RELAY_MEASURED_CYCLES;
+}
+
+/**
+ * @brief Calculates the ultimate gain and period from the measured oscillation, corrected for
+ *        the hysteresis, and the PID gains of a tuning rule.
+ *
+ * @param[in] relay Pointer to the relay.
+ * @param[in] rule Tuning rule.
+ * @param[out] result Ultimate point and gains.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the experiment is not complete or the oscillation is within the hysteresis.
+ */
+int LF_Relay_GetResult(const LF_Relay_T *const relay, LF_RelayRule_T rule, LF_RelayResult_T *const result)
+{
+    if (!LF_Relay_IsComplete(relay))
+    {
+        return -1;
+    }
+
+    float amplitude = relay->amplitudeSum / (float)relay->cycles;
+    float squared = amplitude * amplitude - relay->hysteresis * relay->hysteresis;
+
+    if (!(squared > 0.0f))
+    {
+        return -1;
+    }
+
+    result->ultimateGain = 4.0f * relay->amplitude / (LF_RELAY_PI * sqrtf(squared));
+    result->ultimatePeriod = relay->periodSum / (float)relay->cycles;
+
+    float integralTime;
+    float derivativeTime;
+
+    if (rule == LF_RELAY_RULE_TYREUS_LUYBEN)
+    {
+        result->kp = result->ultimateGain / 2.2f;
+        integralTime = 2.2f * result->ultimatePeriod;
+        derivativeTime = result->ultimatePeriod / 6.3f;
+    }
+    else
+    {
+        result->kp = 0.6f * result->ultimateGain;
+        integralTime = 0.5f * result->ultimatePeriod;
+        derivativeTime = 0.125f * result->ultimatePeriod;
+    }
+
+    result->ki = result->kp / integralTime;
+    result->kd = result->kp * derivativeTime;
+
+    return 0;
+}
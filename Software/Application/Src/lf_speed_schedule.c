@@ -0,0 +1,88 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_speed_schedule.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static float LF_SpeedSchedule_Interpolate(const LF_SpeedCurve_T *const curve, float input);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Evaluates the curve between its breakpoints, a breakpoint not above the previous one is skipped.
+ */
+static float LF_SpeedSchedule_Interpolate(const LF_SpeedCurve_T *const curve, float input)
+{
+    float previousInput = curve->inputs[0];
+    float previousFactor = curve->factors[0];
+
+    if (input <= previousInput)
+    {
+        return previousFactor;
+    }
+
+    for (uint32_t i = 1U; i < LF_SPEED_CURVE_POINTS; i++)
+    {
+        if (curve->inputs[i] <= previousInput)
+        {
+            continue;
+        }
+
+        if (input <= curve->inputs[i])
+        {
+            float fraction = (input - previousInput) / (curve->inputs[i] - previousInput);
+
+            return previousFactor + (curve->factors[i] - previousFactor) * fraction;
+        }
+
+        previousInput = curve->inputs[i];
+        previousFactor = curve->factors[i];
+    }
+
+    return previousFactor;
+}
+
+/**
+ * @brief Resamples the curve from 0 to its highest breakpoint into the LUT,
+ *        to be called when the parameters are compiled.
+ *
+ * @param[out] lut Pointer to the compiled curve.
+ * @param[in] curve Pointer to the curve breakpoints.
+ */
+void LF_SpeedSchedule_Compile(LF_SpeedLut_T *const lut, const LF_SpeedCurve_T *const curve)
+{
+    float range = 0.0f;
+
+    for (uint32_t i = 0U; i < LF_SPEED_CURVE_POINTS; i++)
+    {
+        if (curve->inputs[i] > range)
+        {
+            range = curve->inputs[i];
+        }
+    }
+
+    /* A curve without a positive breakpoint is constant */
+    lut->scale = (range > 0.0f) ? (float)(LF_SPEED_LUT_SIZE - 1U) / range : 0.0f;
+
+    for (uint32_t i = 0U; i < LF_SPEED_LUT_SIZE; i++)
+    {
+        float input = (range > 0.0f) ? (float)i / lut->scale : 0.0f;
+
+        lut->factors[i] = LF_SpeedSchedule_Interpolate(curve, input);
+    }
+}
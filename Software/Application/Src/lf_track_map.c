@@ -0,0 +1,232 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_track_map.h"
+#include <math.h>
+#include <stddef.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static void LF_TrackMap_CloseStep(LF_TrackMap_T *const map, float trackWidth);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Appends the recorded step to the last segment, a step of a different curvature
+ *        starts a new segment. A full map extends its last segment.
+ */
+static void LF_TrackMap_CloseStep(LF_TrackMap_T *const map, float trackWidth)
+{
+    float length = 0.5f * (map->stepLeft + map->stepRight);
+
+    if ((length <= 0.0f) || (map->stepSamples == 0U))
+    {
+        return;
+    }
+
+    float curvature = (map->stepRight - map->stepLeft) / (trackWidth * length);
+    float error = map->stepError / (float)map->stepSamples;
+    LF_TrackSegment_T *segment = (map->count > 0U) ? &map->segments[map->count - 1U] : NULL;
+
+    if ((segment != NULL) && ((fabsf(curvature - segment->curvature) <= LF_TRACK_MAP_CURVATURE_TOLERANCE) ||
+                              (map->count == LF_TRACK_MAP_MAX_SEGMENTS)))
+    {
+        float total = segment->length + length;
+
+        segment->curvature = (segment->curvature * segment->length + curvature * length) / total;
+        segment->error = (segment->error * segment->length + error * length) / total;
+        segment->length = total;
+    }
+    else
+    {
+        segment = &map->segments[map->count++];
+        segment->length = length;
+        segment->curvature = curvature;
+        segment->error = error;
+        segment->speed = 0.0f;
+        segment->entrySpeed = 0.0f;
+    }
+
+    map->stepLeft = 0.0f;
+    map->stepRight = 0.0f;
+    map->stepError = 0.0f;
+    map->stepSamples = 0U;
+}
+
+/**
+ * @brief Clears the map and starts recording it, to be followed by LF_TrackMap_Record
+ *        in every control cycle of the mapping lap.
+ */
+void LF_TrackMap_StartRecording(LF_TrackMap_T *const map)
+{
+    map->count = 0U;
+    map->state = LF_TRACK_MAP_RECORDING;
+    map->stepLeft = 0.0f;
+    map->stepRight = 0.0f;
+    map->stepError = 0.0f;
+    map->stepSamples = 0U;
+}
+
+/**
+ * @brief Records one control cycle of the mapping lap, the heading change is derived
+ *        from the differential travel of the wheels.
+ *
+ * @param[in,out] map Pointer to the map.
+ * @param[in] left Distance travelled by the left wheel since the last call [m].
+ * @param[in] right Distance travelled by the right wheel since the last call [m].
+ * @param[in] trackWidth Distance between the wheels [m].
+ * @param[in] error Sensor error of the cycle.
+ */
+void LF_TrackMap_Record(LF_TrackMap_T *const map, float left, float right, float trackWidth, float error)
+{
+    if (map->state != LF_TRACK_MAP_RECORDING)
+    {
+        return;
+    }
+
+    map->stepLeft += left;
+    map->stepRight += right;
+    map->stepError += fabsf(error);
+    map->stepSamples++;
+
+    if ((0.5f * (map->stepLeft + map->stepRight)) >= LF_TRACK_MAP_STEP)
+    {
+        LF_TrackMap_CloseStep(map, trackWidth);
+    }
+}
+
+/**
+ * @brief Ends the mapping lap, the last partial step is dropped.
+ *
+ * @return
+ * - 0 if the map holds at least one segment.
+ * - -1 if nothing was recorded.
+ */
+int LF_TrackMap_FinishRecording(LF_TrackMap_T *const map)
+{
+    if (map->state != LF_TRACK_MAP_RECORDING)
+    {
+        return -1;
+    }
+
+    map->state = (map->count > 0U) ? LF_TRACK_MAP_READY : LF_TRACK_MAP_EMPTY;
+
+    return (map->state == LF_TRACK_MAP_READY) ? 0 : -1;
+}
+
+/**
+ * @brief Calculates the speed profile of the map and moves to its start. A segment is limited
+ *        by the lateral acceleration in its curve, the entry speeds add the braking distance
+ *        of the following segments in a backward pass.
+ *
+ * @param[in,out] map Pointer to the map.
+ * @param[in] config Limits of the profile.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if there is no map.
+ */
+int LF_TrackMap_StartProfile(LF_TrackMap_T *const map, const LF_TrackMap_Config_T *const config)
+{
+    if (map->state != LF_TRACK_MAP_READY)
+    {
+        return -1;
+    }
+
+    for (uint16_t i = 0U; i < map->count; i++)
+    {
+        LF_TrackSegment_T *segment = &map->segments[i];
+        float speed = config->maxSpeed;
+        float curvature = fabsf(segment->curvature);
+
+        if ((curvature > 0.0f) && ((config->maxLateralAccel / curvature) < (speed * speed)))
+        {
+            speed = sqrtf(config->maxLateralAccel / curvature);
+        }
+
+        /* The line was hard to follow here on the mapping lap, it is not driven faster */
+        if ((segment->error > config->fallbackError) && (speed > config->mappingSpeed))
+        {
+            speed = config->mappingSpeed;
+        }
+
+        segment->speed = speed;
+    }
+
+    /* The end of the map is not braked for, the reactive speed takes over there */
+    float nextEntry = map->segments[map->count - 1U].speed;
+
+    for (uint16_t i = map->count; i > 0U; i--)
+    {
+        LF_TrackSegment_T *segment = &map->segments[i - 1U];
+        float braking = sqrtf(nextEntry * nextEntry + 2.0f * config->maxDecel * segment->length);
+
+        segment->entrySpeed = (braking < segment->speed) ? braking : segment->speed;
+        nextEntry = segment->entrySpeed;
+    }
+
+    map->distance = 0.0f;
+    map->segment = 0U;
+    map->segmentEnd = map->segments[0].length;
+
+    return 0;
+}
+
+/**
+ * @brief Advances the position on the map and returns the speed of the profile there,
+ *        which brakes for the next segment early enough to reach its entry speed.
+ *
+ * @param[in,out] map Pointer to the map.
+ * @param[in] travelled Distance travelled since the last call [m].
+ * @param[in] maxDecel Deceleration used by the profile [m/s^2].
+ * @param[out] speed Speed of the profile [m/s].
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if there is no map or the robot is past its end.
+ */
+int LF_TrackMap_GetSpeed(LF_TrackMap_T *const map, float travelled, float maxDecel, float *speed)
+{
+    if (map->state != LF_TRACK_MAP_READY)
+    {
+        return -1;
+    }
+
+    map->distance += travelled;
+
+    while ((map->segment < map->count) && (map->distance >= map->segmentEnd))
+    {
+        map->segment++;
+        if (map->segment < map->count)
+        {
+            map->segmentEnd += map->segments[map->segment].length;
+        }
+    }
+
+    if (map->segment >= map->count)
+    {
+        return -1;
+    }
+
+    const LF_TrackSegment_T *segment = &map->segments[map->segment];
+    float nextEntry = (map->segment + 1U < map->count) ? map->segments[map->segment + 1U].entrySpeed : segment->speed;
+    float braking = sqrtf(nextEntry * nextEntry + 2.0f * maxDecel * (map->segmentEnd - map->distance));
+
+    *speed = (braking < segment->speed) ? braking : segment->speed;
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_traction.h"
+#include <string.h>
+#include <math.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static bool LF_Traction_IsAccelSlipping(const LF_Traction_T *const traction, const LF_TractionLimits_T *const limits,
+                                        LF_TractionWheel_T wheel);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief A wheel spins when it accelerates faster than its setpoint, or locks when it decelerates
+ *        faster. A wheel lagging behind its setpoint is not slipping.
+ */
+static bool LF_Traction_IsAccelSlipping(const LF_Traction_T *const traction, const LF_TractionLimits_T *const limits,
+                                        LF_TractionWheel_T wheel)
+{
+    float accel = traction->accels[wheel];
+    float expected = traction->setpointAccels[wheel];
+
+    if (!(limits->maxAccelError > 0.0f))
+    {
+        return false;
+    }
+
+    return (accel > fmaxf(expected, 0.0f) + limits->maxAccelError) ||
+           (accel < fminf(expected, 0.0f) - limits->maxAccelError);
+}
+
+/**
+ * @brief Clears the state at the start of a run, the wheels stand still.
+ *
+ * @param[out] traction Pointer to the traction control state.
+ */
+void LF_Traction_Reset(LF_Traction_T *const traction)
+{
+    memset(traction, 0, sizeof(*traction));
+}
+
+/**
+ * @brief Detects a slipping wheel from its acceleration compared with the one of its setpoint and
+ *        from the difference between the wheel speeds compared with the commanded one. The PWM of
+ *        a slipping wheel is capped until it grips again for the hold time.
+ *
+ * @param[in,out] traction Pointer to the traction control state.
+ * @param[in] limits Pointer to the detection limits.
+ * @param[in] velocities Measured wheel velocities [m/s].
+ * @param[in] setpoints Velocity setpoints of the wheels [m/s].
+ * @param[in,out] pwm Signed PWM commands, capped for a slipping wheel.
+ * @param[in] dt Duration of the control cycle [ms].
+ *
+ * @return Mask of the wheels (1 << LF_TractionWheel_T) whose slip started in this cycle.
+ */
+uint8_t LF_Traction_Update(LF_Traction_T *const traction, const LF_TractionLimits_T *const limits,
+                           const float velocities[LF_TRACTION_WHEELS], const float setpoints[LF_TRACTION_WHEELS],
+                           float pwm[LF_TRACTION_WHEELS], float dt)
+{
+    float alpha = dt / (dt + LF_TRACTION_FILTER_MS);
+    /* Positive when the left wheel exceeds its setpoint more than the right one */
+    float slipSpeed = (velocities[LF_TRACTION_LEFT] - setpoints[LF_TRACTION_LEFT]) -
+                      (velocities[LF_TRACTION_RIGHT] - setpoints[LF_TRACTION_RIGHT]);
+    bool isSpeedSlipping = (limits->maxSlipSpeed > 0.0f) && (fabsf(slipSpeed) > limits->maxSlipSpeed);
+    uint8_t started = 0U;
+
+    if (!(dt > 0.0f))
+    {
+        return 0U;
+    }
+
+    for (uint32_t wheel = 0U; wheel < LF_TRACTION_WHEELS; wheel++)
+    {
+        float accel = (velocities[wheel] - traction->prevVelocities[wheel]) * 1000.0f / dt;
+        float setpointAccel = (setpoints[wheel] - traction->prevSetpoints[wheel]) * 1000.0f / dt;
+
+        traction->accels[wheel] += alpha * (accel - traction->accels[wheel]);
+        traction->setpointAccels[wheel] += alpha * (setpointAccel - traction->setpointAccels[wheel]);
+        traction->prevVelocities[wheel] = velocities[wheel];
+        traction->prevSetpoints[wheel] = setpoints[wheel];
+
+        bool isFaster = (wheel == LF_TRACTION_LEFT) ? (slipSpeed > 0.0f) : (slipSpeed < 0.0f);
+
+        if (LF_Traction_IsAccelSlipping(traction, limits, (LF_TractionWheel_T)wheel) ||
+            (isSpeedSlipping && isFaster))
+        {
+            if (traction->holdTimes[wheel] <= 0.0f)
+            {
+                traction->pwmCaps[wheel] = limits->pwmFactor * fabsf(pwm[wheel]);
+                started |= (uint8_t)(1U << wheel);
+            }
+            traction->holdTimes[wheel] = (float)limits->holdTime;
+        }
+        else if (traction->holdTimes[wheel] > 0.0f)
+        {
+            traction->holdTimes[wheel] -= dt;
+        }
+
+        if ((traction->holdTimes[wheel] > 0.0f) && (fabsf(pwm[wheel]) > traction->pwmCaps[wheel]))
+        {
+            pwm[wheel] = copysignf(traction->pwmCaps[wheel], pwm[wheel]);
+        }
+    }
+
+    return started;
+}
+
+/**
+ * @brief Returns the mask of the wheels (1 << LF_TractionWheel_T) whose PWM is capped.
+ */
+uint8_t LF_Traction_GetSlipMask(const LF_Traction_T *const traction)
+{
+    uint8_t mask = 0U;
+
+    for (uint32_t wheel = 0U; wheel < LF_TRACTION_WHEELS; wheel++)
+    {
+        if (traction->holdTimes[wheel] > 0.0f)
+        {
+            mask |= (uint8_t)(1U << wheel);
+        }
+    }
+
+    return mask;
+}
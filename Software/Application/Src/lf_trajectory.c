@@ -0,0 +1,100 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_trajectory.h"
+#include <math.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Acceleration of a removed limit, reaches any target speed within a control cycle [m/s^2] */
+#define LF_TRAJECTORY_UNLIMITED     1.0e6f
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Restarts the setpoint from standstill, the launch limit applies until the target speed
+ *        is reached.
+ *
+ * @param[out] trajectory Pointer to the setpoint.
+ */
+void LF_Trajectory_Reset(LF_Trajectory_T *const trajectory)
+{
+    trajectory->speed = 0.0f;
+    trajectory->accel = 0.0f;
+    trajectory->isLaunching = true;
+}
+
+/**
+ * @brief Moves the setpoint towards the target speed. The acceleration is limited by the launch,
+ *        cruise or brake limit and ramps with the jerk limit; near the target it is lowered so that
+ *        it reaches 0 at the target, which avoids an overshoot.
+ *
+ * @param[in,out] trajectory Pointer to the setpoint.
+ * @param[in] limits Pointer to the limits.
+ * @param[in] target Target speed [m/s].
+ * @param[in] dt Duration of the control cycle [ms].
+ *
+ * @return Speed setpoint [m/s].
+ */
+float LF_Trajectory_Update(LF_Trajectory_T *const trajectory, const LF_TrajectoryLimits_T *const limits,
+                           float target, float dt)
+{
+    float seconds = dt * 0.001f;
+    float error = target - trajectory->speed;
+    bool isRising = (error >= 0.0f);
+    float limit = isRising ? (trajectory->isLaunching ? limits->launchAccel : limits->cruiseAccel) : limits->brakeDecel;
+
+    if (!(limit > 0.0f))
+    {
+        limit = LF_TRAJECTORY_UNLIMITED;
+    }
+
+    float accel = isRising ? limit : -limit;
+
+    if (limits->jerk > 0.0f)
+    {
+        /* Highest acceleration which still ramps down to 0 at the target in steps of one cycle,
+           a + (a - step) + ... + step covers the error, sqrtf(2 * jerk * error) arrives too fast */
+        float step = limits->jerk * seconds;
+        float approach = 0.5f * (sqrtf(step * step + 8.0f * limits->jerk * fabsf(error)) - step);
+
+        if (approach < limit)
+        {
+            accel = isRising ? approach : -approach;
+        }
+        if (accel > trajectory->accel + step)
+        {
+            accel = trajectory->accel + step;
+        }
+        else if (accel < trajectory->accel - step)
+        {
+            accel = trajectory->accel - step;
+        }
+    }
+
+    trajectory->accel = accel;
+    trajectory->speed += accel * seconds;
+
+    if (isRising ? (trajectory->speed >= target) : (trajectory->speed <= target))
+    {
+        trajectory->speed = target;
+        trajectory->accel = 0.0f;
+        trajectory->isLaunching = trajectory->isLaunching && !isRising;
+    }
+
+    return trajectory->speed;
+}
@@ -3,6 +3,13 @@
  ******************************************************************************************/
 #include "lf_main.h"
 #include "lf_calibrate.h"
+#include "lf_identify.h"
+#include "lf_autotune.h"
+#include "lf_profiles.h"
+#include "lf_calib_stats.h"
+#include "lf_track_map.h"
+#include "lf_speed_schedule.h"
+#include <math.h>
 #include <string.h>
 
 /******************************************************************************************
@@ -16,6 +23,16 @@
 #define LF_TimerTick(timer)             ((timer).tick++)
 #define LF_PID_UPDATE_INTERVAL_MS       5.0f
 #define LF_MAX_MOTOR_SPEED              999U
+/* Time constant of the error rate filter of the speed schedule */
+#define LF_ERROR_RATE_FILTER_MS         20.0f
+/* A wheel driven forward at the start of a run whose velocity stays negative has a reversed encoder */
+#define LF_DIRECTION_CHECK_MS           500.0f
+#define LF_DIRECTION_FAULT_MS           50.0f
+#define LF_DIRECTION_MIN_PWM            100.0f
+#define LF_DIRECTION_MIN_VELOCITY       0.05f
+/* Flash operations stall instruction fetches, so the flush waits until no motor is driven by the control loop
+   (calibration, identification, autotune and run) */
+#define LF_IsNvmFlushAllowed(me)        ((me)->state == LF_IDLE)
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
@@ -52,17 +69,30 @@ static LF_ErrorCode_T LF_InitCommunication(LineFollower_T *const me);
 /* State Handling Functions */
 static void LF_StateIdle(LineFollower_T *const me, LF_Signal_T sig);
 static void LF_StateCalibration(LineFollower_T *const me, LF_Signal_T sig);
+static void LF_StateIdentification(LineFollower_T *const me, LF_Signal_T sig);
+static void LF_FinishIdentification(LineFollower_T *const me, LF_IdentificationStatus_T status);
+static void LF_StateAutotune(LineFollower_T *const me, LF_Signal_T sig);
 static void LF_StateRun(LineFollower_T *const me, LF_Signal_T sig);
 
 /* LF_StateRun Helper Functions */
+static void LF_StartRun(LineFollower_T *const me, bool isMapping);
 static void LF_HandleStopSignal(LineFollower_T *const me);
 static void LF_HandleADCDataUpdated(LineFollower_T *const me);
 static void LF_HandleTimerTick(LineFollower_T *const me);
+static uint8_t LF_CheckWheelDirection(LineFollower_T *const me, const float *const pwm, float dt);
+static float LF_GetTargetSpeed(LineFollower_T *const me, bool isSpeedReduced, float dt);
+static float LF_GetScheduledSpeed(LineFollower_T *const me, bool isSpeedReduced, float dt);
+static float LF_ApplyStraightBoost(LineFollower_T *const me, float speed, bool isSpeedReduced, float travelled,
+                                   float dt);
 
 /* Other Functions */
 static void LF_SendDebugData(const SCP_Packet *const packet, void *context);
+static void LF_ProcessNvm(LineFollower_T *const me);
+static void LF_CompileParams(LF_ParamBank_T *const bank, const NVM_Layout_T *const layout);
+static void LF_ActivatePendingParams(LineFollower_T *const me);
 static void LF_DataUpdateCallback(void *data);
 static uint16_t LF_ClampMotorSpeed(float speed);
+static void LF_DriveMotor(LineFollower_T *const me, TB6612MotorDriver_T *const motor, float command);
 static void LF_LogError(const char *file, int line, LF_ErrorCode_T errorCode);
 
 /******************************************************************************************
@@ -97,6 +127,13 @@ static void LF_InitState(LineFollower_T *const me)
     me->isDebugMode = false;
     me->bootFlags = &bootloaderFlags;
     me->prevCycleCount = 0U;
+    me->msPerCycle = 1000.0f / (float)SystemCoreClock;
+    me->params = NULL;
+    me->pendingParams = NULL;
+    me->nvmStatus = NVM_STATUS_COMPLETE;
+    me->trackMap.state = LF_TRACK_MAP_EMPTY;
+    me->trackMap.count = 0U;
+    me->isProfileActive = false;
 
     for (LF_TimetId_T timer = 0; timer < LF_TIMER_NB; timer++)
     {
@@ -175,7 +212,7 @@ static LF_ErrorCode_T LF_ComponentInit(LF_ComponentInitFunc initFunc, LineFollow
 
 static LF_ErrorCode_T LF_InitNVM(LineFollower_T *const me)
 {
-    me->nvmInstance.data = (uint8_t *)me->nvmBlock;
+    me->nvmInstance.data = (uint8_t *)me->nvmProfiles;
 
     if (NVM_Init(&me->nvmInstance) != 0)
     {
@@ -187,6 +224,18 @@ static LF_ErrorCode_T LF_InitNVM(LineFollower_T *const me)
         return LF_ERROR_NVM_READ;
     }
 
+    /* A record of the current layout is covered by the record CRC, the profiles are checked
+       and stored again only when they were migrated or are the defaults */
+    if (me->nvmInstance.loadSource != NVM_LOADED_RECORD)
+    {
+        (void)LF_Profiles_Validate(me->nvmProfiles);
+        (void)LF_StoreParams(me);
+    }
+
+    me->nvmBlock = LF_Profiles_GetActive(me->nvmProfiles);
+    LF_StageParams(me);
+    LF_ActivatePendingParams(me);
+
     return LF_SUCCESS;
 }
 
@@ -229,7 +278,6 @@ static LF_ErrorCode_T LF_InitSensors(LineFollower_T *const me)
 {
     for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
     {
-        me->sensorsInstance.sensors[i].positionWeight = me->nvmBlock->sensors.weights[i];
         me->sensorsInstance.sensors[i].isActive = false;
     }
 
@@ -238,7 +286,8 @@ static LF_ErrorCode_T LF_InitSensors(LineFollower_T *const me)
         return LF_ERROR_SENSOR_INIT;
     }
 
-    Sensors_SetThresholds(&me->sensorsInstance, me->nvmBlock->sensors.thresholds);
+    Sensors_SetCalibration(&me->sensorsInstance, me->params->thresholds, me->params->backgroundLevels,
+                           me->params->lineLevels);
 
     return LF_SUCCESS;
 }
@@ -314,10 +363,49 @@ static void LF_HandleStopSignal(LineFollower_T *const me)
         LF_StopTimer(me->timers[timer]);
     }
 
+    /* A stop ends the mapping lap, the next start follows the recorded map */
+    (void)LF_TrackMap_FinishRecording(&me->trackMap);
+    me->isProfileActive = false;
+    LF_EventLog_Add(&me->eventLog, HAL_GetTick(), LF_EVENT_RUN_STOP, 0U, 0.0f);
+
     me->prevCycleCount = 0U;
     me->state = LF_IDLE;
 }
 
+/**
+ * @brief Resets the control state and enters the LF_RUN state. A mapping lap records the track map
+ *        at the reactive speed, a normal run follows the speed profile of the map when there is one.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in] isMapping Start a mapping lap.
+ */
+static void LF_StartRun(LineFollower_T *const me, bool isMapping)
+{
+    (void)LF_InitPID(me);
+    (void)LF_InitEncoders(me);
+
+    if (isMapping)
+    {
+        LF_TrackMap_StartRecording(&me->trackMap);
+        me->isProfileActive = false;
+    }
+    else
+    {
+        me->isProfileActive = (LF_TrackMap_StartProfile(&me->trackMap, &me->params->speedProfile) == 0);
+    }
+
+    memset(&me->straightBoost, 0, sizeof(me->straightBoost));
+    memset(&me->directionCheck, 0, sizeof(me->directionCheck));
+    LF_Trajectory_Reset(&me->trajectory);
+    LF_Traction_Reset(&me->traction);
+    Sensors_ResetTracker(&me->sensorsInstance);
+    LF_EventLog_Clear(&me->eventLog, HAL_GetTick());
+    LF_EventLog_Add(&me->eventLog, HAL_GetTick(), LF_EVENT_RUN_START, 0U, isMapping ? 1.0f : 0.0f);
+    me->previousError = 0.0f;
+    me->errorRate = 0.0f;
+    me->state = LF_RUN;
+}
+
 /**
  * @brief Handles the LF_SIG_ADC_DATA_UPDATED signal in the LF_RUN state.
  *
@@ -335,9 +423,11 @@ static void LF_HandleADCDataUpdated(LineFollower_T *const me)
 
     uint32_t cycleDiff = currCycleCount - me->prevCycleCount;
     me->prevCycleCount = currCycleCount;
-    float dt = ((float)cycleDiff) / SystemCoreClock * 1000.0f;
+    float dt = (float)cycleDiff * me->msPerCycle;
     bool isSpeedReduced = false;
 
+    Sensors_AdaptThresholds(&me->sensorsInstance, &me->params->adaptation, dt);
+
     if (me->sensorsInstance.anySensorDetectedLine)
     {
         LF_RefreshTimer(me->timers[LF_TIMER_NO_LINE_DETECTED]);
@@ -358,40 +448,234 @@ static void LF_HandleADCDataUpdated(LineFollower_T *const me)
         isSpeedReduced = true;
     }
 
-    float targetSpeedLeft = me->nvmBlock->targetSpeed;
-    float targetSpeedRight = me->nvmBlock->targetSpeed;
+    Encoder_Update(&me->encoderLeft, dt);
+    Encoder_Update(&me->encoderRight, dt);
+
+    me->debugData.sensorError = Sensors_CalculateError(&me->sensorsInstance, &me->params->sensors, dt);
 
-    if (isSpeedReduced)
+    float targetSpeed = LF_GetTargetSpeed(me, isSpeedReduced, dt);
+
+    /* A slipping wheel holds the speed setpoint until it grips again */
+    if ((LF_Traction_GetSlipMask(&me->traction) != 0U) && (targetSpeed > me->trajectory.speed))
     {
-        targetSpeedLeft *= 0.85f;
-        targetSpeedRight *= 0.85f;
+        targetSpeed = me->trajectory.speed;
     }
 
-    me->debugData.sensorError = Sensors_CalculateError(&me->sensorsInstance, &me->nvmBlock->sensors);
+    /* The setpoint limits the acceleration of the robot, the steering of the line PID is not limited */
+    float targetSpeedLeft = LF_Trajectory_Update(&me->trajectory, &me->params->trajectory, targetSpeed, dt);
+    float targetSpeedRight = targetSpeedLeft;
+
+    PID_ScheduleGains(&me->pidSensorInstance, &me->pidSensorSettings, &me->params->sensorGainTable,
+                      0.5f * (me->encoderLeft.velocity + me->encoderRight.velocity));
     float pidSensorOutput = PID_Update(&me->pidSensorInstance, me->debugData.sensorError, dt);
     targetSpeedLeft -= pidSensorOutput;
     targetSpeedRight += pidSensorOutput;
 
-    Encoder_Update(&me->encoderLeft, dt);
-    Encoder_Update(&me->encoderRight, dt);
-
     me->pidEncoderLeftInstance.setpoint = targetSpeedLeft;
     me->pidEncoderRightInstance.setpoint = targetSpeedRight;
 
     float pidEncoderLeftOutput = PID_Update(&me->pidEncoderLeftInstance, me->encoderLeft.velocity, dt);
     float pidEncoderRightOutput = PID_Update(&me->pidEncoderRightInstance, me->encoderRight.velocity, dt);
 
-    uint16_t leftMotorSpeed = LF_ClampMotorSpeed(pidEncoderLeftOutput);
-    uint16_t rightMotorSpeed = LF_ClampMotorSpeed(pidEncoderRightOutput);
+    /* The feedforward gives the PWM of the target velocity, the PIDs only correct the residual */
+    pidEncoderLeftOutput += LF_MotorModel_GetPwm(&me->params->feedforwardLeft, targetSpeedLeft);
+    pidEncoderRightOutput += LF_MotorModel_GetPwm(&me->params->feedforwardRight, targetSpeedRight);
+
+    const float velocities[LF_TRACTION_WHEELS] = {me->encoderLeft.velocity, me->encoderRight.velocity};
+    const float setpoints[LF_TRACTION_WHEELS] = {targetSpeedLeft, targetSpeedRight};
+    float pwm[LF_TRACTION_WHEELS] = {pidEncoderLeftOutput, pidEncoderRightOutput};
+    uint8_t slipStarted = LF_Traction_Update(&me->traction, &me->params->traction, velocities, setpoints, pwm, dt);
 
-    TB6612Motor_ChangeDirection(me->motorLeft, MOTOR_FORWARD);
-    TB6612Motor_ChangeDirection(me->motorRight, MOTOR_FORWARD);
-    TB6612Motor_SetSpeed(me->motorLeft, leftMotorSpeed);
-    TB6612Motor_SetSpeed(me->motorRight, rightMotorSpeed);
+    for (uint32_t wheel = 0U; slipStarted != 0U; wheel++, slipStarted >>= 1U)
+    {
+        if ((slipStarted & 1U) != 0U)
+        {
+            LF_EventLog_Add(&me->eventLog, HAL_GetTick(), LF_EVENT_SLIP, (uint8_t)wheel,
+                            10.0f * me->traction.accels[wheel]);
+        }
+    }
+
+    uint8_t reversed = LF_CheckWheelDirection(me, pwm, dt);
+
+    if (reversed != 0U)
+    {
+        uint8_t wheel = ((reversed & (1U << LF_TRACTION_LEFT)) != 0U) ? LF_TRACTION_LEFT : LF_TRACTION_RIGHT;
+
+        LF_EventLog_Add(&me->eventLog, HAL_GetTick(), LF_EVENT_WHEEL_REVERSED, wheel,
+                        100.0f * velocities[wheel]);
+        LF_HandleStopSignal(me);
+        return;
+    }
+
+    LF_DriveMotor(me, me->motorLeft, pwm[LF_TRACTION_LEFT]);
+    LF_DriveMotor(me, me->motorRight, pwm[LF_TRACTION_RIGHT]);
 
     Sensors_UpdateLeds(&me->sensorsInstance);
 }
 
+/**
+ * @brief Checks the sign of the encoders at the start of a run. A wheel driven forward whose velocity
+ *        stays negative has a reversed encoder, its PID would drive it to full PWM. The calibration
+ *        and the identification use the absolute velocity and do not show it.
+ *
+ * @param[in,out] me Pointer to the LineFollower instance.
+ * @param[in] pwm Commands of the wheels, LF_TractionWheel_T order.
+ * @param[in] dt Duration of the control cycle [ms].
+ * @return Mask of the wheels with a reversed encoder, bit LF_TractionWheel_T.
+ */
+static uint8_t LF_CheckWheelDirection(LineFollower_T *const me, const float *const pwm, float dt)
+{
+    LF_DirectionCheck_T *const check = &me->directionCheck;
+    const float velocities[LF_TRACTION_WHEELS] = {me->encoderLeft.velocity, me->encoderRight.velocity};
+    uint8_t reversed = 0U;
+
+    if (check->runTime > LF_DIRECTION_CHECK_MS)
+    {
+        return 0U;
+    }
+    check->runTime += dt;
+
+    for (uint32_t wheel = 0U; wheel < LF_TRACTION_WHEELS; wheel++)
+    {
+        if ((pwm[wheel] > LF_DIRECTION_MIN_PWM) && (velocities[wheel] < -LF_DIRECTION_MIN_VELOCITY))
+        {
+            check->reversedTime[wheel] += dt;
+        }
+        else
+        {
+            check->reversedTime[wheel] = 0.0f;
+        }
+
+        if (check->reversedTime[wheel] > LF_DIRECTION_FAULT_MS)
+        {
+            reversed |= (uint8_t)(1U << wheel);
+        }
+    }
+
+    return reversed;
+}
+
+/**
+ * @brief Scales the target speed by the speed curves of the sensor error and of its rate, the lower
+ *        factor is used. While the speed is reduced the factor is at most the lowest one of the curves.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in] isSpeedReduced The reduced speed is requested by a right angle or unstable readings.
+ * @param[in] dt Duration of the control cycle [ms].
+ * @return Target speed [m/s].
+ */
+static float LF_GetScheduledSpeed(LineFollower_T *const me, bool isSpeedReduced, float dt)
+{
+    float error = me->debugData.sensorError;
+    float rate = fabsf(error - me->previousError) * 1000.0f / dt;
+
+    me->previousError = error;
+    me->errorRate += (rate - me->errorRate) * dt / (dt + LF_ERROR_RATE_FILTER_MS);
+
+    float factor = LF_SpeedSchedule_Lookup(&me->params->errorSpeedLut, fabsf(error));
+    float rateFactor = LF_SpeedSchedule_Lookup(&me->params->errorRateSpeedLut, me->errorRate);
+
+    if (rateFactor < factor)
+    {
+        factor = rateFactor;
+    }
+
+    if (isSpeedReduced && (factor > me->params->reducedSpeedFactor))
+    {
+        factor = me->params->reducedSpeedFactor;
+    }
+
+    return me->params->targetSpeed * factor;
+}
+
+/**
+ * @brief Raises the target speed on a straight. The boost starts once the line stays between the
+ *        middle sensors for the hold time or distance and ramps up to the boost speed, it ends at once
+ *        when the error grows or the speed is reduced.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in] speed Target speed without the boost [m/s].
+ * @param[in] isSpeedReduced The reduced speed is requested by a right angle or unstable readings.
+ * @param[in] travelled Distance travelled in the control cycle [m].
+ * @param[in] dt Duration of the control cycle [ms].
+ * @return Target speed [m/s].
+ */
+static float LF_ApplyStraightBoost(LineFollower_T *const me, float speed, bool isSpeedReduced, float travelled,
+                                   float dt)
+{
+    const LF_StraightBoostConfig_T *config = &me->params->straightBoost;
+    LF_StraightBoost_T *boost = &me->straightBoost;
+    bool isBoosting = (boost->speed > 0.0f);
+
+    if (!config->isEnabled || isSpeedReduced || (fabsf(me->debugData.sensorError) > config->exitError) ||
+        (!isBoosting && !me->sensorsInstance.straightLineDetected))
+    {
+        memset(boost, 0, sizeof(*boost));
+        return speed;
+    }
+
+    if (!isBoosting)
+    {
+        boost->centredTime += dt;
+        boost->centredDistance += travelled;
+
+        bool isHeld = ((config->holdTime > 0.0f) && (boost->centredTime >= config->holdTime)) ||
+                      ((config->holdDistance > 0.0f) && (boost->centredDistance >= config->holdDistance)) ||
+                      ((config->holdTime <= 0.0f) && (config->holdDistance <= 0.0f));
+
+        if (!isHeld)
+        {
+            return speed;
+        }
+    }
+
+    boost->speed = ((boost->speed > speed) ? boost->speed : speed) + config->accelPerMs * dt;
+    if (boost->speed > config->speed)
+    {
+        boost->speed = config->speed;
+    }
+
+    return boost->speed;
+}
+
+/**
+ * @brief Returns the target speed of the robot centre. The track map is recorded on a mapping lap,
+ *        on a later lap the speed profile of the map is followed until the robot leaves the line
+ *        or the map. The reactive speed, boosted on straights, is used in the other cases and
+ *        still reduces the profile.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in] isSpeedReduced The reduced speed is requested by a right angle or unstable readings.
+ * @param[in] dt Duration of the control cycle [ms].
+ * @return Target speed [m/s].
+ */
+static float LF_GetTargetSpeed(LineFollower_T *const me, bool isSpeedReduced, float dt)
+{
+    /* Signed travel, the inner wheel may turn backward in a sharp turn */
+    float left = (float)me->encoderLeft.deltaCount * me->encoderLeft.metersPerPulse;
+    float right = (float)me->encoderRight.deltaCount * me->encoderRight.metersPerPulse;
+    float reactiveSpeed = LF_ApplyStraightBoost(me, LF_GetScheduledSpeed(me, isSpeedReduced, dt), isSpeedReduced,
+                                                0.5f * (left + right), dt);
+    float profileSpeed;
+
+    LF_TrackMap_Record(&me->trackMap, left, right, chassisSettings.trackWidth, me->debugData.sensorError);
+
+    if (!me->isProfileActive ||
+        (LF_TrackMap_GetSpeed(&me->trackMap, 0.5f * (left + right), me->params->speedProfile.maxDecel,
+                              &profileSpeed) != 0))
+    {
+        return reactiveSpeed;
+    }
+
+    if ((fabsf(me->debugData.sensorError) > me->params->speedProfile.fallbackError) ||
+        (isSpeedReduced && (profileSpeed > reactiveSpeed)))
+    {
+        return reactiveSpeed;
+    }
+
+    return profileSpeed;
+}
+
 /**
  * @brief Handles the LF_SIG_TIMER_TICK signal in the LF_RUN state.
  *
@@ -404,7 +688,7 @@ static void LF_HandleTimerTick(LineFollower_T *const me)
         if (LF_IsTimerOn(me->timers[timer]))
         {
             me->timers[timer].tick++;
-            if (me->timers[timer].tick >= me->nvmBlock->timerTimeout[timer])
+            if (me->timers[timer].tick >= me->params->timerTimeout[timer])
             {
                 LF_StopTimer(me->timers[timer]);
                 if (me->timers[timer].associatedTimeoutSig != LF_SIG_INVALID)
@@ -427,17 +711,32 @@ static void LF_StateIdle(LineFollower_T *const me, LF_Signal_T sig)
     switch (sig)
     {
     case LF_SIG_START:
-        (void)LF_InitPID(me);
-        (void)LF_InitEncoders(me);
-        me->state = LF_RUN;
+        LF_StartRun(me, false);
+        break;
+    case LF_SIG_START_MAPPING:
+        LF_StartRun(me, true);
         break;
     case LF_SIG_CALIBRATE:
+        (void)LF_InitEncoders(me);
         LF_StartCalibration(me);
         LF_StartTimer(me->timers[LF_TIMER_CALIBRATION]);
         me->state = LF_CALIBRATION;
         break;
+    case LF_SIG_IDENTIFY:
+        (void)LF_InitEncoders(me);
+        LF_StartIdentification(me);
+        me->state = LF_IDENTIFICATION;
+        break;
+    case LF_SIG_AUTOTUNE_WHEELS:
+    case LF_SIG_AUTOTUNE_LINE:
+        (void)LF_InitPID(me);
+        (void)LF_InitEncoders(me);
+        LF_StartAutotune(me, sig == LF_SIG_AUTOTUNE_LINE);
+        me->state = LF_AUTOTUNE;
+        break;
     case LF_SIG_ADC_DATA_UPDATED:
-        me->debugData.sensorError = Sensors_CalculateError(&me->sensorsInstance, &me->nvmBlock->sensors);
+        /* No time base in the idle state, the prediction after a loss does not decay */
+        me->debugData.sensorError = Sensors_CalculateError(&me->sensorsInstance, &me->params->sensors, 0.0f);
         Sensors_UpdateLeds(&me->sensorsInstance);
         break;
     case LF_SIG_SEND_DEBUG_DATA:
@@ -461,15 +760,20 @@ static void LF_StateCalibration(LineFollower_T *const me, LF_Signal_T sig)
     switch (sig)
     {
     case LF_SIG_ADC_DATA_UPDATED:
-        LF_UpdateCalibrationData(me);
+        if (LF_UpdateCalibrationData(me) == LF_CALIBRATION_COMPLETE)
+        {
+            LF_SendSignal(me, LF_SIG_CALIBRATION_COMPLETE);
+        }
         break;
 
     case LF_SIG_CALIBRATION_COMPLETE:
+    {
         LF_StopTimer(me->timers[LF_TIMER_CALIBRATION]);
-        LF_StopCalibration(me);
-        SCP_Transmit(&me->scpInstance, LF_CMD_CALIBRATE, NULL, 0);
+        uint16_t failedChannels = LF_StopCalibration(me);
+        SCP_Transmit(&me->scpInstance, LF_CMD_CALIBRATE, &failedChannels, sizeof(failedChannels));
         me->state = LF_IDLE;
         break;
+    }
 
     case LF_SIG_TIMER_TICK:
         LF_HandleTimerTick(me);
@@ -479,6 +783,90 @@ static void LF_StateCalibration(LineFollower_T *const me, LF_Signal_T sig)
     }
 }
 
+/**
+ * @brief Handles the LF_IDENTIFICATION state, a stop aborts the identification.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in] sig Signal received.
+ */
+static void LF_StateIdentification(LineFollower_T *const me, LF_Signal_T sig)
+{
+    switch (sig)
+    {
+    case LF_SIG_ADC_DATA_UPDATED:
+    {
+        LF_IdentificationStatus_T status = LF_UpdateIdentification(me);
+
+        if (status != LF_IDENTIFICATION_IN_PROGRESS)
+        {
+            LF_FinishIdentification(me, status);
+        }
+        break;
+    }
+
+    case LF_SIG_STOP:
+        LF_FinishIdentification(me, LF_IDENTIFICATION_ERROR);
+        break;
+
+    case LF_SIG_TIMER_TICK:
+        LF_HandleTimerTick(me);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Stops the motor identification and reports its result, 0 if the curves were stored.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in] status Status of the identification, an aborted one is an error.
+ */
+static void LF_FinishIdentification(LineFollower_T *const me, LF_IdentificationStatus_T status)
+{
+    const uint8_t result = (LF_StopIdentification(me, status) == 0) ? 0U : 1U;
+
+    SCP_Transmit(&me->scpInstance, LF_CMD_IDENTIFY_MOTORS, &result, sizeof(result));
+    me->state = LF_IDLE;
+}
+
+/**
+ * @brief Handles the LF_AUTOTUNE state, the results are sent when the experiments end, a stop
+ *        aborts them.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in] sig Signal received.
+ */
+static void LF_StateAutotune(LineFollower_T *const me, LF_Signal_T sig)
+{
+    switch (sig)
+    {
+    case LF_SIG_ADC_DATA_UPDATED:
+        if (LF_UpdateAutotune(me) != LF_AUTOTUNE_IN_PROGRESS)
+        {
+            LF_StopAutotune(me);
+            me->state = LF_IDLE;
+        }
+        break;
+
+    case LF_SIG_STOP:
+        LF_StopAutotune(me);
+        me->state = LF_IDLE;
+        break;
+
+    case LF_SIG_SEND_DEBUG_DATA:
+        LF_SendDebugData(NULL, me);
+        break;
+
+    case LF_SIG_TIMER_TICK:
+        LF_HandleTimerTick(me);
+        break;
+
+    default:
+        break;
+    }
+}
 
 /**
  * @brief Callback function for ADC data update.
@@ -503,14 +891,196 @@ static void LF_SendDebugData(const SCP_Packet *const packet, void *context)
     LineFollower_T *const me = (LineFollower_T *const)context;
 
     memcpy(me->debugData.sensorsValues, me->sensorsInstance.adcBuffer, sizeof(me->sensorsInstance.adcBuffer));
+    memcpy(me->debugData.thresholds, me->sensorsInstance.thresholds, sizeof(me->sensorsInstance.thresholds));
     me->debugData.motorLeftVelocity = me->encoderLeft.velocity;
     me->debugData.motorRightVelocity = me->encoderRight.velocity;
+    me->debugData.setpointSpeed = me->trajectory.speed;
+    me->debugData.setpointAccel = me->trajectory.accel;
+    me->debugData.slipMask = LF_Traction_GetSlipMask(&me->traction);
     me->debugData.isSpeedReduced = LF_IsTimerOn(me->timers[LF_TIMER_SENSORS_STABILIZE]) ||
                                    LF_IsTimerOn(me->timers[LF_TIMER_REDUCED_SPEED]);
 
     SCP_Transmit(&me->scpInstance, LF_CMD_SEND_DEBUG_DATA, &me->debugData, sizeof(me->debugData));
 }
 
+/**
+ * @brief Advances the background NVM flush and reports its completion over the communication protocol.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ */
+static void LF_ProcessNvm(LineFollower_T *const me)
+{
+    NVM_Process(&me->nvmInstance, LF_IsNvmFlushAllowed(me));
+
+    NVM_Status_T status = NVM_GetStatus(&me->nvmInstance);
+
+    if (status != me->nvmStatus)
+    {
+        me->nvmStatus = status;
+        if ((status == NVM_STATUS_COMPLETE) || (status == NVM_STATUS_FAILED))
+        {
+            const uint8_t response = (uint8_t)status;
+            SCP_Transmit(&me->scpInstance, LF_CMD_GET_NVM_STATUS, &response, sizeof(response));
+        }
+    }
+}
+
+/**
+ * @brief Compiles the NVM layout into a parameter bank, every value the control loop needs is
+ *        converted to its runtime type and derived constants are calculated once.
+ *
+ * @param[out] bank Pointer to the parameter bank.
+ * @param[in] layout Pointer to the NVM layout.
+ */
+static void LF_CompileParams(LF_ParamBank_T *const bank, const NVM_Layout_T *const layout)
+{
+    bank->pidSensor = layout->pidStgSensor;
+    (void)PID_CompileGainTable(&bank->sensorGainTable, &layout->sensorGainSchedule);
+    bank->pidEncoderLeft = layout->pidStgEncoderLeft;
+    bank->pidEncoderRight = layout->pidStgEncoderRight;
+    (void)LF_MotorModel_Compile(&bank->feedforwardLeft, &layout->motorModel.left, layout->motorModel.gain);
+    (void)LF_MotorModel_Compile(&bank->feedforwardRight, &layout->motorModel.right, layout->motorModel.gain);
+
+    static const TB6612MotorDirection_T reverseDirections[LF_REVERSE_POLICY_NB] = {MOTOR_STOP, MOTOR_BRAKE,
+                                                                                   MOTOR_BACKWARD};
+    bool isReversePolicyValid = (layout->drive.reversePolicy < LF_REVERSE_POLICY_NB);
+
+    bank->reverseDirection = isReversePolicyValid ? reverseDirections[layout->drive.reversePolicy] : MOTOR_STOP;
+    bank->maxReversePwm = (bank->reverseDirection == MOTOR_BACKWARD) ? layout->drive.maxReversePwm : 0U;
+
+    for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
+    {
+        bank->sensors.weights[i] = (float)layout->sensors.weights[i];
+        bank->thresholds[i] = layout->sensors.thresholds[i];
+
+        /* Levels of the calibration, the line reads LF_CALIB_STATS_NORMALIZED_MAX after normalization */
+        float line = (layout->normalization.gains[i] > 0.0f)
+                         ? (float)layout->normalization.offsets[i] +
+                               (float)LF_CALIB_STATS_NORMALIZED_MAX / layout->normalization.gains[i]
+                         : (float)LF_CALIB_STATS_ADC_MAX;
+        bank->backgroundLevels[i] = layout->normalization.offsets[i];
+        bank->lineLevels[i] = (line < (float)LF_CALIB_STATS_ADC_MAX) ? (uint16_t)line : LF_CALIB_STATS_ADC_MAX;
+    }
+    bank->sensors.errorThreshold = layout->sensors.errorThreshold;
+    bank->sensors.fallbackErrorPositive = layout->sensors.fallbackErrorPositive;
+    bank->sensors.fallbackErrorNegative = layout->sensors.fallbackErrorNegative;
+    bank->sensors.lineLossDecay = layout->lineLossDecay;
+
+    bank->targetSpeed = layout->targetSpeed;
+    LF_SpeedSchedule_Compile(&bank->errorSpeedLut, &layout->speedSchedule.error);
+    LF_SpeedSchedule_Compile(&bank->errorRateSpeedLut, &layout->speedSchedule.errorRate);
+
+    float errorEnd = bank->errorSpeedLut.factors[LF_SPEED_LUT_SIZE - 1U];
+    float rateEnd = bank->errorRateSpeedLut.factors[LF_SPEED_LUT_SIZE - 1U];
+    bank->reducedSpeedFactor = (errorEnd < rateEnd) ? errorEnd : rateEnd;
+
+    for (LF_TimetId_T timer = 0; timer < LF_TIMER_NB; timer++)
+    {
+        bank->timerTimeout[timer] = layout->timerTimeout[timer];
+    }
+    bank->adaptation.rate = layout->adaptation.rate;
+    bank->adaptation.margin = layout->adaptation.margin;
+    bank->adaptation.maxDeviation = (float)layout->adaptation.maxDeviation;
+    bank->adaptation.maxStepPerMs = (float)layout->adaptation.maxSlewRate / 1000.0f;
+
+    bank->speedProfile.maxSpeed = layout->speedProfile.maxSpeed;
+    bank->speedProfile.maxLateralAccel = layout->speedProfile.maxLateralAccel;
+    bank->speedProfile.maxDecel = layout->speedProfile.maxDecel;
+    bank->speedProfile.fallbackError = layout->speedProfile.fallbackError;
+    bank->speedProfile.mappingSpeed = layout->targetSpeed;
+
+    bank->straightBoost.speed = layout->straightBoost.speed;
+    bank->straightBoost.accelPerMs = layout->straightBoost.accel / 1000.0f;
+    bank->straightBoost.exitError = layout->straightBoost.exitError;
+    bank->straightBoost.holdDistance = layout->straightBoost.holdDistance;
+    bank->straightBoost.holdTime = (float)layout->straightBoost.holdTime;
+    bank->straightBoost.isEnabled = (layout->straightBoost.speed > layout->targetSpeed);
+    bank->trajectory = layout->trajectory;
+    bank->traction = layout->traction;
+}
+
+/**
+ * @brief Compiles the NVM block into the inactive parameter bank.
+ *        The bank is activated at the next control cycle, so the control loop never sees
+ *        a partially updated parameter set. To be called after every change of the NVM block.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ */
+void LF_StageParams(LineFollower_T *const me)
+{
+    LF_ParamBank_T *bank = (me->params == &me->paramBanks[0]) ? &me->paramBanks[1] : &me->paramBanks[0];
+
+    LF_CompileParams(bank, me->nvmBlock);
+
+    me->pendingParams = bank;
+}
+
+/**
+ * @brief Requests a background write of all profiles, the profile CRCs are updated first.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the write can not be requested.
+ */
+int LF_StoreParams(LineFollower_T *const me)
+{
+    LF_Profiles_UpdateCrc(me->nvmProfiles);
+
+    if (NVM_RequestWrite(&me->nvmInstance) != 0)
+    {
+        return -1;
+    }
+
+    me->isParamsModified = false;
+
+    return 0;
+}
+
+/**
+ * @brief Activates the staged parameter bank, called between two control cycles.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ */
+static void LF_ActivatePendingParams(LineFollower_T *const me)
+{
+    if (me->pendingParams == NULL)
+    {
+        return;
+    }
+
+    const LF_ParamBank_T *previous = me->params;
+
+    me->params = me->pendingParams;
+    me->pendingParams = NULL;
+
+    /* The scheduled gains are kept, the next control cycle schedules them from the new table */
+    const PID_Settings_T scheduled = me->pidSensorSettings;
+
+    me->pidSensorSettings = me->params->pidSensor;
+    if (me->params->sensorGainTable.count > 0U)
+    {
+        me->pidSensorSettings.kp = scheduled.kp;
+        me->pidSensorSettings.ki = scheduled.ki;
+        me->pidSensorSettings.kd = scheduled.kd;
+    }
+
+    me->pidSensorInstance.settings = &me->pidSensorSettings;
+    me->pidEncoderLeftInstance.settings = &me->params->pidEncoderLeft;
+    me->pidEncoderRightInstance.settings = &me->params->pidEncoderRight;
+
+    /* The adapted thresholds are kept until the calibration changes */
+    if ((previous == NULL) ||
+        (memcmp(previous->thresholds, me->params->thresholds, sizeof(me->params->thresholds)) != 0) ||
+        (memcmp(previous->backgroundLevels, me->params->backgroundLevels, sizeof(me->params->backgroundLevels)) != 0) ||
+        (memcmp(previous->lineLevels, me->params->lineLevels, sizeof(me->params->lineLevels)) != 0))
+    {
+        Sensors_SetCalibration(&me->sensorsInstance, me->params->thresholds, me->params->backgroundLevels,
+                               me->params->lineLevels);
+    }
+}
+
 /**
  * @brief Check and clamp motor speed.
  *
@@ -533,6 +1103,29 @@ static uint16_t LF_ClampMotorSpeed(float speed)
     }
 }
 
+/**
+ * @brief Drives a motor with a signed command, a negative one is handled by the reverse policy:
+ *        the inner wheel can coast, brake or turn backward in a sharp turn.
+ *
+ * @param[in] me Pointer to the LineFollower instance.
+ * @param[in,out] motor Motor driver.
+ * @param[in] command Signed PWM command.
+ */
+static void LF_DriveMotor(LineFollower_T *const me, TB6612MotorDriver_T *const motor, float command)
+{
+    if (command >= 0.0f)
+    {
+        TB6612Motor_ChangeDirection(motor, MOTOR_FORWARD);
+        TB6612Motor_SetSpeed(motor, LF_ClampMotorSpeed(command));
+        return;
+    }
+
+    uint16_t speed = LF_ClampMotorSpeed(-command);
+
+    TB6612Motor_ChangeDirection(motor, me->params->reverseDirection);
+    TB6612Motor_SetSpeed(motor, (speed < me->params->maxReversePwm) ? speed : me->params->maxReversePwm);
+}
+
 /**
  * @brief Log the error.
  */
@@ -553,6 +1146,12 @@ void LF_MainFunction(LineFollower_T *const me)
 
     if (LF_SignalQueueDequeue(&me->signals, &sig))
     {
+        /* New sensor data starts a control cycle, parameters are only swapped in between */
+        if (sig == LF_SIG_ADC_DATA_UPDATED)
+        {
+            LF_ActivatePendingParams(me);
+        }
+
         switch (me->state)
         {
         case LF_IDLE:
@@ -561,6 +1160,12 @@ void LF_MainFunction(LineFollower_T *const me)
         case LF_CALIBRATION:
             LF_StateCalibration(me, sig);
             break;
+        case LF_IDENTIFICATION:
+            LF_StateIdentification(me, sig);
+            break;
+        case LF_AUTOTUNE:
+            LF_StateAutotune(me, sig);
+            break;
         case LF_RUN:
             LF_StateRun(me, sig);
             break;
@@ -573,8 +1178,9 @@ void LF_MainFunction(LineFollower_T *const me)
     }
     else
     {
-        /* No signals to process, so let's process the communication protocol */
+        /* No signals to process, so let's process the communication protocol and the NVM flush */
         SCP_Process(me);
+        LF_ProcessNvm(me);
     }
 }
 
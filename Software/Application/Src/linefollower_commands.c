@@ -6,6 +6,9 @@
 #include "lf_main.h"
 #include "sensors.h"
 #include "pid.h"
+#include "lf_params.h"
+#include "lf_profiles.h"
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -15,12 +18,83 @@
  ******************************************************************************************/
 #define LF_COMMAND_MODE_START   0x00U
 #define LF_COMMAND_MODE_STOP    0x01U
+#define LF_COMMAND_MODE_MAP     0x02U
+
+#define LF_AUTOTUNE_MODE_WHEELS 0x00U
+#define LF_AUTOTUNE_MODE_LINE   0x01U
 
 #define LF_COMMAND_ENTER_BOOT_FLAG 0xDEADBEEF
 
+#define LF_PROFILE_RESULT_OK            0x00U
+#define LF_PROFILE_RESULT_INVALID       0x01U
+#define LF_PROFILE_RESULT_UNCOMMITTED   0x02U
+
+/* The NVM layout is larger than a v1 payload, it is read and written in chunks */
+#define LF_NVM_DATA_BYTES_PER_PACKET    240U
+
+#define LF_NVM_WRITE_RESULT_OK          0x00U
+#define LF_NVM_WRITE_RESULT_INVALID     0x01U
+
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
  ******************************************************************************************/
+typedef struct __attribute__((packed))
+{
+    uint16_t total;         /* Size of the NVM layout */
+    uint16_t offset;        /* Offset of the first byte in the packet */
+    uint8_t count;
+    uint8_t data[LF_NVM_DATA_BYTES_PER_PACKET];
+} LF_NvmDataChunk_T;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t result;     /* LF_ParamResult_T */
+    uint16_t id;        /* First rejected parameter, 0 if all were set */
+} LF_SetParamsResponse_T;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t activeProfile;
+    char names[LF_PROFILES_NUMBER][LF_PROFILE_NAME_SIZE];
+} LF_GetProfilesResponse_T;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t source;
+    uint8_t destination;
+    char name[LF_PROFILE_NAME_SIZE];
+} LF_CloneProfileRequest_T;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t profileA;
+    uint8_t profileB;
+    uint16_t firstId;   /* Lowest compared id, to continue a listing that did not fit one packet */
+} LF_DiffProfilesRequest_T;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t profileA;
+    uint8_t profileB;
+    LF_ProfileDiff_T diffs[LF_PROFILES_MAX_DIFFS_PER_PACKET];
+} LF_DiffProfilesResponse_T;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t state;          /* LF_TrackMapState_T */
+    uint16_t total;         /* Number of segments of the map */
+    uint16_t first;         /* Index of the first segment in the packet */
+    uint8_t count;
+    LF_TrackSegment_T segments[LF_TRACK_MAP_SEGMENTS_PER_PACKET];
+} LF_GetTrackMapResponse_T;
+
+typedef struct __attribute__((packed))
+{
+    uint16_t total;         /* Number of events in the log */
+    uint16_t first;         /* Index of the first event in the packet, 0 is the oldest one */
+    uint8_t count;
+    LF_Event_T events[LF_EVENT_LOG_EVENTS_PER_PACKET];
+} LF_GetEventLogResponse_T;
 
 /******************************************************************************************
  *                                   FUNCTIONS PROTOTYPES                                 *
@@ -28,10 +102,23 @@
 static void LF_SetMode(const SCP_Packet *const packet, void *context);
 static void LF_CommandReset(const SCP_Packet *const packet, void *context);
 static void LF_CommandCalibrate(const SCP_Packet *const packet, void *context);
+static void LF_IdentifyMotors(const SCP_Packet *const packet, void *context);
+static void LF_Autotune(const SCP_Packet *const packet, void *context);
 static void LF_ReadNvmData(const SCP_Packet *const packet, void *context);
 static void LF_WriteNvmData(const SCP_Packet *const packet, void *context);
 static void LF_SetDebugMode(const SCP_Packet *const packet, void *context);
 static void LF_GetSession(const SCP_Packet *const packet, void *context);
+static void LF_GetNvmStatus(const SCP_Packet *const packet, void *context);
+static void LF_GetParams(const SCP_Packet *const packet, void *context);
+static void LF_SetParams(const SCP_Packet *const packet, void *context);
+static void LF_CommitParams(const SCP_Packet *const packet, void *context);
+static void LF_SelectProfile(const SCP_Packet *const packet, void *context);
+static void LF_GetProfiles(const SCP_Packet *const packet, void *context);
+static void LF_CloneProfile(const SCP_Packet *const packet, void *context);
+static void LF_DiffProfiles(const SCP_Packet *const packet, void *context);
+static void LF_StoreThresholds(const SCP_Packet *const packet, void *context);
+static void LF_GetTrackMap(const SCP_Packet *const packet, void *context);
+static void LF_GetEventLog(const SCP_Packet *const packet, void *context);
 static void LF_EnterBootloader(const SCP_Packet *const packet, void *context);
 
 /******************************************************************************************
@@ -41,24 +128,39 @@ extern NVM_Layout_T NVM_Block;
 extern PID_Instance_T PidSensorInstance;
 extern SCP_Instance_T ScpInstance;
 
-const SCP_Command_T lineFollowerCommands[LINEFOLLOWER_COMMANDS_NUMBER] = {
-    {LF_CMD_SET_MODE,       1U,                     LF_SetMode},
-    {LF_CMD_RESET,          0U,                     LF_CommandReset},
-    {LF_CMD_CALIBRATE,      0U,                     LF_CommandCalibrate},
-    {LF_CMD_READ_NVM_DATA,  0U,                     LF_ReadNvmData},
-    {LF_CMD_WRITE_NVM_DATA, sizeof(NVM_Layout_T),   LF_WriteNvmData},
-    {LF_CMD_SET_DEBUG_MODE, 1U,                     LF_SetDebugMode},
-    {LF_CMD_GET_SESSION,    0U,                     LF_GetSession},
+/* X(id, sizeKind, size, handler) */
+#define LF_COMMAND_LIST(X)                                                      \
+    X(LF_CMD_SET_MODE,          SCP_SIZE_EXACT, 1U,                     LF_SetMode)           \
+    X(LF_CMD_RESET,             SCP_SIZE_EXACT, 0U,                     LF_CommandReset)      \
+    X(LF_CMD_CALIBRATE,         SCP_SIZE_EXACT, 0U,                     LF_CommandCalibrate)  \
+    X(LF_CMD_READ_NVM_DATA,     SCP_SIZE_EXACT, sizeof(uint16_t),       LF_ReadNvmData)       \
+    X(LF_CMD_WRITE_NVM_DATA,    SCP_SIZE_MAX,   sizeof(LF_NvmDataChunk_T),  LF_WriteNvmData)  \
+    X(LF_CMD_SET_DEBUG_MODE,    SCP_SIZE_EXACT, 1U,                     LF_SetDebugMode)      \
+    X(LF_CMD_GET_SESSION,       SCP_SIZE_EXACT, 0U,                     LF_GetSession)        \
+    X(LF_CMD_GET_NVM_STATUS,    SCP_SIZE_EXACT, 0U,                     LF_GetNvmStatus)      \
+    X(LF_CMD_GET_PARAMS,        SCP_SIZE_MAX,   LF_PARAMS_MAX_PER_PACKET * LF_PARAM_ID_SIZE,    LF_GetParams)     \
+    X(LF_CMD_SET_PARAMS,        SCP_SIZE_MAX,   LF_PARAMS_MAX_PER_PACKET * LF_PARAM_ENTRY_SIZE, LF_SetParams)     \
+    X(LF_CMD_COMMIT_PARAMS,     SCP_SIZE_EXACT, 0U,                     LF_CommitParams)      \
+    X(LF_CMD_SELECT_PROFILE,    SCP_SIZE_EXACT, 1U,                     LF_SelectProfile)     \
+    X(LF_CMD_GET_PROFILES,      SCP_SIZE_EXACT, 0U,                     LF_GetProfiles)       \
+    X(LF_CMD_CLONE_PROFILE,     SCP_SIZE_EXACT, sizeof(LF_CloneProfileRequest_T),   LF_CloneProfile)  \
+    X(LF_CMD_DIFF_PROFILES,     SCP_SIZE_EXACT, sizeof(LF_DiffProfilesRequest_T),   LF_DiffProfiles)  \
+    X(LF_CMD_STORE_THRESHOLDS,  SCP_SIZE_EXACT, 0U,                     LF_StoreThresholds)   \
+    X(LF_CMD_GET_TRACK_MAP,     SCP_SIZE_EXACT, sizeof(uint16_t),       LF_GetTrackMap)       \
+    X(LF_CMD_IDENTIFY_MOTORS,   SCP_SIZE_EXACT, 0U,                     LF_IdentifyMotors)    \
+    X(LF_CMD_AUTOTUNE,          SCP_SIZE_EXACT, 1U,                     LF_Autotune)          \
+    X(LF_CMD_GET_EVENT_LOG,     SCP_SIZE_EXACT, sizeof(uint16_t),       LF_GetEventLog)       \
+    X(LF_CMD_ENTER_BOOTLOADER,  SCP_SIZE_EXACT, 0U,                     LF_EnterBootloader)
 
-    {LF_CMD_ENTER_BOOTLOADER, 0U, LF_EnterBootloader},
-};
+SCP_DEFINE_COMMAND_TABLE(lineFollowerCommands, LF_COMMAND_LIST);
 
 /******************************************************************************************
  *                                        FUNCTIONS                                       *
  ******************************************************************************************/
+/* A response that does not fit the protocol version of the host is answered with a NACK by SCP_Transmit */
 static inline void LF_CommandTransmitResponse(LineFollower_T *me, uint16_t command_id, const void *responseData, uint16_t responseSize)
 {
-    SCP_Transmit(&me->scpInstance, command_id, responseData, responseSize);
+    (void)SCP_Transmit(&me->scpInstance, command_id, responseData, responseSize);
 }
 
 static void LF_SetMode(const SCP_Packet *const packet, void *context)
@@ -73,6 +175,10 @@ static void LF_SetMode(const SCP_Packet *const packet, void *context)
     {
         LF_SendSignal(me, LF_SIG_STOP);
     }
+    else if (packet->data[0] == LF_COMMAND_MODE_MAP)
+    {
+        LF_SendSignal(me, LF_SIG_START_MAPPING);
+    }
 
     LF_CommandTransmitResponse(me, LF_CMD_SET_MODE, NULL, 0);
 }
@@ -89,21 +195,105 @@ static void LF_CommandCalibrate(const SCP_Packet *const packet, void *context)
     LF_SendSignal(me, LF_SIG_CALIBRATE);
 }
 
+/**
+ * @brief Starts the motor identification, the result is sent with the same command when it ends.
+ */
+static void LF_IdentifyMotors(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+
+    LF_SendSignal(me, LF_SIG_IDENTIFY);
+}
+
+/**
+ * @brief Starts the relay feedback autotune of the wheel loops or of the line loop, the results
+ *        are sent with the same command when it ends.
+ */
+static void LF_Autotune(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+
+    if (packet->data[0] == LF_AUTOTUNE_MODE_WHEELS)
+    {
+        LF_SendSignal(me, LF_SIG_AUTOTUNE_WHEELS);
+    }
+    else if (packet->data[0] == LF_AUTOTUNE_MODE_LINE)
+    {
+        LF_SendSignal(me, LF_SIG_AUTOTUNE_LINE);
+    }
+}
+
+/**
+ * @brief Sends the chunk of the NVM layout starting at the requested offset.
+ *        The host requests the next chunk until it has the whole layout.
+ */
 static void LF_ReadNvmData(const SCP_Packet *const packet, void *context)
 {
     LineFollower_T *const me = (LineFollower_T *const )context;
+    const uint8_t *layout = (const uint8_t *)me->nvmBlock;
+    LF_NvmDataChunk_T response;
+    uint16_t offset;
+
+    memcpy(&offset, packet->data, sizeof(offset));
+
+    response.total = sizeof(NVM_Layout_T);
+    response.offset = offset;
+    response.count = 0U;
 
-    LF_CommandTransmitResponse(me, LF_CMD_READ_NVM_DATA, me->nvmBlock, sizeof(NVM_Layout_T));
+    if (offset < sizeof(NVM_Layout_T))
+    {
+        response.count = (uint8_t)(((sizeof(NVM_Layout_T) - offset) < LF_NVM_DATA_BYTES_PER_PACKET) ?
+                                   (sizeof(NVM_Layout_T) - offset) : LF_NVM_DATA_BYTES_PER_PACKET);
+        memcpy(response.data, &layout[offset], response.count);
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_READ_NVM_DATA, &response,
+                               offsetof(LF_NvmDataChunk_T, data) + response.count);
 }
 
+/**
+ * @brief Copies a chunk of the NVM layout sent by the host, the chunks are sent in order.
+ *        The parameters are staged and stored once the last chunk is received.
+ */
 static void LF_WriteNvmData(const SCP_Packet *const packet, void *context)
 {
     LineFollower_T *const me = (LineFollower_T *const )context;
+    LF_NvmTransfer_T *const transfer = &me->nvmTransfer;
+    uint8_t *layout = (uint8_t *)&transfer->layout;
+    uint8_t result = LF_NVM_WRITE_RESULT_INVALID;
+    LF_NvmDataChunk_T request;
+
+    memcpy(&request, packet->data, packet->header.size);
+
+    /* A chunk at offset 0 starts a new transfer */
+    if (request.offset == 0U)
+    {
+        transfer->nextOffset = 0U;
+    }
 
-    memcpy(me->nvmBlock, packet->data, packet->header.size);
-    NVM_Write(&me->nvmInstance);
+    /* The host must have the same layout, the chunk must be complete, follow the previous one and stay within
+       the layout. The chunks are collected aside, the active profile is only replaced by a complete layout */
+    if ((packet->header.size >= offsetof(LF_NvmDataChunk_T, data)) &&
+        (packet->header.size == (offsetof(LF_NvmDataChunk_T, data) + request.count)) &&
+        (request.total == sizeof(NVM_Layout_T)) &&
+        (request.offset == transfer->nextOffset) &&
+        ((request.offset + request.count) <= sizeof(NVM_Layout_T)))
+    {
+        memcpy(&layout[request.offset], request.data, request.count);
+        transfer->nextOffset = request.offset + request.count;
+        result = LF_NVM_WRITE_RESULT_OK;
+
+        /* The data is flushed in the background, LF_CMD_GET_NVM_STATUS reports when it is stored */
+        if (transfer->nextOffset == sizeof(NVM_Layout_T))
+        {
+            memcpy(me->nvmBlock, &transfer->layout, sizeof(NVM_Layout_T));
+            transfer->nextOffset = 0U;
+            LF_StageParams(me);
+            (void)LF_StoreParams(me);
+        }
+    }
 
-    LF_CommandTransmitResponse(me, LF_CMD_WRITE_NVM_DATA, NULL, 0);
+    LF_CommandTransmitResponse(me, LF_CMD_WRITE_NVM_DATA, &result, sizeof(result));
 }
 
 static void LF_SetDebugMode(const SCP_Packet *const packet, void *context)
@@ -141,6 +331,258 @@ static void LF_GetSession(const SCP_Packet *const packet, void *context)
     SCP_Transmit(&me->scpInstance, LF_CMD_GET_SESSION, responseData, sizeof(responseData) - 1);
 };
 
+static void LF_GetNvmStatus(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    const uint8_t status = (uint8_t)NVM_GetStatus(&me->nvmInstance);
+
+    LF_CommandTransmitResponse(me, LF_CMD_GET_NVM_STATUS, &status, sizeof(status));
+}
+
+/**
+ * @brief Reads parameters by id, the request is a list of 16-bit ids.
+ *        The response holds an {id, value} entry for every known id.
+ */
+static void LF_GetParams(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    uint8_t response[LF_PARAMS_MAX_PER_PACKET * LF_PARAM_ENTRY_SIZE];
+    uint16_t responseSize = 0U;
+
+    for (uint16_t offset = 0U; offset + LF_PARAM_ID_SIZE <= packet->header.size; offset += LF_PARAM_ID_SIZE)
+    {
+        uint16_t id;
+        memcpy(&id, &packet->data[offset], sizeof(id));
+
+        if (LF_Params_Get(me->nvmBlock, id, &response[responseSize + LF_PARAM_ID_SIZE]) == 0)
+        {
+            memcpy(&response[responseSize], &id, sizeof(id));
+            responseSize += LF_PARAM_ENTRY_SIZE;
+        }
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_GET_PARAMS, response, responseSize);
+}
+
+/**
+ * @brief Sets parameters in RAM, the request is a list of {id, value} entries.
+ *        All entries are validated first, nothing is set if any of them is rejected.
+ *        The control loop picks the new set up at its next cycle, also while running.
+ *        LF_CMD_COMMIT_PARAMS stores the parameters in flash.
+ */
+static void LF_SetParams(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    LF_SetParamsResponse_T response = {.result = LF_PARAM_OK, .id = 0U};
+
+    if ((packet->header.size % LF_PARAM_ENTRY_SIZE) != 0U)
+    {
+        response.result = LF_PARAM_MALFORMED;
+    }
+
+    for (uint16_t offset = 0U; (response.result == LF_PARAM_OK) && (offset < packet->header.size); offset += LF_PARAM_ENTRY_SIZE)
+    {
+        uint16_t id;
+        memcpy(&id, &packet->data[offset], sizeof(id));
+
+        response.result = LF_Params_Check(id, &packet->data[offset + LF_PARAM_ID_SIZE]);
+        if (response.result != LF_PARAM_OK)
+        {
+            response.id = id;
+        }
+    }
+
+    if (response.result == LF_PARAM_OK)
+    {
+        for (uint16_t offset = 0U; offset < packet->header.size; offset += LF_PARAM_ENTRY_SIZE)
+        {
+            uint16_t id;
+            memcpy(&id, &packet->data[offset], sizeof(id));
+
+            (void)LF_Params_Set(me->nvmBlock, id, &packet->data[offset + LF_PARAM_ID_SIZE]);
+        }
+
+        LF_StageParams(me);
+        me->isParamsModified = true;
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_SET_PARAMS, &response, sizeof(response));
+}
+
+/**
+ * @brief Stores the parameters set in RAM, the response holds the NVM flush status.
+ */
+static void LF_CommitParams(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+
+    (void)LF_StoreParams(me);
+
+    const uint8_t status = (uint8_t)NVM_GetStatus(&me->nvmInstance);
+    LF_CommandTransmitResponse(me, LF_CMD_COMMIT_PARAMS, &status, sizeof(status));
+}
+
+/**
+ * @brief Replaces the thresholds of the active profile with the ones adapted during the runs,
+ *        the response holds the NVM flush status.
+ */
+static void LF_StoreThresholds(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+
+    memcpy(me->nvmBlock->sensors.thresholds, me->sensorsInstance.thresholds, sizeof(me->nvmBlock->sensors.thresholds));
+    LF_StageParams(me);
+    (void)LF_StoreParams(me);
+
+    const uint8_t status = (uint8_t)NVM_GetStatus(&me->nvmInstance);
+    LF_CommandTransmitResponse(me, LF_CMD_STORE_THRESHOLDS, &status, sizeof(status));
+}
+
+/**
+ * @brief Sends the segments of the track map starting from the requested index,
+ *        a map longer than one packet is read with several requests.
+ */
+static void LF_GetTrackMap(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    const LF_TrackMap_T *map = &me->trackMap;
+    LF_GetTrackMapResponse_T response;
+    uint16_t first;
+
+    memcpy(&first, packet->data, sizeof(first));
+
+    response.state = (uint8_t)map->state;
+    response.total = map->count;
+    response.first = first;
+    response.count = 0U;
+
+    while ((response.count < LF_TRACK_MAP_SEGMENTS_PER_PACKET) && ((first + response.count) < map->count))
+    {
+        response.segments[response.count] = map->segments[first + response.count];
+        response.count++;
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_GET_TRACK_MAP, &response,
+                               offsetof(LF_GetTrackMapResponse_T, segments) + response.count * sizeof(LF_TrackSegment_T));
+}
+
+static void LF_GetEventLog(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    LF_GetEventLogResponse_T response;
+    uint16_t first;
+
+    memcpy(&first, packet->data, sizeof(first));
+
+    response.total = me->eventLog.count;
+    response.first = first;
+    response.count = 0U;
+
+    while ((response.count < LF_EVENT_LOG_EVENTS_PER_PACKET) && ((first + response.count) < me->eventLog.count))
+    {
+        response.events[response.count] = *LF_EventLog_Get(&me->eventLog, first + response.count);
+        response.count++;
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_GET_EVENT_LOG, &response,
+                               offsetof(LF_GetEventLogResponse_T, events) + response.count * sizeof(LF_Event_T));
+}
+
+/**
+ * @brief Switches the parameters used by the control loop to another stored profile.
+ *        The new set is active from the next control cycle, the selection is stored in the background.
+ *        Storing the selection would also store the SET_PARAMS edits of the active profile, so the command is
+ *        rejected until they are committed.
+ */
+static void LF_SelectProfile(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    uint8_t result = LF_PROFILE_RESULT_INVALID;
+
+    if (me->isParamsModified)
+    {
+        result = LF_PROFILE_RESULT_UNCOMMITTED;
+    }
+    else if (LF_Profiles_Select(me->nvmProfiles, packet->data[0]) == 0)
+    {
+        me->nvmBlock = LF_Profiles_GetActive(me->nvmProfiles);
+        LF_StageParams(me);
+        (void)LF_StoreParams(me);
+        result = LF_PROFILE_RESULT_OK;
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_SELECT_PROFILE, &result, sizeof(result));
+}
+
+static void LF_GetProfiles(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    LF_GetProfilesResponse_T response = {.activeProfile = (uint8_t)me->nvmProfiles->activeProfile};
+
+    for (uint32_t i = 0U; i < LF_PROFILES_NUMBER; i++)
+    {
+        memcpy(response.names[i], me->nvmProfiles->profiles[i].name, LF_PROFILE_NAME_SIZE);
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_GET_PROFILES, &response, sizeof(response));
+}
+
+/**
+ * @brief Copies the parameters of one profile to another one, the request is {source, destination, name}.
+ *        Overwriting the active profile also changes the parameters used by the control loop.
+ *        As all profiles are stored together, the command is rejected while SET_PARAMS edits are uncommitted.
+ */
+static void LF_CloneProfile(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    LF_CloneProfileRequest_T request;
+    uint8_t result = LF_PROFILE_RESULT_INVALID;
+
+    memcpy(&request, packet->data, sizeof(request));
+
+    if (me->isParamsModified)
+    {
+        result = LF_PROFILE_RESULT_UNCOMMITTED;
+    }
+    else if (LF_Profiles_Clone(me->nvmProfiles, request.source, request.destination, request.name) == 0)
+    {
+        if (request.destination == me->nvmProfiles->activeProfile)
+        {
+            LF_StageParams(me);
+        }
+        (void)LF_StoreParams(me);
+        result = LF_PROFILE_RESULT_OK;
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_CLONE_PROFILE, &result, sizeof(result));
+}
+
+/**
+ * @brief Lists the parameters that differ between two profiles as {id, valueA, valueB} entries.
+ *        A full response means that more differences may follow, starting after the last listed id.
+ */
+static void LF_DiffProfiles(const SCP_Packet *const packet, void *context)
+{
+    LineFollower_T *const me = (LineFollower_T *const )context;
+    LF_DiffProfilesRequest_T request;
+    LF_DiffProfilesResponse_T response;
+    uint16_t count = 0U;
+
+    memcpy(&request, packet->data, sizeof(request));
+    response.profileA = request.profileA;
+    response.profileB = request.profileB;
+
+    if ((request.profileA < LF_PROFILES_NUMBER) && (request.profileB < LF_PROFILES_NUMBER))
+    {
+        count = LF_Profiles_Diff(&me->nvmProfiles->profiles[request.profileA].layout,
+                                 &me->nvmProfiles->profiles[request.profileB].layout,
+                                 request.firstId, response.diffs, LF_PROFILES_MAX_DIFFS_PER_PACKET);
+    }
+
+    LF_CommandTransmitResponse(me, LF_CMD_DIFF_PROFILES, &response,
+                               offsetof(LF_DiffProfilesResponse_T, diffs) + count * sizeof(LF_ProfileDiff_T));
+}
+
 static void LF_EnterBootloader(const SCP_Packet *const packet, void *context)
 {
     LineFollower_T *const me = (LineFollower_T *const )context;
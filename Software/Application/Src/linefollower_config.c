@@ -6,11 +6,120 @@
 #include "usart.h"
 #include "tim.h"
 #include "sensors.h"
+#include "lf_calib_stats.h"
 #include "stm32f7xx_hal.h"
 
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
+/* Until the first calibration the whole ADC range is normalized */
+#define NVM_DEFAULT_GAIN    ((float)LF_CALIB_STATS_NORMALIZED_MAX / (float)LF_CALIB_STATS_ADC_MAX)
+
+#define NVM_DEFAULT_LAYOUT                                                                                     \
+{                                                                                                              \
+    .pidStgSensor = {                                                                                          \
+        .kp = 0.1f,                                                                                            \
+        .ki = 0.0f,                                                                                            \
+        .kd = 0.0f,                                                                                            \
+        .integral_max = 1.0f,                                                                                  \
+        .integral_min = -1.0f,                                                                                 \
+        .output_max = 1.5f,                                                                                    \
+        .output_min = -1.5f,                                                                                   \
+    },                                                                                                         \
+    .pidStgEncoderLeft = {                                                                                     \
+        .kp = 984.0f,                                                                                          \
+        .ki = 21.34f,                                                                                          \
+        .kd = 1200.0f,                                                                                         \
+        .integral_max = 100.0f,                                                                                \
+        .integral_min = -100.0f,                                                                               \
+        .output_max = 1000.0f,                                                                                 \
+        .output_min = 0.0f,                                                                                    \
+    },                                                                                                         \
+    .pidStgEncoderRight = {                                                                                    \
+        .kp = 984.0f,                                                                                          \
+        .ki = 21.34f,                                                                                          \
+        .kd = 1200.0f,                                                                                         \
+        .integral_max = 100.0f,                                                                                \
+        .integral_min = -100.0f,                                                                               \
+        .output_max = 1000.0f,                                                                                 \
+        .output_min = 0.0f,                                                                                    \
+    },                                                                                                         \
+    .sensors = {                                                                                               \
+        .weights = {-8, -6, -4, -2, -1, 0, 0, 1, 2, 4, 6, 8},                                                  \
+        .thresholds = {1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U},    \
+        .errorThreshold = 1.0f,                                                                                \
+        .fallbackErrorPositive = 10.0f,                                                                        \
+        .fallbackErrorNegative = -10.0f                                                                        \
+    },                                                                                                         \
+    .targetSpeed = 1.3f,                                                                                       \
+    .timerTimeout = {                                                                                          \
+        [LF_TIMER_NO_LINE_DETECTED]= 1000U,                                                                    \
+        [LF_TIMER_REDUCED_SPEED]= 300U,                                                                        \
+        [LF_TIMER_SENSORS_STABILIZE]= 500U,                                                                    \
+        [LF_TIMER_CALIBRATION] = 3000u                                                                         \
+    },                                                                                                         \
+    .normalization = {                                                                                         \
+        .gains = {NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN,                      \
+                  NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN,                      \
+                  NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN, NVM_DEFAULT_GAIN},                     \
+        .offsets = {0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U}                                            \
+    },                                                                                                         \
+    .adaptation = {                                                                                            \
+        .rate = 0.0f,                                                                                          \
+        .margin = 0.25f,                                                                                       \
+        .maxDeviation = 400U,                                                                                  \
+        .maxSlewRate = 500U                                                                                    \
+    },                                                                                                         \
+    .speedProfile = {                                                                                          \
+        .maxSpeed = 2.5f,                                                                                      \
+        .maxLateralAccel = 6.0f,                                                                               \
+        .maxDecel = 5.0f,                                                                                      \
+        .fallbackError = 4.0f                                                                                  \
+    },                                                                                                         \
+    .straightBoost = {                                                                                         \
+        .speed = 0.0f,                                                                                         \
+        .accel = 3.0f,                                                                                         \
+        .exitError = 1.0f,                                                                                     \
+        .holdDistance = 0.15f,                                                                                 \
+        .holdTime = 0U                                                                                         \
+    },                                                                                                         \
+    .speedSchedule = {                                                                                         \
+        .error = {                                                                                             \
+            .inputs = {0.0f, 1.0f, 2.0f, 4.0f, 8.0f, 10.0f},                                                   \
+            .factors = {1.0f, 1.0f, 0.97f, 0.93f, 0.88f, 0.85f}                                                \
+        },                                                                                                     \
+        .errorRate = {                                                                                         \
+            .inputs = {0.0f, 100.0f, 200.0f, 400.0f, 800.0f, 1600.0f},                                         \
+            .factors = {1.0f, 1.0f, 0.97f, 0.93f, 0.88f, 0.85f}                                                \
+        }                                                                                                      \
+    },                                                                                                         \
+    .sensorGainSchedule = {                                                                                    \
+        .inputs = {0.0f, 0.0f, 0.0f, 0.0f},                                                                    \
+        .kp = {0.1f, 0.1f, 0.1f, 0.1f},                                                                        \
+        .ki = {0.0f, 0.0f, 0.0f, 0.0f},                                                                        \
+        .kd = {0.0f, 0.0f, 0.0f, 0.0f}                                                                         \
+    },                                                                                                         \
+    .motorModel = {                                                                                            \
+        .gain = 1.0f                                                                                           \
+    },                                                                                                         \
+    .drive = {                                                                                                 \
+        .reversePolicy = LF_REVERSE_DRIVE,                                                                     \
+        .maxReversePwm = 500U                                                                                  \
+    },                                                                                                         \
+    .trajectory = {                                                                                            \
+        .launchAccel = 4.0f,                                                                                   \
+        .cruiseAccel = 8.0f,                                                                                   \
+        .brakeDecel = 15.0f,                                                                                   \
+        .jerk = 200.0f                                                                                         \
+    },                                                                                                         \
+    .traction = {                                                                                              \
+        .maxAccelError = 15.0f,                                                                                \
+        .maxSlipSpeed = 0.5f,                                                                                  \
+        .pwmFactor = 0.7f,                                                                                     \
+        .holdTime = 100U                                                                                       \
+    },                                                                                                         \
+    .lineLossDecay = 150.0f                                                                                    \
+}
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
@@ -24,47 +133,14 @@
  *                                        VARIABLES                                       *
  ******************************************************************************************/
 
-const NVM_Layout_T NvmDefaultData = {
-    .pidStgSensor = {
-        .kp = 0.1f,
-        .ki = 0.0f,
-        .kd = 0.0f,
-        .integral_max = 1.0f,
-        .integral_min = -1.0f,
-        .output_max = 1.5f,
-        .output_min = -1.5f,
-    },
-    .pidStgEncoderLeft = {
-        .kp = 984.0f,
-        .ki = 21.34f,
-        .kd = 1200.0f,
-        .integral_max = 100.0f,
-        .integral_min = -100.0f,
-        .output_max = 1000.0f,
-        .output_min = 0.0f,
-    },
-    .pidStgEncoderRight = {
-        .kp = 984.0f,
-        .ki = 21.34f,
-        .kd = 1200.0f,
-        .integral_max = 100.0f,
-        .integral_min = -100.0f,
-        .output_max = 1000.0f,
-        .output_min = 0.0f,
-    },
-    .sensors = {
-        .weights = {-8, -6, -4, -2, -1, 0, 0, 1, 2, 4, 6, 8},
-        .thresholds = {1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U, 1500U},
-        .errorThreshold = 1.0f,
-        .fallbackErrorPositive = 10.0f,
-        .fallbackErrorNegative = -10.0f
-    },
-    .targetSpeed = 1.3f,
-    .timerTimeout = {
-        [LF_TIMER_NO_LINE_DETECTED]= 1000U,
-        [LF_TIMER_REDUCED_SPEED]= 300U,
-        [LF_TIMER_SENSORS_STABILIZE]= 500U,
-        [LF_TIMER_CALIBRATION] = 3000u
+/* Profile CRCs are calculated at boot, see LF_Profiles_Validate */
+const NVM_Profiles_T NvmDefaultProfiles = {
+    .activeProfile = 0U,
+    .profiles = {
+        {.name = "Profile 1", .layout = NVM_DEFAULT_LAYOUT},
+        {.name = "Profile 2", .layout = NVM_DEFAULT_LAYOUT},
+        {.name = "Profile 3", .layout = NVM_DEFAULT_LAYOUT},
+        {.name = "Profile 4", .layout = NVM_DEFAULT_LAYOUT},
     }
 };
 
@@ -93,7 +169,7 @@ const Sensors_Config_T sensorsConfig = {
 };
 
 /* --------------------------------- MOTORS CONFIG --------------------------------- */
-const TB6612MotorDriver_T LeftMotor = 
+TB6612MotorDriver_T LeftMotor =
 {
     .in1 = {GPIOA, MOTOR1_AIN_Pin},
     .in2 = {GPIOA, MOTOR1_BIN_Pin},
@@ -101,7 +177,7 @@ const TB6612MotorDriver_T LeftMotor =
     .pwmChannel = TIM_CHANNEL_4
 };
 
-const TB6612MotorDriver_T RightMotor =
+TB6612MotorDriver_T RightMotor =
 {
     .in1 = {GPIOB, MOTOR2_AIN_Pin},
     .in2 = {GPIOD, MOTOR2_BIN_Pin},
@@ -116,6 +192,38 @@ const Encoder_Settings_T encoderSettings = {
     .pulsesPerRevolution = 512
 };
 
+/* --------------------------------- CHASSIS CONFIG --------------------------------- */
+const LF_ChassisSettings_T chassisSettings = {
+    .trackWidth = 0.105f
+};
+
+/* ------------------------------- CALIBRATION CONFIG ------------------------------- */
+const LF_CalibrationSettings_T calibrationSettings = {
+    .sweepAngle = 0.35f,
+    .motorSpeed = 150U
+};
+
+/* ----------------------------- IDENTIFICATION CONFIG ------------------------------ */
+const LF_IdentificationSettings_T identificationSettings = {
+    .maxPwm = 700U,
+    .rampRate = 0.1f,
+    .startVelocity = 0.02f,
+    .settleTime = 400U,
+    .measureTime = 200U
+};
+
+/* -------------------------------- AUTOTUNE CONFIG --------------------------------- */
+const LF_AutotuneSettings_T autotuneSettings = {
+    .wheelVelocity = 0.5f,
+    .wheelBias = 300U,
+    .wheelAmplitude = 150.0f,
+    .wheelHysteresis = 0.02f,
+    .lineSpeed = 0.4f,
+    .lineAmplitude = 0.3f,
+    .lineHysteresis = 0.5f,
+    .timeout = 10000U
+};
+
 
 /******************************************************************************************
  *                                        FUNCTIONS                                       *
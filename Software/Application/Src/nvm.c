@@ -2,25 +2,86 @@
  *                                        INCLUDES                                        *
  ******************************************************************************************/
 #include "nvm.h"
-#include "stm32f7xx_hal.h"
-#include "crc.h"
+#include <stddef.h>
 #include <string.h>
 
 /******************************************************************************************
  *                                         DEFINES                                        *
  ******************************************************************************************/
-#define NVM_CRC_INIT_VALUE   (0xFFFFFFFFU)
-#define FLASH_SECTOR_INVALID (0xFFFFFFFFU)
+/*
+ * The data is kept as a journal of records, appended to one of two flash sectors:
+ *   sector start:  sector header {magic, generation, ~generation, index capacity}
+ *   then:          records {sequence, size, version, crc32, data}, 4-byte aligned, growing up,
+ *                  the CRC covers the data followed by the header fields before it
+ *   sector end:    footer index, one word per record holding the offset where the record ends, growing down
+ * The index entry is programmed before its record, so the number of entries, found with a binary search,
+ * gives both the newest record and the next free offset. A record torn by a power cut fails its CRC and
+ * the previous one is used. When the sector is full, the other sector is erased and the journal continues
+ * there with the newest data, the old sector is only erased on the next swap.
+ *
+ * Before the journal the data was stored raw, followed by its CRC32, at the start of the first sector. While
+ * the journal holds no record and the first sector no journal header, such data of legacySize bytes is
+ * converted by the migrate function. The first record goes to the other sector, so the old data is kept
+ * until a record is complete.
+ *
+ * Writes are flushed in the background: the RAM buffer is copied to a staged buffer and NVM_Process
+ * programs it in bounded steps from the main loop, the erase of a swap runs on the flash interrupt.
+ */
+#define NVM_CRC_INIT_VALUE      (0xFFFFFFFFU)
+#define NVM_ERASED_WORD         (0xFFFFFFFFU)
+#define NVM_SECTOR_MAGIC        (0x4A4D564EU)
+#define NVM_NO_SECTOR           (-1)
+#define NVM_ALIGN(size)         (((size) + 3U) & ~3U)
+#define NVM_RECORDS_OFFSET      ((uint32_t)sizeof(NVM_SectorHeader_T))
+#define NVM_INDEX_ENTRY_SIZE    ((uint32_t)sizeof(uint32_t))
 
 /******************************************************************************************
  *                                        TYPEDEFS                                        *
  ******************************************************************************************/
+typedef struct
+{
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t generationInverted;
+    uint32_t indexCapacity;
+} NVM_SectorHeader_T;
+
+typedef struct
+{
+    uint32_t sequence;
+    uint16_t size;
+    uint16_t version;
+    uint32_t crc;
+} NVM_RecordHeader_T;
+
+typedef struct
+{
+    const uint8_t *record;  /* Newest valid record, NULL if none */
+    uint32_t dataCrc;       /* CRC of the record data, calculated while the record is validated */
+    uint32_t sequence;
+    uint32_t writeOffset;
+    uint32_t indexCount;
+} NVM_SectorScan_T;
 
 /******************************************************************************************
  *                                   FUNCTIONS PROTOTYPES                                 *
  ******************************************************************************************/
-static uint32_t GetSectorBaseAddress(uint32_t sector);
-static bool NVM_FlashWrite(uint32_t baseAddress, uint8_t *pData, uint32_t size);
+static uint32_t NVM_ReadWord(const uint8_t *address);
+static bool NVM_ReadSectorHeader(uint32_t sector, NVM_SectorHeader_T *header);
+static const uint8_t *NVM_GetIndexEntry(uint32_t sector, uint32_t entry);
+static uint32_t NVM_CountIndexEntries(uint32_t sector, uint32_t indexCapacity);
+static bool NVM_IsEntryValid(uint32_t start, uint32_t end, uint32_t indexOffset);
+static uint32_t NVM_CalculateRecordCrc(const NVM_RecordHeader_T *header, const uint8_t *data, uint32_t *dataCrc);
+static bool NVM_IsRecordValid(const uint8_t *record, uint32_t length, uint32_t *dataCrc);
+static void NVM_ScanSector(uint32_t sector, const NVM_SectorHeader_T *header, NVM_SectorScan_T *scan);
+static bool NVM_MigrateLegacy(Nvm_Instance_T *const nvm);
+static int NVM_StartSwap(Nvm_Instance_T *const nvm);
+static int NVM_StartSector(Nvm_Instance_T *const nvm);
+static bool NVM_HasSpace(const Nvm_Instance_T *const nvm, uint32_t recordLength);
+static int NVM_ProgramIndexEntry(Nvm_Instance_T *const nvm, uint32_t recordLength);
+static int NVM_ProgramRecordSlice(Nvm_Instance_T *const nvm, const NVM_RecordHeader_T *header);
+static int NVM_FlushStep(Nvm_Instance_T *const nvm);
+static int NVM_EraseSector(uint32_t sector);
 
 /******************************************************************************************
  *                                        VARIABLES                                       *
@@ -30,255 +91,765 @@ static bool NVM_FlashWrite(uint32_t baseAddress, uint8_t *pData, uint32_t size);
  *                                        FUNCTIONS                                       *
  ******************************************************************************************/
 /**
- * @brief Retrieves the base address of the specified flash sector.
+ * @brief Reads a word from flash memory, the address does not have to be aligned.
+ */
+static uint32_t NVM_ReadWord(const uint8_t *address)
+{
+    uint32_t word;
+
+    memcpy(&word, address, sizeof(word));
+
+    return word;
+}
+
+/**
+ * @brief Reads and validates the journal header of the sector.
  *
  * @param[in] sector Flash sector number.
- * 
- * @return The base address of the flash sector, or `FLASH_SECTOR_INVALID` if invalid.
+ * @param[out] header Pointer to the header to be filled.
+ *
+ * @return
+ * - true if the sector holds a journal.
+ * - false if the sector is erased or the header is corrupted.
  */
-static uint32_t GetSectorBaseAddress(uint32_t sector)
+static bool NVM_ReadSectorHeader(uint32_t sector, NVM_SectorHeader_T *header)
 {
-    switch (sector)
-    {
-    case FLASH_SECTOR_0:
-        return 0x08000000U;
-    case FLASH_SECTOR_1:
-        return 0x08004000U;
-    case FLASH_SECTOR_2:
-        return 0x08008000U;
-    case FLASH_SECTOR_3:
-        return 0x0800C000U;
-    case FLASH_SECTOR_4:
-        return 0x08010000U;
-    case FLASH_SECTOR_5:
-        return 0x08020000U;
-    case FLASH_SECTOR_6:
-        return 0x08040000U;
-    case FLASH_SECTOR_7:
-        return 0x08060000U;
-    default:
-        return FLASH_SECTOR_INVALID;
-    }
+    uint32_t sectorSize = NVM_Port_GetSectorSize(sector);
+
+    memcpy(header, NVM_Port_GetSectorAddress(sector), sizeof(*header));
+
+    return (header->magic == NVM_SECTOR_MAGIC) && (header->generation == ~header->generationInverted) &&
+           (header->indexCapacity > 0U) &&
+           (header->indexCapacity <= (sectorSize - NVM_RECORDS_OFFSET) / NVM_INDEX_ENTRY_SIZE);
 }
 
 /**
- * @brief Writes data to the specified flash memory address.
+ * @brief Returns the address of the footer index entry, entries are placed from the sector end downwards.
+ */
+static const uint8_t *NVM_GetIndexEntry(uint32_t sector, uint32_t entry)
+{
+    return NVM_Port_GetSectorAddress(sector) + NVM_Port_GetSectorSize(sector) - (entry + 1U) * NVM_INDEX_ENTRY_SIZE;
+}
+
+/**
+ * @brief Counts the programmed footer index entries with a binary search.
+ *        Entries are programmed in order, so the programmed ones form a prefix of the index.
  *
- * @param[in] baseAddress Starting address in flash memory for the write operation.
- * @param[in] pData Pointer to the data to be written.
- * @param[in] size Number of bytes to write.
+ * @param[in] sector Flash sector number.
+ * @param[in] indexCapacity Number of index entries reserved in the sector.
  *
- * @return
- * - true if the write operation is successful.
- * - false if the write operation fails.
+ * @return Number of programmed entries.
  */
-static bool NVM_FlashWrite(uint32_t baseAddress, uint8_t *pData, uint32_t size)
+static uint32_t NVM_CountIndexEntries(uint32_t sector, uint32_t indexCapacity)
 {
-    HAL_FLASH_Unlock();
+    uint32_t low = 0U;
+    uint32_t high = indexCapacity;
 
-    while (size > 0)
+    while (low < high)
     {
-        uint64_t programData;
-        uint32_t increment, programType;
+        uint32_t middle = low + (high - low) / 2U;
 
-        if (size >= 4U)
-        {
-            programType = FLASH_TYPEPROGRAM_WORD;
-            programData = *(uint32_t *)pData;
-            increment = 4U;
-        }
-        else if (size >= 2U)
+        if (NVM_ReadWord(NVM_GetIndexEntry(sector, middle)) != NVM_ERASED_WORD)
         {
-            programType = FLASH_TYPEPROGRAM_HALFWORD;
-            programData = *(uint16_t *)pData;
-            increment = 2U;
+            low = middle + 1U;
         }
         else
         {
-            programType = FLASH_TYPEPROGRAM_BYTE;
-            programData = *pData;
-            increment = 1U;
+            high = middle;
         }
+    }
+
+    return low;
+}
+
+/**
+ * @brief Checks that an index entry describes a record within the records area.
+ *
+ * @param[in] start Offset of the record, the end of the previous record.
+ * @param[in] end Offset where the record ends, the value of the index entry.
+ * @param[in] indexOffset Offset of the footer index, the end of the records area.
+ *
+ * @return
+ * - true if the entry is plausible.
+ * - false if the entry is corrupted, e.g. by a power cut while it was programmed.
+ */
+static bool NVM_IsEntryValid(uint32_t start, uint32_t end, uint32_t indexOffset)
+{
+    return ((start % NVM_INDEX_ENTRY_SIZE) == 0U) && ((end % NVM_INDEX_ENTRY_SIZE) == 0U) &&
+           (start >= NVM_RECORDS_OFFSET) && (end >= start + sizeof(NVM_RecordHeader_T)) && (end <= indexOffset);
+}
+
+/**
+ * @brief Calculates the CRC of a record, covering the data and then the header fields before the CRC.
+ *        The data goes first, so the CRC of the data alone is available from the same pass.
+ *
+ * @param[in] header Pointer to the record header.
+ * @param[in] data Pointer to the record data.
+ * @param[out] dataCrc CRC of the data alone, may be NULL.
+ *
+ * @return CRC of the record.
+ */
+static uint32_t NVM_CalculateRecordCrc(const NVM_RecordHeader_T *header, const uint8_t *data, uint32_t *dataCrc)
+{
+    uint32_t crc = NVM_Port_CalculateCrc(data, header->size, false);
+
+    if (dataCrc != NULL)
+    {
+        *dataCrc = crc;
+    }
+
+    return NVM_Port_CalculateCrc((const uint8_t *)header, offsetof(NVM_RecordHeader_T, crc), true);
+}
+
+/**
+ * @brief Checks that a record is complete and not corrupted.
+ *
+ * @param[in] record Pointer to the record in flash memory.
+ * @param[in] length Length of the record, given by the index.
+ * @param[out] dataCrc CRC of the record data, set if the record is valid.
+ *
+ * @return
+ * - true if the record is valid.
+ * - false otherwise.
+ */
+static bool NVM_IsRecordValid(const uint8_t *record, uint32_t length, uint32_t *dataCrc)
+{
+    NVM_RecordHeader_T header;
+    const uint8_t *data = record + sizeof(header);
+
+    memcpy(&header, record, sizeof(header));
+
+    if (NVM_ALIGN(sizeof(header) + header.size) != length)
+    {
+        return false;
+    }
 
-        if (HAL_FLASH_Program(programType, baseAddress, programData) != HAL_OK)
+    return (NVM_CalculateRecordCrc(&header, data, dataCrc) == header.crc);
+}
+
+/**
+ * @brief Finds the newest valid record and the next free offset in the sector.
+ *
+ * @param[in] sector Flash sector number.
+ * @param[in] header Pointer to the valid journal header of the sector.
+ * @param[out] scan Pointer to the scan result.
+ */
+static void NVM_ScanSector(uint32_t sector, const NVM_SectorHeader_T *header, NVM_SectorScan_T *scan)
+{
+    const uint8_t *base = NVM_Port_GetSectorAddress(sector);
+    uint32_t indexOffset = NVM_Port_GetSectorSize(sector) - header->indexCapacity * NVM_INDEX_ENTRY_SIZE;
+    uint32_t entries = NVM_CountIndexEntries(sector, header->indexCapacity);
+
+    scan->record = NULL;
+    scan->sequence = 0U;
+    scan->indexCount = entries;
+    scan->writeOffset = NVM_RECORDS_OFFSET;
+
+    if (entries > 0U)
+    {
+        uint32_t end = NVM_ReadWord(NVM_GetIndexEntry(sector, entries - 1U));
+        uint32_t start = (entries > 1U) ? NVM_ReadWord(NVM_GetIndexEntry(sector, entries - 2U)) : NVM_RECORDS_OFFSET;
+
+        /* A torn index entry does not tell where the free space starts, the sector is not appended to anymore */
+        scan->writeOffset = NVM_IsEntryValid(start, end, indexOffset) ? end : indexOffset;
+    }
+
+    /* Usually the newest record is valid, older ones are only checked after a power cut */
+    for (uint32_t entry = entries; entry-- > 0U;)
+    {
+        uint32_t end = NVM_ReadWord(NVM_GetIndexEntry(sector, entry));
+        uint32_t start = (entry > 0U) ? NVM_ReadWord(NVM_GetIndexEntry(sector, entry - 1U)) : NVM_RECORDS_OFFSET;
+
+        if (NVM_IsEntryValid(start, end, indexOffset) &&
+            NVM_IsRecordValid(base + start, end - start, &scan->dataCrc))
         {
-            HAL_FLASH_Lock();
-            return false;
+            scan->record = base + start;
+            scan->sequence = NVM_ReadWord(base + start + offsetof(NVM_RecordHeader_T, sequence));
+            break;
         }
+    }
+}
+
+/**
+ * @brief Converts the data stored before the journal, raw data of legacySize bytes followed by its CRC32
+ *        at the start of the first sector.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance, the buffer holds the default data.
+ *
+ * @return
+ * - true if the old data is valid and converted.
+ * - false otherwise.
+ */
+static bool NVM_MigrateLegacy(Nvm_Instance_T *const nvm)
+{
+    const uint8_t *base = NVM_Port_GetSectorAddress(nvm->sectors[0]);
 
-        baseAddress += increment;
-        pData += increment;
-        size -= increment;
+    if ((nvm->migrate == NULL) || (nvm->legacySize == 0U) || (nvm->legacySize > UINT16_MAX) ||
+        (nvm->legacySize + sizeof(uint32_t) > NVM_Port_GetSectorSize(nvm->sectors[0])) ||
+        (NVM_ReadWord(base + nvm->legacySize) != NVM_Port_CalculateCrc(base, nvm->legacySize, false)))
+    {
+        return false;
     }
 
-    HAL_FLASH_Lock();
+    if (nvm->migrate(nvm->data, base, (uint16_t)nvm->legacySize, NVM_LEGACY_VERSION) != 0)
+    {
+        return false;
+    }
+
+    /* The first sector holds no journal header, so the first flush swaps to the other sector */
+    nvm->activeSector = 0;
 
     return true;
 }
 
 /**
- * @brief Initializes the NVM instance.
+ * @brief Starts the erase of the other sector, the journal continues there once it is erased.
  *
  * @param[in,out] nvm Pointer to the NVM instance.
  *
  * @return
  * - 0 on success.
- * - -1 if the initialization fails.
+ * - -1 if the erase cannot be started.
  */
-int NVM_Init(Nvm_Instance_T *const nvm)
+static int NVM_StartSwap(Nvm_Instance_T *const nvm)
 {
-    if (nvm == NULL || nvm->data == NULL || nvm->sector >= FLASH_SECTOR_TOTAL || nvm->size == 0U)
+    nvm->flushSector = (nvm->activeSector == 0) ? 1 : 0;
+    nvm->activeSector = NVM_NO_SECTOR;
+
+    if (NVM_Port_StartErase(nvm->sectors[nvm->flushSector]) != 0)
     {
         return -1;
     }
 
-    nvm->lastCrc = NVM_CRC_INIT_VALUE;
+    nvm->flushState = NVM_FLUSH_ERASE;
 
     return 0;
 }
 
 /**
- * @brief Reads data from flash memory into the NVM buffer.
+ * @brief Writes a new journal header to the erased sector, making it the active sector.
  *
  * @param[in,out] nvm Pointer to the NVM instance.
  *
  * @return
- * - 0 if the data is read and validated successfully.
- * - -1 if the read operation fails.
+ * - 0 on success.
+ * - -1 if the write operation fails.
  */
-int NVM_Read(Nvm_Instance_T *const nvm)
+static int NVM_StartSector(Nvm_Instance_T *const nvm)
 {
-    if (nvm == NULL || nvm->data == NULL)
+    uint32_t sector = nvm->sectors[nvm->flushSector];
+    uint32_t sectorSize = NVM_Port_GetSectorSize(sector);
+    uint32_t recordLength = NVM_ALIGN(sizeof(NVM_RecordHeader_T) + nvm->size);
+    NVM_SectorHeader_T header =
+    {
+        .magic = NVM_SECTOR_MAGIC,
+        .generation = nvm->generation + 1U,
+        .generationInverted = ~(nvm->generation + 1U),
+        .indexCapacity = (sectorSize - NVM_RECORDS_OFFSET) / (recordLength + NVM_INDEX_ENTRY_SIZE),
+    };
+
+    if (NVM_Port_Program(NVM_Port_GetSectorAddress(sector), (const uint8_t *)&header, sizeof(header)) != 0)
     {
         return -1;
     }
 
-    uint32_t baseAddress = GetSectorBaseAddress(nvm->sector);
-    if (baseAddress == FLASH_SECTOR_INVALID)
+    nvm->activeSector = nvm->flushSector;
+    nvm->generation = header.generation;
+    nvm->writeOffset = NVM_RECORDS_OFFSET;
+    nvm->indexCount = 0U;
+    nvm->flushState = NVM_FLUSH_INDEX;
+
+    return 0;
+}
+
+/**
+ * @brief Checks whether the active sector has space for one more record and its index entry.
+ */
+static bool NVM_HasSpace(const Nvm_Instance_T *const nvm, uint32_t recordLength)
+{
+    NVM_SectorHeader_T header;
+    uint32_t sector = nvm->sectors[nvm->activeSector];
+
+    if (!NVM_ReadSectorHeader(sector, &header) || (nvm->indexCount >= header.indexCapacity))
     {
-        return -1;
+        return false;
     }
 
-    /* Read data from the flash memory into the buffer */
-    for (uint32_t i = 0U; i < nvm->size; i++)
+    uint32_t indexOffset = NVM_Port_GetSectorSize(sector) - header.indexCapacity * NVM_INDEX_ENTRY_SIZE;
+
+    return (nvm->writeOffset + recordLength <= indexOffset);
+}
+
+/**
+ * @brief Programs the footer index entry of the staged record, reserving its space in the active sector.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance.
+ * @param[in] recordLength Aligned length of the record.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the write operation fails.
+ */
+static int NVM_ProgramIndexEntry(Nvm_Instance_T *const nvm, uint32_t recordLength)
+{
+    uint32_t sector = nvm->sectors[nvm->activeSector];
+    uint32_t recordEnd = nvm->writeOffset + recordLength;
+
+    /* The index entry goes first, the space is consumed even if the record is not completed */
+    if (NVM_Port_Program(NVM_GetIndexEntry(sector, nvm->indexCount), (const uint8_t *)&recordEnd, sizeof(recordEnd)) != 0)
     {
-        nvm->data[i] = *(__IO uint8_t *)(baseAddress + i);
+        nvm->activeSector = NVM_NO_SECTOR;
+        return -1;
     }
+    nvm->indexCount++;
+    nvm->recordOffset = nvm->writeOffset;
+    nvm->writeOffset = recordEnd;
+    nvm->flushOffset = 0U;
+    nvm->flushState = NVM_FLUSH_RECORD;
 
-    /* Read the CRC value from the flash memory */
-    uint32_t crcAddress = baseAddress + nvm->size;
-    uint32_t storedCrc = *(__IO uint32_t *)crcAddress;
-    /* Calculate the CRC value of the data */
-    uint32_t calculatedCrc = HAL_CRC_Calculate(&hcrc, (uint32_t *)nvm->data, nvm->size);
+    return 0;
+}
 
-    if (calculatedCrc != storedCrc)
+/**
+ * @brief Programs the next slice of the staged record, the record header first and then
+ *        at most NVM_FLUSH_SLICE_SIZE bytes of data per call.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance.
+ * @param[in] header Pointer to the header of the staged record.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the write operation fails.
+ */
+static int NVM_ProgramRecordSlice(Nvm_Instance_T *const nvm, const NVM_RecordHeader_T *header)
+{
+    const uint8_t *record = NVM_Port_GetSectorAddress(nvm->sectors[nvm->activeSector]) + nvm->recordOffset;
+    int status;
+
+    if (nvm->flushOffset == 0U)
+    {
+        status = NVM_Port_Program(record, (const uint8_t *)header, sizeof(*header));
+        nvm->flushOffset = sizeof(*header);
+    }
+    else
     {
-        if (nvm->defaultData != NULL)
+        uint32_t dataOffset = nvm->flushOffset - sizeof(*header);
+        uint32_t length = nvm->size - dataOffset;
+
+        if (length > NVM_FLUSH_SLICE_SIZE)
         {
-            /* If the calculated CRC value is different, load the default data */
-            memcpy(nvm->data, nvm->defaultData, nvm->size);
-            calculatedCrc = HAL_CRC_Calculate(&hcrc, (uint32_t *)nvm->data, nvm->size);
+            length = NVM_FLUSH_SLICE_SIZE;
         }
-        else
+
+        status = NVM_Port_Program(record + nvm->flushOffset, nvm->staged + dataOffset, length);
+        nvm->flushOffset += length;
+    }
+
+    if (status != 0)
+    {
+        return -1;
+    }
+
+    if (nvm->flushOffset == sizeof(*header) + nvm->size)
+    {
+        nvm->sequence = header->sequence;
+        nvm->lastCrc = nvm->stagedCrc;
+        nvm->flushState = NVM_FLUSH_IDLE;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Executes one bounded step of the flush: choosing the sector, writing the sector header,
+ *        the index entry or a slice of the record.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the step fails.
+ */
+static int NVM_FlushStep(Nvm_Instance_T *const nvm)
+{
+    uint32_t recordLength = NVM_ALIGN(sizeof(NVM_RecordHeader_T) + nvm->size);
+    NVM_RecordHeader_T header =
+    {
+        .sequence = nvm->sequence + 1U,
+        .size = (uint16_t)nvm->size,
+        .version = nvm->version,
+        .crc = nvm->recordCrc,
+    };
+
+    switch (nvm->flushState)
+    {
+    case NVM_FLUSH_PENDING:
+        nvm->recordCrc = NVM_CalculateRecordCrc(&header, nvm->staged, NULL);
+        if ((nvm->activeSector == NVM_NO_SECTOR) || !NVM_HasSpace(nvm, recordLength))
         {
-            return -1;
+            return NVM_StartSwap(nvm);
         }
+        nvm->flushState = NVM_FLUSH_INDEX;
+        return 0;
+
+    case NVM_FLUSH_HEADER:
+        return NVM_StartSector(nvm);
+
+    case NVM_FLUSH_INDEX:
+        return NVM_ProgramIndexEntry(nvm, recordLength);
+
+    case NVM_FLUSH_RECORD:
+        return NVM_ProgramRecordSlice(nvm, &header);
+
+    default:
+        return 0;
     }
+}
 
-    nvm->lastCrc = calculatedCrc;
+/**
+ * @brief Erases the sector, waiting for the erase to complete.
+ *
+ * @param[in] sector Flash sector number.
+ *
+ * @return
+ * - 0 if the sector is erased successfully.
+ * - -1 if the erase operation fails.
+ */
+static int NVM_EraseSector(uint32_t sector)
+{
+    int status;
 
-    return 0;
+    if (NVM_Port_StartErase(sector) != 0)
+    {
+        return -1;
+    }
+
+    while ((status = NVM_Port_GetEraseStatus()) == NVM_PORT_BUSY)
+    {
+    }
+
+    return status;
 }
 
 /**
- * @brief Writes data from the NVM buffer to flash memory.
+ * @brief Initializes the NVM instance.
  *
- * @param[in] nvm Pointer to the NVM instance.
+ * @param[in,out] nvm Pointer to the NVM instance.
  *
  * @return
- * - 0 if the data is written successfully.
- * - -1 if the write operation fails.
+ * - 0 on success.
+ * - -1 if the initialization fails.
  */
-int NVM_Write(Nvm_Instance_T *const nvm)
+int NVM_Init(Nvm_Instance_T *const nvm)
 {
-    if (nvm == NULL || nvm->data == NULL)
+    if (nvm == NULL || nvm->data == NULL || nvm->staged == NULL || nvm->size == 0U || nvm->size > UINT16_MAX)
     {
         return -1;
     }
 
-    uint32_t size = nvm->size;
-    uint8_t *pData = nvm->data;
-    uint32_t currentAddress = GetSectorBaseAddress(nvm->sector);
+    for (uint32_t i = 0U; i < NVM_JOURNAL_SECTORS; i++)
+    {
+        uint32_t sectorSize = NVM_Port_GetSectorSize(nvm->sectors[i]);
 
-    if (currentAddress == FLASH_SECTOR_INVALID)
+        if (!NVM_Port_IsSectorValid(nvm->sectors[i]) ||
+            (sectorSize < NVM_RECORDS_OFFSET + NVM_ALIGN(sizeof(NVM_RecordHeader_T) + nvm->size) + NVM_INDEX_ENTRY_SIZE))
+        {
+            return -1;
+        }
+    }
+    if (nvm->sectors[0] == nvm->sectors[1])
     {
         return -1;
     }
 
-    /* Calculate the CRC value of the data */
-    uint32_t calculatedCrc = HAL_CRC_Calculate(&hcrc, (uint32_t *)nvm->data, nvm->size);
+    nvm->lastCrc = NVM_CRC_INIT_VALUE;
+    nvm->activeSector = NVM_NO_SECTOR;
+    nvm->generation = 0U;
+    nvm->sequence = 0U;
+    nvm->writeOffset = 0U;
+    nvm->indexCount = 0U;
+    nvm->flushState = NVM_FLUSH_IDLE;
+    nvm->flushSector = NVM_NO_SECTOR;
+    nvm->isFlushFailed = false;
+    nvm->isWriteRequested = false;
+
+    return 0;
+}
+
+/**
+ * @brief Reads the newest record from the journal into the NVM buffer.
+ *        A record of another layout, or the data stored before the journal, is converted by the migrate
+ *        function, default data is loaded if there is no valid data that can be used. loadSource tells
+ *        which one happened.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance.
+ *
+ * @return
+ * - 0 if the data is read and validated successfully.
+ * - -1 if the read operation fails or a flush is in progress.
+ */
+int NVM_Read(Nvm_Instance_T *const nvm)
+{
+    if (nvm == NULL || nvm->data == NULL ||
+        (nvm->flushState != NVM_FLUSH_IDLE && nvm->flushState != NVM_FLUSH_PENDING))
+    {
+        return -1;
+    }
+
+    /* A staged write is dropped, the buffer is replaced by the stored data */
+    nvm->flushState = NVM_FLUSH_IDLE;
+    nvm->isWriteRequested = false;
+
+    NVM_SectorScan_T newest = {.record = NULL};
+    NVM_SectorHeader_T headers[NVM_JOURNAL_SECTORS];
+    bool isJournal[NVM_JOURNAL_SECTORS];
 
-    /* If the calculated CRC value is different from the last CRC value, write the data to the flash memory */
-    if (calculatedCrc != nvm->lastCrc)
+    nvm->activeSector = NVM_NO_SECTOR;
+    nvm->generation = 0U;
+
+    for (uint32_t i = 0U; i < NVM_JOURNAL_SECTORS; i++)
     {
-        if (NVM_Erase(nvm) == -1)
+        isJournal[i] = NVM_ReadSectorHeader(nvm->sectors[i], &headers[i]);
+
+        /* Generation of any journal header counts, also of a swap interrupted before its first record */
+        if (isJournal[i] && (headers[i].generation > nvm->generation))
         {
-            return -1;
+            nvm->generation = headers[i].generation;
         }
-        if (NVM_FlashWrite(currentAddress, pData, size) == false)
+    }
+
+    /* Only the newer sector is scanned, the older one only if the newer one holds no valid record */
+    int8_t newer = (isJournal[1] && (!isJournal[0] || (headers[1].generation > headers[0].generation))) ? 1 : 0;
+
+    for (int8_t i = newer, checked = 0; checked < (int8_t)NVM_JOURNAL_SECTORS; i = (i == 0) ? 1 : 0, checked++)
+    {
+        if (!isJournal[i])
         {
-            return -1;
+            continue;
         }
 
-        /* Write the calculated CRC value after the data */
-        uint32_t crcAddress = currentAddress + size;
-        if (NVM_FlashWrite(crcAddress, (uint8_t *)&calculatedCrc, sizeof(calculatedCrc)) == false)
+        NVM_ScanSector(nvm->sectors[i], &headers[i], &newest);
+        if (newest.record != NULL)
         {
-            return -1;
+            nvm->activeSector = i;
+            break;
         }
+    }
+
+    nvm->sequence = newest.sequence;
+    nvm->writeOffset = newest.writeOffset;
+    nvm->indexCount = newest.indexCount;
+
+    NVM_RecordHeader_T recordHeader = {.size = 0U};
+    if (newest.record != NULL)
+    {
+        memcpy(&recordHeader, newest.record, sizeof(recordHeader));
+    }
+
+    /* Fast path: the record data is word aligned and its CRC is known from the validation */
+    if ((newest.record != NULL) && (recordHeader.size == nvm->size) && (recordHeader.version == nvm->version))
+    {
+        memcpy(nvm->data, newest.record + sizeof(recordHeader), nvm->size);
+        nvm->lastCrc = newest.dataCrc;
+        nvm->loadSource = NVM_LOADED_RECORD;
+        return 0;
+    }
+
+    if (nvm->defaultData == NULL)
+    {
+        return -1;
+    }
+
+    memcpy(nvm->data, nvm->defaultData, nvm->size);
+    nvm->loadSource = NVM_LOADED_DEFAULTS;
+
+    if ((newest.record != NULL) && (nvm->migrate != NULL) &&
+        (nvm->migrate(nvm->data, newest.record + sizeof(recordHeader), recordHeader.size, recordHeader.version) == 0))
+    {
+        nvm->loadSource = NVM_LOADED_MIGRATED;
+    }
+    else if ((newest.record == NULL) && !isJournal[0] && NVM_MigrateLegacy(nvm))
+    {
+        nvm->loadSource = NVM_LOADED_MIGRATED;
+    }
+
+    nvm->lastCrc = NVM_Port_CalculateCrc(nvm->data, nvm->size, false);
 
-        /* Update the last CRC value */
-        nvm->lastCrc = calculatedCrc;
+    /* The migrated data is not stored yet, the next write request has to store it even if unchanged */
+    if (nvm->loadSource == NVM_LOADED_MIGRATED)
+    {
+        nvm->lastCrc = ~nvm->lastCrc;
     }
 
     return 0;
 }
 
 /**
- * @brief Erases the specified flash sector.
+ * @brief Stages the NVM buffer for a background flush, if it changed since the last read or write.
+ *        While a flush is in progress the request is remembered and staged once the flush ends.
  *
- * @param[in] nvm Pointer to the NVM instance.
+ * @param[in,out] nvm Pointer to the NVM instance.
  *
  * @return
- * - 0 if the sector is erased successfully.
- * - -1 if the erase operation fails.
+ * - 0 if the data is staged, or there is nothing to write.
+ * - -1 if the instance is invalid.
  */
-int NVM_Erase(Nvm_Instance_T *const nvm)
+int NVM_RequestWrite(Nvm_Instance_T *const nvm)
 {
-    if (nvm == NULL || nvm->data == NULL)
+    if (nvm == NULL || nvm->data == NULL || nvm->staged == NULL)
     {
         return -1;
     }
 
-    FLASH_EraseInitTypeDef eraseInitStruct;
-    uint32_t sectorError = 0U;
+    /* The staged copy is being programmed, it cannot be replaced */
+    if (nvm->flushState != NVM_FLUSH_IDLE && nvm->flushState != NVM_FLUSH_PENDING)
+    {
+        nvm->isWriteRequested = true;
+        return 0;
+    }
+
+    /* Calculate the CRC value of the data */
+    uint32_t calculatedCrc = NVM_Port_CalculateCrc(nvm->data, nvm->size, false);
+
+    /* If the calculated CRC value is the last stored one, a pending flush is not needed anymore */
+    if (calculatedCrc == nvm->lastCrc)
+    {
+        nvm->flushState = NVM_FLUSH_IDLE;
+        return 0;
+    }
+
+    memcpy(nvm->staged, nvm->data, nvm->size);
+    nvm->stagedCrc = calculatedCrc;
+    nvm->isFlushFailed = false;
+    nvm->flushState = NVM_FLUSH_PENDING;
+
+    return 0;
+}
+
+/**
+ * @brief Advances the background flush by one bounded step, to be called from the main loop.
+ *        The completion of an erase is tracked regardless of isFlushAllowed, no flash
+ *        operation is started while the flush is not allowed.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance.
+ * @param[in] isFlushAllowed Whether the flush may program or erase the flash now.
+ */
+void NVM_Process(Nvm_Instance_T *const nvm, bool isFlushAllowed)
+{
+    int status = 0;
+
+    if (nvm == NULL || nvm->flushState == NVM_FLUSH_IDLE)
+    {
+        return;
+    }
+
+    if (nvm->flushState == NVM_FLUSH_ERASE)
+    {
+        status = NVM_Port_GetEraseStatus();
+        if (status == NVM_PORT_BUSY)
+        {
+            return;
+        }
+        if (status == 0)
+        {
+            nvm->flushState = NVM_FLUSH_HEADER;
+        }
+    }
+
+    if (status == 0 && isFlushAllowed)
+    {
+        status = NVM_FlushStep(nvm);
+    }
+
+    if (status != 0)
+    {
+        nvm->flushState = NVM_FLUSH_IDLE;
+        nvm->isFlushFailed = true;
+    }
 
-    eraseInitStruct.TypeErase = FLASH_TYPEERASE_SECTORS;
-    eraseInitStruct.VoltageRange = FLASH_VOLTAGE_RANGE_3;
-    eraseInitStruct.Sector = nvm->sector;
-    eraseInitStruct.NbSectors = 1U;
+    /* Data written during the flush is staged as soon as the staged copy is released */
+    if (nvm->flushState == NVM_FLUSH_IDLE && nvm->isWriteRequested)
+    {
+        nvm->isWriteRequested = false;
+        (void)NVM_RequestWrite(nvm);
+    }
+}
 
-    HAL_FLASH_Unlock();
+/**
+ * @brief Returns the status of the background flush.
+ *
+ * @param[in] nvm Pointer to the NVM instance.
+ *
+ * @return Status of the flush.
+ */
+NVM_Status_T NVM_GetStatus(const Nvm_Instance_T *const nvm)
+{
+    switch (nvm->flushState)
+    {
+    case NVM_FLUSH_IDLE:
+        return nvm->isFlushFailed ? NVM_STATUS_FAILED : NVM_STATUS_COMPLETE;
+    case NVM_FLUSH_PENDING:
+        return NVM_STATUS_PENDING;
+    default:
+        return NVM_STATUS_BUSY;
+    }
+}
 
-    if (HAL_FLASHEx_Erase(&eraseInitStruct, &sectorError) != HAL_OK)
+/**
+ * @brief Appends the NVM buffer to the journal, if it changed since the last read or write.
+ *        Blocks until the flush, including one already in progress, is completed.
+ *        A sector is only erased when the journal swaps to it.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance.
+ *
+ * @return
+ * - 0 if the data is written successfully.
+ * - -1 if the write operation fails.
+ */
+int NVM_Write(Nvm_Instance_T *const nvm)
+{
+    if (NVM_RequestWrite(nvm) != 0)
     {
-        HAL_FLASH_Lock();
         return -1;
     }
 
-    HAL_FLASH_Lock();
+    while (nvm->flushState != NVM_FLUSH_IDLE)
+    {
+        NVM_Process(nvm, true);
+    }
+
+    return nvm->isFlushFailed ? -1 : 0;
+}
 
+/**
+ * @brief Erases both journal sectors, the next write starts a new journal.
+ *
+ * @param[in,out] nvm Pointer to the NVM instance.
+ *
+ * @return
+ * - 0 if the sectors are erased successfully.
+ * - -1 if the erase operation fails or a flush is in progress.
+ */
+int NVM_Erase(Nvm_Instance_T *const nvm)
+{
+    if (nvm == NULL || nvm->data == NULL ||
+        (nvm->flushState != NVM_FLUSH_IDLE && nvm->flushState != NVM_FLUSH_PENDING))
+    {
+        return -1;
+    }
+
+    nvm->activeSector = NVM_NO_SECTOR;
     nvm->lastCrc = NVM_CRC_INIT_VALUE;
+    nvm->flushState = NVM_FLUSH_IDLE;
+    nvm->isWriteRequested = false;
+
+    for (uint32_t i = 0U; i < NVM_JOURNAL_SECTORS; i++)
+    {
+        if (NVM_EraseSector(nvm->sectors[i]) != 0)
+        {
+            return -1;
+        }
+    }
 
     return 0;
 }
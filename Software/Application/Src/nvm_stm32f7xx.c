@@ -0,0 +1,247 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "nvm.h"
+#include "stm32f7xx_hal.h"
+#include "crc.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define FLASH_SECTOR_INVALID (0xFFFFFFFFU)
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static uint32_t GetSectorBaseAddress(uint32_t sector);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+static volatile int eraseStatus = 0;
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+/**
+ * @brief Retrieves the base address of the specified flash sector.
+ *
+ * @param[in] sector Flash sector number.
+ *
+ * @return The base address of the flash sector, or `FLASH_SECTOR_INVALID` if invalid.
+ */
+static uint32_t GetSectorBaseAddress(uint32_t sector)
+{
+    switch (sector)
+    {
+    case FLASH_SECTOR_0:
+        return 0x08000000U;
+    case FLASH_SECTOR_1:
+        return 0x08004000U;
+    case FLASH_SECTOR_2:
+        return 0x08008000U;
+    case FLASH_SECTOR_3:
+        return 0x0800C000U;
+    case FLASH_SECTOR_4:
+        return 0x08010000U;
+    case FLASH_SECTOR_5:
+        return 0x08020000U;
+    case FLASH_SECTOR_6:
+        return 0x08040000U;
+    case FLASH_SECTOR_7:
+        return 0x08060000U;
+    default:
+        return FLASH_SECTOR_INVALID;
+    }
+}
+
+/**
+ * @brief Checks whether the sector exists on the device.
+ */
+bool NVM_Port_IsSectorValid(uint32_t sector)
+{
+    return (GetSectorBaseAddress(sector) != FLASH_SECTOR_INVALID);
+}
+
+/**
+ * @brief Returns the memory mapped address of the sector, NULL if the sector does not exist.
+ */
+const uint8_t *NVM_Port_GetSectorAddress(uint32_t sector)
+{
+    uint32_t baseAddress = GetSectorBaseAddress(sector);
+
+    return (baseAddress == FLASH_SECTOR_INVALID) ? NULL : (const uint8_t *)baseAddress;
+}
+
+/**
+ * @brief Returns the size of the sector in bytes, 0 if the sector does not exist.
+ */
+uint32_t NVM_Port_GetSectorSize(uint32_t sector)
+{
+    switch (sector)
+    {
+    case FLASH_SECTOR_0:
+    case FLASH_SECTOR_1:
+    case FLASH_SECTOR_2:
+    case FLASH_SECTOR_3:
+        return 0x4000U;
+    case FLASH_SECTOR_4:
+        return 0x10000U;
+    case FLASH_SECTOR_5:
+    case FLASH_SECTOR_6:
+    case FLASH_SECTOR_7:
+        return 0x20000U;
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief Starts the erase of the specified flash sector, the flash interrupt reports its completion.
+ *        The flash stays unlocked until the erase ends.
+ *
+ * @param[in] sector Flash sector number.
+ *
+ * @return
+ * - 0 if the erase is started.
+ * - -1 if the erase cannot be started.
+ */
+int NVM_Port_StartErase(uint32_t sector)
+{
+    FLASH_EraseInitTypeDef eraseInitStruct;
+
+    eraseInitStruct.TypeErase = FLASH_TYPEERASE_SECTORS;
+    eraseInitStruct.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    eraseInitStruct.Sector = sector;
+    eraseInitStruct.NbSectors = 1U;
+
+    eraseStatus = NVM_PORT_BUSY;
+    HAL_FLASH_Unlock();
+
+    if (HAL_FLASHEx_Erase_IT(&eraseInitStruct) != HAL_OK)
+    {
+        HAL_FLASH_Lock();
+        eraseStatus = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Returns the status of the last started erase.
+ *
+ * @return
+ * - NVM_PORT_BUSY while the erase is in progress.
+ * - 0 if the sector is erased.
+ * - -1 if the erase failed.
+ */
+int NVM_Port_GetEraseStatus(void)
+{
+    return eraseStatus;
+}
+
+/**
+ * @brief Flash end of operation interrupt callback, called once the sector erase is completed.
+ *
+ * @param[in] ReturnValue Erased sector, 0xFFFFFFFF when the erase procedure is completed.
+ */
+void HAL_FLASH_EndOfOperationCallback(uint32_t ReturnValue)
+{
+    if (ReturnValue == 0xFFFFFFFFU)
+    {
+        HAL_FLASH_Lock();
+        eraseStatus = 0;
+    }
+}
+
+/**
+ * @brief Flash operation error interrupt callback.
+ *
+ * @param[in] ReturnValue Sector which failed to be erased.
+ */
+void HAL_FLASH_OperationErrorCallback(uint32_t ReturnValue)
+{
+    HAL_FLASH_Lock();
+    eraseStatus = -1;
+}
+
+/**
+ * @brief Writes data to the specified flash memory address.
+ *
+ * @param[in] address Starting address in flash memory for the write operation.
+ * @param[in] data Pointer to the data to be written.
+ * @param[in] size Number of bytes to write.
+ *
+ * @return
+ * - 0 if the write operation is successful.
+ * - -1 if the write operation fails.
+ */
+int NVM_Port_Program(const uint8_t *address, const uint8_t *data, uint32_t size)
+{
+    uint32_t baseAddress = (uint32_t)address;
+
+    HAL_FLASH_Unlock();
+
+    while (size > 0)
+    {
+        uint64_t programData;
+        uint32_t increment, programType;
+
+        if (size >= 4U)
+        {
+            programType = FLASH_TYPEPROGRAM_WORD;
+            programData = *(const uint32_t *)data;
+            increment = 4U;
+        }
+        else if (size >= 2U)
+        {
+            programType = FLASH_TYPEPROGRAM_HALFWORD;
+            programData = *(const uint16_t *)data;
+            increment = 2U;
+        }
+        else
+        {
+            programType = FLASH_TYPEPROGRAM_BYTE;
+            programData = *data;
+            increment = 1U;
+        }
+
+        if (HAL_FLASH_Program(programType, baseAddress, programData) != HAL_OK)
+        {
+            HAL_FLASH_Lock();
+            return -1;
+        }
+
+        baseAddress += increment;
+        data += increment;
+        size -= increment;
+    }
+
+    HAL_FLASH_Lock();
+
+    return 0;
+}
+
+/**
+ * @brief Calculates the CRC32 of the data on the CRC unit.
+ *
+ * @param[in] data Pointer to the data.
+ * @param[in] size Size of the data in bytes.
+ * @param[in] accumulate Continue the previous calculation instead of starting a new one.
+ *
+ * @return CRC32 value.
+ */
+uint32_t NVM_Port_CalculateCrc(const uint8_t *data, uint32_t size, bool accumulate)
+{
+    if (accumulate)
+    {
+        return HAL_CRC_Accumulate(&hcrc, (uint32_t *)data, size);
+    }
+
+    return HAL_CRC_Calculate(&hcrc, (uint32_t *)data, size);
+}
@@ -19,6 +19,7 @@ static inline float PID_CalculateIntegralTerm(const PID_Instance_T *const pid, c
 static inline float PID_CalculateDerivativeTerm(const PID_Instance_T *const pid, const float error, const float dt);
 static inline float PID_CalculateProportionalTerm(const PID_Instance_T *const pid, const float error);
 static inline float PID_LimitOutput(const PID_Instance_T *const pid, const float output);
+static void PID_TransferIntegral(PID_Instance_T *const pid, const float kiPrevious);
 
 /******************************************************************************************
  *                                        VARIABLES                                       *
@@ -150,3 +151,117 @@ float PID_Update(PID_Instance_T *const pid, const float measured, const float dt
 
     return output;
 }
+
+/**
+ * @brief Rescales the integral after a change of the integral gain, so that its contribution
+ *        to the output stays the same (bumpless transfer).
+ *
+ * @param[in,out] pid Pointer to the PID instance, its settings hold the new gain.
+ * @param[in] kiPrevious The integral gain used in the previous update.
+ */
+static void PID_TransferIntegral(PID_Instance_T *const pid, const float kiPrevious)
+{
+    const float ki = pid->settings->ki;
+
+    if (ki == kiPrevious)
+    {
+        return;
+    }
+
+    /* Without a gain the integral had no contribution, it restarts from zero */
+    if ((kiPrevious == 0.0f) || (ki == 0.0f))
+    {
+        pid->integral = 0.0f;
+        return;
+    }
+
+    pid->integral *= kiPrevious / ki;
+
+    if (pid->integral > pid->settings->integral_max)
+    {
+        pid->integral = pid->settings->integral_max;
+    }
+    else if (pid->integral < pid->settings->integral_min)
+    {
+        pid->integral = pid->settings->integral_min;
+    }
+}
+
+/**
+ * @brief Compiles a gain schedule into segments, to be called when the parameters change.
+ *
+ * @param[out] table Pointer to the compiled schedule.
+ * @param[in] schedule Pointer to the gains at the breakpoints.
+ *
+ * @return
+ * - 0 on success.
+ * - -1 if the breakpoints are not ascending, the table is disabled.
+ */
+int PID_CompileGainTable(PID_GainTable_T *const table, const PID_GainSchedule_T *const schedule)
+{
+    table->count = 0U;
+
+    for (uint32_t i = 1U; i < PID_GAIN_SCHEDULE_POINTS; i++)
+    {
+        if (!(schedule->inputs[i] > schedule->inputs[i - 1U]))
+        {
+            return -1;
+        }
+    }
+
+    for (uint32_t i = 0U; i < PID_GAIN_SCHEDULE_POINTS; i++)
+    {
+        const float gains[3] = {schedule->kp[i], schedule->ki[i], schedule->kd[i]};
+        const uint32_t next = (i + 1U < PID_GAIN_SCHEDULE_POINTS) ? (i + 1U) : i;
+        const float nextGains[3] = {schedule->kp[next], schedule->ki[next], schedule->kd[next]};
+        const float range = schedule->inputs[next] - schedule->inputs[i];
+
+        table->starts[i] = schedule->inputs[i];
+
+        for (uint32_t k = 0U; k < 3U; k++)
+        {
+            table->gains[i][k] = gains[k];
+            /* The gains hold past the last breakpoint */
+            table->slopes[i][k] = (range > 0.0f) ? (nextGains[k] - gains[k]) / range : 0.0f;
+        }
+    }
+
+    table->count = PID_GAIN_SCHEDULE_POINTS;
+
+    return 0;
+}
+
+/**
+ * @brief Sets the gains of the PID to the schedule at the given input, the gains hold below the
+ *        first and above the last breakpoint. The integral is transferred bumplessly. A disabled
+ *        schedule leaves the gains unchanged.
+ *
+ * @param[in,out] pid Pointer to the PID instance, its settings must point to settings.
+ * @param[in,out] settings The settings used by the PID, only the gains are written.
+ * @param[in] table Pointer to the compiled schedule.
+ * @param[in] input The scheduling input, e.g. the measured speed.
+ */
+void PID_ScheduleGains(PID_Instance_T *const pid, PID_Settings_T *const settings, const PID_GainTable_T *const table,
+                       const float input)
+{
+    if (table->count == 0U)
+    {
+        return;
+    }
+
+    const float kiPrevious = settings->ki;
+    uint32_t segment = 0U;
+
+    while ((segment + 1U < table->count) && (input >= table->starts[segment + 1U]))
+    {
+        segment++;
+    }
+
+    const float offset = (input > table->starts[segment]) ? (input - table->starts[segment]) : 0.0f;
+
+    settings->kp = table->gains[segment][0] + table->slopes[segment][0] * offset;
+    settings->ki = table->gains[segment][1] + table->slopes[segment][1] * offset;
+    settings->kd = table->gains[segment][2] + table->slopes[segment][2] * offset;
+
+    PID_TransferIntegral(pid, kiPrevious);
+}
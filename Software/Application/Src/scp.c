@@ -69,6 +69,16 @@ static int SCP_RegisterInstance(SCP_Instance_T *const scp)
     return 0;
 }
 
+/**
+ * @brief Enables the DWT cycle counter used for SCP timestamps.
+ */
+static void SCP_EnableCycleCounter(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55U;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
 /**
  * @brief Initializes an SCP instance for UART communication.
  *
@@ -80,18 +90,29 @@ static int SCP_RegisterInstance(SCP_Instance_T *const scp)
  */
 int SCP_Init(SCP_Instance_T *const scp)
 {
-    if (NULL == scp || NULL == scp->buffer || NULL == scp->huart || NULL == scp->commands || scp->numCommands == 0)
+    if (NULL == scp || NULL == scp->buffer || NULL == scp->huart || NULL == scp->commands)
     {
         return -1;
     }
 
+    scp->state = SCP_PACKET_STATE_IDLE;
+    scp->hostVersion = SCP_PROTOCOL_VERSION_1;
+    scp->receivedVersion = SCP_PROTOCOL_VERSION_1;
+    scp->rawVersion = SCP_PROTOCOL_VERSION_1;
+    scp->nextPendingSlot = 0U;
+    scp->isCobsFraming = false;
+    scp->isCobsFrameOverflow = false;
+    scp->cobsFrameSize = 0U;
+    memset(scp->pendingRequests, 0, sizeof(scp->pendingRequests));
+
+    SCP_Dispatcher_Init(&scp->queue);
+    SCP_EnableCycleCounter();
+
     if (SCP_RegisterInstance(scp) != 0)
     {
         return -1; 
     }
 
-    SCP_Dispatcher_Init(&scp->queue);
-
     return 0;
 }
 
@@ -112,10 +133,52 @@ void SCP_Process(void *context)
 }
 
 /**
- * @brief Transmits data over UART
+ * @brief Returns the largest payload that fits into a packet of the given protocol version.
+ *
+ * @param[in] version Protocol version.
+ * 
+ * @return Maximum payload size in bytes.
+ */
+uint16_t SCP_GetMaxPayloadSize(uint8_t version)
+{
+    if ((version == SCP_PROTOCOL_VERSION_1) && (SCP_PACKET_MAX_SIZE > UINT8_MAX))
+    {
+        return UINT8_MAX;
+    }
+
+    return SCP_PACKET_MAX_SIZE;
+}
+
+/**
+ * @brief Takes the pending request with the given command ID, so its response reuses the sequence number.
  *
  * @param[in] scp Pointer to the SCP instance.
  * @param[in] id Command ID.
+ * 
+ * @return Pointer to the released request, NULL if no request is pending for the command.
+ */
+static const SCP_PendingRequest_T *SCP_TakePendingRequest(SCP_Instance_T *const scp, SCP_CommandId_T id)
+{
+    for (size_t i = 0U; i < SCP_MAX_PENDING_REQUESTS; i++)
+    {
+        SCP_PendingRequest_T *request = &scp->pendingRequests[i];
+
+        if (request->isPending && request->id == id)
+        {
+            request->isPending = false;
+            return request;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Wraps a v2 packet into a COBS frame and transmits it over UART with a single transfer.
+ *        The frame starts with the delimiter as well, so that the host drops any garbage received before it.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] header Pointer to the packet header.
  * @param[in] data Pointer to the data to be transmitted.
  * @param[in] size Size of the data to be transmitted.
  * 
@@ -123,29 +186,92 @@ void SCP_Process(void *context)
  * - 0 on success.
  * - -1 on failure.
  */
-int SCP_Transmit(SCP_Instance_T *const scp, SCP_CommandId_T id, const void *data, uint16_t size)
+static int SCP_TransmitCobsFrame(SCP_Instance_T *const scp, const SCP_PacketHeader *header, const void *data, uint16_t size)
 {
-    if (!scp)
+    size_t packetSize = sizeof(*header) + size;
+    uint8_t *packet = &scp->txFrame[1U + SCP_COBS_OVERHEAD(packetSize)];
+    size_t frameSize;
+
+    memcpy(packet, header, sizeof(*header));
+    if (size > 0)
     {
+        memcpy(&packet[sizeof(*header)], data, size);
+    }
+
+    scp->txFrame[0] = SCP_COBS_DELIMITER;
+    frameSize = 1U + SCP_Cobs_EncodeInPlace(&scp->txFrame[1], packetSize);
+    scp->txFrame[frameSize++] = SCP_COBS_DELIMITER;
+
+    if (HAL_UART_Transmit(scp->huart, scp->txFrame, (uint16_t)frameSize, HAL_MAX_DELAY) != HAL_OK)
+    {
+        SCP_ErrorHandler(scp);
         return -1;
     }
 
+    return 0;
+}
+
+/**
+ * @brief Builds the packet header and transmits the packet over UART.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] version Protocol version of the packet.
+ * @param[in] id Command ID.
+ * @param[in] seq Sequence number, ignored for protocol v1.
+ * @param[in] status Response status, ignored for protocol v1.
+ * @param[in] data Pointer to the data to be transmitted.
+ * @param[in] size Size of the data to be transmitted.
+ * 
+ * @return 
+ * - 0 on success.
+ * - -1 on failure.
+ */
+static int SCP_TransmitPacket(SCP_Instance_T *const scp, uint8_t version, SCP_CommandId_T id, uint8_t seq,
+                              SCP_Status_T status, const void *data, uint16_t size)
+{
     SCP_PacketHeader packetHeader =
     {
-        .start = SCP_PACKET_START,
+        .start = SCP_PACKET_START_V2,
         .crc = 0,
         .id = id,
-        .size = size
+        .size = size,
+        .seq = seq,
+        .status = status
     };
+    SCP_PacketHeaderV1_T packetHeaderV1;
+    const uint8_t *header = (const uint8_t *)&packetHeader;
+    uint16_t headerSize = sizeof(packetHeader);
+    uint16_t crc;
+
+    if (size > SCP_GetMaxPayloadSize(version))
+    {
+        return -1;
+    }
 
-    uint16_t crcHeaderSize = sizeof(scp->receivedPacket.header.id) + sizeof(scp->receivedPacket.header.size);
-    uint16_t crc = CRC_CalculateCRC16((uint8_t *)&packetHeader.id, crcHeaderSize, SCP_PACKET_CRC_INIT);
+    if (version == SCP_PROTOCOL_VERSION_1)
+    {
+        packetHeaderV1.start = SCP_PACKET_START;
+        packetHeaderV1.id = id;
+        packetHeaderV1.size = (uint8_t)size;
+        crc = CRC_CalculateCRC16((uint8_t *)&packetHeaderV1.id, sizeof(packetHeaderV1.id) + sizeof(packetHeaderV1.size), SCP_PACKET_CRC_INIT);
+        packetHeaderV1.crc = CRC_CalculateCRC16((uint8_t *)data, size, crc);
 
-    crc = CRC_CalculateCRC16((uint8_t *)data, size, crc);
-    packetHeader.crc = crc;
+        header = (const uint8_t *)&packetHeaderV1;
+        headerSize = sizeof(packetHeaderV1);
+    }
+    else
+    {
+        crc = CRC_CalculateCRC16((uint8_t *)&packetHeader.id, sizeof(packetHeader) - offsetof(SCP_PacketHeader, id), SCP_PACKET_CRC_INIT);
+        packetHeader.crc = CRC_CalculateCRC16((uint8_t *)data, size, crc);
+
+        if (version == SCP_PROTOCOL_VERSION_3)
+        {
+            return SCP_TransmitCobsFrame(scp, &packetHeader, data, size);
+        }
+    }
 
     /* TODO: Currently blocking, consider using non-blocking transmission */
-    if (HAL_UART_Transmit(scp->huart, (uint8_t *)&packetHeader, sizeof(packetHeader), HAL_MAX_DELAY) != HAL_OK)
+    if (HAL_UART_Transmit(scp->huart, (uint8_t *)header, headerSize, HAL_MAX_DELAY) != HAL_OK)
     {
         SCP_ErrorHandler(scp);
         return -1;
@@ -162,6 +288,73 @@ int SCP_Transmit(SCP_Instance_T *const scp, SCP_CommandId_T id, const void *data
     return 0;
 }
 
+/**
+ * @brief Transmits data over UART.
+ *        If a request with the same command ID is pending, the packet is sent as its response,
+ *        using the request's protocol version and sequence number. Otherwise the packet is sent
+ *        unsolicited, with sequence number 0, in the protocol version last used by the host.
+ *        Data larger than the payload of that version is not sent, the host receives a
+ *        NACK_TOO_LARGE instead. Protocol v1 has no status field, there the NACK is a response
+ *        without data, which the host tells apart from the expected response by its size.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] id Command ID.
+ * @param[in] data Pointer to the data to be transmitted.
+ * @param[in] size Size of the data to be transmitted.
+ * 
+ * @return 
+ * - 0 on success.
+ * - -1 on failure.
+ */
+int SCP_Transmit(SCP_Instance_T *const scp, SCP_CommandId_T id, const void *data, uint16_t size)
+{
+    if (!scp)
+    {
+        return -1;
+    }
+
+    const SCP_PendingRequest_T *request = SCP_TakePendingRequest(scp, id);
+    const uint8_t version = request ? request->version : scp->hostVersion;
+    const uint8_t seq = request ? request->seq : 0U;
+
+    if (size > SCP_GetMaxPayloadSize(version))
+    {
+        (void)SCP_TransmitPacket(scp, version, id, seq, SCP_STATUS_NACK_TOO_LARGE, NULL, 0U);
+        return -1;
+    }
+
+    return SCP_TransmitPacket(scp, version, id, seq, SCP_STATUS_OK, data, size);
+}
+
+/**
+ * @brief Transmits a response without data carrying only the status, e.g. a NACK.
+ *        The response uses the protocol version of the last received packet.
+ *        Protocol v1 has no status field, so nothing is sent to a v1 host.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] id Command ID of the request.
+ * @param[in] seq Sequence number of the request.
+ * @param[in] status Status to be reported.
+ * 
+ * @return 
+ * - 0 on success.
+ * - -1 on failure.
+ */
+int SCP_TransmitStatus(SCP_Instance_T *const scp, SCP_CommandId_T id, uint8_t seq, SCP_Status_T status)
+{
+    if (!scp)
+    {
+        return -1;
+    }
+
+    if (scp->receivedVersion == SCP_PROTOCOL_VERSION_1)
+    {
+        return 0;
+    }
+
+    return SCP_TransmitPacket(scp, scp->receivedVersion, id, seq, status, NULL, 0U);
+}
+
 /**
  * @brief UART receive event callback for handling incoming data.
  *
@@ -176,6 +369,13 @@ void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
 
         if (scp && scp->huart == huart)
         {
+            /* Half transfer is followed by the idle or complete event reporting the whole chunk */
+            if (huart->RxEventType == HAL_UART_RXEVENT_HT)
+            {
+                return;
+            }
+
+            scp->rxTimestamp = SCP_GetTimestamp();
             SCP_Dispatcher_Enqueue(&scp->queue, scp->buffer, size);
             HAL_UARTEx_ReceiveToIdle_DMA(scp->huart, scp->buffer, scp->size);
             return;
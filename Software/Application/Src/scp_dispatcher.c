@@ -20,7 +20,16 @@
 /******************************************************************************************
  *                                   FUNCTIONS PROTOTYPES                                 *
  ******************************************************************************************/
-static void SCP_Dispatcher_HandlePacketReceived(SCP_Instance_T *scp, void *context);
+static void SCP_Dispatcher_AddPendingRequest(SCP_Instance_T *scp, const SCP_Packet *packet);
+static void SCP_Dispatcher_HandleEcho(SCP_Instance_T *scp, SCP_Packet *packet);
+static void SCP_Dispatcher_HandleGetProtocolVersion(SCP_Instance_T *scp);
+static bool SCP_Dispatcher_IsPacketValid(const SCP_Packet *packet, uint8_t version);
+static bool SCP_Dispatcher_IsSizeValid(const SCP_Command_T *command, uint16_t size);
+static void SCP_Dispatcher_HandlePacketReceived(SCP_Instance_T *scp, SCP_Packet *packet, uint8_t version, void *context);
+static void SCP_Dispatcher_HandleCorruptedPacket(SCP_Instance_T *scp, const SCP_Packet *packet, uint8_t version);
+static void SCP_Dispatcher_HeaderComplete(SCP_Instance_T *scp);
+static void SCP_Dispatcher_ProcessRawByte(SCP_Instance_T *scp, uint8_t byte, void *context);
+static void SCP_Dispatcher_HandleCobsFrame(SCP_Instance_T *scp, void *context);
 
 /******************************************************************************************
  *                                        VARIABLES                                       *
@@ -30,28 +39,201 @@ static void SCP_Dispatcher_HandlePacketReceived(SCP_Instance_T *scp, void *conte
  *                                        FUNCTIONS                                       *
  ******************************************************************************************/
 /**
- * @brief Handles the received packet.
+ * @brief Stores the received request, so that SCP_Transmit can answer it with its sequence number.
+ *        A pending request with the same command ID is replaced, otherwise the oldest slot is reused.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] packet Pointer to the received packet.
+ */
+static void SCP_Dispatcher_AddPendingRequest(SCP_Instance_T *scp, const SCP_Packet *packet)
+{
+    const SCP_PacketHeader *header = &packet->header;
+    SCP_PendingRequest_T *request = NULL;
+
+    for (size_t i = 0U; i < SCP_MAX_PENDING_REQUESTS; i++)
+    {
+        if (scp->pendingRequests[i].isPending && scp->pendingRequests[i].id == header->id)
+        {
+            request = &scp->pendingRequests[i];
+            break;
+        }
+    }
+
+    if (request == NULL)
+    {
+        request = &scp->pendingRequests[scp->nextPendingSlot];
+        scp->nextPendingSlot = (scp->nextPendingSlot + 1U) % SCP_MAX_PENDING_REQUESTS;
+    }
+
+    request->id = header->id;
+    request->seq = header->seq;
+    request->version = scp->receivedVersion;
+    request->isPending = true;
+}
+
+/**
+ * @brief Handles the built-in echo command.
+ *
+ * The payload is echoed back prefixed with the device timestamps, so that the host can
+ * separate the on-device queueing and processing time from the link round trip time.
+ * Payloads which do not fit into the response together with the timestamps are truncated.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in,out] packet Pointer to the received packet, its data buffer is reused for the response.
+ */
+static void SCP_Dispatcher_HandleEcho(SCP_Instance_T *scp, SCP_Packet *packet)
+{
+    SCP_EchoHeader_T echoHeader =
+    {
+        .coreClockHz = SystemCoreClock,
+        .rxTimestamp = scp->packetTimestamp,
+        .dispatchTimestamp = SCP_GetTimestamp(),
+    };
+    uint16_t maxPayloadSize = SCP_GetMaxPayloadSize(scp->receivedVersion) - sizeof(echoHeader);
+    uint16_t payloadSize = packet->header.size;
+
+    if (payloadSize > maxPayloadSize)
+    {
+        payloadSize = maxPayloadSize;
+    }
+
+    memmove(&packet->data[sizeof(echoHeader)], packet->data, payloadSize);
+    echoHeader.txTimestamp = SCP_GetTimestamp();
+    memcpy(packet->data, &echoHeader, sizeof(echoHeader));
+
+    SCP_Transmit(scp, SCP_CMD_ECHO, packet->data, sizeof(echoHeader) + payloadSize);
+}
+
+/**
+ * @brief Handles the built-in protocol version command, used by the host to negotiate the protocol.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ */
+static void SCP_Dispatcher_HandleGetProtocolVersion(SCP_Instance_T *scp)
+{
+    const SCP_ProtocolInfo_T protocolInfo =
+    {
+        .maxVersion = SCP_PROTOCOL_VERSION_3,
+        .maxPendingRequests = SCP_MAX_PENDING_REQUESTS,
+        .maxPayloadSize = SCP_PACKET_MAX_SIZE,
+    };
+
+    SCP_Transmit(scp, SCP_CMD_GET_PROTOCOL_VERSION, &protocolInfo, sizeof(protocolInfo));
+}
+
+/**
+ * @brief Verifies the CRC of the received packet.
+ * 
+ * @param[in] packet Pointer to the received packet.
+ * @param[in] version Protocol version the packet was received with.
+ * 
+ * @return
+ * - true if the CRC matches.
+ * - false otherwise.
+ */
+static bool SCP_Dispatcher_IsPacketValid(const SCP_Packet *packet, uint8_t version)
+{
+    const SCP_PacketHeader *header = &packet->header;
+    uint16_t crc;
+
+    if (version == SCP_PROTOCOL_VERSION_1)
+    {
+        /* v1 CRC covers the 8-bit size, the low byte of the size field */
+        crc = CRC_CalculateCRC16((uint8_t *)&header->id, sizeof(header->id) + sizeof(uint8_t), SCP_PACKET_CRC_INIT);
+    }
+    else
+    {
+        crc = CRC_CalculateCRC16((uint8_t *)&header->id, sizeof(*header) - offsetof(SCP_PacketHeader, id), SCP_PACKET_CRC_INIT);
+    }
+    crc = CRC_CalculateCRC16(packet->data, header->size, crc);
+
+    return (crc == header->crc);
+}
+
+/**
+ * @brief Checks the payload size against the size declared in the command table.
+ * 
+ * @param[in] command Pointer to the command table entry.
+ * @param[in] size Payload size of the received packet.
+ * 
+ * @return
+ * - true if the size is accepted by the command.
+ * - false otherwise.
+ */
+static bool SCP_Dispatcher_IsSizeValid(const SCP_Command_T *command, uint16_t size)
+{
+    switch (command->sizeKind)
+    {
+    case SCP_SIZE_EXACT:
+        return (size == command->size);
+    case SCP_SIZE_MAX:
+        return (size <= command->size);
+    case SCP_SIZE_VARIABLE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Dispatches a valid packet to the built-in or registered command handler.
+ *        The command is looked up in the hash table with a single access, requests with an unknown
+ *        command or an invalid size are rejected with a NACK.
  * 
  * @param[in] scp Pointer to the SCP instance.
+ * @param[in] packet Pointer to the received packet.
+ * @param[in] version Protocol version the packet was received with.
  * @param[in] context Pointer to the context, to be passed to the command handler.
  */
-static void SCP_Dispatcher_HandlePacketReceived(SCP_Instance_T *scp, void *context)
+static void SCP_Dispatcher_HandlePacketReceived(SCP_Instance_T *scp, SCP_Packet *packet, uint8_t version, void *context)
 {
-    uint16_t crcDataSize = scp->receivedPacket.header.size + sizeof(scp->receivedPacket.header.id) + sizeof(scp->receivedPacket.header.size);
-    uint16_t crc = CRC_CalculateCRC16((uint8_t *)&scp->receivedPacket.header.id, crcDataSize, SCP_PACKET_CRC_INIT);
+    const SCP_PacketHeader *header = &packet->header;
+
+    scp->receivedVersion = version;
+    scp->hostVersion = version;
+
+    if (header->id == SCP_CMD_ECHO)
+    {
+        SCP_Dispatcher_AddPendingRequest(scp, packet);
+        SCP_Dispatcher_HandleEcho(scp, packet);
+        return;
+    }
+    if (header->id == SCP_CMD_GET_PROTOCOL_VERSION)
+    {
+        SCP_Dispatcher_AddPendingRequest(scp, packet);
+        SCP_Dispatcher_HandleGetProtocolVersion(scp);
+        return;
+    }
+
+    const SCP_Command_T *command = &scp->commands[SCP_COMMAND_HASH(header->id)];
 
-    if (crc == scp->receivedPacket.header.crc)
+    if ((command->handler != NULL) && (command->id == header->id))
     {
-        for (size_t i = 0U; i < scp->numCommands; i++)
+        if (!SCP_Dispatcher_IsSizeValid(command, header->size))
         {
-            if ((scp->receivedPacket.header.id == scp->commands[i].id) &&
-                (scp->receivedPacket.header.size == scp->commands[i].size))
-            {
-                scp->commands[i].handler(&scp->receivedPacket, context);
-                break;
-            }
+            SCP_TransmitStatus(scp, header->id, header->seq, SCP_STATUS_NACK_INVALID_SIZE);
+            return;
         }
+
+        SCP_Dispatcher_AddPendingRequest(scp, packet);
+        command->handler(packet, context);
+        return;
     }
+
+    SCP_TransmitStatus(scp, header->id, header->seq, SCP_STATUS_NACK_UNKNOWN_COMMAND);
+}
+
+/**
+ * @brief Handles a packet which failed the CRC check, a NACK is sent to hosts supporting it.
+ * 
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] packet Pointer to the received packet.
+ * @param[in] version Protocol version the packet was received with.
+ */
+static void SCP_Dispatcher_HandleCorruptedPacket(SCP_Instance_T *scp, const SCP_Packet *packet, uint8_t version)
+{
+    scp->receivedVersion = version;
+    SCP_TransmitStatus(scp, packet->header.id, packet->header.seq, SCP_STATUS_NACK_CRC);
 }
 
 /**
@@ -73,6 +255,7 @@ void SCP_Dispatcher_Init(SCP_DispatcherQueue_T *scpQueue)
 
 /**
  * @brief Enqueue a data into the global circular buffer.
+ *        Data that does not fit entirely is dropped, the parser resynchronizes on the next start byte.
  *
  * @param[in] scpQueue Pointer to the SCP queue.
  * @param[in] data The byte array to be enqueued.
@@ -82,7 +265,7 @@ void SCP_Dispatcher_Enqueue(SCP_DispatcherQueue_T *scpQueue, const uint8_t *data
 {
     SCP_Dispatcher_EnterCritical();
 
-    if (scpQueue->count < SCP_GLOBAL_BUFFER_SIZE)
+    if ((scpQueue->count + size) <= SCP_GLOBAL_BUFFER_SIZE)
     {
         for (uint16_t i = 0U; i < size; i++)
         {
@@ -122,8 +305,181 @@ uint8_t SCP_Dispatcher_Dequeue(SCP_DispatcherQueue_T *scpQueue, uint8_t *data)
     return retVal;
 }
 
+/**
+ * @brief Starts the reception of the packet data, once the whole header has been received.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ */
+static void SCP_Dispatcher_HeaderComplete(SCP_Instance_T *scp)
+{
+    scp->dataBytesReceived = 0U;
+
+    if (scp->receivedPacket.header.size > SCP_PACKET_MAX_SIZE)
+    {
+        scp->state = SCP_PACKET_STATE_IDLE;
+    }
+    else if (scp->receivedPacket.header.size > 0U)
+    {
+        scp->state = SCP_PACKET_STATE_GETTING_DATA;
+    }
+    else
+    {
+        scp->state = SCP_PACKET_STATE_PACKET_COMPLETE;
+    }
+}
+
+/**
+ * @brief Feeds a byte to the parser of unframed v1 and v2 packets, the version is selected by the start byte.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] byte Received byte.
+ * @param[in] context Pointer to the context, to be passed to the command handler.
+ */
+static void SCP_Dispatcher_ProcessRawByte(SCP_Instance_T *scp, uint8_t byte, void *context)
+{
+    SCP_PacketHeader *header = &scp->receivedPacket.header;
+
+    switch (scp->state)
+    {
+    case SCP_PACKET_STATE_IDLE:
+        if (byte == SCP_PACKET_START || byte == SCP_PACKET_START_V2)
+        {
+            memset(header, 0, sizeof(*header));
+            header->start = byte;
+            scp->rawVersion = (byte == SCP_PACKET_START) ? SCP_PROTOCOL_VERSION_1 : SCP_PROTOCOL_VERSION_2;
+            scp->packetTimestamp = scp->rxTimestamp;
+            scp->state = SCP_PACKET_STATE_GOT_START;
+        }
+        break;
+    case SCP_PACKET_STATE_GOT_START:
+        header->crc = byte;
+        scp->state = SCP_PACKET_STATE_GOT_CRC_LOW;
+        break;
+    case SCP_PACKET_STATE_GOT_CRC_LOW:
+        header->crc |= (uint16_t)(byte << 8);
+        scp->state = SCP_PACKET_STATE_GOT_CRC_HIGH;
+        break;
+    case SCP_PACKET_STATE_GOT_CRC_HIGH:
+        header->id = byte;
+        scp->state = SCP_PACKET_STATE_GOT_ID_LOW;
+        break;
+    case SCP_PACKET_STATE_GOT_ID_LOW:
+        header->id |= (uint16_t)(byte << 8);
+        scp->state = SCP_PACKET_STATE_GOT_ID_HIGH;
+        break;
+    case SCP_PACKET_STATE_GOT_ID_HIGH:
+        header->size = byte;
+        if (scp->rawVersion == SCP_PROTOCOL_VERSION_1)
+        {
+            SCP_Dispatcher_HeaderComplete(scp);
+        }
+        else
+        {
+            scp->state = SCP_PACKET_STATE_GOT_SIZE_LOW;
+        }
+        break;
+    case SCP_PACKET_STATE_GOT_SIZE_LOW:
+        header->size |= (uint16_t)(byte << 8);
+        scp->state = SCP_PACKET_STATE_GOT_SIZE_HIGH;
+        break;
+    case SCP_PACKET_STATE_GOT_SIZE_HIGH:
+        header->seq = byte;
+        scp->state = SCP_PACKET_STATE_GOT_SEQ;
+        break;
+    case SCP_PACKET_STATE_GOT_SEQ:
+        header->status = byte;
+        SCP_Dispatcher_HeaderComplete(scp);
+        break;
+    case SCP_PACKET_STATE_GETTING_DATA:
+        scp->receivedPacket.data[scp->dataBytesReceived++] = byte;
+        if (scp->dataBytesReceived == header->size)
+        {
+            scp->state = SCP_PACKET_STATE_PACKET_COMPLETE;
+        }
+        break;
+    default:
+        scp->state = SCP_PACKET_STATE_IDLE;
+        break;
+    }
+
+    if (scp->state == SCP_PACKET_STATE_PACKET_COMPLETE)
+    {
+        scp->state = SCP_PACKET_STATE_IDLE;
+
+        if (SCP_Dispatcher_IsPacketValid(&scp->receivedPacket, scp->rawVersion))
+        {
+            scp->isCobsFraming = false;
+            SCP_Dispatcher_HandlePacketReceived(scp, &scp->receivedPacket, scp->rawVersion, context);
+        }
+        else
+        {
+            SCP_Dispatcher_HandleCorruptedPacket(scp, &scp->receivedPacket, scp->rawVersion);
+        }
+    }
+}
+
+/**
+ * @brief Handles a complete COBS frame, terminated by the delimiter.
+ *
+ * A frame which decodes to a v2 packet with a valid CRC switches the instance to COBS framing,
+ * from then on unframed parsing is bypassed and any corruption is confined to a single frame.
+ * In COBS framing, frames which are not well-formed COBS are passed to the unframed parser,
+ * so that a host which starts over with unframed packets is still understood.
+ *
+ * @param[in] scp Pointer to the SCP instance.
+ * @param[in] context Pointer to the context, to be passed to the command handler.
+ */
+static void SCP_Dispatcher_HandleCobsFrame(SCP_Instance_T *scp, void *context)
+{
+    SCP_Packet *packet = (SCP_Packet *)scp->cobsFrame;
+    size_t frameSize = scp->cobsFrameSize;
+
+    scp->cobsFrameSize = 0U;
+
+    if (scp->isCobsFrameOverflow || (frameSize == 0U))
+    {
+        scp->isCobsFrameOverflow = false;
+        return;
+    }
+
+    if (!SCP_Cobs_IsValid(scp->cobsFrame, frameSize))
+    {
+        if (scp->isCobsFraming)
+        {
+            for (size_t i = 0U; i < frameSize; i++)
+            {
+                SCP_Dispatcher_ProcessRawByte(scp, scp->cobsFrame[i], context);
+            }
+            SCP_Dispatcher_ProcessRawByte(scp, SCP_COBS_DELIMITER, context);
+        }
+        return;
+    }
+
+    size_t packetSize = SCP_Cobs_DecodeInPlace(scp->cobsFrame, frameSize);
+
+    if ((packetSize < sizeof(SCP_PacketHeader)) || (packet->header.start != SCP_PACKET_START_V2) ||
+        (packet->header.size != (packetSize - sizeof(SCP_PacketHeader))) || (packet->header.size > SCP_PACKET_MAX_SIZE))
+    {
+        return;
+    }
+
+    if (SCP_Dispatcher_IsPacketValid(packet, SCP_PROTOCOL_VERSION_3))
+    {
+        scp->isCobsFraming = true;
+        scp->state = SCP_PACKET_STATE_IDLE;
+        scp->packetTimestamp = scp->cobsFrameTimestamp;
+        SCP_Dispatcher_HandlePacketReceived(scp, packet, SCP_PROTOCOL_VERSION_3, context);
+    }
+    else if (scp->isCobsFraming)
+    {
+        SCP_Dispatcher_HandleCorruptedPacket(scp, packet, SCP_PROTOCOL_VERSION_3);
+    }
+}
+
 /**
  * @brief Processes the next command in the global buffer.
+ *        Every byte is collected into the COBS frame. Until the host switches to COBS framing,
+ *        the bytes are also parsed as unframed v1 and v2 packets.
  *
  * @param[in] scp Pointer to the SCP instance.
  * @param[in] context Pointer to the context, to be passed to the command handler.
@@ -135,61 +491,28 @@ void SCP_Dispatcher_Process(SCP_Instance_T *scp, void *context)
 
     while (SCP_Dispatcher_Dequeue(scpQueue, &byte))
     {
-        switch (scp->state)
-        {
-        case SCP_PACKET_STATE_IDLE:
-            if (byte == SCP_PACKET_START)
-            {
-                scp->receivedPacket.header.start = byte;
-                scp->receivedPacket.header.size = 0U;
-                scp->state = SCP_PACKET_STATE_GOT_START;
-            }
-            break;
-        case SCP_PACKET_STATE_GOT_START:
-            scp->receivedPacket.header.crc = byte;
-            scp->state = SCP_PACKET_STATE_GOT_CRC_LOW;
-            break;
-        case SCP_PACKET_STATE_GOT_CRC_LOW:
-            scp->receivedPacket.header.crc |= (uint16_t)(byte << 8);
-            scp->state = SCP_PACKET_STATE_GOT_CRC_HIGH;
-            break;
-        case SCP_PACKET_STATE_GOT_CRC_HIGH:
-            scp->receivedPacket.header.id = byte;
-            scp->state = SCP_PACKET_STATE_GOT_ID_LOW;
-            break;
-        case SCP_PACKET_STATE_GOT_ID_LOW:
-            scp->receivedPacket.header.id |= (uint16_t)(byte << 8);
-            scp->state = SCP_PACKET_STATE_GOT_SIZE;
-            break;
-        case SCP_PACKET_STATE_GOT_SIZE:
-            scp->receivedPacket.header.size = byte;
-            scp->dataBytesReceived = 0U;
+        bool isCobsFraming = scp->isCobsFraming;
 
-            if (scp->receivedPacket.header.size > 0U)
-            {
-                scp->state = SCP_PACKET_STATE_GETTING_DATA;
-            }
-            else
-            {
-                scp->state = SCP_PACKET_STATE_PACKET_COMPLETE;
-            }
-            break;
-        case SCP_PACKET_STATE_GETTING_DATA:
-            scp->receivedPacket.data[scp->dataBytesReceived++] = byte;
-            if (scp->dataBytesReceived == scp->receivedPacket.header.size)
+        if (byte == SCP_COBS_DELIMITER)
+        {
+            SCP_Dispatcher_HandleCobsFrame(scp, context);
+        }
+        else if (scp->cobsFrameSize < sizeof(scp->cobsFrame))
+        {
+            if (scp->cobsFrameSize == 0U)
             {
-                scp->state = SCP_PACKET_STATE_PACKET_COMPLETE;
+                scp->cobsFrameTimestamp = scp->rxTimestamp;
             }
-            break;
-        default:
-            scp->state = SCP_PACKET_STATE_IDLE;
-            break;
+            scp->cobsFrame[scp->cobsFrameSize++] = byte;
+        }
+        else
+        {
+            scp->isCobsFrameOverflow = true;
         }
 
-        if (scp->state == SCP_PACKET_STATE_PACKET_COMPLETE)
+        if (!isCobsFraming)
         {
-            SCP_Dispatcher_HandlePacketReceived(scp, context);
-            scp->state = SCP_PACKET_STATE_IDLE;
+            SCP_Dispatcher_ProcessRawByte(scp, byte, context);
         }
     }
 }
@@ -4,6 +4,7 @@
 #include "sensors.h"
 #include "cmsis_compiler.h"
 #include <string.h>
+#include <math.h>
 
 /******************************************************************************************
  *                                         DEFINES                                        *
@@ -18,6 +19,8 @@ static bool Sensors_UpdateSlidingWindow(Sensors_Instance_T *const instance, uint
                                         uint8_t *activeCount, uint8_t *windowStart,
                                         uint8_t maxStartIndex, uint8_t sideStartIndex);
 static void Sensors_UpdateState(Sensors_Instance_T *const instance);
+static void Sensors_FitTracker(Sensors_LineTracker_T *const tracker);
+static float Sensors_PredictError(Sensors_LineTracker_T *const tracker, const Sensors_ErrorConfig_T *const config);
 
 /******************************************************************************************
  *                                        FUNCTIONS                                       *
@@ -188,11 +191,13 @@ int Sensors_Init(Sensors_Instance_T *const instance,
     instance->callback = callback;
     instance->callbackContext = callbackContext;
     instance->anySensorDetectedLine = false;
+    Sensors_ResetTracker(instance);
 
     for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
     {
         instance->sensors[i].isActive = false;
         instance->thresholds[i] = 0xFFFFU;
+        instance->calibratedThresholds[i] = 0xFFFFU;
     }
 
     /* Start ADC in DMA mode, triggered by timer */
@@ -209,24 +214,78 @@ int Sensors_Init(Sensors_Instance_T *const instance,
 }
 
 /**
- * @brief Sets the thresholds for sensor activation.
+ * @brief Sets the calibrated thresholds and line/background levels, the adaptation restarts from them.
  *
- * @param[in,out] instance    Pointer to the sensors instance.
- * @param[in]     thresholds  Array of thresholds for each sensor.
+ * @param[in,out] instance          Pointer to the sensors instance.
+ * @param[in]     thresholds        Array of thresholds for each sensor.
+ * @param[in]     backgroundLevels  Array of background readings for each sensor.
+ * @param[in]     lineLevels        Array of line readings for each sensor.
  */
-void Sensors_SetThresholds(Sensors_Instance_T *const instance, uint16_t *const thresholds)
+void Sensors_SetCalibration(Sensors_Instance_T *const instance, const uint16_t *const thresholds,
+                            const uint16_t *const backgroundLevels, const uint16_t *const lineLevels)
 {
-    if (instance == NULL || thresholds == NULL)
+    if (instance == NULL || thresholds == NULL || backgroundLevels == NULL || lineLevels == NULL)
     {
         return;
     }
 
     for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
     {
+        instance->calibratedThresholds[i] = thresholds[i];
+        instance->sensors[i].threshold = (float)thresholds[i];
+        instance->sensors[i].backgroundLevel = (float)backgroundLevels[i];
+        instance->sensors[i].lineLevel = (float)lineLevels[i];
         instance->thresholds[i] = thresholds[i];
     }
 }
 
+/**
+ * @brief Follows slow changes of the lighting. A reading clearly above or below the threshold
+ *        updates the exponential average of the line or the background level, the threshold moves
+ *        towards the middle of the levels within the bound around the calibrated threshold and
+ *        the rate limit. Readings close to the threshold are ignored.
+ *
+ * @param[in,out] instance  Pointer to the sensors instance.
+ * @param[in]     config    Adaptation settings.
+ * @param[in]     dt        Time since the previous call [ms].
+ */
+void Sensors_AdaptThresholds(Sensors_Instance_T *const instance, const Sensors_AdaptConfig_T *const config, float dt)
+{
+    if (config->rate <= 0.0f)
+    {
+        return;
+    }
+
+    const float maxStep = config->maxStepPerMs * dt;
+
+    for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
+    {
+        Sensor_Instance_T *sensor = &instance->sensors[i];
+        const float reading = (float)instance->adcBuffer[i];
+        const float band = config->margin * (sensor->lineLevel - sensor->backgroundLevel);
+
+        if (reading > (sensor->threshold + band))
+        {
+            sensor->lineLevel += config->rate * (reading - sensor->lineLevel);
+        }
+        else if (reading < (sensor->threshold - band))
+        {
+            sensor->backgroundLevel += config->rate * (reading - sensor->backgroundLevel);
+        }
+        else
+        {
+            continue;
+        }
+
+        const float calibrated = (float)instance->calibratedThresholds[i];
+        float target = 0.5f * (sensor->lineLevel + sensor->backgroundLevel);
+
+        target = fminf(fmaxf(target, calibrated - config->maxDeviation), calibrated + config->maxDeviation);
+        sensor->threshold += fminf(fmaxf(target - sensor->threshold, -maxStep), maxStep);
+        instance->thresholds[i] = (uint16_t)(sensor->threshold + 0.5f);
+    }
+}
+
 /**
  * @brief Updates the state of the LEDs based on sensor activity.
  *
@@ -252,59 +311,174 @@ void Sensors_UpdateLeds(Sensors_Instance_T *const instance)
 }
 
 /**
- * @brief Calculates the error based on sensor readings.
+ * @brief Fits a line to the tracked errors over time by least squares, the time of the last sample
+ *        is 0. The rate is 0 if the samples do not span any time, at least one sample is needed.
+ */
+static void Sensors_FitTracker(Sensors_LineTracker_T *const tracker)
+{
+    float sumTime = 0.0f;
+    float sumError = 0.0f;
+    float sumTimeSquared = 0.0f;
+    float sumProduct = 0.0f;
+    float time = 0.0f;
+    uint8_t index = tracker->head;
+    float count = (float)tracker->count;
+
+    for (uint8_t i = 0U; i < tracker->count; i++)
+    {
+        index = (index == 0U) ? (SENSORS_TRACKER_SAMPLES - 1U) : (index - 1U);
+
+        sumTime += time;
+        sumError += tracker->errors[index];
+        sumTimeSquared += time * time;
+        sumProduct += time * tracker->errors[index];
+
+        time -= tracker->intervals[index];
+    }
+
+    float denominator = count * sumTimeSquared - sumTime * sumTime;
+
+    tracker->errorRate = (denominator > 1e-6f) ? (count * sumProduct - sumTime * sumError) / denominator : 0.0f;
+    tracker->predictedError = (sumError - tracker->errorRate * sumTime) / count;
+}
+
+/**
+ * @brief Extrapolates the fitted error to the time since the line was lost, within the fallback
+ *        errors. The confidence in it falls linearly over lineLossDecay and the error moves towards
+ *        the fallback error of the side the line went to.
+ */
+static float Sensors_PredictError(Sensors_LineTracker_T *const tracker, const Sensors_ErrorConfig_T *const config)
+{
+    float errorMin = fminf(config->fallbackErrorPositive, config->fallbackErrorNegative);
+    float errorMax = fmaxf(config->fallbackErrorPositive, config->fallbackErrorNegative);
+    float prediction = tracker->predictedError + tracker->errorRate * tracker->elapsed;
+    float confidence = 0.0f;
+
+    prediction = fminf(fmaxf(prediction, errorMin), errorMax);
+
+    if (config->lineLossDecay > 0.0f)
+    {
+        confidence = fmaxf(1.0f - tracker->elapsed / config->lineLossDecay, 0.0f);
+    }
+
+    /* Without the prediction the side is the one of the last error, as before the tracker */
+    float side = (config->lineLossDecay > 0.0f) ? prediction : tracker->lastError;
+    float fallback = prediction;
+
+    if (side > config->errorThreshold)
+    {
+        fallback = config->fallbackErrorPositive;
+    }
+    else if (side < config->errorThreshold)
+    {
+        fallback = config->fallbackErrorNegative;
+    }
+    else if (config->lineLossDecay <= 0.0f)
+    {
+        return tracker->lastError;
+    }
+
+    return fallback + confidence * (prediction - fallback);
+}
+
+/**
+ * @brief Clears the error history of the line tracker, to be called before a run.
+ *
+ * @param[in,out] instance Pointer to the sensors instance.
+ */
+void Sensors_ResetTracker(Sensors_Instance_T *const instance)
+{
+    if (instance == NULL)
+    {
+        return;
+    }
+
+    memset(&instance->tracker, 0, sizeof(instance->tracker));
+}
+
+/**
+ * @brief Calculates the error based on sensor readings. While the line is detected the error is
+ *        tracked, after a loss it is predicted from the tracked errors, see Sensors_PredictError.
  *
  * @param[in,out] instance    Pointer to the sensors instance.
- * @param[in]     nvmSensors  Pointer to the configuration from NVM.
+ * @param[in]     config      Pointer to the error calculation settings.
+ * @param[in]     dt          Time since the previous call [ms].
  *
  * @return Calculated error value.
  */
-float Sensors_CalculateError(Sensors_Instance_T *const instance, const NVM_Sensors_T *const nvmSensors)
+float Sensors_CalculateError(Sensors_Instance_T *const instance, const Sensors_ErrorConfig_T *const config,
+                             float dt)
 {
-    static float lastError = 0.0f;
     float currentError = 0.0f;
-    int totalWeight = 0;
+    float totalWeight = 0.0f;
     int activeSensors = 0;
 
-    if (instance == NULL || nvmSensors == NULL)
+    if (instance == NULL)
     {
-        return lastError;
+        return 0.0f;
     }
 
-    for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
+    Sensors_LineTracker_T *const tracker = &instance->tracker;
+
+    if (config == NULL)
     {
-        instance->sensors[i].positionWeight = nvmSensors->weights[i];
+        return tracker->lastError;
+    }
 
+    for (uint16_t i = 0U; i < SENSORS_NUMBER; i++)
+    {
         if (instance->sensors[i].isActive)
         {
-            totalWeight += instance->sensors[i].positionWeight;
+            totalWeight += config->weights[i];
             activeSensors++;
         }
     }
 
+    tracker->elapsed += dt;
+
     if (activeSensors == 0)
     {
-        /* If no sensors are active, return the fallback error based on the last known error */
-        if (lastError > nvmSensors->errorThreshold)
-        {
-            currentError = nvmSensors->fallbackErrorPositive;
-        }
-        else if (lastError < nvmSensors->errorThreshold)
+        if (!tracker->isLineLost)
         {
-            currentError = nvmSensors->fallbackErrorNegative;
-        }
-        else
-        {
-            return lastError;
+            tracker->isLineLost = true;
+
+            if (tracker->count > 0U)
+            {
+                Sensors_FitTracker(tracker);
+            }
+            else
+            {
+                /* Nothing tracked yet, the last error or the fallback of its side is used */
+                tracker->predictedError = tracker->lastError;
+                tracker->errorRate = 0.0f;
+            }
         }
+
+        currentError = Sensors_PredictError(tracker, config);
     }
     else
     {
         /* Calculate the current error as a weighted average of active sensors */
-        currentError = (float)totalWeight / (float)activeSensors;
+        currentError = totalWeight / (float)activeSensors;
+
+        /* The history from before a loss does not describe the line found again */
+        if (tracker->isLineLost)
+        {
+            tracker->isLineLost = false;
+            tracker->count = 0U;
+        }
+
+        tracker->errors[tracker->head] = currentError;
+        tracker->intervals[tracker->head] = tracker->elapsed;
+        tracker->head = (tracker->head + 1U) % SENSORS_TRACKER_SAMPLES;
+        if (tracker->count < SENSORS_TRACKER_SAMPLES)
+        {
+            tracker->count++;
+        }
+        tracker->elapsed = 0.0f;
     }
 
-    lastError = currentError;
+    tracker->lastError = currentError;
 
     return currentError;
 }
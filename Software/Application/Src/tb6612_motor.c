@@ -14,6 +14,7 @@
 /******************************************************************************************
  *                                   FUNCTIONS PROTOTYPES                                 *
  ******************************************************************************************/
+static void TB6612Motor_WritePins(const TB6612MotorDriver_T *const driver, TB6612MotorDirection_T direction);
 
 /******************************************************************************************
  *                                        VARIABLES                                       *
@@ -27,7 +28,7 @@
  * 
  * @param driver Pointer to the TB6612MotorDriver_T instance.
  */
-int TB6612Motor_Init(const TB6612MotorDriver_T *const driver)
+int TB6612Motor_Init(TB6612MotorDriver_T *const driver)
 {
     if ((driver == NULL) || (driver->pwmTimer == NULL) || (driver->in1.port == NULL) || (driver->in2.port == NULL))
     {
@@ -35,18 +36,32 @@ int TB6612Motor_Init(const TB6612MotorDriver_T *const driver)
     }
 
     HAL_TIM_PWM_Start(driver->pwmTimer, driver->pwmChannel);
-    TB6612Motor_Stop(driver);
+    /* The pin state is unknown until it is written once */
+    TB6612Motor_WritePins(driver, MOTOR_STOP);
+    driver->direction = MOTOR_STOP;
+    TB6612Motor_SetSpeed(driver, 0);
 
     return 0;
 }
 
 /**
- * @brief Changes the motor direction.
+ * @brief Changes the motor direction, the pins are only written when the direction changes.
  * 
  * @param driver Pointer to the TB6612MotorDriver_T instance.
  * @param direction Motor direction.
  */
-void TB6612Motor_ChangeDirection(const TB6612MotorDriver_T *const driver, TB6612MotorDirection_T direction)
+void TB6612Motor_ChangeDirection(TB6612MotorDriver_T *const driver, TB6612MotorDirection_T direction)
+{
+    if (direction == driver->direction)
+    {
+        return;
+    }
+
+    TB6612Motor_WritePins(driver, direction);
+    driver->direction = direction;
+}
+
+static void TB6612Motor_WritePins(const TB6612MotorDriver_T *const driver, TB6612MotorDirection_T direction)
 {
     switch (direction)
     {
@@ -85,7 +100,7 @@ void TB6612Motor_SetSpeed(const TB6612MotorDriver_T *const driver, uint16_t spee
  * 
  * @param driver Pointer to the TB6612MotorDriver_T instance.
  */
-void TB6612Motor_Stop(const TB6612MotorDriver_T *const driver)
+void TB6612Motor_Stop(TB6612MotorDriver_T *const driver)
 {
     TB6612Motor_ChangeDirection(driver, MOTOR_STOP);
     TB6612Motor_SetSpeed(driver, 0);
@@ -96,7 +111,7 @@ void TB6612Motor_Stop(const TB6612MotorDriver_T *const driver)
  * 
  * @param driver Pointer to the TB6612MotorDriver_T instance.
  */
-void TB6612Motor_Brake(const TB6612MotorDriver_T *const driver)
+void TB6612Motor_Brake(TB6612MotorDriver_T *const driver)
 {
     TB6612Motor_ChangeDirection(driver, MOTOR_BRAKE);
     TB6612Motor_SetSpeed(driver, 0);
@@ -29,6 +29,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "lf_main.h"
+#include "lf_profiles.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -51,42 +52,39 @@
 /* USER CODE BEGIN PV */
 extern const Sensors_Config_T sensorsConfig;
 
-static NVM_Layout_T NvmBlock;
+static NVM_Profiles_T NvmProfiles;
+static NVM_Profiles_T NvmStagedProfiles;
 static uint8_t ScpBuffer[SCP_BUFFER_SIZE];
 
 LineFollower_T LineFollower = {
     .debugModeTimer = &htim6,
     .cycleCountReg = &DWT->CYCCNT,
     .nvmInstance = {
-        .defaultData = (const uint8_t *)&NvmDefaultData,
-        .size = sizeof(NVM_Layout_T),
-        .sector = NVM_SECTOR_USED
+        .defaultData = (const uint8_t *)&NvmDefaultProfiles,
+        .size = sizeof(NVM_Profiles_T),
+        .version = NVM_LAYOUT_VERSION,
+        .migrate = LF_Profiles_Migrate,
+        .legacySize = LF_PROFILES_LEGACY_LAYOUT_SIZE,
+        .staged = (uint8_t *)&NvmStagedProfiles,
+        .sectors = {NVM_SECTOR_PRIMARY, NVM_SECTOR_SECONDARY}
     },
-    .nvmBlock = &NvmBlock,
+    .nvmProfiles = &NvmProfiles,
     .scpInstance = {
         .buffer = ScpBuffer,
         .size = SCP_BUFFER_SIZE,
         .huart = &huart4,
         .commands = lineFollowerCommands,
-        .numCommands = sizeof(lineFollowerCommands) / sizeof(lineFollowerCommands[0]),
         .errorHandler = NULL
     },
-    .pidSensorInstance = {
-        .settings = &NvmBlock.pidStgSensor
-    },
-    .pidEncoderLeftInstance = {
-      .settings =&NvmBlock.pidStgEncoderLeft
-    },
-    .pidEncoderRightInstance = {
-      .settings =&NvmBlock.pidStgEncoderRight
-    },
     .encoderLeft = {
       .settings = &encoderSettings,
-      .htim = &htim8
+      .htim = &htim8,
+      .isReversed = false
     },
     .encoderRight = {
       .settings = &encoderSettings,
-      .htim = &htim4
+      .htim = &htim4,
+      .isReversed = false
     },
     .sensorsInstance = {
       .config = &sensorsConfig
@@ -0,0 +1,248 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "lf_calib_stats.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define REPLAY_CHANNELS         12U
+#define REPLAY_MAX_SAMPLES      100000U
+/* Simulated spin: 3 s at 1 kHz, the line sweeps twice across the sensors per second */
+#define REPLAY_SIM_SAMPLES      3000U
+#define REPLAY_SIM_PERIOD       500.0
+#define REPLAY_SIM_SWEEP_MM     40.0
+#define REPLAY_SIM_PITCH_MM     4.0
+#define REPLAY_SIM_LINE_MM      19.0
+#define REPLAY_SIM_EDGE_MM      2.0
+#define REPLAY_SIM_NOISE        30.0
+/* One sample out of REPLAY_SIM_SPIKE_RATE reads a rail on a random channel */
+#define REPLAY_SIM_SPIKE_RATE   200
+#define REPLAY_PI               3.14159265358979323846
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef struct
+{
+    uint32_t count;
+    uint16_t readings[REPLAY_MAX_SAMPLES][REPLAY_CHANNELS];
+    uint8_t onLine[REPLAY_MAX_SAMPLES][REPLAY_CHANNELS];    /* Ground truth of a simulated spin */
+    int simulated;
+} Replay_Spin_T;
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static double Replay_Noise(void);
+static void Replay_Simulate(void);
+static int Replay_Load(const char *path);
+static uint32_t Replay_CountErrors(uint32_t channel, uint16_t threshold);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+static Replay_Spin_T spin;
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+static double Replay_Noise(void)
+{
+    double u1 = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double u2 = ((double)rand() + 1.0) / ((double)RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * REPLAY_PI * u2);
+}
+
+/**
+ * @brief Simulates a calibration spin: every channel has its own background and line level,
+ *        the readings are noisy and some of them are rail to rail spikes.
+ */
+static void Replay_Simulate(void)
+{
+    double background[REPLAY_CHANNELS];
+    double line[REPLAY_CHANNELS];
+
+    for (uint32_t ch = 0U; ch < REPLAY_CHANNELS; ch++)
+    {
+        background[ch] = 250.0 + (double)(rand() % 300);
+        line[ch] = 1400.0 + (double)(rand() % 2300);
+    }
+
+    spin.count = REPLAY_SIM_SAMPLES;
+    spin.simulated = 1;
+
+    for (uint32_t i = 0U; i < spin.count; i++)
+    {
+        double linePosition = REPLAY_SIM_SWEEP_MM * sin(2.0 * REPLAY_PI * (double)i / REPLAY_SIM_PERIOD);
+
+        for (uint32_t ch = 0U; ch < REPLAY_CHANNELS; ch++)
+        {
+            double sensorPosition = ((double)ch - (REPLAY_CHANNELS - 1U) / 2.0) * REPLAY_SIM_PITCH_MM;
+            double distance = fabs(sensorPosition - linePosition) - REPLAY_SIM_LINE_MM / 2.0;
+            double coverage = 0.5 - distance / REPLAY_SIM_EDGE_MM;
+
+            coverage = (coverage < 0.0) ? 0.0 : ((coverage > 1.0) ? 1.0 : coverage);
+
+            double reading = background[ch] + (line[ch] - background[ch]) * coverage + REPLAY_SIM_NOISE * Replay_Noise();
+
+            reading = (reading < 0.0) ? 0.0 : ((reading > LF_CALIB_STATS_ADC_MAX) ? LF_CALIB_STATS_ADC_MAX : reading);
+            spin.readings[i][ch] = (uint16_t)reading;
+            spin.onLine[i][ch] = (coverage > 0.5) ? 1U : 0U;
+        }
+
+        if ((rand() % REPLAY_SIM_SPIKE_RATE) == 0)
+        {
+            spin.readings[i][rand() % REPLAY_CHANNELS] = (rand() & 1) ? LF_CALIB_STATS_ADC_MAX : 0U;
+        }
+    }
+}
+
+/**
+ * @brief Loads a recorded spin, a line of 12 readings separated by commas or spaces per sample.
+ *        Other lines, like a header, are skipped.
+ */
+static int Replay_Load(const char *path)
+{
+    FILE *file = fopen(path, "r");
+    char text[256];
+
+    if (file == NULL)
+    {
+        return -1;
+    }
+
+    while ((spin.count < REPLAY_MAX_SAMPLES) && (fgets(text, sizeof(text), file) != NULL))
+    {
+        char *cursor = text;
+        uint32_t ch = 0U;
+
+        for (; ch < REPLAY_CHANNELS; ch++)
+        {
+            char *end;
+            unsigned long value = strtoul(cursor, &end, 10);
+
+            if ((end == cursor) || (value > LF_CALIB_STATS_ADC_MAX))
+            {
+                break;
+            }
+            spin.readings[spin.count][ch] = (uint16_t)value;
+            cursor = end + strspn(end, ", \t;");
+        }
+
+        if (ch == REPLAY_CHANNELS)
+        {
+            spin.count++;
+        }
+    }
+
+    fclose(file);
+
+    return (spin.count > 0U) ? 0 : -1;
+}
+
+static uint32_t Replay_CountErrors(uint32_t channel, uint16_t threshold)
+{
+    uint32_t errors = 0U;
+
+    for (uint32_t i = 0U; i < spin.count; i++)
+    {
+        if ((spin.readings[i][channel] > threshold) != (spin.onLine[i][channel] != 0U))
+        {
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1U;
+    uint32_t failures = 0U;
+    uint32_t errorsOtsu = 0U;
+    uint32_t errorsMidpoint = 0U;
+
+    srand(seed);
+
+    if (argc > 2)
+    {
+        if (Replay_Load(argv[2]) != 0)
+        {
+            fprintf(stderr, "usage: %s [seed] [recorded spin]\n", argv[0]);
+            return 1;
+        }
+        printf("replaying %u samples of %s\n", spin.count, argv[2]);
+    }
+    else
+    {
+        Replay_Simulate();
+        printf("simulated spin of %u samples, seed %u\n", spin.count, seed);
+    }
+
+    printf("ch  threshold  midpoint  background  line  offset  gain");
+    printf(spin.simulated ? "    errors (threshold / midpoint)\n" : "\n");
+
+    for (uint32_t ch = 0U; ch < REPLAY_CHANNELS; ch++)
+    {
+        LF_CalibStats_Histogram_T histogram;
+        LF_CalibStats_Result_T result;
+        uint16_t min = UINT16_MAX;
+        uint16_t max = 0U;
+
+        LF_CalibStats_Reset(&histogram);
+
+        for (uint32_t i = 0U; i < spin.count; i++)
+        {
+            uint16_t reading = spin.readings[i][ch];
+
+            LF_CalibStats_Add(&histogram, reading);
+            min = (reading < min) ? reading : min;
+            max = (reading > max) ? reading : max;
+        }
+
+        /* Threshold of the previous calibration, the middle of the extremes */
+        uint16_t midpoint = (uint16_t)(min + (max - min) / 2U);
+
+        if (LF_CalibStats_Compute(&histogram, &result) != 0)
+        {
+            printf("%2u  failed     %8u\n", ch, midpoint);
+            failures++;
+            continue;
+        }
+
+        printf("%2u  %9u  %8u  %10u  %4u  %6u  %.4f", ch, result.threshold, midpoint, result.background,
+               result.line, result.offset, (double)result.gain);
+
+        if (spin.simulated)
+        {
+            uint32_t otsu = Replay_CountErrors(ch, result.threshold);
+            uint32_t middle = Replay_CountErrors(ch, midpoint);
+
+            printf("  %6u / %u", otsu, middle);
+            errorsOtsu += otsu;
+            errorsMidpoint += middle;
+        }
+        printf("\n");
+    }
+
+    if (spin.simulated)
+    {
+        printf("misclassified readings: threshold %u, midpoint %u of %u\n", errorsOtsu, errorsMidpoint,
+               spin.count * REPLAY_CHANNELS);
+    }
+    printf("failed channels: %u\n", failures);
+
+    /* A simulated spin has to calibrate every channel at least as well as the midpoint */
+    if (spin.simulated && ((failures != 0U) || (errorsOtsu > errorsMidpoint)))
+    {
+        return 1;
+    }
+
+    return (failures == 0U) ? 0 : 1;
+}
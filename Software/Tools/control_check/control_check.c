@@ -0,0 +1,624 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include "lf_trajectory.h"
+#include "lf_traction.h"
+#include "lf_relay.h"
+#include "lf_track_map.h"
+#include "lf_speed_schedule.h"
+#include "sensors.h"
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define CHECK_PI                3.14159265f
+/* Control cycle of the checks [ms] */
+#define CHECK_DT                1.0f
+/* Acceleration left when the setpoint snaps onto the target, two jerk steps of a cycle and the
+   float rounding of the speed [m/s^2] */
+#define CHECK_ARRIVAL_ACCEL     (2.0f * CheckTrajectoryLimits.jerk * CHECK_DT * 0.001f + 1e-3f)
+#define CHECK_TOLERANCE         1e-4f
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static uint32_t Check_Expect(bool passed, const char *name);
+static uint32_t Check_TrajectoryLaunch(void);
+static uint32_t Check_TrajectoryReversal(void);
+static uint32_t Check_Traction(void);
+static uint32_t Check_Tracker(void);
+static uint32_t Check_Relay(void);
+static uint32_t Check_TrackMapProfile(void);
+static uint32_t Check_TrackMapRecording(void);
+static uint32_t Check_SpeedSchedule(void);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+static const LF_TrajectoryLimits_T CheckTrajectoryLimits =
+{
+    .launchAccel = 4.0f,
+    .cruiseAccel = 2.0f,
+    .brakeDecel = 6.0f,
+    .jerk = 50.0f
+};
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    (void)port;
+    (void)pin;
+    (void)state;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *handle)
+{
+    (void)handle;
+
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef *handle, uint32_t *data, uint32_t length)
+{
+    (void)handle;
+    (void)data;
+    (void)length;
+
+    return HAL_OK;
+}
+
+/**
+ * @brief Prints a failed check.
+ *
+ * @return 1 if the check failed, 0 otherwise.
+ */
+static uint32_t Check_Expect(bool passed, const char *name)
+{
+    if (!passed)
+    {
+        printf("FAIL %s\n", name);
+    }
+
+    return passed ? 0U : 1U;
+}
+
+/**
+ * @brief Launches from standstill to 1.3 m/s. The setpoint must reach the target without
+ *        overshooting it, within the launch acceleration and the jerk limit.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_TrajectoryLaunch(void)
+{
+    const float target = 1.3f;
+    LF_Trajectory_T trajectory;
+    float maxSpeed = 0.0f;
+    float maxAccel = 0.0f;
+    float maxJerk = 0.0f;
+    float arrivalAccel = 0.0f;
+    float reachedTime = -1.0f;
+    uint32_t failures = 0U;
+
+    LF_Trajectory_Reset(&trajectory);
+
+    for (uint32_t step = 1U; step <= 3000U; step++)
+    {
+        float previousAccel = trajectory.accel;
+        float speed = LF_Trajectory_Update(&trajectory, &CheckTrajectoryLimits, target, CHECK_DT);
+
+        maxSpeed = fmaxf(maxSpeed, speed);
+        maxAccel = fmaxf(maxAccel, fabsf(trajectory.accel));
+
+        /* The acceleration is cleared when the target is reached, that step is not ramped */
+        if (speed != target)
+        {
+            maxJerk = fmaxf(maxJerk, fabsf(trajectory.accel - previousAccel) / (CHECK_DT * 0.001f));
+        }
+        if ((speed == target) && (reachedTime < 0.0f))
+        {
+            reachedTime = (float)step * CHECK_DT;
+            arrivalAccel = previousAccel;
+        }
+    }
+
+    printf("trajectory launch: target reached after %.0f ms at %.3f m/s^2, peak %.4f m/s, accel %.2f m/s^2, "
+           "jerk %.1f m/s^3\n", reachedTime, arrivalAccel, maxSpeed, maxAccel, maxJerk);
+
+    failures += Check_Expect(reachedTime > 0.0f, "launch reaches the target speed");
+    failures += Check_Expect(maxSpeed <= target, "launch does not overshoot");
+    failures += Check_Expect(fabsf(arrivalAccel) <= CHECK_ARRIVAL_ACCEL,
+                             "launch ramps the acceleration down at the target");
+    failures += Check_Expect(maxAccel <= CheckTrajectoryLimits.launchAccel + CHECK_TOLERANCE,
+                             "launch within the launch acceleration");
+    failures += Check_Expect(maxJerk <= CheckTrajectoryLimits.jerk * (1.0f + CHECK_TOLERANCE),
+                             "launch within the jerk limit");
+    failures += Check_Expect(!trajectory.isLaunching, "launch ends at the target speed");
+
+    return failures;
+}
+
+/**
+ * @brief Lowers the target while the setpoint still accelerates. The acceleration must turn into
+ *        a deceleration through the jerk limit, so the speed keeps rising for a while, and the
+ *        setpoint must settle on the new target without undershooting it.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_TrajectoryReversal(void)
+{
+    const float lowTarget = 0.3f;
+    LF_Trajectory_T trajectory;
+    float reversalSpeed;
+    float peakSpeed;
+    float minSpeed;
+    float minAccel = 0.0f;
+    float maxJerk = 0.0f;
+    float arrivalAccel = -1.0f;
+    uint32_t failures = 0U;
+
+    LF_Trajectory_Reset(&trajectory);
+
+    for (uint32_t step = 0U; step < 300U; step++)
+    {
+        (void)LF_Trajectory_Update(&trajectory, &CheckTrajectoryLimits, 1.3f, CHECK_DT);
+    }
+
+    reversalSpeed = trajectory.speed;
+    peakSpeed = reversalSpeed;
+    minSpeed = reversalSpeed;
+
+    failures += Check_Expect(trajectory.accel > 1.0f, "reversal starts while accelerating");
+
+    for (uint32_t step = 0U; step < 3000U; step++)
+    {
+        float previousAccel = trajectory.accel;
+        float speed = LF_Trajectory_Update(&trajectory, &CheckTrajectoryLimits, lowTarget, CHECK_DT);
+
+        peakSpeed = fmaxf(peakSpeed, speed);
+        minSpeed = fminf(minSpeed, speed);
+        minAccel = fminf(minAccel, trajectory.accel);
+
+        if (speed != lowTarget)
+        {
+            maxJerk = fmaxf(maxJerk, fabsf(trajectory.accel - previousAccel) / (CHECK_DT * 0.001f));
+        }
+        else if (arrivalAccel < 0.0f)
+        {
+            arrivalAccel = fabsf(previousAccel);
+        }
+    }
+
+    printf("trajectory reversal at %.3f m/s: peak %.3f m/s, decel %.2f m/s^2, jerk %.1f m/s^3, final %.3f m/s "
+           "reached at %.3f m/s^2\n", reversalSpeed, peakSpeed, -minAccel, maxJerk, trajectory.speed, arrivalAccel);
+
+    failures += Check_Expect(peakSpeed > reversalSpeed, "reversal ramps the acceleration down");
+    failures += Check_Expect(maxJerk <= CheckTrajectoryLimits.jerk * (1.0f + CHECK_TOLERANCE),
+                             "reversal within the jerk limit");
+    failures += Check_Expect(-minAccel <= CheckTrajectoryLimits.brakeDecel + CHECK_TOLERANCE,
+                             "reversal within the brake deceleration");
+    failures += Check_Expect(minSpeed >= lowTarget, "reversal does not undershoot");
+    failures += Check_Expect(arrivalAccel <= CHECK_ARRIVAL_ACCEL,
+                             "reversal ramps the deceleration down at the target");
+    failures += Check_Expect(trajectory.speed == lowTarget, "reversal settles on the target");
+
+    return failures;
+}
+
+/**
+ * @brief Both wheels follow a 1 m/s^2 ramp, then the left wheel spins up by 0.5 m/s within 20 ms
+ *        and grips again within the next 20 ms. Only the left wheel must be detected, once, and its
+ *        PWM must be capped until the hold time has passed after the last detection.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_Traction(void)
+{
+    const LF_TractionLimits_T limits =
+    {
+        .maxAccelError = 3.0f,
+        .maxSlipSpeed = 0.3f,
+        .pwmFactor = 0.6f,
+        .holdTime = 50U
+    };
+    const float pwmCommand = 400.0f;
+    LF_Traction_T traction;
+    uint32_t leftStarts = 0U;
+    uint32_t rightStarts = 0U;
+    int32_t firstDetection = -1;
+    int32_t lastDetection = -1;
+    int32_t release = -1;
+    bool isCapHeld = true;
+    bool isRightCapped = false;
+    uint32_t failures = 0U;
+
+    LF_Traction_Reset(&traction);
+
+    for (int32_t step = 1; step <= 500; step++)
+    {
+        float setpoint = 0.001f * (float)step;
+        float spin = 0.0f;
+        float setpoints[LF_TRACTION_WHEELS] = {setpoint, setpoint};
+        float velocities[LF_TRACTION_WHEELS];
+        float pwm[LF_TRACTION_WHEELS] = {pwmCommand, pwmCommand};
+
+        if ((step > 200) && (step <= 220))
+        {
+            spin = 0.5f * (float)(step - 200) / 20.0f;
+        }
+        else if ((step > 220) && (step <= 240))
+        {
+            spin = 0.5f * (float)(240 - step) / 20.0f;
+        }
+
+        velocities[LF_TRACTION_LEFT] = setpoint + spin;
+        velocities[LF_TRACTION_RIGHT] = setpoint;
+
+        uint8_t started = LF_Traction_Update(&traction, &limits, velocities, setpoints, pwm, CHECK_DT);
+        uint8_t mask = LF_Traction_GetSlipMask(&traction);
+
+        leftStarts += (started & (1U << LF_TRACTION_LEFT)) ? 1U : 0U;
+        rightStarts += (started & (1U << LF_TRACTION_RIGHT)) ? 1U : 0U;
+        isRightCapped = isRightCapped || (pwm[LF_TRACTION_RIGHT] != pwmCommand);
+
+        /* The hold time is restarted in every cycle with a detection */
+        if (traction.holdTimes[LF_TRACTION_LEFT] == (float)limits.holdTime)
+        {
+            firstDetection = (firstDetection < 0) ? step : firstDetection;
+            lastDetection = step;
+        }
+        if ((firstDetection > 0) && (release < 0))
+        {
+            if (mask & (1U << LF_TRACTION_LEFT))
+            {
+                isCapHeld = isCapHeld &&
+                            (fabsf(pwm[LF_TRACTION_LEFT] - limits.pwmFactor * pwmCommand) < CHECK_TOLERANCE);
+            }
+            else
+            {
+                release = step;
+            }
+        }
+    }
+
+    printf("traction: left slip detected at %d ms, last detection %d ms, cap released at %d ms\n",
+           firstDetection, lastDetection, release);
+
+    failures += Check_Expect((firstDetection > 200) && (firstDetection <= 220), "slip detected while spinning up");
+    failures += Check_Expect(leftStarts == 1U, "one slip reported for the left wheel");
+    failures += Check_Expect((rightStarts == 0U) && !isRightCapped, "gripping right wheel not capped");
+    failures += Check_Expect(isCapHeld, "PWM capped to the part of its value at the detection");
+    failures += Check_Expect(release == lastDetection + (int32_t)(limits.holdTime / CHECK_DT),
+                             "cap held for the hold time after the last detection");
+
+    return failures;
+}
+
+/**
+ * @brief Feeds an error ramp of 0.1 per ms and loses the line. The fitted rate and error must match
+ *        the ramp, the prediction must extrapolate it and give way to the fallback error of its
+ *        side over the decay time. Without the decay the fallback is used at once.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_Tracker(void)
+{
+    static const Sensors_Config_T config = {0};
+    Sensors_Instance_T instance = {.config = &config};
+    Sensors_ErrorConfig_T errorConfig =
+    {
+        .weights = {-5.5f, -4.5f, -3.5f, -2.5f, -1.5f, -0.5f, 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f},
+        .errorThreshold = 0.0f,
+        .fallbackErrorPositive = 8.0f,
+        .fallbackErrorNegative = -8.0f,
+        .lineLossDecay = 100.0f
+    };
+    const float interval = 10.0f;
+    float maxDeviation = 0.0f;
+    float error = 0.0f;
+    uint32_t failures = 0U;
+
+    Sensors_ResetTracker(&instance);
+
+    /* Errors 0.5, 1.5, 2.5 and 3.5, one sensor over the line at a time */
+    for (uint16_t sensor = 6U; sensor <= 9U; sensor++)
+    {
+        memset(instance.sensors, 0, sizeof(instance.sensors));
+        instance.sensors[sensor].isActive = true;
+        (void)Sensors_CalculateError(&instance, &errorConfig, interval);
+    }
+
+    memset(instance.sensors, 0, sizeof(instance.sensors));
+
+    for (uint32_t step = 1U; step <= 150U; step++)
+    {
+        float elapsed = (float)step * CHECK_DT;
+        float prediction = fminf(3.5f + 0.1f * elapsed, errorConfig.fallbackErrorPositive);
+        float confidence = fmaxf(1.0f - elapsed / errorConfig.lineLossDecay, 0.0f);
+        float expected = errorConfig.fallbackErrorPositive +
+                         confidence * (prediction - errorConfig.fallbackErrorPositive);
+
+        error = Sensors_CalculateError(&instance, &errorConfig, CHECK_DT);
+        maxDeviation = fmaxf(maxDeviation, fabsf(error - expected));
+    }
+
+    printf("tracker: rate %.4f 1/ms, fitted error %.4f, prediction deviation %.6f, error after the decay %.3f\n",
+           instance.tracker.errorRate, instance.tracker.predictedError, maxDeviation, error);
+
+    failures += Check_Expect(fabsf(instance.tracker.errorRate - 0.1f) < CHECK_TOLERANCE, "tracker fits the error rate");
+    failures += Check_Expect(fabsf(instance.tracker.predictedError - 3.5f) < CHECK_TOLERANCE,
+                             "tracker fits the last error");
+    failures += Check_Expect(maxDeviation < 1e-3f, "prediction extrapolates the fit and decays");
+    failures += Check_Expect(error == errorConfig.fallbackErrorPositive, "prediction ends at the fallback error");
+
+    /* The line found again starts a new history */
+    instance.sensors[2].isActive = true;
+    (void)Sensors_CalculateError(&instance, &errorConfig, CHECK_DT);
+    failures += Check_Expect(instance.tracker.count == 1U, "history restarts when the line is found");
+
+    errorConfig.lineLossDecay = 0.0f;
+    instance.sensors[2].isActive = false;
+    error = Sensors_CalculateError(&instance, &errorConfig, CHECK_DT);
+    failures += Check_Expect(error == errorConfig.fallbackErrorNegative, "without decay the fallback is used at once");
+
+    return failures;
+}
+
+/**
+ * @brief Runs the relay on a synthetic limit cycle, a sine error independent of the relay output.
+ *        The ultimate period must be the period of the sine and the ultimate gain the describing
+ *        function value 4d / (pi * sqrt(a^2 - h^2)).
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_Relay(void)
+{
+    const float relayAmplitude = 100.0f;
+    const float errorAmplitude = 2.0f;
+    const float period = 200.0f;
+    const float hystereses[] = {0.0f, 0.5f};
+    LF_RelayResult_T result;
+    LF_Relay_T relay;
+    uint32_t failures = 0U;
+
+    for (uint32_t i = 0U; i < (sizeof(hystereses) / sizeof(hystereses[0])); i++)
+    {
+        float hysteresis = hystereses[i];
+        float expectedGain = 4.0f * relayAmplitude /
+                             (CHECK_PI * sqrtf(errorAmplitude * errorAmplitude - hysteresis * hysteresis));
+        uint32_t step = 0U;
+
+        LF_Relay_Init(&relay, relayAmplitude, hysteresis);
+        failures += Check_Expect(LF_Relay_GetResult(&relay, LF_RELAY_RULE_ZIEGLER_NICHOLS, &result) == -1,
+                                 "relay without a result before the cycles are measured");
+
+        while (!LF_Relay_IsComplete(&relay) && (step < 10000U))
+        {
+            step++;
+            (void)LF_Relay_Update(&relay, errorAmplitude * sinf(2.0f * CHECK_PI * (float)step * CHECK_DT / period),
+                                  CHECK_DT);
+        }
+
+        failures += Check_Expect(LF_Relay_GetResult(&relay, LF_RELAY_RULE_ZIEGLER_NICHOLS, &result) == 0,
+                                 "relay completes on a limit cycle");
+
+        printf("relay h=%.1f: Ku %.3f (expected %.3f), Pu %.1f ms (expected %.1f ms) after %u ms\n",
+               hysteresis, result.ultimateGain, expectedGain, result.ultimatePeriod, period, step);
+
+        failures += Check_Expect(fabsf(result.ultimateGain - expectedGain) < 0.01f * expectedGain,
+                                 "relay ultimate gain");
+        failures += Check_Expect(fabsf(result.ultimatePeriod - period) <= CHECK_DT, "relay ultimate period");
+        failures += Check_Expect((fabsf(result.kp - 0.6f * result.ultimateGain) < CHECK_TOLERANCE) &&
+                                 (fabsf(result.ki - result.kp / (0.5f * result.ultimatePeriod)) < CHECK_TOLERANCE) &&
+                                 (fabsf(result.kd - result.kp * 0.125f * result.ultimatePeriod) < 0.01f),
+                                 "relay Ziegler-Nichols gains");
+    }
+
+    /* An oscillation within the hysteresis never switches the relay */
+    LF_Relay_Init(&relay, relayAmplitude, errorAmplitude);
+    for (uint32_t step = 1U; step <= 2000U; step++)
+    {
+        (void)LF_Relay_Update(&relay, errorAmplitude * sinf(2.0f * CHECK_PI * (float)step * CHECK_DT / period),
+                              CHECK_DT);
+    }
+    failures += Check_Expect(LF_Relay_GetResult(&relay, LF_RELAY_RULE_TYREUS_LUYBEN, &result) == -1,
+                             "relay without a result within the hysteresis");
+
+    return failures;
+}
+
+/**
+ * @brief Follows the profile of a 2 m straight, a 0.6 m curve of 0.25 m radius and a 1.5 m straight.
+ *        The profile must brake from 3 m/s at the point from which the deceleration reaches the
+ *        curve speed at the curve entry, and never brake harder than the deceleration limit.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_TrackMapProfile(void)
+{
+    static LF_TrackMap_T map;
+    const LF_TrackMap_Config_T config =
+    {
+        .maxSpeed = 3.0f,
+        .maxLateralAccel = 4.0f,
+        .maxDecel = 5.0f,
+        .fallbackError = 10.0f,
+        .mappingSpeed = 1.0f
+    };
+    const float step = 0.001f;
+    const float curveSpeed = sqrtf(config.maxLateralAccel / 4.0f);
+    const float brakingPoint = 2.0f - (config.maxSpeed * config.maxSpeed - curveSpeed * curveSpeed) /
+                                      (2.0f * config.maxDecel);
+    float firstBraking = -1.0f;
+    float entrySpeed = -1.0f;
+    float maxDecel = 0.0f;
+    float previous = config.maxSpeed;
+    float distance = 0.0f;
+    float speed;
+    uint32_t failures = 0U;
+
+    memset(&map, 0, sizeof(map));
+    map.segments[0] = (LF_TrackSegment_T){.length = 2.0f, .curvature = 0.0f};
+    map.segments[1] = (LF_TrackSegment_T){.length = 0.6f, .curvature = 4.0f};
+    map.segments[2] = (LF_TrackSegment_T){.length = 1.5f, .curvature = 0.0f};
+    map.count = 3U;
+    map.state = LF_TRACK_MAP_READY;
+
+    failures += Check_Expect(LF_TrackMap_StartProfile(&map, &config) == 0, "profile of a recorded map");
+
+    while (LF_TrackMap_GetSpeed(&map, (distance > 0.0f) ? step : 0.0f, config.maxDecel, &speed) == 0)
+    {
+        if ((speed < config.maxSpeed) && (firstBraking < 0.0f))
+        {
+            firstBraking = distance;
+        }
+        if ((map.segment == 1U) && (entrySpeed < 0.0f))
+        {
+            entrySpeed = speed;
+        }
+
+        maxDecel = fmaxf(maxDecel, (previous * previous - speed * speed) / (2.0f * step));
+        previous = speed;
+        distance += step;
+    }
+
+    printf("track map: braking from %.3f m (expected %.3f m), curve entered at %.3f m/s (limit %.3f m/s), "
+           "decel %.2f m/s^2, end at %.3f m\n", firstBraking, brakingPoint, entrySpeed, curveSpeed, maxDecel, distance);
+
+    failures += Check_Expect(fabsf(firstBraking - brakingPoint) <= 2.0f * step, "profile braking point");
+    failures += Check_Expect(entrySpeed <= curveSpeed + CHECK_TOLERANCE, "curve entered at its speed limit");
+    failures += Check_Expect(maxDecel <= config.maxDecel * 1.01f, "profile within the deceleration limit");
+    failures += Check_Expect(fabsf(distance - 4.1f) <= 2.0f * step, "profile ends with the map");
+    failures += Check_Expect((map.segments[0].entrySpeed == config.maxSpeed) &&
+                             (fabsf(map.segments[1].speed - curveSpeed) < CHECK_TOLERANCE) &&
+                             (map.segments[2].entrySpeed == config.maxSpeed), "segment speed limits");
+
+    /* A segment followed with a large error on the mapping lap is not driven faster */
+    map.segments[2].error = 20.0f;
+    (void)LF_TrackMap_StartProfile(&map, &config);
+    failures += Check_Expect(map.segments[2].speed == config.mappingSpeed, "hard segment kept at the mapping speed");
+
+    return failures;
+}
+
+/**
+ * @brief Records 1 m of straight and 0.6 m of a curve of 0.25 m radius from the wheel travel.
+ *        The map must hold the two segments with their lengths and curvatures.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_TrackMapRecording(void)
+{
+    static LF_TrackMap_T map;
+    const float trackWidth = 0.15f;
+    const float curvature = 4.0f;
+    const float step = 0.001f;
+    uint32_t failures = 0U;
+
+    LF_TrackMap_StartRecording(&map);
+
+    for (uint32_t i = 0U; i < 1000U; i++)
+    {
+        LF_TrackMap_Record(&map, step, step, trackWidth, 0.1f);
+    }
+    for (uint32_t i = 0U; i < 600U; i++)
+    {
+        LF_TrackMap_Record(&map, step * (1.0f - 0.5f * trackWidth * curvature),
+                           step * (1.0f + 0.5f * trackWidth * curvature), trackWidth, 0.1f);
+    }
+
+    failures += Check_Expect(LF_TrackMap_FinishRecording(&map) == 0, "recording finished with segments");
+
+    printf("track map recording: %u segments, %.3f m at %.3f 1/m, %.3f m at %.3f 1/m\n", map.count,
+           map.segments[0].length, map.segments[0].curvature, map.segments[1].length, map.segments[1].curvature);
+
+    failures += Check_Expect(map.count == 2U, "straight and curve recorded as two segments");
+    failures += Check_Expect((fabsf(map.segments[0].length - 1.0f) <= LF_TRACK_MAP_STEP) &&
+                             (fabsf(map.segments[0].curvature) < 0.01f), "recorded straight");
+    failures += Check_Expect((fabsf(map.segments[1].length - 0.6f) <= LF_TRACK_MAP_STEP) &&
+                             (fabsf(map.segments[1].curvature - curvature) < 0.01f), "recorded curve");
+
+    return failures;
+}
+
+/**
+ * @brief Compiles a speed curve and compares the LUT with the piecewise-linear curve, a breakpoint
+ *        not above the previous one is skipped. A curve without a positive breakpoint is constant.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_SpeedSchedule(void)
+{
+    const LF_SpeedCurve_T curve =
+    {
+        .inputs = {0.0f, 0.5f, 1.0f, 2.0f, 2.0f, 2.0f},
+        .factors = {1.0f, 1.0f, 0.8f, 0.3f, 0.3f, 0.3f}
+    };
+    const LF_SpeedCurve_T constant =
+    {
+        .inputs = {0.0f},
+        .factors = {0.7f, 0.1f}
+    };
+    LF_SpeedLut_T lut;
+    float maxDeviation = 0.0f;
+    bool isConstant = true;
+    uint32_t failures = 0U;
+
+    LF_SpeedSchedule_Compile(&lut, &curve);
+
+    for (uint32_t i = 0U; i <= 3000U; i++)
+    {
+        float input = 0.001f * (float)i;
+        float expected = 0.3f;
+
+        if (input <= 0.5f)
+        {
+            expected = 1.0f;
+        }
+        else if (input <= 1.0f)
+        {
+            expected = 1.0f - 0.4f * (input - 0.5f);
+        }
+        else if (input <= 2.0f)
+        {
+            expected = 0.8f - 0.5f * (input - 1.0f);
+        }
+
+        maxDeviation = fmaxf(maxDeviation, fabsf(LF_SpeedSchedule_Lookup(&lut, input) - expected));
+    }
+
+    LF_SpeedSchedule_Compile(&lut, &constant);
+    for (uint32_t i = 0U; i <= 100U; i++)
+    {
+        isConstant = isConstant && (LF_SpeedSchedule_Lookup(&lut, 0.1f * (float)i) == 0.7f);
+    }
+
+    printf("speed schedule: LUT deviation %.4f from the curve\n", maxDeviation);
+
+    failures += Check_Expect(maxDeviation < 0.01f, "LUT follows the curve");
+    failures += Check_Expect(isConstant, "curve without a positive breakpoint is constant");
+
+    return failures;
+}
+
+int main(void)
+{
+    uint32_t failures = 0U;
+
+    failures += Check_TrajectoryLaunch();
+    failures += Check_TrajectoryReversal();
+    failures += Check_Traction();
+    failures += Check_Tracker();
+    failures += Check_Relay();
+    failures += Check_TrackMapProfile();
+    failures += Check_TrackMapRecording();
+    failures += Check_SpeedSchedule();
+
+    printf("%u checks failed\n", failures);
+
+    return (failures == 0U) ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+/* Host stand-in for the Cortex-M intrinsics used by Application/Src/sensors.c, included before any
+   other header. The device header is included first so that the CMSIS definitions are already
+   seen when the interrupt intrinsics are replaced by empty statements. */
+#ifndef __HOST_CMSIS_H__
+#define __HOST_CMSIS_H__
+
+#include "stm32f7xx.h"
+
+#undef __disable_irq
+#undef __enable_irq
+#define __disable_irq() ((void)0)
+#define __enable_irq()  ((void)0)
+
+#endif /* __HOST_CMSIS_H__ */
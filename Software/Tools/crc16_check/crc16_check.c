@@ -0,0 +1,152 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+/* The CRC module is included to reach its test vectors and table path, CRC_SOURCE selects the
+   application or the bootloader copy */
+#include CRC_SOURCE
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+#define CHECK_MAX_SIZE      1100U
+#define CHECK_RANDOM_RUNS   2000U
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static uint16_t Check_CalculateBitwise(const uint8_t *data, uint32_t size, uint16_t init);
+static uint32_t Check_TestVectors(void);
+static uint32_t Check_RandomBuffers(void);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+CRC_TypeDef hostCrcUnit;
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+HAL_StatusTypeDef HAL_CRC_Init(CRC_HandleTypeDef *handle)
+{
+  handle->State = HAL_CRC_STATE_READY;
+
+  return HAL_OK;
+}
+
+void Error_Handler(void)
+{
+  printf("HAL_CRC_Init failed\n");
+  exit(1);
+}
+
+/**
+ * @brief Reference CRC16-CCITT, one bit per step (poly 0x1021, no reflection, no final XOR).
+ */
+static uint16_t Check_CalculateBitwise(const uint8_t *data, uint32_t size, uint16_t init)
+{
+  uint16_t crc = init;
+
+  for (uint32_t i = 0U; i < size; i++)
+  {
+    crc ^= (uint16_t)(data[i] << 8);
+    for (uint32_t bit = 0U; bit < 8U; bit++)
+    {
+      crc = (crc & 0x8000U) ? (uint16_t)((crc << 1) ^ CRC16_CCITT_POLYNOMIAL) : (uint16_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+/**
+ * @brief Checks the expected values of the test vectors with the bitwise reference, and the table
+ *        path and CRC_CalculateCRC16 against them.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_TestVectors(void)
+{
+  uint32_t failures = 0U;
+
+  for (size_t i = 0U; i < sizeof(crc16TestVectors) / sizeof(crc16TestVectors[0]); i++)
+  {
+    const CRC16_TestVector_T *vector = &crc16TestVectors[i];
+    const uint8_t *data = (const uint8_t *)vector->data;
+    uint32_t size = strlen(vector->data);
+    uint16_t reference = Check_CalculateBitwise(data, size, vector->init);
+    uint16_t table = CRC_CalculateCRC16Software(data, size, vector->init);
+    uint16_t api = CRC_CalculateCRC16(data, size, vector->init);
+
+    if ((reference != vector->crc) || (table != vector->crc) || (api != vector->crc))
+    {
+      printf("vector \"%s\" init 0x%04X: expected 0x%04X, bitwise 0x%04X, table 0x%04X, api 0x%04X\n",
+             vector->data, vector->init, vector->crc, reference, table, api);
+      failures++;
+    }
+  }
+
+  return failures;
+}
+
+/**
+ * @brief Compares the table path with the bitwise reference on random buffers up to the size of
+ *        a bootloader chunk, calculated at once and chained at a random split.
+ *
+ * @return Number of failed checks.
+ */
+static uint32_t Check_RandomBuffers(void)
+{
+  static uint8_t buffer[CHECK_MAX_SIZE];
+  uint32_t failures = 0U;
+
+  for (uint32_t run = 0U; run < CHECK_RANDOM_RUNS; run++)
+  {
+    uint32_t size = (uint32_t)rand() % (CHECK_MAX_SIZE + 1U);
+    uint32_t split = (uint32_t)rand() % (size + 1U);
+    uint16_t init = (uint16_t)rand();
+
+    for (uint32_t i = 0U; i < size; i++)
+    {
+      buffer[i] = (uint8_t)rand();
+    }
+
+    uint16_t reference = Check_CalculateBitwise(buffer, size, init);
+    uint16_t chained = CRC_CalculateCRC16Software(buffer, split, init);
+
+    chained = CRC_CalculateCRC16Software(buffer + split, size - split, chained);
+
+    if ((CRC_CalculateCRC16Software(buffer, size, init) != reference) || (chained != reference))
+    {
+      printf("random buffer of %u B, init 0x%04X, split at %u: mismatch\n", size, init, split);
+      failures++;
+    }
+  }
+
+  return failures;
+}
+
+int main(int argc, char *argv[])
+{
+  uint32_t seed = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 1U;
+
+  srand(seed);
+
+  /* Runs the target self-test, the host CRC unit does not calculate so the table path stays in use */
+  MX_CRC_Init();
+  if (crc16HardwareReady)
+  {
+    printf("self-test accepted a CRC unit that does not calculate\n");
+    return 1;
+  }
+
+  uint32_t vectorFailures = Check_TestVectors();
+  uint32_t randomFailures = Check_RandomBuffers();
+
+  printf("%s: %u test vectors, %u failed; %u random buffers, %u failed\n", CRC_SOURCE,
+         (uint32_t)(sizeof(crc16TestVectors) / sizeof(crc16TestVectors[0])), vectorFailures,
+         CHECK_RANDOM_RUNS, randomFailures);
+
+  return ((vectorFailures == 0U) && (randomFailures == 0U)) ? 0 : 1;
+}
@@ -0,0 +1,651 @@
+/******************************************************************************************
+ *                                        INCLUDES                                        *
+ ******************************************************************************************/
+#include "nvm.h"
+#include <setjmp.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************************************************
+ *                                         DEFINES                                        *
+ ******************************************************************************************/
+/* Same sectors as on the target, sector 2 (16 KB) and sector 7 (128 KB) */
+#define SIM_SECTOR_PRIMARY      2U
+#define SIM_SECTOR_SECONDARY    7U
+#define SIM_SECTOR_PRIMARY_SIZE   0x4000U
+#define SIM_SECTOR_SECONDARY_SIZE 0x20000U
+#define SIM_CRC32_POLYNOMIAL    0x04C11DB7U
+#define SIM_NO_POWER_CUT        0xFFFFFFFFU
+#define SIM_DEFAULT_PATTERN     0xA5U
+#define SIM_MAX_DATA_SIZE       1024U
+#define SIM_ERASE_BUSY_POLLS    3U
+/* Journal magic of nvm.c, and the layout version of the data migrated by Sim_Migrate */
+#define SIM_SECTOR_MAGIC        0x4A4D564EU
+#define SIM_OLD_VERSION         0U
+
+/******************************************************************************************
+ *                                        TYPEDEFS                                        *
+ ******************************************************************************************/
+typedef struct
+{
+    uint8_t primary[SIM_SECTOR_PRIMARY_SIZE];
+    uint8_t secondary[SIM_SECTOR_SECONDARY_SIZE];
+    uint32_t erases[2];
+    uint32_t operations;        /* Programmed words and erases since the start of the run */
+    uint32_t powerCutAt;        /* Operation interrupted by the power cut */
+    uint32_t programViolations; /* Words programmed without being erased */
+    uint32_t crc;
+    uint32_t crcBytes;          /* Bytes passed to the CRC calculation */
+    int eraseStatus;
+    uint32_t eraseBusyPolls;    /* Status polls left until the erase completes */
+    jmp_buf powerCut;
+} Sim_Flash_T;
+
+/* Copies of the journal structures in nvm.c, to build a journal holding an older layout */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t generationInverted;
+    uint32_t indexCapacity;
+} Sim_SectorHeader_T;
+
+typedef struct
+{
+    uint32_t sequence;
+    uint16_t size;
+    uint16_t version;
+    uint32_t crc;
+} Sim_RecordHeader_T;
+
+/******************************************************************************************
+ *                                   FUNCTIONS PROTOTYPES                                 *
+ ******************************************************************************************/
+static uint8_t *Sim_GetSector(uint32_t sector);
+static void Sim_Operation(void);
+static void Sim_FillData(uint8_t *data, uint32_t size, uint32_t writeIndex);
+static int Sim_RunBackgroundFlush(uint32_t size);
+static void Sim_WriteOldLayoutJournal(const uint8_t *data, uint16_t size);
+static int Sim_Migrate(uint8_t *data, const uint8_t *record, uint16_t recordSize, uint16_t recordVersion);
+static int Sim_RunMigration(uint32_t size);
+static void Sim_WriteLegacyImage(const uint8_t *data, uint16_t size);
+static int Sim_RunLegacyBoot(uint32_t size, uint32_t powerCutAt, uint32_t *operations);
+
+/******************************************************************************************
+ *                                        VARIABLES                                       *
+ ******************************************************************************************/
+static Sim_Flash_T flash;
+
+/******************************************************************************************
+ *                                        FUNCTIONS                                       *
+ ******************************************************************************************/
+static uint8_t *Sim_GetSector(uint32_t sector)
+{
+    switch (sector)
+    {
+    case SIM_SECTOR_PRIMARY:
+        return flash.primary;
+    case SIM_SECTOR_SECONDARY:
+        return flash.secondary;
+    default:
+        return NULL;
+    }
+}
+
+/**
+ * @brief Counts a flash operation, returns to the test loop when the power cut is due.
+ *        The caller has already left the interrupted operation in its partial state.
+ */
+static void Sim_Operation(void)
+{
+    if (flash.operations++ == flash.powerCutAt)
+    {
+        longjmp(flash.powerCut, 1);
+    }
+}
+
+bool NVM_Port_IsSectorValid(uint32_t sector)
+{
+    return (Sim_GetSector(sector) != NULL);
+}
+
+const uint8_t *NVM_Port_GetSectorAddress(uint32_t sector)
+{
+    return Sim_GetSector(sector);
+}
+
+uint32_t NVM_Port_GetSectorSize(uint32_t sector)
+{
+    switch (sector)
+    {
+    case SIM_SECTOR_PRIMARY:
+        return SIM_SECTOR_PRIMARY_SIZE;
+    case SIM_SECTOR_SECONDARY:
+        return SIM_SECTOR_SECONDARY_SIZE;
+    default:
+        return 0U;
+    }
+}
+
+/**
+ * @brief Erases the sector at once, the status is reported busy for a few polls like an erase running on the interrupt.
+ */
+int NVM_Port_StartErase(uint32_t sector)
+{
+    uint8_t *base = Sim_GetSector(sector);
+    uint32_t size = NVM_Port_GetSectorSize(sector);
+
+    if (flash.operations == flash.powerCutAt)
+    {
+        /* Interrupted erase, an arbitrary part of the sector is erased */
+        for (uint32_t i = 0U; i < size; i++)
+        {
+            if (rand() & 1)
+            {
+                base[i] = 0xFFU;
+            }
+        }
+    }
+    else
+    {
+        memset(base, 0xFF, size);
+        flash.erases[(sector == SIM_SECTOR_PRIMARY) ? 0 : 1]++;
+    }
+    Sim_Operation();
+    flash.eraseStatus = NVM_PORT_BUSY;
+    flash.eraseBusyPolls = SIM_ERASE_BUSY_POLLS;
+
+    return 0;
+}
+
+int NVM_Port_GetEraseStatus(void)
+{
+    if ((flash.eraseStatus == NVM_PORT_BUSY) && (flash.eraseBusyPolls-- == 0U))
+    {
+        flash.eraseStatus = 0;
+    }
+
+    return flash.eraseStatus;
+}
+
+int NVM_Port_Program(const uint8_t *address, const uint8_t *data, uint32_t size)
+{
+    uint8_t *target = (uint8_t *)address;
+
+    for (uint32_t i = 0U; i < size; i += 4U)
+    {
+        uint32_t length = (size - i < 4U) ? (size - i) : 4U;
+
+        for (uint32_t j = 0U; j < length; j++)
+        {
+            if (target[i + j] != 0xFFU)
+            {
+                flash.programViolations++;
+            }
+
+            /* Programming only clears bits, an interrupted word gets a random subset of them */
+            uint8_t value = data[i + j];
+            if (flash.operations == flash.powerCutAt)
+            {
+                value |= (uint8_t)rand();
+            }
+            target[i + j] &= value;
+        }
+        Sim_Operation();
+    }
+
+    return 0;
+}
+
+/**
+ * @brief CRC-32/MPEG-2, as calculated by the CRC unit in its default configuration with byte input.
+ */
+uint32_t NVM_Port_CalculateCrc(const uint8_t *data, uint32_t size, bool accumulate)
+{
+    uint32_t crc = accumulate ? flash.crc : 0xFFFFFFFFU;
+
+    flash.crcBytes += size;
+
+    for (uint32_t i = 0U; i < size; i++)
+    {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x80000000U) ? ((crc << 1) ^ SIM_CRC32_POLYNOMIAL) : (crc << 1);
+        }
+    }
+    flash.crc = crc;
+
+    return crc;
+}
+
+static void Sim_FillData(uint8_t *data, uint32_t size, uint32_t writeIndex)
+{
+    uint32_t state = writeIndex * 2654435761U + 1U;
+
+    for (uint32_t i = 0U; i < size; i++)
+    {
+        state = state * 1103515245U + 12345U;
+        data[i] = (uint8_t)(state >> 16);
+    }
+    /* The write index keeps consecutive writes distinct */
+    memcpy(data, &writeIndex, (size < sizeof(writeIndex)) ? size : sizeof(writeIndex));
+}
+
+/**
+ * @brief Writes a series of records, with the power cut at the given flash operation,
+ *        then reboots and checks that the journal holds the last completed or the interrupted write.
+ *
+ * @return
+ * - 0 if the journal recovered.
+ * - -1 otherwise.
+ */
+static int Sim_Run(uint32_t size, uint32_t writes, uint32_t powerCutAt, uint32_t *operations)
+{
+    static uint8_t ram[SIM_MAX_DATA_SIZE];
+    static uint8_t defaults[SIM_MAX_DATA_SIZE];
+    static uint8_t expected[SIM_MAX_DATA_SIZE];
+    static uint8_t interrupted[SIM_MAX_DATA_SIZE];
+    static uint8_t staged[SIM_MAX_DATA_SIZE];
+    Nvm_Instance_T nvm =
+    {
+        .data = ram,
+        .defaultData = defaults,
+        .size = size,
+        .staged = staged,
+        .sectors = {SIM_SECTOR_PRIMARY, SIM_SECTOR_SECONDARY},
+    };
+    volatile uint32_t completed = 0U;
+
+    memset(flash.primary, 0xFF, sizeof(flash.primary));
+    memset(flash.secondary, 0xFF, sizeof(flash.secondary));
+    memset(defaults, SIM_DEFAULT_PATTERN, size);
+    flash.erases[0] = 0U;
+    flash.erases[1] = 0U;
+    flash.operations = 0U;
+    flash.powerCutAt = powerCutAt;
+
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0))
+    {
+        return -1;
+    }
+
+    if (setjmp(flash.powerCut) == 0)
+    {
+        for (uint32_t i = 1U; i <= writes; i++)
+        {
+            Sim_FillData(ram, size, i);
+            if (NVM_Write(&nvm) != 0)
+            {
+                return -1;
+            }
+            completed = i;
+        }
+    }
+    *operations = flash.operations;
+
+    /* Reboot */
+    flash.powerCutAt = SIM_NO_POWER_CUT;
+    memset(ram, 0, size);
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0))
+    {
+        return -1;
+    }
+
+    if (completed == 0U)
+    {
+        memcpy(expected, defaults, size);
+    }
+    else
+    {
+        Sim_FillData(expected, size, completed);
+    }
+    Sim_FillData(interrupted, size, completed + 1U);
+
+    if ((memcmp(ram, expected, size) != 0) && ((completed == writes) || (memcmp(ram, interrupted, size) != 0)))
+    {
+        return -1;
+    }
+
+    /* The journal has to stay writable after the power cut */
+    Sim_FillData(ram, size, writes + 1U);
+    if (NVM_Write(&nvm) != 0)
+    {
+        return -1;
+    }
+    memset(ram, 0, size);
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0))
+    {
+        return -1;
+    }
+    Sim_FillData(expected, size, writes + 1U);
+
+    return (memcmp(ram, expected, size) == 0) ? 0 : -1;
+}
+
+/**
+ * @brief Checks that a postponed flush touches no flash, and that data written while a flush
+ *        is in progress is flushed right after it.
+ *
+ * @return
+ * - 0 if the background flush behaves as expected.
+ * - -1 otherwise.
+ */
+static int Sim_RunBackgroundFlush(uint32_t size)
+{
+    static uint8_t ram[SIM_MAX_DATA_SIZE];
+    static uint8_t staged[SIM_MAX_DATA_SIZE];
+    static uint8_t expected[SIM_MAX_DATA_SIZE];
+    Nvm_Instance_T nvm =
+    {
+        .data = ram,
+        .defaultData = expected,
+        .size = size,
+        .sectors = {SIM_SECTOR_PRIMARY, SIM_SECTOR_SECONDARY},
+        .staged = staged,
+    };
+    uint32_t steps = 0U;
+
+    memset(flash.primary, 0xFF, sizeof(flash.primary));
+    memset(flash.secondary, 0xFF, sizeof(flash.secondary));
+    memset(expected, SIM_DEFAULT_PATTERN, size);
+    flash.operations = 0U;
+    flash.powerCutAt = SIM_NO_POWER_CUT;
+
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0))
+    {
+        return -1;
+    }
+
+    Sim_FillData(ram, size, 1U);
+    if (NVM_RequestWrite(&nvm) != 0)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0U; i < 10U; i++)
+    {
+        NVM_Process(&nvm, false);
+    }
+    if ((flash.operations != 0U) || (NVM_GetStatus(&nvm) != NVM_STATUS_PENDING))
+    {
+        return -1;
+    }
+
+    /* The second write arrives while the first one is programmed */
+    NVM_Process(&nvm, true);
+    Sim_FillData(ram, size, 2U);
+    if ((NVM_GetStatus(&nvm) != NVM_STATUS_BUSY) || (NVM_RequestWrite(&nvm) != 0))
+    {
+        return -1;
+    }
+    while (NVM_GetStatus(&nvm) != NVM_STATUS_COMPLETE)
+    {
+        if ((NVM_GetStatus(&nvm) == NVM_STATUS_FAILED) || (++steps > 10000U))
+        {
+            return -1;
+        }
+        NVM_Process(&nvm, true);
+    }
+
+    memset(ram, 0, size);
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0))
+    {
+        return -1;
+    }
+    Sim_FillData(expected, size, 2U);
+    printf("background flush: %u steps for 2 writes of %u B\n", steps, size);
+
+    return (memcmp(ram, expected, size) == 0) ? 0 : -1;
+}
+
+/**
+ * @brief Writes a journal with a single record of the older layout to the primary sector.
+ */
+static void Sim_WriteOldLayoutJournal(const uint8_t *data, uint16_t size)
+{
+    uint32_t recordLength = (sizeof(Sim_RecordHeader_T) + size + 3U) & ~3U;
+    Sim_SectorHeader_T header =
+    {
+        .magic = SIM_SECTOR_MAGIC,
+        .generation = 1U,
+        .generationInverted = ~1U,
+        .indexCapacity = (SIM_SECTOR_PRIMARY_SIZE - sizeof(Sim_SectorHeader_T)) / (recordLength + sizeof(uint32_t)),
+    };
+    Sim_RecordHeader_T record = {.sequence = 1U, .size = size, .version = SIM_OLD_VERSION};
+    uint32_t recordEnd = sizeof(header) + recordLength;
+
+    /* The record CRC covers the data and then the header fields before the CRC */
+    NVM_Port_CalculateCrc(data, size, false);
+    record.crc = NVM_Port_CalculateCrc((const uint8_t *)&record, offsetof(Sim_RecordHeader_T, crc), true);
+
+    memset(flash.primary, 0xFF, sizeof(flash.primary));
+    memset(flash.secondary, 0xFF, sizeof(flash.secondary));
+    memcpy(flash.primary, &header, sizeof(header));
+    memcpy(flash.primary + sizeof(header), &record, sizeof(record));
+    memcpy(flash.primary + sizeof(header) + sizeof(record), data, size);
+    memcpy(flash.primary + SIM_SECTOR_PRIMARY_SIZE - sizeof(recordEnd), &recordEnd, sizeof(recordEnd));
+}
+
+/**
+ * @brief Writes the data as stored before the journal, raw and followed by its CRC32, to the primary sector.
+ */
+static void Sim_WriteLegacyImage(const uint8_t *data, uint16_t size)
+{
+    uint32_t crc = NVM_Port_CalculateCrc(data, size, false);
+
+    memset(flash.primary, 0xFF, sizeof(flash.primary));
+    memset(flash.secondary, 0xFF, sizeof(flash.secondary));
+    memcpy(flash.primary, data, size);
+    memcpy(flash.primary + size, &crc, sizeof(crc));
+}
+
+/**
+ * @brief The older layout is the first half of the current one, the second half keeps its defaults.
+ */
+static int Sim_Migrate(uint8_t *data, const uint8_t *record, uint16_t recordSize, uint16_t recordVersion)
+{
+    if ((recordVersion != SIM_OLD_VERSION) && (recordVersion != NVM_LEGACY_VERSION))
+    {
+        return -1;
+    }
+
+    memcpy(data, record, recordSize);
+
+    return 0;
+}
+
+/**
+ * @brief Reads a journal holding an older layout, checks the migration and that the next write stores
+ *        the migrated data, and compares the CRC work of both reads.
+ *
+ * @return
+ * - 0 if the data is migrated and stored.
+ * - -1 otherwise.
+ */
+static int Sim_RunMigration(uint32_t size)
+{
+    static uint8_t ram[SIM_MAX_DATA_SIZE];
+    static uint8_t staged[SIM_MAX_DATA_SIZE];
+    static uint8_t defaults[SIM_MAX_DATA_SIZE];
+    static uint8_t expected[SIM_MAX_DATA_SIZE];
+    uint16_t oldSize = (uint16_t)(size / 2U);
+    Nvm_Instance_T nvm =
+    {
+        .data = ram,
+        .defaultData = defaults,
+        .size = size,
+        .version = SIM_OLD_VERSION + 1U,
+        .migrate = Sim_Migrate,
+        .sectors = {SIM_SECTOR_PRIMARY, SIM_SECTOR_SECONDARY},
+        .staged = staged,
+    };
+    uint32_t migrationCrcBytes;
+
+    memset(defaults, SIM_DEFAULT_PATTERN, size);
+    Sim_FillData(expected, oldSize, 1U);
+    Sim_WriteOldLayoutJournal(expected, oldSize);
+    flash.operations = 0U;
+    flash.powerCutAt = SIM_NO_POWER_CUT;
+
+    flash.crcBytes = 0U;
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0) || (nvm.loadSource != NVM_LOADED_MIGRATED))
+    {
+        return -1;
+    }
+    migrationCrcBytes = flash.crcBytes;
+
+    memcpy(expected + oldSize, defaults + oldSize, size - oldSize);
+    if ((memcmp(ram, expected, size) != 0) || (NVM_Write(&nvm) != 0))
+    {
+        return -1;
+    }
+
+    memset(ram, 0, size);
+    flash.crcBytes = 0U;
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0) || (nvm.loadSource != NVM_LOADED_RECORD))
+    {
+        return -1;
+    }
+    /* The CRC work stands in for the boot time, which is not measured on the host */
+    printf("boot read of %u B: %u B through the CRC, %u B when migrating an older layout\n",
+           size, flash.crcBytes, migrationCrcBytes);
+
+    return (memcmp(ram, expected, size) == 0) ? 0 : -1;
+}
+
+/**
+ * @brief Boots from the data stored before the journal and writes it back, with the power cut at the given
+ *        flash operation of the write. After the reboot the migrated data has to be read, from the journal
+ *        or again from the old data, which is only erased once the journal holds a record.
+ *
+ * @return
+ * - 0 if the old data is migrated and survives the power cut.
+ * - -1 otherwise.
+ */
+static int Sim_RunLegacyBoot(uint32_t size, uint32_t powerCutAt, uint32_t *operations)
+{
+    static uint8_t ram[SIM_MAX_DATA_SIZE];
+    static uint8_t staged[SIM_MAX_DATA_SIZE];
+    static uint8_t defaults[SIM_MAX_DATA_SIZE];
+    static uint8_t expected[SIM_MAX_DATA_SIZE];
+    uint16_t oldSize = (uint16_t)(size / 2U) & ~3U;
+    Nvm_Instance_T nvm =
+    {
+        .data = ram,
+        .defaultData = defaults,
+        .size = size,
+        .version = SIM_OLD_VERSION + 1U,
+        .migrate = Sim_Migrate,
+        .legacySize = oldSize,
+        .sectors = {SIM_SECTOR_PRIMARY, SIM_SECTOR_SECONDARY},
+        .staged = staged,
+    };
+
+    memset(defaults, SIM_DEFAULT_PATTERN, size);
+    Sim_FillData(expected, oldSize, 1U);
+    Sim_WriteLegacyImage(expected, oldSize);
+    memcpy(expected + oldSize, defaults + oldSize, size - oldSize);
+    flash.operations = 0U;
+    flash.powerCutAt = powerCutAt;
+
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0) || (nvm.loadSource != NVM_LOADED_MIGRATED) ||
+        (memcmp(ram, expected, size) != 0))
+    {
+        return -1;
+    }
+
+    if (setjmp(flash.powerCut) == 0)
+    {
+        if (NVM_Write(&nvm) != 0)
+        {
+            return -1;
+        }
+    }
+    *operations = flash.operations;
+
+    /* Reboot */
+    flash.powerCutAt = SIM_NO_POWER_CUT;
+    memset(ram, 0, size);
+    if ((NVM_Init(&nvm) != 0) || (NVM_Read(&nvm) != 0) || (nvm.loadSource == NVM_LOADED_DEFAULTS))
+    {
+        return -1;
+    }
+
+    return (memcmp(ram, expected, size) == 0) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t size = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0) : 128U;
+    uint32_t writes = (argc > 2) ? (uint32_t)strtoul(argv[2], NULL, 0) : 400U;
+    uint32_t seed = (argc > 3) ? (uint32_t)strtoul(argv[3], NULL, 0) : 1U;
+    uint32_t totalOperations = 0U;
+    uint32_t failures = 0U;
+
+    if ((size == 0U) || (size > SIM_MAX_DATA_SIZE) || (writes == 0U))
+    {
+        fprintf(stderr, "usage: %s [data size <= %u] [writes] [seed]\n", argv[0], SIM_MAX_DATA_SIZE);
+        return 1;
+    }
+
+    srand(seed);
+
+    /* Reference run without power cut, gives the number of flash operations and the wear */
+    if (Sim_Run(size, writes, SIM_NO_POWER_CUT, &totalOperations) != 0)
+    {
+        printf("reference run failed\n");
+        return 1;
+    }
+    printf("%u writes of %u B: %u flash operations, erases sector %u/%u: %u/%u, %u writes per erase\n",
+           writes, size, totalOperations, SIM_SECTOR_PRIMARY, SIM_SECTOR_SECONDARY, flash.erases[0], flash.erases[1],
+           writes / ((flash.erases[0] + flash.erases[1]) ? (flash.erases[0] + flash.erases[1]) : 1U));
+
+    if (Sim_RunBackgroundFlush(size) != 0)
+    {
+        printf("background flush failed\n");
+        return 1;
+    }
+
+    if (Sim_RunMigration(size) != 0)
+    {
+        printf("migration failed\n");
+        return 1;
+    }
+
+    uint32_t legacyOperations = 0U;
+    if (Sim_RunLegacyBoot(size, SIM_NO_POWER_CUT, &legacyOperations) != 0)
+    {
+        printf("boot from the data stored before the journal failed\n");
+        return 1;
+    }
+    for (uint32_t cut = 0U; cut < legacyOperations; cut++)
+    {
+        uint32_t operations;
+
+        if (Sim_RunLegacyBoot(size, cut, &operations) != 0)
+        {
+            printf("power cut at operation %u of the first write after the old data: data lost\n", cut);
+            return 1;
+        }
+    }
+    printf("boot from the data stored before the journal: %u power cuts in the first write recovered\n",
+           legacyOperations);
+
+    for (uint32_t cut = 0U; cut < totalOperations; cut++)
+    {
+        uint32_t operations;
+
+        if (Sim_Run(size, writes, cut, &operations) != 0)
+        {
+            printf("power cut at operation %u: journal not recovered\n", cut);
+            failures++;
+        }
+    }
+
+    printf("power cuts: %u, recovered: %u, failed: %u, program violations: %u\n",
+           totalOperations, totalOperations - failures, failures, flash.programViolations);
+
+    return (failures == 0U) ? 0 : 1;
+}